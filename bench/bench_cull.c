@@ -0,0 +1,85 @@
+// Frustum and occlusion culling over a large random scene: checks the SIMD frustum pass against
+// a per-object reference test and reports objects/s and culled counts.
+//
+// usage: bench_cull [entities]
+#include "clock.h"
+#include "culling.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define REPEATS 20
+
+static float randomFloat(float lo, float hi) { return lo + (hi - lo) * ((float)rand() / (float)RAND_MAX); }
+
+static bool referenceInside(const Culler *c, size_t i) {
+  for (int p = 0; p < 6; p++) {
+    const Vec4 *plane = &c->planes[p];
+    if (c->cx[i] * plane->x + c->cy[i] * plane->y + c->cz[i] * plane->z + plane->w < -c->radius[i])
+      return false;
+  }
+  return true;
+}
+
+static void printStats(const char *label, const CullStats *stats, double seconds) {
+  printf("%-10s %.1f M objects/s, %zu tested, %zu frustum culled, %zu occluded, %zu visible\n", label,
+         stats->tested * REPEATS / seconds * 1e-6, stats->tested, stats->frustum_culled, stats->occlusion_culled,
+         stats->visible);
+}
+
+int main(int argc, char **argv) {
+  size_t count = argc > 1 ? (size_t)atol(argv[1]) : 1 << 20;
+  Scene scene;
+  Culler culler;
+  if (!SceneInit(&scene, count) || !CullerInit(&culler, count, false)) {
+    fprintf(stderr, "bench_cull: cannot allocate %zu entities\n", count);
+    return 1;
+  }
+
+  // Objects scattered around the camera; a few large ones close in front act as occluders
+  for (size_t i = 0; i < count; i++) {
+    EntityId id = SceneCreateEntity(&scene);
+    float size = randomFloat(0.2f, 2.0f);
+    SceneSetTransform(&scene, id, Vec3Make(randomFloat(-500, 500), randomFloat(-50, 50), randomFloat(-500, 500)),
+                      QuatIdentity(), Vec3Make(size, size, size));
+  }
+  for (size_t i = 0; i < 16 && i < count; i++) {
+    EntityId id = scene.entity[i];
+    SceneSetTransform(&scene, id, Vec3Make(-30.0f + 4.0f * (float)i, 0.0f, -20.0f), QuatIdentity(),
+                      Vec3Make(4, 4, 4));
+    SceneSetVisibility(&scene, id, VISIBILITY_VISIBLE | VISIBILITY_OCCLUDER);
+  }
+  SceneUpdateTransforms(&scene);
+  Vec4 unit_sphere = Vec4Make(0, 0, 0, 1);
+  CullerUpdateBounds(&culler, &scene, &unit_sphere);
+
+  Mat4 view = Mat4LookAt(Vec3Make(0, 0, 0), Vec3Make(0, 0, -1), Vec3Make(0, 1, 0));
+  Mat4 projection = Mat4Perspective(1.0f, 16.0f / 9.0f, 0.1f, 300.0f);
+  CullerSetCamera(&culler, &view, &projection);
+  printf("cull backend: %s, %zu entities\n", culler.backend, count);
+
+  size_t mismatches = 0, expected = 0;
+  CullerRun(&culler, &scene, VISIBILITY_VISIBLE);
+  for (size_t i = 0, v = 0; i < count; i++) {
+    if (!referenceInside(&culler, i))
+      continue;
+    expected++;
+    mismatches += v >= culler.visible_count || culler.visible[v++] != i;
+  }
+  mismatches += expected != culler.visible_count;
+  printf("frustum check: %s\n", mismatches ? "FAILED" : "ok");
+
+  double start = ClockNow();
+  for (int r = 0; r < REPEATS; r++)
+    CullerRun(&culler, &scene, VISIBILITY_VISIBLE);
+  printStats("frustum", &culler.last, ClockNow() - start);
+
+  culler.occlusion = true;
+  start = ClockNow();
+  for (int r = 0; r < REPEATS; r++)
+    CullerRun(&culler, &scene, VISIBILITY_VISIBLE);
+  printStats("occlusion", &culler.last, ClockNow() - start);
+
+  CullerDestroy(&culler);
+  SceneDestroy(&scene);
+  return mismatches ? 1 : 0;
+}
@@ -0,0 +1,84 @@
+// Encodes a synthetic frame (gradients, flat panels and a noisy strip, roughly what the scene
+// looks like after the post chain) as PNG and QOI, one frame at a time and then a batch spread
+// over the job system the way capture dumps a headless run.
+//
+// usage: bench_image_write [width] [height] [frames]
+#include "clock.h"
+#include "image_write.h"
+#include "jobs.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct EncodeJob {
+  const unsigned char *pixels;
+  int width, height;
+  bool qoi;
+  size_t size;
+} EncodeJob;
+
+static void encodeJob(void *data) {
+  EncodeJob *job = data;
+  unsigned char *encoded;
+  job->size = job->qoi ? ImageEncodeQoi(job->pixels, job->width, job->height, &encoded)
+                       : ImageEncodePng(job->pixels, job->width, job->height, &encoded);
+  free(encoded);
+}
+
+int main(int argc, char **argv) {
+  int width = argc > 1 ? atoi(argv[1]) : 1280;
+  int height = argc > 2 ? atoi(argv[2]) : 720;
+  size_t frames = argc > 3 ? (size_t)atol(argv[3]) : 32;
+
+  unsigned char *pixels = malloc((size_t)width * height * 4);
+  unsigned state = 12345;
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      unsigned char *p = pixels + ((size_t)y * width + x) * 4;
+      if (y < height / 3) {
+        p[0] = (unsigned char)(x * 255 / width);
+        p[1] = (unsigned char)(y * 255 / height);
+        p[2] = 96;
+      } else if (y < height * 2 / 3) {
+        p[0] = x < width / 2 ? 51 : 200;
+        p[1] = 76;
+        p[2] = 76;
+      } else {
+        state = state * 1103515245u + 12345u;
+        p[0] = (unsigned char)(state >> 16);
+        p[1] = (unsigned char)(state >> 20);
+        p[2] = (unsigned char)(state >> 24);
+      }
+      p[3] = 255;
+    }
+  }
+  double raw = (double)width * height * 4;
+  printf("%dx%d frame, %.1f MiB raw\n", width, height, raw / (1024.0 * 1024.0));
+
+  JobSystem jobs;
+  if (!JobSystemInit(&jobs, 0))
+    return 1;
+  EncodeJob *batch = malloc(frames * sizeof(*batch));
+  for (int qoi = 0; qoi <= 1; qoi++) {
+    EncodeJob single = {pixels, width, height, qoi, 0};
+    double start = ClockNow();
+    encodeJob(&single);
+    double one = ClockNow() - start;
+
+    JobCounter done = {0};
+    start = ClockNow();
+    for (size_t i = 0; i < frames; i++) {
+      batch[i] = single;
+      JobsRun(&jobs, encodeJob, &batch[i], &done);
+    }
+    JobsWait(&jobs, &done);
+    double all = ClockNow() - start;
+    printf("%s: %.1f%% of raw, %.2f ms per frame on one thread (%.0f MiB/s), %zu frames on %d workers in "
+           "%.2f ms (%.1f frames/s)\n",
+           qoi ? "QOI" : "PNG", 100.0 * (double)single.size / raw, 1000.0 * one, raw / one / (1024.0 * 1024.0),
+           frames, jobs.worker_count, 1000.0 * all, (double)frames / all);
+  }
+  JobSystemShutdown(&jobs);
+  free(batch);
+  free(pixels);
+  return 0;
+}
@@ -0,0 +1,116 @@
+// Scaling of the job system from 1 to N workers on two synthetic workloads: decoding a JPEG
+// many times over (coarse jobs) and transforming a large point array (fine-grained ParallelFor).
+//
+// usage: bench_jobs [image] [max_workers]
+#include "clock.h"
+#include "image.h"
+#include "jobs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define DECODE_JOBS 64
+#define POINT_COUNT (4 * 1024 * 1024)
+#define TRANSFORM_REPEATS 8
+
+typedef struct DecodeWork {
+  const unsigned char *encoded;
+  int size;
+} DecodeWork;
+
+typedef struct TransformWork {
+  const float *matrix; // column-major 4x4
+  const float *in;
+  float *out;
+} TransformWork;
+
+static void decodeJob(void *data) {
+  DecodeWork *work = data;
+  int width, height, channels;
+  unsigned char *pixels = stbi_load_from_memory(work->encoded, work->size, &width, &height, &channels, 0);
+  stbi_image_free(pixels);
+}
+
+static void transformRange(void *data, size_t begin, size_t end) {
+  TransformWork *work = data;
+  const float *m = work->matrix;
+  for (size_t i = begin; i < end; i++) {
+    const float *p = &work->in[i * 3];
+    float *o = &work->out[i * 3];
+    o[0] = m[0] * p[0] + m[4] * p[1] + m[8] * p[2] + m[12];
+    o[1] = m[1] * p[0] + m[5] * p[1] + m[9] * p[2] + m[13];
+    o[2] = m[2] * p[0] + m[6] * p[1] + m[10] * p[2] + m[14];
+  }
+}
+
+static unsigned char *readFile(const char *path, int *size) {
+  FILE *file = fopen(path, "rb");
+  if (!file)
+    return NULL;
+  fseek(file, 0, SEEK_END);
+  long length = ftell(file);
+  rewind(file);
+  unsigned char *data = malloc(length);
+  if (data && fread(data, 1, length, file) != (size_t)length) {
+    free(data);
+    data = NULL;
+  }
+  fclose(file);
+  *size = (int)length;
+  return data;
+}
+
+int main(int argc, char **argv) {
+  const char *image_path = argc > 1 ? argv[1] : "data/container.jpg";
+  int max_workers = argc > 2 ? atoi(argv[2]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+  DecodeWork decode = {0};
+  unsigned char *encoded = readFile(image_path, &decode.size);
+  if (!encoded) {
+    fprintf(stderr, "bench_jobs: cannot read %s\n", image_path);
+    return 1;
+  }
+  decode.encoded = encoded;
+
+  float matrix[16] = {0.5f, 0, 0, 0, 0, 0.5f, 0, 0, 0, 0, 0.5f, 0, 1, 2, 3, 1};
+  float *in = malloc(POINT_COUNT * 3 * sizeof(float));
+  float *out = malloc(POINT_COUNT * 3 * sizeof(float));
+  for (size_t i = 0; i < POINT_COUNT * 3; i++)
+    in[i] = (float)(i % 1000) * 0.001f;
+  TransformWork transform = {matrix, in, out};
+
+  double decode_base = 0.0, transform_base = 0.0;
+  printf("%8s %14s %8s %16s %8s\n", "workers", "decode ms", "speedup", "transform ms", "speedup");
+  for (int workers = 1; workers <= max_workers; workers++) {
+    JobSystem jobs;
+    JobSystemInit(&jobs, workers);
+
+    double start = ClockNow();
+    JobCounter decoded = {0};
+    for (int i = 0; i < DECODE_JOBS; i++)
+      JobsRun(&jobs, decodeJob, &decode, &decoded);
+    JobsWait(&jobs, &decoded);
+    double decode_time = ClockNow() - start;
+
+    start = ClockNow();
+    for (int r = 0; r < TRANSFORM_REPEATS; r++) {
+      JobCounter transformed = {0};
+      JobsParallelFor(&jobs, POINT_COUNT, 16 * 1024, transformRange, &transform, &transformed);
+      JobsWait(&jobs, &transformed);
+    }
+    double transform_time = ClockNow() - start;
+
+    if (workers == 1) {
+      decode_base = decode_time;
+      transform_base = transform_time;
+    }
+    printf("%8d %14.2f %7.2fx %16.2f %7.2fx\n", jobs.worker_count, 1000.0 * decode_time, decode_base / decode_time,
+           1000.0 * transform_time, transform_base / transform_time);
+    JobSystemShutdown(&jobs);
+  }
+
+  free(encoded);
+  free(in);
+  free(out);
+  return 0;
+}
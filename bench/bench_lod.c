@@ -0,0 +1,109 @@
+// Builds an LOD chain for a dense heightfield, then draws a field of instances at increasing
+// distance and compares the triangles submitted with and without per-object LOD selection.
+//
+// usage: bench_lod [grid side] [instances] [pixel error]
+#include "clock.h"
+#include "lod.h"
+#include "mesh.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static float randomFloat(float lo, float hi) { return lo + (hi - lo) * ((float)rand() / (float)RAND_MAX); }
+
+// Unit terrain tile centred on the origin with UVs, so borders and attributes both constrain collapses
+static bool buildTerrain(Mesh *mesh, size_t side) {
+  memset(mesh, 0, sizeof(*mesh));
+  mesh->vertex_count = (side + 1) * (side + 1);
+  mesh->index_count = 6 * side * side;
+  mesh->positions = malloc(mesh->vertex_count * 3 * sizeof(float));
+  mesh->uvs = malloc(mesh->vertex_count * 2 * sizeof(float));
+  mesh->indices = malloc(mesh->index_count * sizeof(uint32_t));
+  if (!mesh->positions || !mesh->uvs || !mesh->indices)
+    return false;
+  for (size_t y = 0, v = 0; y <= side; y++)
+    for (size_t x = 0; x <= side; x++, v++) {
+      float u = (float)x / (float)side, w = (float)y / (float)side;
+      mesh->positions[v * 3 + 0] = u - 0.5f;
+      mesh->positions[v * 3 + 1] = 0.06f * sinf(u * 11.0f) * cosf(w * 7.0f) + 0.01f * sinf(u * 53.0f + w * 41.0f);
+      mesh->positions[v * 3 + 2] = w - 0.5f;
+      mesh->uvs[v * 2 + 0] = u;
+      mesh->uvs[v * 2 + 1] = w;
+    }
+  for (size_t y = 0, i = 0; y < side; y++)
+    for (size_t x = 0; x < side; x++, i += 6) {
+      uint32_t a = (uint32_t)(y * (side + 1) + x), b = a + 1, c = a + (uint32_t)side + 1, d = c + 1;
+      uint32_t quad[6] = {a, c, d, a, d, b};
+      memcpy(mesh->indices + i, quad, sizeof(quad));
+    }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  size_t side = argc > 1 ? (size_t)atol(argv[1]) : 700;
+  size_t instances = argc > 2 ? (size_t)atol(argv[2]) : 4096;
+  float pixel_error = argc > 3 ? (float)atof(argv[3]) : LOD_DEFAULT_PIXEL_ERROR;
+
+  Mesh mesh;
+  if (!buildTerrain(&mesh, side)) {
+    fprintf(stderr, "bench_lod: cannot allocate a %zux%zu grid\n", side, side);
+    return 1;
+  }
+  double start = ClockNow();
+  MeshLodChain chain;
+  if (!MeshBuildLods(&mesh, MESH_MAX_LODS, &chain)) {
+    fprintf(stderr, "bench_lod: simplification failed\n");
+    return 1;
+  }
+  double build_time = ClockNow() - start;
+  printf("%zu triangles, %zu levels built in %.2f s\n", mesh.index_count / 3, chain.lod_count, build_time);
+  for (size_t l = 0; l < chain.lod_count; l++)
+    printf("  lod %zu: %8zu triangles, error %.6f\n", l, chain.counts[l] / 3, chain.errors[l]);
+
+  // Tiles scattered over a wide field in front of a 1080p camera
+  Mat4 view = Mat4LookAt(Vec3Make(0, 2, 0), Vec3Make(0, 0, -50), Vec3Make(0, 1, 0));
+  Mat4 projection = Mat4Perspective(1.0f, 16.0f / 9.0f, 0.1f, 1000.0f);
+  LodSelector selector;
+  LodSelectorInit(&selector, &view, &projection, 1080, pixel_error);
+  // The tile is centred on the origin, so its bounding sphere reaches its farthest vertex
+  float radius = 0.0f;
+  for (size_t v = 0; v < mesh.vertex_count; v++) {
+    const float *p = &mesh.positions[v * 3];
+    radius = fmaxf(radius, sqrtf(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]));
+  }
+  Mat4 *worlds = malloc(instances * sizeof(Mat4));
+  uint32_t *selected = malloc(instances * sizeof(uint32_t));
+  if (!worlds || !selected)
+    return 1;
+  srand(1);
+  for (size_t i = 0; i < instances; i++) {
+    float scale = randomFloat(2.0f, 8.0f);
+    Mat4 translation = Mat4Translation(Vec3Make(randomFloat(-200, 200), 0.0f, -randomFloat(2.0f, 600.0f)));
+    Mat4 scaling = Mat4Scaling(Vec3Make(scale, scale, scale));
+    worlds[i] = Mat4Mul(&translation, &scaling);
+  }
+
+  start = ClockNow();
+  for (size_t i = 0; i < instances; i++)
+    selected[i] = LodSelect(&selector, &worlds[i], Vec3Make(0, 0, 0), radius, chain.errors, (uint32_t)chain.lod_count);
+  double select_time = ClockNow() - start;
+
+  size_t histogram[MESH_MAX_LODS] = {0};
+  double full = 0.0, reduced = 0.0;
+  for (size_t i = 0; i < instances; i++) {
+    histogram[selected[i]]++;
+    full += (double)chain.counts[0] / 3;
+    reduced += (double)chain.counts[selected[i]] / 3;
+  }
+  printf("%zu instances within %.2f px: %.1f M -> %.2f M triangles (%.1fx), selection %.1f ns/object\n", instances,
+         pixel_error, full * 1e-6, reduced * 1e-6, full / reduced, select_time / (double)instances * 1e9);
+  for (size_t l = 0; l < chain.lod_count; l++)
+    printf("  lod %zu: %zu instances\n", l, histogram[l]);
+
+  free(worlds);
+  free(selected);
+  MeshLodChainFree(&chain);
+  MeshFree(&mesh);
+  return 0;
+}
@@ -0,0 +1,181 @@
+// Generates a large grid mesh with shuffled triangles, writes it as OBJ and as binary glTF,
+// then imports both and reports parse throughput and ACMR before/after cache optimization.
+// Each import is also written as a binary mesh cache and reopened, for the cost of a warm start.
+//
+// usage: bench_mesh_import [triangles] [directory]
+#include "clock.h"
+#include "mesh.h"
+#include "mesh_cache.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static bool writeObj(const char *path, size_t side, const uint32_t *indices, size_t index_count) {
+  FILE *file = fopen(path, "wb");
+  if (!file)
+    return false;
+  for (size_t y = 0; y <= side; y++)
+    for (size_t x = 0; x <= side; x++)
+      fprintf(file, "v %.6f %.6f %.6f\nvt %.6f %.6f\n", (float)x / side, (float)y / side,
+              0.05f * (float)((x * 7 + y * 13) % 17) / 17.0f, (float)x / side, (float)y / side);
+  fprintf(file, "vn 0 0 1\n");
+  for (size_t i = 0; i < index_count; i += 3)
+    fprintf(file, "f %u/%u/1 %u/%u/1 %u/%u/1\n", indices[i] + 1, indices[i] + 1, indices[i + 1] + 1,
+            indices[i + 1] + 1, indices[i + 2] + 1, indices[i + 2] + 1);
+  return fclose(file) == 0;
+}
+
+static bool writeGlb(const char *path, size_t side, const uint32_t *indices, size_t index_count) {
+  size_t vertex_count = (side + 1) * (side + 1);
+  size_t positions_size = vertex_count * 3 * sizeof(float);
+  size_t uvs_size = vertex_count * 2 * sizeof(float);
+  size_t indices_size = index_count * sizeof(uint32_t);
+  uint32_t bin_size = (uint32_t)(positions_size + uvs_size + indices_size);
+
+  char json[2048];
+  int length = snprintf(
+      json, sizeof(json),
+      "{\"asset\":{\"version\":\"2.0\"},\"buffers\":[{\"byteLength\":%u}],"
+      "\"bufferViews\":[{\"buffer\":0,\"byteOffset\":0,\"byteLength\":%zu},"
+      "{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu},{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu}],"
+      "\"accessors\":[{\"bufferView\":0,\"componentType\":5126,\"count\":%zu,\"type\":\"VEC3\"},"
+      "{\"bufferView\":1,\"componentType\":5126,\"count\":%zu,\"type\":\"VEC2\"},"
+      "{\"bufferView\":2,\"componentType\":5125,\"count\":%zu,\"type\":\"SCALAR\"}],"
+      "\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0,\"TEXCOORD_0\":1},\"indices\":2}]}]}",
+      bin_size, positions_size, positions_size, uvs_size, positions_size + uvs_size, indices_size, vertex_count,
+      vertex_count, index_count);
+  while (length % 4)
+    json[length++] = ' ';
+
+  float *positions = malloc(positions_size), *uvs = malloc(uvs_size);
+  FILE *file = fopen(path, "wb");
+  if (!positions || !uvs || !file) {
+    free(positions);
+    free(uvs);
+    if (file)
+      fclose(file);
+    return false;
+  }
+  for (size_t y = 0, v = 0; y <= side; y++)
+    for (size_t x = 0; x <= side; x++, v++) {
+      positions[v * 3 + 0] = (float)x / side;
+      positions[v * 3 + 1] = (float)y / side;
+      positions[v * 3 + 2] = 0.05f * (float)((x * 7 + y * 13) % 17) / 17.0f;
+      uvs[v * 2 + 0] = (float)x / side;
+      uvs[v * 2 + 1] = (float)y / side;
+    }
+  uint32_t header[5] = {0x46546c67u, 2, 12 + 8 + (uint32_t)length + 8 + bin_size, (uint32_t)length, 0x4e4f534au};
+  uint32_t bin_header[2] = {bin_size, 0x004e4942u};
+  fwrite(header, sizeof(header), 1, file);
+  fwrite(json, 1, (size_t)length, file);
+  fwrite(bin_header, sizeof(bin_header), 1, file);
+  fwrite(positions, 1, positions_size, file);
+  fwrite(uvs, 1, uvs_size, file);
+  fwrite(indices, 1, indices_size, file);
+  free(positions);
+  free(uvs);
+  return fclose(file) == 0;
+}
+
+static void run(const char *path) {
+  Mesh mesh;
+  MeshImportStats stats;
+  MeshResult result = MeshImportFile(path, &mesh, &stats);
+  if (result != MESH_SUCCESS) {
+    printf("%s: import failed (%d)\n", path, (int)result);
+    return;
+  }
+  printf("%s: %.1f MB parsed at %.1f MB/s (%.3f s), optimized in %.3f s\n", path, stats.bytes / 1e6,
+         stats.bytes / 1e6 / stats.parse_time, stats.parse_time, stats.optimize_time);
+  MeshPrintStats(path, &mesh, &stats);
+
+  VertexLayout layout;
+  VertexLayoutInit(&layout);
+  VertexLayoutAdd(&layout, 0, VERTEX_FORMAT_HALF4);
+  VertexLayoutAdd(&layout, 2, VERTEX_FORMAT_UNORM16X2);
+  VertexSource sources[] = {{mesh.positions, 3, 3}, {mesh.uvs, mesh.uvs ? 2 : 0, 2}};
+  MeshCacheStreamDesc stream = {&layout, sources};
+  char cache_path[4096];
+  snprintf(cache_path, sizeof(cache_path), "%s.meshcache", path);
+
+  // Staleness is checked against a hash of the source, so a warm start still reads it once
+  int fd = open(path, O_RDONLY);
+  struct stat st;
+  void *source = fd >= 0 && fstat(fd, &st) == 0 ? mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)
+                                                 : MAP_FAILED;
+  if (fd >= 0)
+    close(fd);
+  MeshCache cache;
+  if (source != MAP_FAILED &&
+      MeshCacheBuild(MeshCacheHash(source, (size_t)st.st_size), &mesh, &stream, 1, NULL, 0, NULL, &cache) ==
+          MESH_CACHE_SUCCESS) {
+    MeshCacheResult written = MeshCacheWrite(cache_path, &cache);
+    MeshCacheClose(&cache);
+    double start = ClockNow();
+    uint64_t source_hash = MeshCacheHash(source, (size_t)st.st_size);
+    double hashed = ClockNow();
+    MeshCacheResult opened = MeshCacheOpen(cache_path, source_hash, &layout, 1, &cache);
+    double end = ClockNow();
+    if (written == MESH_CACHE_SUCCESS && opened == MESH_CACHE_SUCCESS) {
+      printf("  cache %.1f MB: hash source %.2f ms (%.1f GB/s), open %.3f ms, %.0fx faster than importing\n",
+             cache.size / 1e6, 1000.0 * (hashed - start), st.st_size / 1e9 / (hashed - start),
+             1000.0 * (end - hashed), (stats.parse_time + stats.optimize_time) / (end - start));
+      MeshCacheClose(&cache);
+    } else {
+      printf("  cache round trip failed (%d, %d)\n", (int)written, (int)opened);
+    }
+    remove(cache_path);
+  }
+  if (source != MAP_FAILED)
+    munmap(source, (size_t)st.st_size);
+  MeshFree(&mesh);
+}
+
+int main(int argc, char **argv) {
+  size_t triangles = argc > 1 ? (size_t)atol(argv[1]) : 2000000;
+  const char *directory = argc > 2 ? argv[2] : ".";
+  size_t side = 1;
+  while (2 * side * side < triangles)
+    side++;
+
+  // Shuffled triangle order is the worst case for the post-transform cache
+  size_t index_count = 6 * side * side;
+  uint32_t *indices = malloc(index_count * sizeof(uint32_t));
+  if (!indices)
+    return 1;
+  for (size_t y = 0, i = 0; y < side; y++)
+    for (size_t x = 0; x < side; x++, i += 6) {
+      uint32_t a = (uint32_t)(y * (side + 1) + x), b = a + 1, c = a + (uint32_t)side + 1, d = c + 1;
+      uint32_t quad[6] = {a, b, d, a, d, c};
+      memcpy(indices + i, quad, sizeof(quad));
+    }
+  srand(1);
+  for (size_t t = index_count / 3 - 1; t > 0; t--) {
+    size_t u = (size_t)rand() % (t + 1);
+    uint32_t tmp[3];
+    memcpy(tmp, indices + 3 * t, sizeof(tmp));
+    memcpy(indices + 3 * t, indices + 3 * u, sizeof(tmp));
+    memcpy(indices + 3 * u, tmp, sizeof(tmp));
+  }
+
+  char obj_path[4096], glb_path[4096];
+  snprintf(obj_path, sizeof(obj_path), "%s/bench_mesh.obj", directory);
+  snprintf(glb_path, sizeof(glb_path), "%s/bench_mesh.glb", directory);
+  printf("writing %zu triangles (%zux%zu grid)\n", index_count / 3, side, side);
+  bool written = writeObj(obj_path, side, indices, index_count) && writeGlb(glb_path, side, indices, index_count);
+  free(indices);
+  if (!written) {
+    printf("failed to write test meshes to %s\n", directory);
+    return 1;
+  }
+
+  run(obj_path);
+  run(glb_path);
+  remove(obj_path);
+  remove(glb_path);
+  return 0;
+}
@@ -0,0 +1,128 @@
+// Splits a million-triangle sphere into meshlets, then culls a field of instances cluster by
+// cluster on the job system and reports what reaches the indirect draw list. Needs no window.
+//
+// usage: bench_meshlet [face side] [instances] [frames] [workers]
+#include "clock.h"
+#include "jobs.h"
+#include "mesh.h"
+#include "meshlet.h"
+#include "render_commands.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Unit sphere made of six subdivided cube faces, wound counter-clockwise seen from outside
+static bool buildSphere(Mesh *mesh, size_t side) {
+  memset(mesh, 0, sizeof(*mesh));
+  size_t face_vertices = (side + 1) * (side + 1);
+  mesh->vertex_count = 6 * face_vertices;
+  mesh->index_count = 6 * 6 * side * side;
+  mesh->positions = malloc(mesh->vertex_count * 3 * sizeof(float));
+  mesh->indices = malloc(mesh->index_count * sizeof(uint32_t));
+  if (!mesh->positions || !mesh->indices)
+    return false;
+  static const float frames[6][3][3] = {
+      {{1, 0, 0}, {0, 0, -1}, {0, 1, 0}},  {{-1, 0, 0}, {0, 0, 1}, {0, 1, 0}}, {{0, 1, 0}, {1, 0, 0}, {0, 0, -1}},
+      {{0, -1, 0}, {1, 0, 0}, {0, 0, 1}}, {{0, 0, 1}, {1, 0, 0}, {0, 1, 0}},  {{0, 0, -1}, {-1, 0, 0}, {0, 1, 0}},
+  };
+  size_t i = 0;
+  for (size_t f = 0; f < 6; f++) {
+    const float(*axes)[3] = frames[f];
+    for (size_t y = 0, v = f * face_vertices; y <= side; y++)
+      for (size_t x = 0; x <= side; x++, v++) {
+        float u = 2.0f * (float)x / (float)side - 1.0f, w = 2.0f * (float)y / (float)side - 1.0f;
+        Vec3 p = Vec3Make(axes[0][0] + u * axes[1][0] + w * axes[2][0], axes[0][1] + u * axes[1][1] + w * axes[2][1],
+                          axes[0][2] + u * axes[1][2] + w * axes[2][2]);
+        p = Vec3Normalize(p);
+        memcpy(mesh->positions + v * 3, &p, sizeof(p));
+      }
+    for (size_t y = 0; y < side; y++)
+      for (size_t x = 0; x < side; x++, i += 6) {
+        uint32_t a = (uint32_t)(f * face_vertices + y * (side + 1) + x), b = a + 1, c = a + (uint32_t)side + 1;
+        uint32_t d = c + 1;
+        uint32_t quad[6] = {a, b, d, a, d, c};
+        memcpy(mesh->indices + i, quad, sizeof(quad));
+      }
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  size_t side = argc > 1 ? (size_t)atol(argv[1]) : 290;
+  size_t instances = argc > 2 ? (size_t)atol(argv[2]) : 16;
+  int frames = argc > 3 ? atoi(argv[3]) : 50;
+  int workers = argc > 4 ? atoi(argv[4]) : 0;
+
+  Mesh mesh;
+  if (!buildSphere(&mesh, side)) {
+    fprintf(stderr, "bench_meshlet: cannot allocate a sphere of side %zu\n", side);
+    return 1;
+  }
+  double start = ClockNow();
+  MeshOptimizeVertexCache(mesh.indices, mesh.index_count, mesh.vertex_count);
+  double optimize_time = ClockNow() - start;
+  start = ClockNow();
+  MeshletSet set;
+  if (!MeshletBuild(&mesh, mesh.indices, mesh.index_count, &set)) {
+    fprintf(stderr, "bench_meshlet: meshlet build failed\n");
+    return 1;
+  }
+  double build_time = ClockNow() - start;
+  printf("%zu triangles: vertex cache order %.0f ms, meshlets %.0f ms\n", mesh.index_count / 3, optimize_time * 1e3,
+         build_time * 1e3);
+  MeshletPrintStats(&set);
+
+  // A row of spheres filling a 16:9 view, the outer ones partly off-screen
+  Mat4 view = Mat4LookAt(Vec3Make(0, 0, 6), Vec3Make(0, 0, 0), Vec3Make(0, 1, 0));
+  Mat4 projection = Mat4Perspective(1.0f, 16.0f / 9.0f, 0.1f, 100.0f);
+  Mat4 *worlds = malloc(instances * sizeof(Mat4));
+  if (!worlds)
+    return 1;
+  for (size_t i = 0; i < instances; i++) {
+    float x = ((float)i - 0.5f * (float)(instances - 1)) * 1.5f;
+    float z = -(float)(i % 4) * 2.0f;
+    worlds[i] = Mat4Translation(Vec3Make(x, 0.0f, z));
+  }
+
+  JobSystem jobs;
+  if (!JobSystemInit(&jobs, workers))
+    return 1;
+  MeshletCuller culler;
+  MeshletCullerInit(&culler);
+  MeshletCullerSetCamera(&culler, &view, &projection);
+  RenderCommandList list;
+  if (!RenderCommandListInit(&list, 1024))
+    return 1;
+
+  double cull_time = 0.0, record_time = 0.0;
+  for (int f = 0; f < frames; f++) {
+    start = ClockNow();
+    MeshletCull(&culler, &jobs, &set, worlds, instances);
+    double mid = ClockNow();
+    RenderCommandListReset(&list);
+    MeshletRecordDraws(&culler, worlds, 0, &list);
+    cull_time += mid - start;
+    record_time += ClockNow() - mid;
+  }
+
+  const MeshletCullStats *s = &culler.last;
+  size_t triangles = 0;
+  for (size_t i = 0; i < culler.command_count; i++)
+    triangles += culler.commands[i].count / 3;
+  double total = (double)(mesh.index_count / 3) * (double)instances;
+  printf("%zu instances on %d workers: cull %.3f ms, record %.3f ms per frame\n", instances, jobs.worker_count,
+         cull_time / frames * 1e3, record_time / frames * 1e3);
+  printf("  %zu meshlets tested: %zu off-screen, %zu back-facing, %zu visible in %zu draws\n", s->tested,
+         s->frustum_culled, s->backface_culled, s->visible, culler.command_count);
+  printf("  %.2f M -> %.2f M triangles (%.0f%% culled)\n", total * 1e-6, (double)triangles * 1e-6,
+         100.0 * (1.0 - (double)triangles / total));
+
+  RenderCommandListDestroy(&list);
+  MeshletCullerDestroy(&culler);
+  JobSystemShutdown(&jobs);
+  free(worlds);
+  MeshletSetFree(&set);
+  MeshFree(&mesh);
+  return 0;
+}
@@ -0,0 +1,98 @@
+// Times recording particle updates and draws for pools from a thousand to millions of
+// particles at the same emission rate. The GPU backend does the simulation on replay, so its
+// recording cost should not grow with the pool; the CPU backend simulates while recording, so
+// it is reported in particles per millisecond, from full pools. Only records commands, so it
+// needs no GL context.
+//
+// usage: bench_particles [emitted per second] [frames]
+#include "clock.h"
+#include "jobs.h"
+#include "particles.h"
+#include "render_commands.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static const char *simdName(void) {
+#if defined(VECMATH_AVX)
+  return "AVX";
+#elif defined(VECMATH_SSE)
+  return "SSE";
+#elif defined(VECMATH_NEON)
+  return "NEON";
+#else
+  return "scalar";
+#endif
+}
+
+// A pool at its steady state: every slot live, with life left spread over the lifetime
+static void fill(ParticleSystem *particles) {
+  const ParticleSoA *s = &particles->state[particles->current_state];
+  uint32_t random = 1;
+  for (size_t i = 0; i < particles->capacity; i++) {
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    float u = (float)(random >> 8) / 16777216.0f;
+    s->x[i] = s->y[i] = s->z[i] = 0.0f;
+    s->vx[i] = u - 0.5f;
+    s->vy[i] = 1.6f;
+    s->vz[i] = 0.5f - u;
+    s->lifetime[i] = particles->emitter.lifetime;
+    s->life[i] = u * particles->emitter.lifetime;
+  }
+  particles->live = particles->capacity;
+}
+
+int main(int argc, char **argv) {
+  float rate = argc > 1 ? (float)atof(argv[1]) : 60000.0f;
+  int frames = argc > 2 ? atoi(argv[2]) : 600;
+  static const size_t capacities[] = {1000, 10000, 100000, 1000000, 4000000};
+  RenderCommandList list;
+  JobSystem jobs;
+  if (!RenderCommandListInit(&list, 16) || !JobSystemInit(&jobs, 0))
+    return 1;
+  printf("GPU backend, recording only\n");
+  for (size_t c = 0; c < sizeof(capacities) / sizeof(capacities[0]); c++) {
+    ParticleSystem particles;
+    if (!ParticleSystemInit(&particles, PARTICLE_BACKEND_GPU, capacities[c], NULL, 0, 0))
+      return 1;
+    particles.emitter.rate = rate;
+    double start = ClockNow();
+    for (int f = 0; f < frames; f++) {
+      RenderCommandListReset(&list);
+      ParticleSystemRecordUpdate(&particles, &list, 1.0f / 60.0f);
+      ParticleSystemRecordDraw(&particles, &list, 1920, 1080);
+    }
+    double elapsed = ClockNow() - start;
+    printf("%8zu particles: %7.3f us per frame recording %.0f emitted\n", capacities[c], 1e6 * elapsed / frames,
+           (double)particles.emitted / frames);
+    ParticleSystemDestroy(&particles);
+  }
+
+  printf("CPU backend, %s kernels on %d workers\n", simdName(), jobs.worker_count);
+  for (size_t c = 0; c < sizeof(capacities) / sizeof(capacities[0]); c++) {
+    ParticleSystem particles;
+    if (!ParticleSystemInit(&particles, PARTICLE_BACKEND_CPU, capacities[c], &jobs, 0, 0))
+      return 1;
+    particles.emitter.lifetime = 2.0f;
+    particles.emitter.rate = (float)capacities[c] / particles.emitter.lifetime;
+    particles.gravity = Vec3Make(0.0f, -1.5f, 0.0f);
+    particles.drag = 0.1f;
+    fill(&particles);
+    double simulated = 0.0;
+    double start = ClockNow();
+    for (int f = 0; f < frames; f++) {
+      RenderCommandListReset(&list);
+      simulated += (double)particles.live;
+      ParticleSystemRecordUpdate(&particles, &list, 1.0f / 60.0f);
+      ParticleSystemRecordDraw(&particles, &list, 1920, 1080);
+    }
+    double elapsed = ClockNow() - start;
+    printf("%8zu particles: %8.3f ms per frame, %9.0f particles per ms, %zu live at the end\n", capacities[c],
+           1e3 * elapsed / frames, simulated / (1e3 * elapsed), particles.live);
+    ParticleSystemDestroy(&particles);
+  }
+  JobSystemShutdown(&jobs);
+  RenderCommandListDestroy(&list);
+  return 0;
+}
@@ -0,0 +1,86 @@
+// Sorting and recording 100k randomized draws through the render queue, with the state
+// switches it takes compared to submitting them unsorted. Nothing is sent to GL.
+//
+// usage: bench_render_queue [draws]
+#include "clock.h"
+#include "render_queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define REPEATS 20
+#define PROGRAMS 16
+#define TEXTURE_SETS 64
+#define VERTEX_ARRAYS 256
+
+static void fill(RenderQueue *queue, size_t draws) {
+  srand(1);
+  RenderQueueReset(queue);
+  for (size_t i = 0; i < draws; i++) {
+    unsigned program = (unsigned)rand() % PROGRAMS;
+    unsigned texture_set = 1 + (unsigned)rand() % TEXTURE_SETS;
+    unsigned geometry = (unsigned)rand() % VERTEX_ARRAYS;
+    float depth = (float)rand() / (float)RAND_MAX;
+    RenderDraw *draw = RenderQueuePush(queue, RenderKeyMake(0, program, texture_set, geometry, depth));
+    draw->vertex_array = 1 + geometry;
+    draw->mode = GL_TRIANGLES;
+    draw->first = 0;
+    draw->count = 36;
+    draw->index_type = GL_UNSIGNED_INT;
+    draw->model_location = 0;
+  }
+}
+
+static void printStats(const char *label, const RenderQueueStats *stats) {
+  printf("%-8s %zu draws: %zu program, %zu texture, %zu vertex array switches\n", label, stats->draws,
+         stats->program_switches, stats->texture_switches, stats->vertex_array_switches);
+}
+
+int main(int argc, char **argv) {
+  size_t draws = argc > 1 ? (size_t)atol(argv[1]) : 100000;
+  RenderQueue queue;
+  RenderCommandList list;
+  if (!RenderQueueInit(&queue, draws) || !RenderCommandListInit(&list, 4 * draws)) {
+    fprintf(stderr, "bench_render_queue: out of memory\n");
+    return 1;
+  }
+  for (unsigned p = 0; p < PROGRAMS; p++)
+    RenderQueueSetProgram(&queue, p, p + 1, NULL, NULL);
+  for (unsigned t = 1; t <= TEXTURE_SETS; t++) {
+    GLuint textures[2] = {2 * t, 2 * t + 1};
+    RenderQueueSetTextures(&queue, t, GL_TEXTURE_2D, textures, 2);
+  }
+
+  fill(&queue, draws);
+  RenderQueueSubmit(&queue, &list);
+  RenderQueueStats unsorted = queue.last;
+  RenderCommandListReset(&list);
+
+  double fill_time = 0, sort_time = 0, submit_time = 0;
+  for (int r = 0; r < REPEATS; r++) {
+    RenderCommandListReset(&list);
+    double start = ClockNow();
+    fill(&queue, draws);
+    double sorted = ClockNow();
+    RenderQueueSort(&queue);
+    double submitted = ClockNow();
+    RenderQueueSubmit(&queue, &list);
+    double end = ClockNow();
+    fill_time += sorted - start;
+    sort_time += submitted - sorted;
+    submit_time += end - submitted;
+  }
+
+  size_t out_of_order = 0;
+  for (size_t i = 1; i < queue.count; i++)
+    out_of_order += queue.keys[i - 1] > queue.keys[i];
+
+  printStats("unsorted", &unsorted);
+  printStats("sorted", &queue.last);
+  printf("order check: %s, %zu commands recorded\n", out_of_order ? "FAILED" : "ok", list.count);
+  printf("per frame: push %.3f ms, radix sort %.3f ms (%.1f M keys/s), record %.3f ms\n", fill_time / REPEATS * 1e3,
+         sort_time / REPEATS * 1e3, draws * REPEATS / sort_time * 1e-6, submit_time / REPEATS * 1e3);
+
+  RenderCommandListDestroy(&list);
+  RenderQueueDestroy(&queue);
+  return out_of_order ? 1 : 0;
+}
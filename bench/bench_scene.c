@@ -0,0 +1,106 @@
+// Churns a large scene (create, random destroy, refill) while checking that entity ids stay
+// valid, then measures the per-frame sweeps: transform update, serial and on the job system,
+// and visible-slot collection feeding a draw loop.
+//
+// usage: bench_scene [entities]
+#include "clock.h"
+#include "jobs.h"
+#include "scene.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define REPEATS 10
+#define UPDATE_GRAIN 4096
+
+static float randomFloat(float lo, float hi) { return lo + (hi - lo) * ((float)rand() / (float)RAND_MAX); }
+
+static void randomize(Scene *scene, EntityId id) {
+  Quat rotation = QuatNormalize(Vec4Make(randomFloat(-1, 1), randomFloat(-1, 1), randomFloat(-1, 1), 1.0f));
+  SceneSetTransform(scene, id, Vec3Make(randomFloat(-100, 100), randomFloat(-100, 100), randomFloat(-100, 100)),
+                    rotation, Vec3Make(1, 1, 1));
+  SceneSetMesh(scene, id, (MeshHandle)(rand() % 16));
+  SceneSetMaterial(scene, id, (MaterialHandle)(rand() % 8));
+  SceneSetVisibility(scene, id, rand() % 4 != 0 ? VISIBILITY_VISIBLE : 0);
+}
+
+int main(int argc, char **argv) {
+  size_t count = argc > 1 ? (size_t)atol(argv[1]) : 1 << 20;
+  Scene scene;
+  if (!SceneInit(&scene, count)) {
+    fprintf(stderr, "bench_scene: cannot allocate %zu entities\n", count);
+    return 1;
+  }
+  EntityId *ids = malloc(count * sizeof(EntityId));
+  uint32_t *visible = malloc(count * sizeof(uint32_t));
+
+  double start = ClockNow();
+  for (size_t i = 0; i < count; i++)
+    ids[i] = SceneCreateEntity(&scene);
+  double create_time = ClockNow() - start;
+  for (size_t i = 0; i < count; i++)
+    randomize(&scene, ids[i]);
+
+  // Destroy a random tenth, then refill; stale ids must be rejected and survivors keep their data
+  size_t destroyed = 0;
+  start = ClockNow();
+  for (size_t i = 0; i < count / 10; i++) {
+    size_t pick = (size_t)rand() % count;
+    if (SceneDestroyEntity(&scene, ids[pick]))
+      destroyed++;
+  }
+  double destroy_time = ClockNow() - start;
+  size_t stale = 0, errors = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (!SceneAlive(&scene, ids[i])) {
+      stale++;
+      EntityId old = ids[i];
+      ids[i] = SceneCreateEntity(&scene);
+      errors += SceneAlive(&scene, old) || ids[i] == old;
+      randomize(&scene, ids[i]);
+    } else {
+      errors += scene.entity[SceneSlot(&scene, ids[i])] != ids[i];
+    }
+  }
+  errors += stale != destroyed || scene.count != count;
+  printf("scene: %zu entities, create %.1f M/s, destroy %.1f M/s, id check %s\n", count,
+         count / create_time * 1e-6, destroyed / destroy_time * 1e-6, errors ? "FAILED" : "ok");
+
+  start = ClockNow();
+  for (int r = 0; r < REPEATS; r++)
+    SceneUpdateTransforms(&scene);
+  double update_time = ClockNow() - start;
+
+  JobSystem jobs;
+  JobSystemInit(&jobs, 0);
+  start = ClockNow();
+  for (int r = 0; r < REPEATS; r++) {
+    JobCounter done = {0};
+    JobsParallelFor(&jobs, scene.count, UPDATE_GRAIN, SceneUpdateTransformsRange, &scene, &done);
+    JobsWait(&jobs, &done);
+  }
+  double parallel_time = ClockNow() - start;
+  printf("update transforms: serial %.1f M/s, %d workers %.1f M/s\n", count * REPEATS / update_time * 1e-6,
+         jobs.worker_count, count * REPEATS / parallel_time * 1e-6);
+  JobSystemShutdown(&jobs);
+
+  // Stand-in for the render loop: every visible entity's mesh, material and matrix is read
+  size_t drawn = 0;
+  float checksum = 0.0f;
+  start = ClockNow();
+  for (int r = 0; r < REPEATS; r++) {
+    size_t n = SceneCollectVisible(&scene, VISIBILITY_VISIBLE, visible);
+    for (size_t i = 0; i < n; i++) {
+      uint32_t slot = visible[i];
+      checksum += scene.world[slot].m[12] + (float)(scene.mesh[slot] ^ scene.material[slot]);
+    }
+    drawn += n;
+  }
+  double iterate_time = ClockNow() - start;
+  printf("collect + iterate: %.1f M entities/s, %zu visible per frame (checksum %g)\n",
+         count * REPEATS / iterate_time * 1e-6, drawn / REPEATS, checksum);
+
+  SceneDestroy(&scene);
+  free(ids);
+  free(visible);
+  return errors ? 1 : 0;
+}
@@ -0,0 +1,317 @@
+// Checks vecmath.h against plain C reference code, in double precision where it computes
+// the same thing differently, and measures the throughput of the SIMD batch routines. Exits
+// nonzero when any error is over its tolerance.
+//
+// usage: bench_vecmath [count]
+#include "clock.h"
+#include "vecmath.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define REPEATS 20
+#define CHECKS 10000
+
+static int failures;
+
+static void check(const char *name, double error, double tolerance) {
+  bool ok = error <= tolerance;
+  printf("%-17s max error %-12g %s\n", name, error, ok ? "ok" : "FAILED");
+  failures += !ok;
+}
+
+static float randomFloat(float lo, float hi) { return lo + (hi - lo) * ((float)rand() / (float)RAND_MAX); }
+
+static void referenceTransform(const float *m, const float *x, const float *y, const float *z, float *ox, float *oy,
+                               float *oz, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    ox[i] = m[0] * x[i] + m[4] * y[i] + m[8] * z[i] + m[12];
+    oy[i] = m[1] * x[i] + m[5] * y[i] + m[9] * z[i] + m[13];
+    oz[i] = m[2] * x[i] + m[6] * y[i] + m[10] * z[i] + m[14];
+  }
+}
+
+// Rotation matrix via rotating the basis vectors, independent of Mat4FromTRS
+static void referenceCompose(const TransformSoA *t, size_t i, float *out) {
+  Quat q = Vec4Make(t->qx[i], t->qy[i], t->qz[i], t->qw[i]);
+  Vec3 basis[3] = {{t->sx[i], 0, 0}, {0, t->sy[i], 0}, {0, 0, t->sz[i]}};
+  for (int c = 0; c < 3; c++) {
+    Vec3 r = QuatRotate(q, basis[c]);
+    out[c * 4 + 0] = r.x;
+    out[c * 4 + 1] = r.y;
+    out[c * 4 + 2] = r.z;
+    out[c * 4 + 3] = 0.0f;
+  }
+  out[12] = t->px[i];
+  out[13] = t->py[i];
+  out[14] = t->pz[i];
+  out[15] = 1.0f;
+}
+
+static double maxDouble(double a, double b) { return a > b ? a : b; }
+
+static Vec3 randomVec3(float lo, float hi) {
+  return Vec3Make(randomFloat(lo, hi), randomFloat(lo, hi), randomFloat(lo, hi));
+}
+
+static Quat randomQuat(void) {
+  return QuatNormalize(Vec4Make(randomFloat(-1, 1), randomFloat(-1, 1), randomFloat(-1, 1), randomFloat(-1, 1)));
+}
+
+static double distance3(Vec3 a, double x, double y, double z) { return fabs(a.x - x) + fabs(a.y - y) + fabs(a.z - z); }
+
+// Column-major m * v in double
+static void referenceMulVec4(const Mat4 *m, const double v[4], double out[4]) {
+  for (int row = 0; row < 4; row++)
+    out[row] = m->m[row] * v[0] + m->m[4 + row] * v[1] + m->m[8 + row] * v[2] + m->m[12 + row] * v[3];
+}
+
+// General 4x4 inverse by Gauss-Jordan elimination with partial pivoting
+static bool referenceInverse(const Mat4 *m, double out[16]) {
+  double a[4][8];
+  for (int row = 0; row < 4; row++)
+    for (int c = 0; c < 4; c++) {
+      a[row][c] = m->m[c * 4 + row];
+      a[row][4 + c] = row == c;
+    }
+  for (int c = 0; c < 4; c++) {
+    int pivot = c;
+    for (int row = c + 1; row < 4; row++)
+      if (fabs(a[row][c]) > fabs(a[pivot][c]))
+        pivot = row;
+    if (a[pivot][c] == 0.0)
+      return false;
+    for (int k = 0; k < 8; k++) {
+      double tmp = a[c][k];
+      a[c][k] = a[pivot][k];
+      a[pivot][k] = tmp;
+    }
+    double scale = 1.0 / a[c][c];
+    for (int k = 0; k < 8; k++)
+      a[c][k] *= scale;
+    for (int row = 0; row < 4; row++) {
+      if (row == c)
+        continue;
+      double factor = a[row][c];
+      for (int k = 0; k < 8; k++)
+        a[row][k] -= factor * a[c][k];
+    }
+  }
+  for (int row = 0; row < 4; row++)
+    for (int c = 0; c < 4; c++)
+      out[c * 4 + row] = a[row][4 + c];
+  return true;
+}
+
+// Slerp as a * (a^-1 b)^t, through the axis and angle of the relative rotation, in double
+static void referenceSlerp(Quat a, Quat b, double t, double out[4]) {
+  double ax = a.x, ay = a.y, az = a.z, aw = a.w;
+  double bx = b.x, by = b.y, bz = b.z, bw = b.w;
+  if (ax * bx + ay * by + az * bz + aw * bw < 0.0)
+    bx = -bx, by = -by, bz = -bz, bw = -bw;
+  // d = conjugate(a) * b
+  double dx = aw * bx - ax * bw - ay * bz + az * by;
+  double dy = aw * by + ax * bz - ay * bw - az * bx;
+  double dz = aw * bz - ax * by + ay * bx - az * bw;
+  double dw = aw * bw + ax * bx + ay * by + az * bz;
+  double sin_half = sqrt(dx * dx + dy * dy + dz * dz);
+  double half = atan2(sin_half, dw);
+  double px = 0.0, py = 0.0, pz = 0.0, pw = 1.0;
+  if (sin_half > 0.0) {
+    double k = sin(half * t) / sin_half;
+    px = dx * k, py = dy * k, pz = dz * k, pw = cos(half * t);
+  }
+  out[0] = aw * px + ax * pw + ay * pz - az * py;
+  out[1] = aw * py - ax * pz + ay * pw + az * px;
+  out[2] = aw * pz + ax * py - ay * px + az * pw;
+  out[3] = aw * pw - ax * px - ay * py - az * pz;
+}
+
+// The scalar routines the batch code builds on, each against an independent reference
+static void checkScalar(void) {
+  // Perspective: the near and far planes land on NDC depth -1 and 1, and the frustum's
+  // top and right edges on 1
+  double perspective_error = 0.0;
+  for (int i = 0; i < CHECKS; i++) {
+    double fovy = randomFloat(0.2f, 2.5f), aspect = randomFloat(0.5f, 3.0f);
+    double near_plane = randomFloat(0.01f, 1.0f), far_plane = near_plane * randomFloat(10.0f, 1000.0f);
+    Mat4 m = Mat4Perspective((float)fovy, (float)aspect, (float)near_plane, (float)far_plane);
+    double depths[2] = {near_plane, far_plane}, expected[2] = {-1.0, 1.0};
+    for (int k = 0; k < 2; k++) {
+      double d = depths[k], top = d * tan(fovy * 0.5), right = top * aspect;
+      double clip[4];
+      referenceMulVec4(&m, (double[]){right, top, -d, 1.0}, clip);
+      perspective_error = maxDouble(perspective_error, fabs(clip[0] / clip[3] - 1.0));
+      perspective_error = maxDouble(perspective_error, fabs(clip[1] / clip[3] - 1.0));
+      perspective_error = maxDouble(perspective_error, fabs(clip[2] / clip[3] - expected[k]));
+    }
+  }
+  check("perspective", perspective_error, 1e-5);
+
+  // LookAt: a rigid motion putting the eye at the origin, the target down -z and up in the
+  // upper half of the yz plane
+  double look_error = 0.0;
+  for (int i = 0; i < CHECKS; i++) {
+    Vec3 eye = randomVec3(-50, 50), target = randomVec3(-50, 50), up = randomVec3(-1, 1);
+    Vec3 forward = Vec3Sub(target, eye);
+    Vec3 side = Vec3Cross(forward, up);
+    if (Vec3Length(forward) < 1.0f || Vec3Length(side) < 0.1f * Vec3Length(forward) * Vec3Length(up))
+      continue;
+    Mat4 m = Mat4LookAt(eye, target, up);
+    double distance = Vec3Length(forward);
+    look_error = maxDouble(look_error, distance3(Mat4TransformPoint(&m, eye), 0, 0, 0) / distance);
+    look_error = maxDouble(look_error, distance3(Mat4TransformPoint(&m, target), 0, 0, -distance) / distance);
+    Vec3 u = Mat4TransformDirection(&m, up);
+    look_error = maxDouble(look_error, fabs(u.x) / Vec3Length(up) + (u.y < 0.0f));
+    for (int c = 0; c < 3; c++)
+      for (int r = 0; r < 3; r++) {
+        double dot = 0.0;
+        for (int k = 0; k < 3; k++)
+          dot += (double)m.m[c * 4 + k] * m.m[r * 4 + k];
+        look_error = maxDouble(look_error, fabs(dot - (c == r)));
+      }
+  }
+  check("look at", look_error, 1e-4);
+
+  // InverseAffine against a general inverse, relative to the size of each entry
+  double inverse_error = 0.0;
+  for (int i = 0; i < CHECKS; i++) {
+    Mat4 m = Mat4FromTRS(randomVec3(-100, 100), randomQuat(), randomVec3(0.1f, 4));
+    Mat4 inverse = Mat4InverseAffine(&m);
+    double reference[16];
+    if (!referenceInverse(&m, reference))
+      continue;
+    for (int k = 0; k < 16; k++)
+      inverse_error = maxDouble(inverse_error, fabs(inverse.m[k] - reference[k]) / (1.0 + fabs(reference[k])));
+  }
+  check("inverse affine", inverse_error, 1e-4);
+
+  // QuatMul: rotating by a * b is rotating by b, then by a
+  double mul_error = 0.0;
+  for (int i = 0; i < CHECKS; i++) {
+    Quat a = randomQuat(), b = randomQuat();
+    Vec3 v = randomVec3(-10, 10);
+    Vec3 expected = QuatRotate(a, QuatRotate(b, v));
+    Vec3 r = QuatRotate(QuatMul(a, b), v);
+    mul_error = maxDouble(mul_error, distance3(r, expected.x, expected.y, expected.z) / (1.0 + Vec3Length(v)));
+  }
+  check("quat mul", mul_error, 1e-5);
+
+  // Slerp, including pairs close enough for the nlerp fallback; q and -q are the same rotation
+  double slerp_error = 0.0;
+  for (int i = 0; i < CHECKS; i++) {
+    Quat a = randomQuat();
+    Quat b = i % 4 == 0 ? QuatNormalize(Vec4Add(a, Vec4Scale(randomQuat(), 0.02f))) : randomQuat();
+    double t = randomFloat(0, 1), reference[4];
+    referenceSlerp(a, b, t, reference);
+    Quat q = QuatSlerp(a, b, (float)t);
+    double same = 0.0, flipped = 0.0;
+    for (int k = 0; k < 4; k++) {
+      same = maxDouble(same, fabs(q.v[k] - reference[k]));
+      flipped = maxDouble(flipped, fabs(q.v[k] + reference[k]));
+    }
+    slerp_error = maxDouble(slerp_error, same < flipped ? same : flipped);
+  }
+  check("quat slerp", slerp_error, 1e-5);
+}
+
+static const char *backend(void) {
+#if defined(VECMATH_AVX)
+  return "AVX";
+#elif defined(VECMATH_SSE)
+  return "SSE";
+#elif defined(VECMATH_NEON)
+  return "NEON";
+#else
+  return "scalar";
+#endif
+}
+
+int main(int argc, char **argv) {
+  size_t count = argc > 1 ? (size_t)atol(argv[1]) : 1 << 20;
+  printf("vecmath backend: %s, %zu elements\n", backend(), count);
+  checkScalar();
+
+  float *x = calloc(count, sizeof(float)), *y = calloc(count, sizeof(float)), *z = calloc(count, sizeof(float));
+  float *ox = malloc(count * sizeof(float)), *oy = malloc(count * sizeof(float)), *oz = malloc(count * sizeof(float));
+  float *rx = malloc(count * sizeof(float)), *ry = malloc(count * sizeof(float)), *rz = malloc(count * sizeof(float));
+  for (size_t i = 0; i < count; i++) {
+    x[i] = randomFloat(-10, 10);
+    y[i] = randomFloat(-10, 10);
+    z[i] = randomFloat(-10, 10);
+  }
+
+  Mat4 m = Mat4FromTRS(Vec3Make(1, 2, 3), QuatFromAxisAngle(Vec3Make(1, 1, 0), 0.7f), Vec3Make(2, 2, 2));
+  Mat4TransformPointsSoA(&m, x, y, z, ox, oy, oz, count);
+  referenceTransform(m.m, x, y, z, rx, ry, rz, count);
+  float max_error = 0.0f;
+  for (size_t i = 0; i < count; i++) {
+    float e = fabsf(ox[i] - rx[i]) + fabsf(oy[i] - ry[i]) + fabsf(oz[i] - rz[i]);
+    if (e > max_error)
+      max_error = e;
+  }
+
+  check("transform points", max_error, 1e-4);
+
+  double start = ClockNow();
+  for (int r = 0; r < REPEATS; r++)
+    referenceTransform(m.m, x, y, z, rx, ry, rz, count);
+  double reference_time = ClockNow() - start;
+  start = ClockNow();
+  for (int r = 0; r < REPEATS; r++)
+    Mat4TransformPointsSoA(&m, x, y, z, ox, oy, oz, count);
+  double batch_time = ClockNow() - start;
+  printf("transform points: reference %.1f Mpts/s, batch %.1f Mpts/s (%.2fx)\n",
+         count * REPEATS / reference_time * 1e-6, count * REPEATS / batch_time * 1e-6, reference_time / batch_time);
+
+  TransformSoA t;
+  float **fields[] = {&t.px, &t.py, &t.pz, &t.qx, &t.qy, &t.qz, &t.qw, &t.sx, &t.sy, &t.sz};
+  for (size_t f = 0; f < sizeof(fields) / sizeof(fields[0]); f++)
+    *fields[f] = malloc(count * sizeof(float));
+  for (size_t i = 0; i < count; i++) {
+    t.px[i] = randomFloat(-100, 100);
+    t.py[i] = randomFloat(-100, 100);
+    t.pz[i] = randomFloat(-100, 100);
+    Quat q = randomQuat();
+    t.qx[i] = q.x;
+    t.qy[i] = q.y;
+    t.qz[i] = q.z;
+    t.qw[i] = q.w;
+    t.sx[i] = randomFloat(0.1f, 4);
+    t.sy[i] = randomFloat(0.1f, 4);
+    t.sz[i] = randomFloat(0.1f, 4);
+  }
+
+  Mat4 *matrices = aligned_alloc(16, count * sizeof(Mat4));
+  Mat4ComposeSoA(&t, matrices, count);
+  max_error = 0.0f;
+  for (size_t i = 0; i < count; i++) {
+    float reference[16];
+    referenceCompose(&t, i, reference);
+    for (int k = 0; k < 16; k++) {
+      float e = fabsf(matrices[i].m[k] - reference[k]);
+      if (e > max_error)
+        max_error = e;
+    }
+  }
+
+  check("compose TRS", max_error, 1e-5);
+
+  start = ClockNow();
+  for (int r = 0; r < REPEATS; r++)
+    for (size_t i = 0; i < count; i++)
+      matrices[i] = Mat4ComposeOne(&t, i);
+  reference_time = ClockNow() - start;
+  start = ClockNow();
+  for (int r = 0; r < REPEATS; r++)
+    Mat4ComposeSoA(&t, matrices, count);
+  batch_time = ClockNow() - start;
+  printf("compose TRS:      per-object %.1f M/s, batch %.1f M/s (%.2fx)\n",
+         count * REPEATS / reference_time * 1e-6, count * REPEATS / batch_time * 1e-6, reference_time / batch_time);
+
+  for (size_t f = 0; f < sizeof(fields) / sizeof(fields[0]); f++)
+    free(*fields[f]);
+  free(matrices);
+  free(x), free(y), free(z), free(ox), free(oy), free(oz), free(rx), free(ry), free(rz);
+  return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,134 @@
+// Quantizes a large float mesh into compact vertex layouts and reports the size reduction,
+// packing throughput and the worst round-trip error per attribute. Exits nonzero when any
+// component decodes further from its source than its format's rounding allows.
+//
+// usage: bench_vertex_layout [vertices]
+#include "clock.h"
+#include "vertex_layout.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FLOATS_PER_VERTEX 12 // position 3, normal 3, uv 2, color 4
+
+static int failures;
+
+static float randomFloat(float lo, float hi) { return lo + (hi - lo) * ((float)rand() / (float)RAND_MAX); }
+
+// Reads one component back the way GL would
+static float decode(VertexFormat format, const unsigned char *data, int c) {
+  switch (format) {
+  case VERTEX_FORMAT_FLOAT3: {
+    float f;
+    memcpy(&f, data + 4 * c, 4);
+    return f;
+  }
+  case VERTEX_FORMAT_HALF2:
+  case VERTEX_FORMAT_HALF4: {
+    uint16_t h;
+    memcpy(&h, data + 2 * c, 2);
+    return VertexHalfToFloat(h);
+  }
+  case VERTEX_FORMAT_UNORM8X4:
+    return data[c] / 255.0f;
+  case VERTEX_FORMAT_SNORM10_10_10_2: {
+    uint32_t packed;
+    memcpy(&packed, data, 4);
+    int32_t v = (int32_t)(packed << (22 - 10 * c)) >> 22;
+    return fmaxf((float)v / 511.0f, -1.0f);
+  }
+  default:
+    return NAN;
+  }
+}
+
+// Half a step of the format at `value`, since packing rounds to nearest, with some slack for
+// the float arithmetic around it
+static float tolerance(VertexFormat format, float value) {
+  switch (format) {
+  case VERTEX_FORMAT_FLOAT3:
+    return 0.0f;
+  case VERTEX_FORMAT_HALF2:
+  case VERTEX_FORMAT_HALF4:
+    return fabsf(value) * 0x1p-11f + 0x1p-25f; // 11 significant bits, denormal step 2^-24
+  case VERTEX_FORMAT_UNORM8X4:
+    return 0.5f / 255.0f * 1.001f;
+  case VERTEX_FORMAT_SNORM10_10_10_2:
+    return 0.5f / 511.0f * 1.001f;
+  default:
+    return 0.0f;
+  }
+}
+
+static void run(const char *name, const VertexFormat *formats, const float *mesh, size_t count) {
+  VertexLayout layout;
+  VertexLayoutInit(&layout);
+  for (GLuint a = 0; a < 4; a++)
+    VertexLayoutAdd(&layout, a, formats[a]);
+  VertexSource sources[] = {{mesh, 3, FLOATS_PER_VERTEX},
+                            {mesh + 3, 3, FLOATS_PER_VERTEX},
+                            {mesh + 6, 2, FLOATS_PER_VERTEX},
+                            {mesh + 8, 4, FLOATS_PER_VERTEX}};
+  unsigned char *packed = malloc((size_t)layout.stride * count);
+
+  double start = ClockNow();
+  VertexLayoutPack(&layout, sources, count, packed);
+  double elapsed = ClockNow() - start;
+
+  const int components[] = {3, 3, 2, 4};
+  float max_error[4] = {0};
+  size_t over[4] = {0};
+  for (size_t i = 0; i < count; i++) {
+    for (size_t a = 0; a < 4; a++) {
+      const unsigned char *data = packed + i * layout.stride + layout.attributes[a].offset;
+      for (int c = 0; c < components[a]; c++) {
+        float source = sources[a].data[i * FLOATS_PER_VERTEX + c];
+        float error = fabsf(decode(formats[a], data, c) - source);
+        max_error[a] = error > max_error[a] ? error : max_error[a];
+        over[a] += !(error <= tolerance(formats[a], source));
+      }
+    }
+  }
+
+  size_t source_bytes = count * FLOATS_PER_VERTEX * sizeof(float);
+  double ratio = (double)(FLOATS_PER_VERTEX * sizeof(float)) / layout.stride;
+  printf("%-8s %2d bytes/vertex (%.2fx smaller), pack %.1f MB/s of source\n", name, layout.stride, ratio,
+         source_bytes / elapsed * 1e-6);
+  printf("         max error: position %.2g, normal %.2g, uv %.2g, color %.2g\n", max_error[0], max_error[1],
+         max_error[2], max_error[3]);
+  const char *attributes[] = {"position", "normal", "uv", "color"};
+  for (size_t a = 0; a < 4; a++) {
+    if (over[a]) {
+      printf("         FAILED: %zu %s components over the rounding bound\n", over[a], attributes[a]);
+      failures++;
+    }
+  }
+  free(packed);
+}
+
+int main(int argc, char **argv) {
+  size_t count = argc > 1 ? (size_t)atol(argv[1]) : 1 << 20;
+  float *mesh = malloc(count * FLOATS_PER_VERTEX * sizeof(float));
+  for (size_t i = 0; i < count; i++) {
+    float *v = mesh + i * FLOATS_PER_VERTEX;
+    for (int c = 0; c < 3; c++)
+      v[c] = randomFloat(-8, 8);
+    float nx = randomFloat(-1, 1), ny = randomFloat(-1, 1), nz = randomFloat(-1, 1);
+    float length = sqrtf(nx * nx + ny * ny + nz * nz) + 1e-6f;
+    v[3] = nx / length, v[4] = ny / length, v[5] = nz / length;
+    v[6] = randomFloat(0, 1), v[7] = randomFloat(0, 1);
+    for (int c = 8; c < 12; c++)
+      v[c] = randomFloat(0, 1);
+  }
+
+  const VertexFormat compact[] = {VERTEX_FORMAT_FLOAT3, VERTEX_FORMAT_SNORM10_10_10_2, VERTEX_FORMAT_HALF2,
+                                  VERTEX_FORMAT_UNORM8X4};
+  const VertexFormat tight[] = {VERTEX_FORMAT_HALF4, VERTEX_FORMAT_SNORM10_10_10_2, VERTEX_FORMAT_HALF2,
+                                VERTEX_FORMAT_UNORM8X4};
+  printf("%zu vertices, float source %zu bytes/vertex\n", count, FLOATS_PER_VERTEX * sizeof(float));
+  run("compact", compact, mesh, count);
+  run("tight", tight, mesh, count);
+  free(mesh);
+  return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
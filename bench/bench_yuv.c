@@ -0,0 +1,122 @@
+// Checks the RGBA to YUV 4:2:0 conversion against floating-point reference code, measures its
+// throughput, then streams a batch of frames through VideoOutput from the job system, the way
+// CAPTURE_VIDEO does.
+//
+// usage: bench_yuv [width] [height] [frames] [output.y4m | "|command"]
+#include "clock.h"
+#include "jobs.h"
+#include "video_out.h"
+#include "yuv.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define REPEATS 20
+
+static const char *backend(void) {
+#if defined(__SSE2__) || defined(_M_X64)
+  return "SSE2";
+#elif defined(__ARM_NEON)
+  return "NEON";
+#else
+  return "scalar";
+#endif
+}
+
+static int roundByte(double value) { return value < 0.0 ? 0 : value > 255.0 ? 255 : (int)floor(value + 0.5); }
+
+static int referenceDifference(const unsigned char *rgba, const YuvImage *image) {
+  int worst = 0, width = image->width, height = image->height;
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      const unsigned char *p = rgba + ((size_t)y * width + x) * 4;
+      int expected = roundByte(0.299 * p[0] + 0.587 * p[1] + 0.114 * p[2]);
+      int d = abs(expected - image->y[(size_t)y * width + x]);
+      worst = d > worst ? d : worst;
+    }
+  }
+  int chroma_width = YuvChromaWidth(width);
+  for (int cy = 0; cy < YuvChromaHeight(height); cy++) {
+    for (int cx = 0; cx < chroma_width; cx++) {
+      double r = 0.0, g = 0.0, b = 0.0;
+      for (int k = 0; k < 4; k++) {
+        int x = cx * 2 + (k & 1), y = cy * 2 + (k >> 1);
+        x = x < width ? x : width - 1;
+        y = y < height ? y : height - 1;
+        const unsigned char *p = rgba + ((size_t)y * width + x) * 4;
+        r += p[0] * 0.25;
+        g += p[1] * 0.25;
+        b += p[2] * 0.25;
+      }
+      int u = roundByte(128.0 - 0.168736 * r - 0.331264 * g + 0.5 * b);
+      int v = roundByte(128.0 + 0.5 * r - 0.418688 * g - 0.081312 * b);
+      int du = abs(u - image->u[(size_t)cy * chroma_width + cx]);
+      int dv = abs(v - image->v[(size_t)cy * chroma_width + cx]);
+      worst = du > worst ? du : worst;
+      worst = dv > worst ? dv : worst;
+    }
+  }
+  return worst;
+}
+
+typedef struct StreamJob {
+  VideoOutput *video;
+  const unsigned char *rgba;
+  int width, height;
+  size_t sequence;
+} StreamJob;
+
+static void streamJob(void *data) {
+  StreamJob *job = data;
+  VideoOutputSubmit(job->video, job->sequence, job->rgba, job->width, job->height);
+}
+
+int main(int argc, char **argv) {
+  int width = argc > 1 ? atoi(argv[1]) : 1920;
+  int height = argc > 2 ? atoi(argv[2]) : 1080;
+  size_t frames = argc > 3 ? (size_t)atol(argv[3]) : 120;
+  const char *target = argc > 4 ? argv[4] : "/dev/null";
+
+  unsigned char *rgba = malloc((size_t)width * height * 4);
+  unsigned char *planes = malloc(YuvImageSize(width, height));
+  for (size_t i = 0; i < (size_t)width * height * 4; i++)
+    rgba[i] = (unsigned char)rand();
+  YuvImage image;
+  YuvImageInit(&image, planes, width, height);
+  YuvFromRgba(rgba, &image);
+  printf("yuv backend: %s, %dx%d, max difference from the exact conversion %d\n", backend(), width, height,
+         referenceDifference(rgba, &image));
+
+  double start = ClockNow();
+  for (int r = 0; r < REPEATS; r++)
+    YuvFromRgba(rgba, &image);
+  double elapsed = (ClockNow() - start) / REPEATS;
+  printf("convert: %.3f ms per frame, %.1f Mpixel/s\n", 1000.0 * elapsed, (double)width * height / elapsed * 1e-6);
+
+  // Every job converts the same pixels; the stream still has to keep them in order
+  JobSystem jobs;
+  VideoOutput video;
+  if (!JobSystemInit(&jobs, 0) || !VideoOutputOpen(&video, target, 60))
+    return 1;
+  StreamJob *batch = malloc(frames * sizeof(*batch));
+  JobCounter done = {0};
+  start = ClockNow();
+  for (size_t i = 0; i < frames; i++) {
+    // Same bounds as capture: a few conversions in flight, and none past the reorder window
+    if (atomic_load(&done.value) >= VIDEO_REORDER_SIZE / 2 || !VideoOutputAccepts(&video, i))
+      JobsWait(&jobs, &done);
+    batch[i] = (StreamJob){&video, rgba, width, height, i};
+    JobsRun(&jobs, streamJob, &batch[i], &done);
+  }
+  JobsWait(&jobs, &done);
+  elapsed = ClockNow() - start;
+  VideoOutputClose(&video);
+  printf("stream to %s: %zu frames on %d workers in %.1f ms (%.1f frames/s)\n", target, frames, jobs.worker_count,
+         1000.0 * elapsed, (double)frames / elapsed);
+  VideoOutputPrintStats(&video);
+  JobSystemShutdown(&jobs);
+  free(batch);
+  free(planes);
+  free(rgba);
+  return 0;
+}
@@ -0,0 +1,50 @@
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define ANIMATION_DEFAULT_STEP (1.0 / 120.0)
+#define ANIMATION_MAX_STEPS 32 // per advance; after a longer hitch the clock drops time instead of catching up
+#define FRAME_UNIFORM_BINDING 0
+
+// Fixed-timestep clock for animated state. Wall time, scaled and paused as requested, feeds an
+// accumulator that is drained in whole steps, so simulation is independent of the frame rate.
+// Rendering blends the last two simulated states by AnimationClockAlpha, which draws the scene
+// up to a step behind the simulation but never jerks when frames and steps do not line up.
+typedef struct AnimationClock {
+  double step;  // seconds of animation time per simulation step
+  double scale; // animation seconds per wall second
+  bool paused;
+  double last;        // wall time of the previous advance, < 0 before the first
+  double accumulator; // scaled time not simulated yet, under a step after an advance
+  double time;        // animation time of the latest step
+  size_t steps;
+  double dropped; // animation seconds skipped after hitches
+} AnimationClock;
+
+// std140 layout of the `Frame` uniform block, read by every animated material
+typedef struct FrameUniforms {
+  float time[4];         // interpolated animation seconds, step, alpha, scale
+  float breath_color[4]; // shaders/breathing.fragment.glsl
+} FrameUniforms;
+
+void AnimationClockInit(AnimationClock *clock, double step);
+// Moves the clock to wall time `now` and returns how many steps to simulate, each advancing
+// the state to the next multiple of the step; `time` is already at the last of them
+size_t AnimationClockAdvance(AnimationClock *clock, double now);
+// Where rendering falls between the state one step before `time` (0) and the state at `time` (1)
+float AnimationClockAlpha(const AnimationClock *clock);
+// Animation time of the interpolated state that gets rendered
+double AnimationClockRenderTime(const AnimationClock *clock);
+// Pausing stops the clock where it is; the wall time spent paused is never simulated
+void AnimationClockSetPaused(AnimationClock *clock, bool paused);
+void AnimationClockSetScale(AnimationClock *clock, double scale);
+// Fills the block's time row for this frame
+void AnimationClockFrameUniforms(const AnimationClock *clock, FrameUniforms *uniforms);
+void AnimationClockPrintStats(const AnimationClock *clock);
+
+static inline float AnimationLerp(float previous, float current, float alpha) {
+  return previous + (current - previous) * alpha;
+}
+#endif
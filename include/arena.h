@@ -0,0 +1,42 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define ARENA_ALIGNMENT 16
+
+typedef struct ArenaStats {
+  size_t allocations;    // served from the arena
+  size_t heap_fallbacks; // scratch requests that did not fit and went to malloc
+  size_t peak_bytes;     // high-water mark of the arena offset
+  size_t resets;
+} ArenaStats;
+
+// Linear allocator over one up-front block. Individual frees are no-ops except for the most
+// recent allocation, which is rolled back; everything else is released by ArenaReset. Only one
+// allocation is remembered, so after a rollback further frees are no-ops until the next allocation.
+typedef struct Arena {
+  unsigned char *base;
+  size_t capacity;
+  size_t offset;
+  size_t last_offset; // start of the most recent allocation
+  ArenaStats stats;
+} Arena;
+
+bool ArenaInit(Arena *arena, size_t capacity);
+void ArenaDestroy(Arena *arena);
+void *ArenaAlloc(Arena *arena, size_t size);
+void ArenaReset(Arena *arena);
+bool ArenaOwns(const Arena *arena, const void *ptr);
+void ArenaPrintStats(const Arena *arena, const char *name);
+
+// Per-thread scratch allocation. With an arena bound to the calling thread requests are served
+// from it, otherwise (or when it is full) they fall through to the heap. Pointers from another
+// thread's arena may be passed in: realloc copies them out and free leaves them to that arena.
+void ArenaBindThread(Arena *arena);
+Arena *ArenaThreadCurrent(void);
+void *ArenaScratchAlloc(size_t size);
+void *ArenaScratchRealloc(void *ptr, size_t old_size, size_t new_size);
+void ArenaScratchFree(void *ptr);
+#endif
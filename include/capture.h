@@ -0,0 +1,89 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include "jobs.h"
+#include "video_out.h"
+#include <GL/gl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define CAPTURE_RING_SIZE 3   // readbacks the GPU may still be writing while later frames render
+#define CAPTURE_MAX_PENDING 8 // frames copied out but not yet written before the main thread waits
+
+typedef struct RenderCommandList RenderCommandList;
+typedef enum CaptureFormat { CAPTURE_FORMAT_PNG, CAPTURE_FORMAT_QOI } CaptureFormat;
+
+// A pixel pack buffer the GPU copies one frame into, fenced so it is only mapped once done
+typedef struct CaptureSlot {
+  GLuint buffer;
+  GLsizeiptr size;
+  GLsync fence; // 0 when the slot is free
+  GLsizei width, height;
+  size_t frame;
+} CaptureSlot;
+
+// A frame mapped back, rows top to bottom, waiting for a worker to encode it
+typedef struct CaptureFrame {
+  struct Capture *capture;
+  unsigned char *pixels;
+  GLsizei width, height;
+  size_t frame;
+  size_t sequence; // order of dispatch, which the video stream keeps
+  struct CaptureFrame *next;
+} CaptureFrame;
+
+// Writes frames to `<directory>/frame_<n>.png|qoi` without stalling the pipeline. The recording
+// thread marks which frames to grab; the replaying thread reads them back into a ring of pixel
+// pack buffers and maps each one a few frames later, once its fence has passed; the main thread
+// hands the copies to the job system, whose workers encode and write them, or convert them
+// for a video stream.
+typedef struct Capture {
+  char directory[1024];
+  CaptureFormat format;
+  JobSystem *jobs;
+  VideoOutput *video;
+
+  // Recording thread
+  bool every_frame;
+  bool requested; // a single screenshot of the next frame
+  size_t frame;
+
+  // Replaying thread
+  CaptureSlot ring[CAPTURE_RING_SIZE];
+  size_t next_slot;
+  size_t readbacks;
+  size_t stalls; // readbacks that found their slot still in flight and had to wait for it
+
+  // Replaying thread to main thread
+  pthread_mutex_t mutex;
+  CaptureFrame *ready_head, *ready_tail;
+
+  // Main thread and workers
+  bool directory_ready;
+  size_t sequence;
+  JobCounter encoding;
+  atomic_size_t written;
+  atomic_size_t failed;
+  atomic_size_t bytes;
+  size_t waits; // times the main thread let the encoders catch up
+} Capture;
+
+// every_frame captures each frame; otherwise only the ones asked for with CaptureRequest.
+// `directory` is created when the first frame is written.
+bool CaptureInit(Capture *capture, JobSystem *jobs, const char *directory, CaptureFormat format, bool every_frame);
+// Needs the GL context; call after CaptureFinish
+void CaptureDestroy(Capture *capture);
+void CaptureRequest(Capture *capture);
+// Streams the captured frames to `video` instead of writing images; set before the first frame
+void CaptureSetVideo(Capture *capture, VideoOutput *video);
+// Recording side: after the frame's last pass, reads the default framebuffer back if due. The
+// replay starts this frame's copy and hands on every earlier one the GPU has finished.
+void CaptureRecord(Capture *capture, RenderCommandList *list, GLsizei width, GLsizei height);
+// Main thread, once per frame: queues encode jobs for the frames read back so far
+void CaptureDispatch(Capture *capture);
+// Needs the GL context and the main thread: waits for the readbacks in flight and their writes
+void CaptureFinish(Capture *capture);
+void CapturePrintStats(const Capture *capture);
+#endif
@@ -0,0 +1,12 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <time.h>
+
+// Monotonic seconds, for timing code outside the GLFW loop
+static inline double ClockNow(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (double)t.tv_sec + (double)t.tv_nsec * 1e-9;
+}
+#endif
@@ -0,0 +1,52 @@
+#ifndef CULLING_H
+#define CULLING_H
+
+#include "scene.h"
+#include "vecmath.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define CULL_DEPTH_WIDTH 256
+#define CULL_DEPTH_HEIGHT 128
+
+typedef struct CullStats {
+  size_t tested;
+  size_t frustum_culled;
+  size_t occlusion_culled;
+  size_t visible;
+} CullStats;
+
+// World-space bounding spheres of every scene slot, kept as SoA so the frustum test runs
+// 8 (AVX) or 4 (SSE/NEON) objects per instruction. The result is a compact list of visible
+// slots in ascending order.
+typedef struct Culler {
+  size_t capacity;
+  float *cx, *cy, *cz, *radius;
+  uint32_t *visible;
+  size_t visible_count;
+
+  Vec4 planes[6]; // xyz normal pointing inside, w distance; normalized
+  Mat4 view;
+  Mat4 projection;
+  bool occlusion; // only meaningful with a perspective projection
+  float *depth;   // CULL_DEPTH_WIDTH x CULL_DEPTH_HEIGHT view-space depths, nearest occluder per texel
+
+  CullStats last;
+  CullStats total;
+  size_t frames;
+  const char *backend;
+} Culler;
+
+bool CullerInit(Culler *culler, size_t capacity, bool occlusion);
+void CullerDestroy(Culler *culler);
+void CullerSetCamera(Culler *culler, const Mat4 *view, const Mat4 *projection);
+// Frustum planes of a view-projection matrix, normals pointing inside, normalized
+void CullExtractPlanes(const Mat4 *view_projection, Vec4 planes[6]);
+
+// mesh_spheres holds each mesh's local bounding sphere (xyz centre, w radius), indexed by MeshHandle
+void CullerUpdateBounds(Culler *culler, const Scene *scene, const Vec4 *mesh_spheres);
+// Culls every slot whose visibility shares a bit with `mask` and fills culler->visible
+size_t CullerRun(Culler *culler, const Scene *scene, uint32_t mask);
+void CullerPrintStats(const Culler *culler);
+#endif
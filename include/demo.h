@@ -0,0 +1,127 @@
+#ifndef DEMO_H
+#define DEMO_H
+
+#include "animation.h"
+#include "arena.h"
+#include "culling.h"
+#include "jobs.h"
+#include "mesh.h"
+#include "pack.h"
+#include "particles.h"
+#include "post_process.h"
+#include "render_graph.h"
+#include "render_queue.h"
+#include "render_target.h"
+#include "scene.h"
+#include "texture_atlas.h"
+#include "uniform_ring.h"
+#include "uploader.h"
+#include <GL/gl.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define DEMO_DEFAULT_POST_CHAIN "none" // the scene as drawn; post-processing is opt-in
+
+typedef enum DemoMeshId { DEMO_MESH_TRIANGLE, DEMO_MESH_RECTANGLE, DEMO_MESH_COUNT } DemoMeshId;
+typedef enum DemoMaterialId {
+  DEMO_MATERIAL_VERTEX_COLOR,
+  DEMO_MATERIAL_TEXTURED,
+  DEMO_MATERIAL_BREATHING,
+  DEMO_MATERIAL_COUNT
+} DemoMaterialId;
+typedef enum DemoTextureSetId { DEMO_TEXTURE_SET_NONE, DEMO_TEXTURE_SET_CONTAINER } DemoTextureSetId;
+
+// Index ranges of every level of detail in the mesh's element buffer
+typedef struct DemoMeshDraw {
+  GLuint vertex_array;
+  bool indexed;
+  uint32_t lod_count;
+  GLint first[MESH_MAX_LODS];
+  GLsizei count[MESH_MAX_LODS];
+  float error[MESH_MAX_LODS]; // object-space simplification error
+} DemoMeshDraw;
+
+typedef struct DemoMaterial {
+  GLuint program;
+  GLint modelLocation;
+  DemoTextureSetId textureSet;
+} DemoMaterial;
+
+// Decodes into its own arena so several images can be in flight on different workers
+typedef struct DemoImage {
+  const char *path;
+  const Pack *assets;
+  Arena arena;
+  unsigned char *pixels;
+  int width, height, channels;
+} DemoImage;
+
+// The application's scene: a triangle and a textured rectangle placed in clip space, drawn
+// through the render queue into a render graph that ends in the post-process chain. Whoever
+// owns the window feeds it wall time and input; everything GL is recorded into command lists.
+typedef struct Demo {
+  const Pack *assets; // NULL reads loose files relative to the working directory
+  GLuint fShader;
+  GLuint tShader;
+  GLuint bShader;
+  GLint atlasLocation;
+  GLint uvRect0Location;
+  GLint uvRect1Location;
+  GLint layer0Location;
+  GLint layer1Location;
+  GLint mixAmountLocation;
+  GLuint VAO_rect;
+  GLuint VAO_tri;
+  GLuint buffers[4]; // vertices and indices of the rectangle, then the triangle
+  TextureAtlas atlas;
+  DemoImage images[2];
+  UploadRequest texture0;
+  UploadRequest texture1;
+  UploadRequest texture_mips;
+  AtlasRegion region0;
+  AtlasRegion region1;
+  bool textures_synced;
+  DemoMeshDraw meshes[DEMO_MESH_COUNT];
+  Vec4 mesh_bounds[DEMO_MESH_COUNT]; // local bounding spheres for culling
+  DemoMaterial materials[DEMO_MATERIAL_COUNT];
+  Scene entities;
+  EntityId triangle;
+  EntityId rectangle;
+  Culler culler;
+  float lod_pixel_error;
+  RenderQueue queue;
+  RenderTargetPool targets;
+  RenderGraph graph;
+  PostChain post;
+  AnimationClock clock;
+  float breath_previous, breath_current; // green channel of the breathing material, one step apart
+  UniformRing frame_uniforms;
+  float animation_dt; // animation seconds simulated this frame
+  ParticleSystem particles; // capacity 0 unless started
+
+  // Set by input
+  GLenum polygon_mode;
+  float texture_mix;
+} Demo;
+
+// Needs the GL context. Loads meshes and shaders and queues the textures on `uploader`, decoding
+// the images on `jobs`; the first frames skip the textured material until the uploads are done.
+// The rectangle starts out visible and the triangle hidden. `occlusion` enables the culler's
+// depth pass.
+bool DemoLoad(Demo *demo, const Pack *assets, Uploader *uploader, JobSystem *jobs, bool occlusion);
+// Needs the GL context
+void DemoDestroy(Demo *demo);
+// Needs the GL context. `passes` lists them in order, e.g. "tonemap,fxaa,blur"; "none" draws
+// straight to the backbuffer. False if a shader does not compile; unknown passes are skipped.
+bool DemoBuildPostChain(Demo *demo, const char *passes);
+// Needs the GL context. A fountain of `capacity` particles, emitted as fast as they die.
+bool DemoStartParticles(Demo *demo, size_t capacity, ParticleBackend backend, JobSystem *jobs);
+// Moves the animation clock to wall time `now`, simulates the steps that brings and updates
+// the transforms
+void DemoUpdate(Demo *demo, double now);
+void DemoCull(Demo *demo);
+// Records the frame, declaring the graph from scratch; it is only recompiled when its shape
+// changes, e.g. with a new size. False when there is nothing to draw into.
+bool DemoRecordFrame(Demo *demo, RenderCommandList *list, GLsizei width, GLsizei height);
+void DemoPrintStats(const Demo *demo);
+#endif
@@ -0,0 +1,34 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define FRAME_MAX_STAGES 16
+
+typedef void (*FrameStageFn)(void *user);
+
+typedef struct FrameStage {
+  const char *name;
+  FrameStageFn run;
+  void *user;
+  double last_time;
+  double total_time;
+  double max_time;
+} FrameStage;
+
+// Ordered list of per-frame stages, run front to back once per FrameLoopRunFrame.
+typedef struct FrameLoop {
+  FrameStage stages[FRAME_MAX_STAGES];
+  size_t stage_count;
+  size_t frames;
+} FrameLoop;
+
+void FrameLoopInit(FrameLoop *loop);
+bool FrameLoopAddStage(FrameLoop *loop, const char *name, FrameStageFn run, void *user);
+// Inserts before the stage called `before`, or appends when there is none.
+bool FrameLoopInsertStage(FrameLoop *loop, const char *before, const char *name, FrameStageFn run, void *user);
+bool FrameLoopRemoveStage(FrameLoop *loop, const char *name);
+void FrameLoopRunFrame(FrameLoop *loop);
+void FrameLoopPrintTimings(const FrameLoop *loop);
+#endif
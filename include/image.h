@@ -1,2 +1,5 @@
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
\ No newline at end of file
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include "stb_image.h"
+#endif
\ No newline at end of file
@@ -0,0 +1,23 @@
+#ifndef IMAGE_DIFF_H
+#define IMAGE_DIFF_H
+
+#include <stddef.h>
+
+#define IMAGE_DIFF_DEFAULT_THRESHOLD 0.1f
+
+typedef struct ImageDiffStats {
+  size_t pixels;
+  size_t differing;     // pixels whose perceptual difference is above the threshold
+  unsigned max_channel; // largest absolute difference of any channel, 0..255
+  double mean_error;    // perceptual difference averaged over every pixel, 0..1
+  float max_error;
+} ImageDiffStats;
+
+// Perceptual difference of two RGBA pixels, 0..1: the weighted YIQ distance of Kotsarenko and
+// Ramos ("Measuring perceived color difference using YIQ NTSC transmission color space in
+// mobile applications"), as used by pixelmatch. Alpha is ignored; frames are opaque.
+float ImageDiffPixel(const unsigned char *a, const unsigned char *b);
+// Compares two RGBA images four pixels at a time (SSE or NEON through vecmath.h's detection)
+void ImageDiff(const unsigned char *a, const unsigned char *b, size_t pixel_count, float threshold,
+               ImageDiffStats *stats);
+#endif
@@ -0,0 +1,17 @@
+#ifndef IMAGE_WRITE_H
+#define IMAGE_WRITE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Encoders for 8-bit RGBA images, rows top to bottom. The result is malloc'ed; the size is
+// 0 when allocation fails.
+size_t ImageEncodeQoi(const unsigned char *rgba, int width, int height, unsigned char **encoded);
+// Deflated with zlib when built with it (HAVE_ZLIB), stored uncompressed otherwise
+size_t ImageEncodePng(const unsigned char *rgba, int width, int height, unsigned char **encoded);
+
+// Fails on an empty buffer, so an encoder's result can be passed straight through
+bool ImageWriteFile(const char *path, const void *data, size_t size);
+bool ImageWriteQoi(const char *path, const unsigned char *rgba, int width, int height);
+bool ImageWritePng(const char *path, const unsigned char *rgba, int width, int height);
+#endif
@@ -0,0 +1,83 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define JOBS_MAX_WORKERS 64
+#define JOBS_QUEUE_SIZE 4096 // per worker, power of two
+
+typedef void (*JobFn)(void *data);
+typedef void (*JobRangeFn)(void *data, size_t begin, size_t end);
+
+// Number of jobs still outstanding; zero means everything tracked by it has finished.
+typedef struct JobCounter {
+  atomic_int value;
+} JobCounter;
+
+typedef struct Job {
+  JobFn fn;
+  JobRangeFn range_fn; // used instead of fn for JobsParallelFor chunks
+  size_t begin, end;
+  void *data;
+  JobCounter *counter;    // decremented when the job finishes, may be NULL
+  JobCounter *dependency; // job is held off the queues until this reaches zero, may be NULL
+} Job;
+
+// A job waiting for its dependency, in the system's waiting list
+typedef struct JobWaiter {
+  Job job;
+  struct JobWaiter *next;
+} JobWaiter;
+
+// Chase-Lev work-stealing deque. The owning worker pushes and pops at the bottom,
+// every other worker steals from the top. Jobs are stored in the slot they occupy, so a slot
+// is only rewritten once the job in it has been taken.
+typedef struct JobDeque {
+  atomic_llong top;
+  atomic_llong bottom;
+  Job slots[JOBS_QUEUE_SIZE];
+} JobDeque;
+
+typedef struct JobSystem JobSystem;
+
+typedef struct JobWorker {
+  JobDeque deque;
+  JobSystem *system;
+  unsigned steal_seed;
+  size_t executed;
+  size_t stolen;
+} JobWorker;
+
+struct JobSystem {
+  int worker_count; // including the thread that called JobSystemInit (worker 0)
+  JobWorker *workers;
+  pthread_t threads[JOBS_MAX_WORKERS];
+  atomic_int queued;
+  atomic_int sleeping;
+  atomic_bool quit;
+  pthread_mutex_t mutex;
+  pthread_cond_t wake;
+  pthread_mutex_t waiting_mutex;
+  JobWaiter *waiting;       // JobsRunAfter jobs whose dependency has not reached zero yet
+  atomic_int waiting_count; // checked by every counter that reaches zero
+};
+
+// worker_count <= 0 uses one worker per online CPU. The calling thread becomes worker 0 and
+// runs jobs while it waits in JobsWait. Jobs may only be submitted from worker threads.
+bool JobSystemInit(JobSystem *jobs, int worker_count);
+void JobSystemShutdown(JobSystem *jobs);
+int JobsWorkerIndex(void);
+
+void JobsRun(JobSystem *jobs, JobFn fn, void *data, JobCounter *counter);
+// Like JobsRun, but the job is not queued before `dependency` drops to zero. `dependency` must
+// stay valid until then.
+void JobsRunAfter(JobSystem *jobs, JobCounter *dependency, JobFn fn, void *data, JobCounter *counter);
+// Splits [0, count) into chunks of `grain` and calls fn(data, begin, end) for each as a job.
+void JobsParallelFor(JobSystem *jobs, size_t count, size_t grain, JobRangeFn fn, void *data, JobCounter *counter);
+// Runs queued jobs on the calling worker until `counter` reaches zero.
+void JobsWait(JobSystem *jobs, JobCounter *counter);
+void JobSystemPrintStats(const JobSystem *jobs);
+#endif
@@ -0,0 +1,27 @@
+#ifndef LOD_H
+#define LOD_H
+
+#include "vecmath.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define LOD_DEFAULT_PIXEL_ERROR 1.0f
+
+// Picks levels of detail by projecting their object-space simplification error to pixels, so
+// levels switch where the difference stays under `pixel_error` regardless of camera or scale.
+typedef struct LodSelector {
+  Mat4 view_projection;
+  float pixels_per_unit; // at clip w = 1
+  float near_w;          // clip w on the near plane, the closest a visible point gets
+  float pixel_error;
+} LodSelector;
+
+void LodSelectorInit(LodSelector *selector, const Mat4 *view, const Mat4 *projection, int viewport_height,
+                     float pixel_error);
+// Pixels covered by `error` object-space units at the point of the bounding sphere (local
+// `center`, `radius`) of an object at `world` nearest the eye, where they cover the most
+float LodProjectedError(const LodSelector *selector, const Mat4 *world, Vec3 center, float radius, float error);
+// Coarsest level whose projected error is within tolerance; errors ascend with the level
+uint32_t LodSelect(const LodSelector *selector, const Mat4 *world, Vec3 center, float radius, const float *errors,
+                   uint32_t lod_count);
+#endif
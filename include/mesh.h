@@ -0,0 +1,76 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MESH_CACHE_SIZE 32      // LRU post-transform cache the vertex cache optimizer targets
+#define MESH_ACMR_CACHE_SIZE 16 // FIFO cache used when reporting ACMR
+#define MESH_MAX_LODS 8
+#define MESH_LOD_MIN_TRIANGLES 16
+
+// Indexed triangle list with separate float attribute arrays; absent attributes are NULL
+typedef struct Mesh {
+  float *positions; // xyz
+  float *normals;   // xyz
+  float *uvs;       // uv
+  float *colors;    // rgb
+  uint32_t *indices;
+  size_t vertex_count;
+  size_t index_count;
+} Mesh;
+
+// Progressively coarser index buffers over the same vertices, back to back. Level 0 is the
+// source; errors are object-space distances and never decrease along the chain.
+typedef struct MeshLodChain {
+  uint32_t *indices;
+  size_t index_count;
+  size_t offsets[MESH_MAX_LODS];
+  size_t counts[MESH_MAX_LODS];
+  float errors[MESH_MAX_LODS];
+  size_t lod_count;
+} MeshLodChain;
+
+typedef enum MeshResult { MESH_SUCCESS, MESH_FAILED_OPEN, MESH_FAILED_FORMAT, MESH_FAILED_MEMORY } MeshResult;
+
+typedef struct MeshImportStats {
+  size_t bytes;
+  size_t corners; // vertices referenced by the source before welding
+  double parse_time;
+  double optimize_time;
+  double acmr_before;
+  double acmr_after;
+} MeshImportStats;
+
+// Parses Wavefront OBJ (v [r g b], vt, vn, f with polygons fanned into triangles) or binary
+// glTF 2.0 (every triangle primitive of every mesh, node transforms ignored), picked by the
+// extension of `name`. The result is welded and reordered for the vertex cache and for fetch.
+MeshResult MeshImport(const char *name, const void *data, size_t size, Mesh *mesh, MeshImportStats *stats);
+// Same, reading the file through a private mapping
+MeshResult MeshImportFile(const char *path, Mesh *mesh, MeshImportStats *stats);
+void MeshFree(Mesh *mesh);
+
+// Merges vertices whose attributes are bit-identical
+bool MeshWeld(Mesh *mesh);
+// Forsyth's linear-speed vertex cache optimization; reorders triangles only
+bool MeshOptimizeVertexCache(uint32_t *indices, size_t index_count, size_t vertex_count);
+// Renumbers vertices in order of first use and drops unreferenced ones
+bool MeshOptimizeVertexFetch(Mesh *mesh);
+// Average cache misses per triangle for a FIFO cache of `cache_size` entries
+double MeshAcmr(const uint32_t *indices, size_t index_count, size_t vertex_count, unsigned cache_size);
+
+// Quadric error edge collapse of `indices` into `destination` (room for index_count), until
+// target_index_count is reached or the next collapse would move the surface further than
+// target_error, relative to the mesh extent. Borders, non-manifold edges and attribute seams
+// stay fixed; attribute differences add to the collapse cost. Returns the new index count and
+// the object-space error reached.
+size_t MeshSimplify(const Mesh *mesh, const uint32_t *indices, size_t index_count, uint32_t *destination,
+                    size_t target_index_count, float target_error, float *result_error);
+// Largest axis of the bounding box
+float MeshExtent(const Mesh *mesh);
+// Halves the triangle count per level until the simplifier stalls or max_lods is reached
+bool MeshBuildLods(const Mesh *mesh, size_t max_lods, MeshLodChain *chain);
+void MeshLodChainFree(MeshLodChain *chain);
+void MeshPrintStats(const char *name, const Mesh *mesh, const MeshImportStats *stats);
+#endif
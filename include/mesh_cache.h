@@ -0,0 +1,115 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include "mesh.h"
+#include "vertex_layout.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Binary mesh container, ready for the GPU. Layout on disk:
+//   MeshCacheHeader | MeshCacheSubmesh[submesh_count] | MeshCacheLod[lod_count] | vertex streams |
+//   uint32 indices
+// The index buffer holds every level of detail back to back; submesh ranges refer to level 0.
+// Each vertex stream is interleaved with its own layout, so a mesh can be stored fully
+// interleaved or split (e.g. positions apart for depth-only passes). Payloads start on a
+// MESH_CACHE_ALIGNMENT boundary and go to glBufferData straight from the mapping.
+#define MESH_CACHE_MAGIC 0x4853454du // "MESH"
+#define MESH_CACHE_VERSION 2u
+#define MESH_CACHE_ALIGNMENT 64u
+#define MESH_CACHE_MAX_STREAMS 4
+
+typedef struct MeshCacheAttribute {
+  uint16_t location;
+  uint16_t format; // VertexFormat
+} MeshCacheAttribute;
+
+typedef struct MeshCacheStream {
+  uint64_t offset;
+  uint64_t size;
+  uint32_t stride;
+  uint32_t attribute_count;
+  MeshCacheAttribute attributes[VERTEX_MAX_ATTRIBUTES];
+} MeshCacheStream;
+
+typedef struct MeshCacheSubmesh {
+  uint32_t index_offset;
+  uint32_t index_count;
+  float sphere[4]; // xyz center, radius
+} MeshCacheSubmesh;
+
+typedef struct MeshCacheLod {
+  uint32_t index_offset;
+  uint32_t index_count;
+  float error; // object-space distance from the source surface
+  uint32_t reserved;
+} MeshCacheLod;
+
+typedef struct MeshCacheHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t source_hash; // MeshCacheHash of the asset the cache was built from
+  uint64_t checksum;    // MeshCacheHash of the header (this field zeroed), submesh and LOD tables
+  uint64_t file_size;
+  uint32_t vertex_count;
+  uint32_t index_count; // all levels
+  uint32_t stream_count;
+  uint32_t submesh_count;
+  uint32_t lod_count;
+  uint32_t reserved;
+  uint64_t index_offset;
+  float bounds_min[3];
+  float bounds_max[3];
+  float sphere[4];
+  MeshCacheStream streams[MESH_CACHE_MAX_STREAMS];
+} MeshCacheHeader;
+
+typedef enum MeshCacheResult {
+  MESH_CACHE_SUCCESS,
+  MESH_CACHE_FAILED_OPEN,
+  MESH_CACHE_FAILED_FORMAT,
+  MESH_CACHE_FAILED_STALE,
+  MESH_CACHE_FAILED_WRITE
+} MeshCacheResult;
+
+// A validated cache, in its own mapping, built in memory, or borrowed from an asset pack
+typedef struct MeshCache {
+  const unsigned char *base;
+  size_t size;
+  bool mapped;
+  bool owned;
+  const MeshCacheHeader *header;
+  const MeshCacheSubmesh *submeshes;
+  const MeshCacheLod *lods;
+  const uint32_t *indices;
+} MeshCache;
+
+// One interleaved stream to write: float sources in layout order, as for VertexLayoutPack
+typedef struct MeshCacheStreamDesc {
+  const VertexLayout *layout;
+  const VertexSource *sources;
+} MeshCacheStreamDesc;
+
+// 64-bit content hash, reading 8 bytes per step
+uint64_t MeshCacheHash(const void *data, size_t size);
+
+// Quantizes `mesh` into the given streams and lays out the container in memory. NULL
+// submeshes stores a single range over every index; NULL lods stores the mesh indices alone.
+MeshCacheResult MeshCacheBuild(uint64_t source_hash, const Mesh *mesh, const MeshCacheStreamDesc *streams,
+                               size_t stream_count, const MeshCacheSubmesh *submeshes, size_t submesh_count,
+                               const MeshLodChain *lods, MeshCache *cache);
+// Replaces `path` atomically
+MeshCacheResult MeshCacheWrite(const char *path, const MeshCache *cache);
+
+// Maps a cache file. Stale is reported when `source_hash` or the stream layouts do not match
+// what the caller would build today; pass a NULL layout array to skip the layout check.
+MeshCacheResult MeshCacheOpen(const char *path, uint64_t source_hash, const VertexLayout *layouts,
+                              size_t layout_count, MeshCache *cache);
+// Same checks over memory the caller keeps alive, such as an uncompressed pack entry
+MeshCacheResult MeshCacheView(const void *data, size_t size, uint64_t source_hash, const VertexLayout *layouts,
+                              size_t layout_count, MeshCache *cache);
+void MeshCacheClose(MeshCache *cache);
+
+const void *MeshCacheStreamData(const MeshCache *cache, size_t stream);
+void MeshCacheStreamLayout(const MeshCache *cache, size_t stream, VertexLayout *layout);
+#endif
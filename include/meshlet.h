@@ -0,0 +1,98 @@
+#ifndef MESHLET_H
+#define MESHLET_H
+
+#include "jobs.h"
+#include "mesh.h"
+#include "render_commands.h"
+#include "vecmath.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+#define MESHLET_CULL_GRAIN 256 // meshlets per culling job
+
+// A cluster of triangles that is culled as a unit. Its triangles are a contiguous range of
+// MeshletSet.indices, which still refer to the mesh vertices, so every meshlet can be drawn
+// straight from the mesh's own vertex and index buffers.
+typedef struct Meshlet {
+  uint32_t index_offset;
+  uint32_t triangle_count;
+  uint32_t vertex_count; // distinct vertices referenced
+  float center[3];
+  float radius;
+  float cone_axis[3]; // average face normal
+  float cone_cutoff;  // sin of the normal cone's half angle; 1 when the cluster can never face away
+} Meshlet;
+
+typedef struct MeshletSet {
+  Meshlet *meshlets;
+  size_t count;
+  uint32_t *indices;
+  size_t index_count;
+} MeshletSet;
+
+// Same layout as GL's DrawElementsIndirectCommand
+typedef struct MeshletDrawCommand {
+  uint32_t count;
+  uint32_t instance_count;
+  uint32_t first_index;
+  int32_t base_vertex;
+  uint32_t base_instance; // index into the instance array passed to MeshletCull
+} MeshletDrawCommand;
+
+typedef struct MeshletCullStats {
+  size_t tested;
+  size_t frustum_culled;
+  size_t backface_culled;
+  size_t visible;
+} MeshletCullStats;
+
+typedef struct MeshletInstance {
+  Mat4 world;
+  float scale;  // largest axis scale
+  bool similar; // rotation and uniform scale only, so normal cones survive the transform
+} MeshletInstance;
+
+// Culls every meshlet of every instance against the frustum and its normal cone, across the job
+// system, and compacts the survivors into an indirect draw list. Runs of visible meshlets that
+// are adjacent in the index buffer are merged into one command.
+typedef struct MeshletCuller {
+  Vec4 planes[6];
+  Vec3 eye;
+
+  MeshletInstance *instances;
+  size_t instance_capacity;
+  MeshletDrawCommand *scratch; // one slot per tested meshlet, compacted per job
+  size_t scratch_capacity;
+  uint32_t *chunk_counts;
+  size_t chunk_capacity;
+
+  MeshletDrawCommand *commands;
+  size_t command_count;
+
+  atomic_size_t frustum_culled;
+  atomic_size_t backface_culled;
+  MeshletCullStats last;
+} MeshletCuller;
+
+// Splits the triangles of `indices` into meshlets in their current order, so the input should
+// already be optimized for the vertex cache
+bool MeshletBuild(const Mesh *mesh, const uint32_t *indices, size_t index_count, MeshletSet *set);
+void MeshletSetFree(MeshletSet *set);
+
+void MeshletCullerInit(MeshletCuller *culler);
+void MeshletCullerDestroy(MeshletCuller *culler);
+void MeshletCullerSetCamera(MeshletCuller *culler, const Mat4 *view, const Mat4 *projection);
+// Returns the number of draw commands in culler->commands
+size_t MeshletCull(MeshletCuller *culler, JobSystem *jobs, const MeshletSet *set, const Mat4 *worlds,
+                   size_t instance_count);
+
+// GL 3.3 has no indirect draws: replays the list as one glDrawElements per command, setting
+// `model_location` whenever the instance changes. Indices must be uint32 in the bound buffer.
+void MeshletRecordDraws(const MeshletCuller *culler, const Mat4 *worlds, GLint model_location,
+                        RenderCommandList *list);
+void MeshletPrintStats(const MeshletSet *set);
+#endif
@@ -0,0 +1,42 @@
+#ifndef PACING_H
+#define PACING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SWAP_INTERVAL_ADAPTIVE -1
+
+typedef struct FramePacerConfig {
+  int swap_interval;     // 0 = off, 1 = vsync, SWAP_INTERVAL_ADAPTIVE = tear when late
+  double target_fps;     // software limiter, 0 disables it
+  double spin_threshold; // seconds before the deadline where sleeping stops and spinning starts
+} FramePacerConfig;
+
+typedef struct FramePacer {
+  FramePacerConfig config;
+  int applied_swap_interval;
+  double next_deadline;
+  double pending_input; // oldest input not yet seen by a frame, < 0 if none
+  size_t frames;
+  size_t latency_samples;
+  double latency_total;
+  double latency_max;
+} FramePacer;
+
+// Reads FRAME_SWAP_INTERVAL and FRAME_TARGET_FPS, defaulting to vsync without a limiter.
+FramePacerConfig FramePacerConfigFromEnv(void);
+
+// Requires a current GL context. Returns the swap interval actually applied.
+int FramePacerInit(FramePacer *pacer, FramePacerConfig config);
+int FramePacerSetSwapInterval(FramePacer *pacer, int interval);
+
+// Latency is measured from FramePacerMarkInput to the present of the first frame begun after the
+// input, i.e. the first frame that can show its effect. FramePacerBeginFrame hands out that input's
+// timestamp, which travels with the frame to FramePacerPresented, so the two halves may run on
+// different threads.
+void FramePacerMarkInput(FramePacer *pacer);
+double FramePacerBeginFrame(FramePacer *pacer);
+void FramePacerLimit(FramePacer *pacer);
+void FramePacerPresented(FramePacer *pacer, double input_time);
+void FramePacerPrintStats(const FramePacer *pacer);
+#endif
@@ -0,0 +1,68 @@
+#ifndef PACK_H
+#define PACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Single-file asset archive. Layout on disk:
+//   PackHeader | PackTocEntry[entry_count] (sorted by hash) | path strings | payloads
+// Uncompressed payloads start on a PACK_PAYLOAD_ALIGNMENT boundary so they can be used
+// straight out of the mapping.
+#define PACK_MAGIC 0x4b434150u // "PACK"
+#define PACK_VERSION 1u
+#define PACK_PAYLOAD_ALIGNMENT 4096u
+#define PACK_COMPRESSED_ALIGNMENT 16u
+
+typedef enum PackCodec { PACK_CODEC_NONE, PACK_CODEC_LZ4, PACK_CODEC_ZSTD } PackCodec;
+
+typedef struct PackHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t entry_count;
+  uint32_t reserved;
+  uint64_t toc_offset;
+  uint64_t names_offset;
+  uint64_t names_size;
+  uint64_t file_size;
+} PackHeader;
+
+typedef struct PackTocEntry {
+  uint64_t hash;
+  uint64_t offset;
+  uint64_t size;        // decompressed size
+  uint64_t stored_size; // size in the archive
+  uint32_t codec;
+  uint32_t name_offset; // into the path string table, NUL terminated
+} PackTocEntry;
+
+typedef enum PackResult {
+  PACK_SUCCESS,
+  PACK_FAILED_OPEN,
+  PACK_FAILED_FORMAT,
+  PACK_FAILED_NOT_FOUND,
+  PACK_FAILED_CODEC
+} PackResult;
+
+typedef struct Pack {
+  const unsigned char *base;
+  size_t size;
+  const PackHeader *header;
+  const PackTocEntry *toc;
+  const char *names;
+} Pack;
+
+typedef struct PackEntry {
+  const void *data; // points into the mapping, compressed if codec != PACK_CODEC_NONE
+  uint64_t size;
+  uint64_t stored_size;
+  PackCodec codec;
+} PackEntry;
+
+uint64_t PackHashPath(const char *path);
+int PackCodecAvailable(PackCodec codec);
+
+PackResult PackOpen(const char *path, Pack *pack);
+void PackClose(Pack *pack);
+PackResult PackFind(const Pack *pack, const char *path, PackEntry *entry);
+PackResult PackDecompress(const PackEntry *entry, void *dst, size_t dst_size);
+#endif
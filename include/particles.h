@@ -0,0 +1,113 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include "jobs.h"
+#include "vecmath.h"
+#include <GL/gl.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define PARTICLE_EMIT_FRAMES 3  // emission batches: one recording, one replaying, one spare
+#define PARTICLE_MAX_EMIT 16384 // particles one system emits per frame at most; the rest are dropped
+#define PARTICLE_CPU_GRAIN 16384 // particles per job of the CPU backend
+
+typedef struct RenderCommandList RenderCommandList;
+
+// Where particles are simulated; both draw the same sprites with the same program
+typedef enum ParticleBackend { PARTICLE_BACKEND_GPU, PARTICLE_BACKEND_CPU } ParticleBackend;
+
+// One particle as stored in the state buffers, two vec4 attributes
+typedef struct Particle {
+  float position[3];
+  float life; // seconds left, dead at 0
+  float velocity[3];
+  float lifetime; // seconds it was emitted with, for fading
+} Particle;
+
+// What the CPU backend uploads for a live particle: a vec4 of position and life left as a
+// fraction of its lifetime
+typedef struct ParticleSprite {
+  float position[3];
+  float fade;
+} ParticleSprite;
+
+// The CPU backend's state, one array per component
+typedef struct ParticleSoA {
+  float *x, *y, *z;
+  float *vx, *vy, *vz;
+  float *life, *lifetime;
+} ParticleSoA;
+
+typedef struct ParticleEmitter {
+  Vec3 position;
+  Vec3 velocity;  // mean initial velocity
+  float spread;   // radius of the sphere random velocities are added from
+  float rate;     // particles per second
+  float lifetime; // mean seconds, varied by a quarter either way
+} ParticleEmitter;
+
+// Particles drawn as instanced sprites, simulated by either backend.
+//
+// GPU: the state lives in two buffers; each update runs the update program over one with
+// transform feedback into the other. The only per-frame CPU work is generating the particles
+// emitted that frame, which are written over the oldest slots, so recording costs the same for
+// a thousand particles as for millions. The GPU processes every slot, live or not.
+//
+// CPU: for software rasterizers, where the GPU is no faster. The live particles are kept
+// dense in SoA arrays and integrated with SIMD on the job system, which also drops the dead
+// ones without branching and writes the survivors as sprites; the replaying thread streams
+// those into an orphaned buffer. Emissions that find the pool full are dropped.
+typedef struct ParticleSystem {
+  ParticleBackend backend;
+  size_t capacity;
+  ParticleEmitter emitter;
+  Vec3 gravity;
+  float drag;     // fraction of velocity lost per second
+  float size;     // sprite half extent in clip space, vertically
+  float color[4]; // alpha scales the additive blend
+
+  // Recording thread
+  float emit_accumulator;
+  uint32_t random;
+  size_t cursor; // slot the next emitted particle goes to
+  Particle *batches[PARTICLE_EMIT_FRAMES];
+  size_t batch;
+  size_t emitted;
+  size_t dropped; // emissions over PARTICLE_MAX_EMIT in a frame
+  size_t frames;
+
+  // Recording thread, CPU backend
+  JobSystem *jobs;
+  ParticleSoA state[2]; // integrated in state[current_state], then compacted into the other
+  int current_state;
+  size_t live;
+  float dt;
+  size_t *chunk_live; // survivors of each PARTICLE_CPU_GRAIN chunk, then where they go
+  ParticleSprite *sprites[PARTICLE_EMIT_FRAMES];
+
+  // Replaying thread
+  GLuint update_program, draw_program;
+  GLint dt_location, gravity_location, drag_location, size_location, color_location;
+  GLuint buffers[2];
+  GLuint update_arrays[2], draw_arrays[2]; // reading buffers[i]; the CPU backend streams into buffers[0]
+  int current;                             // buffer holding the latest state
+  size_t draw_count;                       // sprites in the stream buffer
+  size_t updates;
+} ParticleSystem;
+
+// For the GPU backend, `update_program` must capture positionLife and velocityLifetime (see
+// ShaderCaptureVaryings); the CPU backend ignores it and runs its jobs on `jobs`. GL objects
+// are created on first use by the replaying thread.
+bool ParticleSystemInit(ParticleSystem *system, ParticleBackend backend, size_t capacity, JobSystem *jobs,
+                        GLuint update_program, GLuint draw_program);
+// Needs the GL context
+void ParticleSystemDestroy(ParticleSystem *system);
+// Recording side. Emits for `dt` seconds and advances every particle by as much; a `dt` of 0
+// leaves them where they are. The CPU backend simulates here, on the calling worker and the
+// others.
+void ParticleSystemRecordUpdate(ParticleSystem *system, RenderCommandList *list, float dt);
+// Into the current render target, `width` x `height`, blended additively
+void ParticleSystemRecordDraw(ParticleSystem *system, RenderCommandList *list, GLsizei width, GLsizei height);
+void ParticleSystemPrintStats(const ParticleSystem *system);
+#endif
@@ -0,0 +1,45 @@
+#ifndef POST_PROCESS_H
+#define POST_PROCESS_H
+
+#include "render_graph.h"
+#include <GL/gl.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define POST_MAX_PASSES 8
+#define POST_SCENE_FORMAT GL_RGBA16F
+#define POST_DEPTH_FORMAT GL_DEPTH24_STENCIL8
+
+// One full-screen triangle reading the previous pass. Programs may declare
+//   uniform sampler2D source;  // previous pass (the scene for the first)
+//   uniform vec4 texelSize;    // 1/width, 1/height, width, height of source
+//   uniform vec4 params;       // pass specific
+typedef struct PostPass {
+  const char *name;
+  GLuint program;
+  GLuint vertex_array; // the chain's, empty: the triangle comes from gl_VertexID
+  GLint source_location;
+  GLint texel_size_location;
+  GLint params_location;
+  float params[4];
+  float scale;   // output size relative to the chain's output
+  GLenum format; // output format; the last pass writes the chain's output instead
+} PostPass;
+
+// Full-screen passes applied in order between the scene and the screen, declared into the
+// frame's render graph, which owns their intermediate targets
+typedef struct PostChain {
+  PostPass passes[POST_MAX_PASSES];
+  size_t count;
+  GLuint vertex_array;
+} PostChain;
+
+// Needs the GL context
+bool PostChainInit(PostChain *chain);
+void PostChainDestroy(PostChain *chain);
+// Appends a pass and looks up its uniforms; NULL when the chain is full
+PostPass *PostChainAdd(PostChain *chain, const char *name, GLuint program, float scale, GLenum format);
+// Adds one graph pass per post pass, from `scene` to `output`
+void PostChainDeclare(const PostChain *chain, RenderGraph *graph, RenderGraphResource scene,
+                      RenderGraphResource output);
+#endif
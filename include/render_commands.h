@@ -0,0 +1,130 @@
+#ifndef RENDER_COMMANDS_H
+#define RENDER_COMMANDS_H
+
+#include "render_target.h"
+#include <GL/gl.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define RENDER_CMD_PAYLOAD_SIZE 72 // bytes a callback command carries inline: a pointer and a 64-byte block
+
+// Replays work recorded by a module outside this file, with the payload it filled in
+typedef void (*RenderCallback)(const void *payload);
+
+typedef enum RenderCommandType {
+  RENDER_CMD_VIEWPORT,
+  RENDER_CMD_CLEAR,
+  RENDER_CMD_POLYGON_MODE,
+  RENDER_CMD_USE_PROGRAM,
+  RENDER_CMD_UNIFORM_1I,
+  RENDER_CMD_UNIFORM_1F,
+  RENDER_CMD_UNIFORM_4F,
+  RENDER_CMD_UNIFORM_MATRIX_4FV,
+  RENDER_CMD_BIND_TEXTURE,
+  RENDER_CMD_BIND_VERTEX_ARRAY,
+  RENDER_CMD_DRAW_ARRAYS,
+  RENDER_CMD_DRAW_ELEMENTS,
+  RENDER_CMD_WAIT_SYNC,
+  RENDER_CMD_BIND_RENDER_TARGET,
+  RENDER_CMD_BIND_RENDER_TARGET_TEXTURE,
+  RENDER_CMD_EVICT_RENDER_TARGET,
+  RENDER_CMD_CALLBACK
+} RenderCommandType;
+
+typedef struct RenderCommand {
+  RenderCommandType type;
+  union {
+    struct {
+      GLint x, y;
+      GLsizei width, height;
+    } viewport;
+    struct {
+      GLfloat r, g, b, a;
+      GLbitfield mask;
+    } clear;
+    GLenum polygon_mode;
+    GLuint program;
+    struct {
+      GLint location;
+      GLint value;
+    } uniform_1i;
+    struct {
+      GLint location;
+      GLfloat value;
+    } uniform_1f;
+    struct {
+      GLint location;
+      GLfloat value[4];
+    } uniform_4f;
+    struct {
+      GLint location;
+      GLfloat value[16]; // column-major
+    } uniform_matrix_4fv;
+    struct {
+      GLenum unit; // GL_TEXTURE0 + n
+      GLenum target;
+      GLuint texture;
+    } bind_texture;
+    GLuint vertex_array;
+    struct {
+      GLenum mode;
+      GLint first;
+      GLsizei count;
+    } draw_arrays;
+    struct {
+      GLenum mode;
+      GLsizei count;
+      GLenum index_type;
+      size_t offset;
+    } draw_elements;
+    GLsync sync;
+    struct {
+      RenderTargetPool *pool;
+      RenderTargetHandle color, depth; // color alone names the slot for texture binds and evictions
+      GLenum unit;
+      RenderTargetDesc color_desc, depth_desc; // as recorded, so the replay allocates lazily
+    } render_target;
+    struct {
+      RenderCallback callback;
+      union {
+        max_align_t align;
+        unsigned char bytes[RENDER_CMD_PAYLOAD_SIZE];
+      } payload;
+    } callback;
+  };
+} RenderCommand;
+
+// Recorded on the simulation thread and replayed on whichever thread owns the GL context.
+// Storage is kept between frames, so steady-state recording does not allocate.
+typedef struct RenderCommandList {
+  RenderCommand *commands;
+  size_t count;
+  size_t capacity;
+  double input_time; // oldest input this frame reflects (see FramePacerBeginFrame), < 0 if none
+} RenderCommandList;
+
+bool RenderCommandListInit(RenderCommandList *list, size_t capacity);
+void RenderCommandListDestroy(RenderCommandList *list);
+void RenderCommandListReset(RenderCommandList *list);
+RenderCommand *RenderCommandPush(RenderCommandList *list, RenderCommandType type);
+void RenderCommandListExecute(const RenderCommandList *list);
+
+void RenderCmdViewport(RenderCommandList *list, GLint x, GLint y, GLsizei width, GLsizei height);
+void RenderCmdClear(RenderCommandList *list, GLfloat r, GLfloat g, GLfloat b, GLfloat a, GLbitfield mask);
+void RenderCmdPolygonMode(RenderCommandList *list, GLenum mode);
+void RenderCmdUseProgram(RenderCommandList *list, GLuint program);
+void RenderCmdUniform1i(RenderCommandList *list, GLint location, GLint value);
+void RenderCmdUniform1f(RenderCommandList *list, GLint location, GLfloat value);
+void RenderCmdUniform4f(RenderCommandList *list, GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w);
+void RenderCmdUniformMatrix4fv(RenderCommandList *list, GLint location, const GLfloat *value);
+void RenderCmdBindTexture(RenderCommandList *list, GLenum unit, GLenum target, GLuint texture);
+void RenderCmdBindVertexArray(RenderCommandList *list, GLuint vertex_array);
+void RenderCmdDrawArrays(RenderCommandList *list, GLenum mode, GLint first, GLsizei count);
+void RenderCmdDrawElements(RenderCommandList *list, GLenum mode, GLsizei count, GLenum index_type, size_t offset);
+// Makes the replaying context wait for a fence from another context, then deletes the fence.
+void RenderCmdWaitSync(RenderCommandList *list, GLsync sync);
+// Returns `size` bytes of payload for the caller to fill in, which the replay passes to
+// `callback`; NULL if the command could not be recorded or the payload is over
+// RENDER_CMD_PAYLOAD_SIZE.
+void *RenderCmdCallback(RenderCommandList *list, RenderCallback callback, size_t size);
+#endif
@@ -0,0 +1,104 @@
+#ifndef RENDER_GRAPH_H
+#define RENDER_GRAPH_H
+
+#include "render_commands.h"
+#include "render_target.h"
+#include <GL/gl.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define RENDER_GRAPH_MAX_PASSES 32
+#define RENDER_GRAPH_MAX_TEXTURES 64
+#define RENDER_GRAPH_MAX_READS 8
+#define RENDER_GRAPH_MAX_WRITES 4
+#define RENDER_GRAPH_NONE UINT16_MAX
+
+typedef uint16_t RenderGraphResource;
+typedef uint16_t RenderGraphPassId;
+typedef struct RenderGraph RenderGraph;
+typedef struct RenderGraphPass RenderGraphPass;
+
+typedef struct RenderGraphContext {
+  const RenderGraph *graph;
+  const RenderGraphPass *pass;
+  GLsizei width, height; // of the framebuffer bound for the pass
+  bool depth;            // a depth target is attached
+} RenderGraphContext;
+
+// Records the pass; its writes are bound as the framebuffer and its reads on texture units
+// 0, 1, ... in the order they were declared
+typedef void (*RenderGraphExecuteFn)(RenderCommandList *list, const RenderGraphContext *context, void *user);
+
+typedef struct RenderGraphTexture {
+  const char *name;
+  RenderTargetDesc desc;
+  bool imported; // the default framebuffer; never allocated, writing it is a side effect
+} RenderGraphTexture;
+
+struct RenderGraphPass {
+  const char *name;
+  RenderGraphExecuteFn execute;
+  void *user;
+  RenderGraphResource reads[RENDER_GRAPH_MAX_READS];
+  RenderGraphResource writes[RENDER_GRAPH_MAX_WRITES]; // at most one color and one depth texture
+  uint8_t read_count, write_count;
+  bool side_effect;
+};
+
+typedef struct RenderGraphStats {
+  size_t passes;
+  size_t culled;
+  size_t textures;       // transient textures used by live passes
+  size_t physical;       // textures after aliasing
+  size_t naive_bytes;    // every transient texture allocated on its own
+  size_t physical_bytes; // what the aliased plan allocates
+  size_t peak_live_bytes; // most transient bytes alive at one point of the frame
+} RenderGraphStats;
+
+// Passes declare the textures they read and write each frame. Compiling orders them by their
+// dependencies, culls passes whose results never reach a side effect and gives transient
+// textures with disjoint lifetimes the same storage. GL 3.3 cannot place different formats
+// in one allocation, so only textures of equal size and format share a slot. A frame that
+// declares the same graph as the last one skips compilation.
+struct RenderGraph {
+  RenderGraphTexture textures[RENDER_GRAPH_MAX_TEXTURES];
+  size_t texture_count;
+  RenderGraphPass passes[RENDER_GRAPH_MAX_PASSES];
+  size_t pass_count;
+  bool overflow; // a declaration did not fit; compiling fails
+
+  // Compiled plan, valid for as long as the declaration hashes the same
+  uint64_t compiled_hash;
+  RenderGraphPassId order[RENDER_GRAPH_MAX_PASSES]; // live passes only
+  size_t order_count;
+  bool culled[RENDER_GRAPH_MAX_PASSES];
+  uint16_t first_use[RENDER_GRAPH_MAX_TEXTURES], last_use[RENDER_GRAPH_MAX_TEXTURES]; // positions in order
+  uint16_t physical_of[RENDER_GRAPH_MAX_TEXTURES]; // RENDER_GRAPH_NONE when unused or imported
+  RenderTargetDesc physical[RENDER_GRAPH_MAX_TEXTURES];
+  size_t physical_count;
+  RenderTargetHandle slots[RENDER_GRAPH_MAX_TEXTURES]; // pool slots while executing
+
+  RenderGraphStats stats;
+  size_t frames;
+  size_t compiles;
+};
+
+void RenderGraphInit(RenderGraph *graph);
+// Starts declaring a frame; the compiled plan is kept for comparison
+void RenderGraphReset(RenderGraph *graph);
+RenderGraphResource RenderGraphImportBackbuffer(RenderGraph *graph, GLsizei width, GLsizei height);
+RenderGraphResource RenderGraphCreateTexture(RenderGraph *graph, const char *name, const RenderTargetDesc *desc);
+RenderGraphPassId RenderGraphAddPass(RenderGraph *graph, const char *name, RenderGraphExecuteFn execute, void *user);
+void RenderGraphRead(RenderGraph *graph, RenderGraphPassId pass, RenderGraphResource texture);
+void RenderGraphWrite(RenderGraph *graph, RenderGraphPassId pass, RenderGraphResource texture);
+// Keeps a pass that writes nothing imported, such as one reading back results
+void RenderGraphSetSideEffect(RenderGraph *graph, RenderGraphPassId pass);
+
+// False on a dependency cycle or an overflowed declaration
+bool RenderGraphCompile(RenderGraph *graph);
+// Records the live passes in order, taking storage from the pool for the frame
+void RenderGraphExecute(RenderGraph *graph, RenderCommandList *list, RenderTargetPool *pool);
+const RenderTargetDesc *RenderGraphTextureDesc(const RenderGraph *graph, RenderGraphResource texture);
+void RenderGraphPrintStats(const RenderGraph *graph);
+#endif
@@ -0,0 +1,88 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include "render_commands.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Draw sort key, most significant first:
+//   layer (4) | program (8) | texture set (12) | geometry (16) | depth (24)
+// so sorting groups draws by program, then textures, then geometry, and orders by depth last.
+// Geometry is a small index chosen by the caller, one per vertex array; the GL name itself goes
+// in RenderDraw, since names are not bounded.
+#define RENDER_KEY_LAYER_SHIFT 60
+#define RENDER_KEY_PROGRAM_SHIFT 52
+#define RENDER_KEY_TEXTURE_SHIFT 40
+#define RENDER_KEY_GEOMETRY_SHIFT 24
+
+#define RENDER_QUEUE_MAX_PROGRAMS 256
+#define RENDER_QUEUE_MAX_TEXTURE_SETS 4096
+#define RENDER_TEXTURE_SET_SIZE 4
+
+// Called after the program is bound, to set uniforms shared by every draw using it
+typedef void (*RenderProgramSetupFn)(RenderCommandList *list, void *user);
+
+typedef struct RenderProgram {
+  GLuint program;
+  RenderProgramSetupFn setup;
+  void *user;
+} RenderProgram;
+
+// Texture set 0 binds nothing
+typedef struct RenderTextureSet {
+  GLenum target;
+  GLuint textures[RENDER_TEXTURE_SET_SIZE]; // bound to units 0..count-1
+  unsigned count;
+} RenderTextureSet;
+
+typedef struct RenderDraw {
+  GLuint vertex_array; // the same for every draw with the same geometry index
+  GLenum mode;
+  GLint first; // first index, or first vertex for non-indexed draws
+  GLsizei count;
+  GLenum index_type; // 0 for non-indexed draws
+  GLint model_location;
+  GLfloat model[16];
+} RenderDraw;
+
+typedef struct RenderQueueStats {
+  size_t draws;
+  size_t program_switches;
+  size_t texture_switches;
+  size_t vertex_array_switches;
+} RenderQueueStats;
+
+typedef struct RenderQueue {
+  uint64_t *keys;
+  uint32_t *order; // draw indices, sorted alongside keys
+  uint64_t *scratch_keys;
+  uint32_t *scratch_order;
+  RenderDraw *draws;
+  size_t count;
+  size_t capacity;
+
+  RenderProgram programs[RENDER_QUEUE_MAX_PROGRAMS];
+  RenderTextureSet *texture_sets;
+
+  RenderQueueStats last;
+  RenderQueueStats total;
+  size_t frames;
+} RenderQueue;
+
+uint64_t RenderKeyMake(unsigned layer, unsigned program, unsigned texture_set, unsigned geometry, float depth);
+
+bool RenderQueueInit(RenderQueue *queue, size_t capacity);
+void RenderQueueDestroy(RenderQueue *queue);
+void RenderQueueReset(RenderQueue *queue);
+void RenderQueueSetProgram(RenderQueue *queue, unsigned id, GLuint program, RenderProgramSetupFn setup, void *user);
+void RenderQueueSetTextures(RenderQueue *queue, unsigned id, GLenum target, const GLuint *textures, unsigned count);
+
+// Returns the draw to fill in, or NULL when out of memory
+RenderDraw *RenderQueuePush(RenderQueue *queue, uint64_t key);
+// LSD radix sort on the keys, skipping bytes that are the same for every draw
+void RenderQueueSort(RenderQueue *queue);
+// Records the draws in key order, changing state only where the key does
+void RenderQueueSubmit(RenderQueue *queue, RenderCommandList *list);
+void RenderQueuePrintStats(const RenderQueue *queue);
+#endif
@@ -0,0 +1,85 @@
+#ifndef RENDER_TARGET_H
+#define RENDER_TARGET_H
+
+#include <GL/gl.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define RENDER_TARGET_MAX 32
+#define RENDER_TARGET_NONE UINT16_MAX
+#define RENDER_TARGET_MAX_FRAMEBUFFERS 32
+#define RENDER_TARGET_EVICT_FRAMES 3 // unused this long, a slot is freed (e.g. after a resize)
+
+typedef struct RenderCommandList RenderCommandList;
+typedef uint16_t RenderTargetHandle;
+
+typedef struct RenderTargetDesc {
+  GLsizei width, height;
+  GLenum format; // sized internal format; depth formats become depth attachments
+} RenderTargetDesc;
+
+// What the replaying thread has actually allocated for a slot
+typedef struct RenderTargetStorage {
+  GLuint texture;
+  RenderTargetDesc desc;
+} RenderTargetStorage;
+
+typedef struct RenderTargetFramebuffer {
+  RenderTargetHandle color, depth;
+  GLuint color_texture, depth_texture; // attached now; re-attached when a slot is reallocated
+  GLuint framebuffer;
+} RenderTargetFramebuffer;
+
+// Textures for offscreen passes, pooled by size and format. The recording thread hands out
+// slots: a slot released during a frame is given to the next pass asking for the same
+// description, so passes that do not overlap share memory. GL storage is created by the thread
+// replaying the command lists, when a slot is first bound with a description it does not have
+// yet, so resizing the window only costs allocations on the next frame that uses the new size.
+typedef struct RenderTargetPool {
+  // Recording thread
+  RenderTargetDesc descs[RENDER_TARGET_MAX];
+  bool in_use[RENDER_TARGET_MAX];
+  size_t last_used[RENDER_TARGET_MAX]; // frame + 1, 0 for a free slot
+  size_t frame;
+  size_t acquires;
+  size_t reuses; // acquires served by a slot another pass released earlier in the frame
+  bool released[RENDER_TARGET_MAX];
+
+  // Replaying thread
+  GLuint backbuffer; // framebuffer bound for the default one, 0 (the window's) unless set
+  RenderTargetStorage storage[RENDER_TARGET_MAX];
+  RenderTargetFramebuffer framebuffers[RENDER_TARGET_MAX_FRAMEBUFFERS];
+  size_t framebuffer_count;
+  size_t allocations;
+  size_t bytes;
+  size_t peak_bytes;
+} RenderTargetPool;
+
+void RenderTargetPoolInit(RenderTargetPool *pool);
+// Needs the GL context
+void RenderTargetPoolDestroy(RenderTargetPool *pool);
+
+// Recording side. Returns RENDER_TARGET_NONE once every slot is taken.
+RenderTargetHandle RenderTargetAcquire(RenderTargetPool *pool, const RenderTargetDesc *desc);
+void RenderTargetRelease(RenderTargetPool *pool, RenderTargetHandle target);
+// Frees slots nobody asked for in a while and records the deletion of their storage
+void RenderTargetPoolEndFrame(RenderTargetPool *pool, RenderCommandList *list);
+// Binds color and depth (either may be RENDER_TARGET_NONE) as the framebuffer and viewport;
+// with neither, binds the default framebuffer (the pool's backbuffer) at `width` x `height`
+void RenderCmdBindRenderTarget(RenderCommandList *list, RenderTargetPool *pool, RenderTargetHandle color,
+                               RenderTargetHandle depth, GLsizei width, GLsizei height);
+void RenderCmdBindRenderTargetTexture(RenderCommandList *list, RenderTargetPool *pool, GLenum unit,
+                                      RenderTargetHandle target);
+
+// Replaying side, called by RenderCommandListExecute
+void RenderTargetPoolBind(RenderTargetPool *pool, RenderTargetHandle color, const RenderTargetDesc *color_desc,
+                          RenderTargetHandle depth, const RenderTargetDesc *depth_desc);
+void RenderTargetPoolBindTexture(RenderTargetPool *pool, RenderTargetHandle target, const RenderTargetDesc *desc);
+void RenderTargetPoolEvict(RenderTargetPool *pool, RenderTargetHandle target);
+
+size_t RenderTargetBytes(const RenderTargetDesc *desc);
+bool RenderTargetDescEqual(const RenderTargetDesc *a, const RenderTargetDesc *b);
+bool RenderTargetIsDepth(GLenum format);
+void RenderTargetPoolPrintStats(const RenderTargetPool *pool);
+#endif
@@ -0,0 +1,38 @@
+#ifndef RENDER_THREAD_H
+#define RENDER_THREAD_H
+
+#include "pacing.h"
+#include "render_commands.h"
+#include <GLFW/glfw3.h>
+#include <pthread.h>
+#include <stdbool.h>
+
+// Owns the GL context of a window and replays double-buffered command lists on a dedicated
+// thread, so the recording thread can build frame N+1 while frame N is submitted and swapped.
+// Without a thread (threaded = false) lists are replayed and presented inline on submit.
+typedef struct RenderThread {
+  GLFWwindow *window;
+  FramePacer *pacer; // Limit/Presented are called from the thread that presents
+  bool threaded;
+
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  RenderCommandList lists[2];
+  int recording; // list owned by the recording thread
+  int pending;   // submitted but not yet picked up, -1 if none
+  int replaying; // list being replayed, -1 if none
+  bool quit;
+
+  size_t frames;
+  double submit_wait; // total seconds the recording thread blocked in begin/submit
+} RenderThread;
+
+// The window's context must be current on the calling thread. With threaded = true it is
+// handed to the render thread until RenderThreadStop makes it current here again.
+bool RenderThreadStart(RenderThread *renderer, GLFWwindow *window, FramePacer *pacer, bool threaded);
+void RenderThreadStop(RenderThread *renderer);
+RenderCommandList *RenderThreadBeginFrame(RenderThread *renderer);
+void RenderThreadSubmit(RenderThread *renderer);
+void RenderThreadPrintStats(const RenderThread *renderer);
+#endif
@@ -0,0 +1,67 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include "vecmath.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Entity ids stay valid across deletions of other entities; a destroyed id is recognised as
+// stale through its generation. The index is in the low bits and the generation in the high 32,
+// so a slot has to be reused 2^32 times before a stale id could validate again.
+typedef uint64_t EntityId;
+typedef uint32_t MeshHandle;
+typedef uint32_t MaterialHandle;
+
+#define ENTITY_INDEX_BITS 24
+#define ENTITY_INDEX_MASK ((1u << ENTITY_INDEX_BITS) - 1)
+#define ENTITY_GENERATION_SHIFT 32
+#define ENTITY_NONE UINT64_MAX
+#define SCENE_MAX_ENTITIES ENTITY_INDEX_MASK
+
+#define VISIBILITY_VISIBLE 0x1u
+#define VISIBILITY_OCCLUDER 0x2u // rasterized into the culler's depth buffer
+
+// Dense component arrays: slot i of every array belongs to the same entity, and live entities
+// occupy slots [0, count). Destroying an entity moves the last one into its slot.
+typedef struct Scene {
+  size_t count;
+  size_t capacity;
+
+  TransformSoA transform;
+  Mat4 *world; // written by SceneUpdateTransforms
+  MeshHandle *mesh;
+  MaterialHandle *material;
+  uint32_t *visibility;
+  EntityId *entity; // slot -> id
+
+  // id index -> slot, plus generation and free list for recycling indices
+  uint32_t *slot_of;
+  uint32_t *generation;
+  uint32_t *free_indices;
+  size_t free_count;
+  size_t next_index;
+} Scene;
+
+bool SceneInit(Scene *scene, size_t capacity);
+void SceneDestroy(Scene *scene);
+
+EntityId SceneCreateEntity(Scene *scene);
+bool SceneDestroyEntity(Scene *scene, EntityId id);
+bool SceneAlive(const Scene *scene, EntityId id);
+// Dense slot of a live entity, or SIZE_MAX
+size_t SceneSlot(const Scene *scene, EntityId id);
+
+void SceneSetTransform(Scene *scene, EntityId id, Vec3 position, Quat rotation, Vec3 scale);
+void SceneSetMesh(Scene *scene, EntityId id, MeshHandle mesh);
+void SceneSetMaterial(Scene *scene, EntityId id, MaterialHandle material);
+MaterialHandle SceneGetMaterial(const Scene *scene, EntityId id);
+void SceneSetVisibility(Scene *scene, EntityId id, uint32_t visibility);
+uint32_t SceneGetVisibility(const Scene *scene, EntityId id);
+
+// Rebuilds world matrices for slots [begin, end); usable as a JobsParallelFor range
+void SceneUpdateTransformsRange(void *scene, size_t begin, size_t end);
+void SceneUpdateTransforms(Scene *scene);
+// Writes the slots whose visibility has any bit of `mask` set and returns how many there are
+size_t SceneCollectVisible(const Scene *scene, uint32_t mask, uint32_t *slots);
+#endif
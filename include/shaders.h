@@ -1,6 +1,7 @@
 #ifndef SHADERS_H
 #define SHADERS_H
 
+#include "pack.h"
 #include <GL/gl.h>
 #include <GLFW/glfw3.h>
 #include <stdbool.h>
@@ -15,6 +16,12 @@ typedef enum ShaderLoadResult {
 } ShaderLoadResult;
 
 ShaderLoadResult ShaderLoadFromDisk(const char *vertex_path, const char *fragment_path, GLuint *shader_output_program);
+ShaderLoadResult ShaderLoadFromMemory(const char *vertex_source, GLint vertex_length, const char *fragment_source,
+                                      GLint fragment_length, GLuint *shader_output_program);
+ShaderLoadResult ShaderLoadFromPack(const Pack *pack, const char *vertex_path, const char *fragment_path,
+                                    GLuint *shader_output_program);
+// Relinks a loaded program so transform feedback captures `varyings`, interleaved in that order
+ShaderLoadResult ShaderCaptureVaryings(GLuint program, const char *const *varyings, GLsizei count);
 void PrintShaderCompilationError(GLuint shader_handle);
 void PrintShaderLinkageError(GLuint program_shader_handle);
 #endif
\ No newline at end of file
@@ -0,0 +1,60 @@
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+#include "uploader.h"
+#include <GL/gl.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define ATLAS_MAX_LAYERS 16
+#define ATLAS_MAX_SHELVES 64
+
+// Where an image ended up: shaders sample texture(atlas, vec3(mix(uv.xy, uv.zw, coord), layer))
+typedef struct AtlasRegion {
+  GLint layer;
+  GLint x, y;
+  GLsizei width, height;
+  float uv[4]; // u0, v0, u1, v1
+} AtlasRegion;
+
+typedef struct AtlasShelf {
+  GLint y;
+  GLsizei height;
+  GLint x; // next free column
+} AtlasShelf;
+
+typedef struct AtlasPage {
+  AtlasShelf shelves[ATLAS_MAX_SHELVES];
+  size_t shelf_count;
+  GLint next_y; // top of the unshelved space
+} AtlasPage;
+
+// RGBA8 GL_TEXTURE_2D_ARRAY whose layers are shelf-packed with same-format images, so draws using
+// different images can share one texture binding. Every image starts on a multiple of `padding`
+// and is surrounded by that many copies of its edge texels, which keeps the first log2(padding)
+// mip levels free of bleeding. The rest of the texture is cleared to transparent black.
+typedef struct TextureAtlas {
+  GLuint texture;
+  GLsizei width, height, layers;
+  GLint padding;
+  GLint max_level;
+  AtlasPage pages[ATLAS_MAX_LAYERS];
+  size_t regions;
+  size_t used_area;
+} TextureAtlas;
+
+// Creates the array texture; needs a current context, and blocks until the GPU has created it so
+// other contexts can upload into it. padding must be a power of two.
+bool TextureAtlasInit(TextureAtlas *atlas, GLsizei width, GLsizei height, GLsizei layers, GLint padding);
+void TextureAtlasDestroy(TextureAtlas *atlas);
+// Reserves space without touching GL
+bool TextureAtlasPack(TextureAtlas *atlas, GLsizei width, GLsizei height, AtlasRegion *region);
+// Packs the image and queues its upload, edges extruded into the padding. `request` must outlive
+// the upload; its release callback and user pointer are kept.
+bool TextureAtlasAdd(TextureAtlas *atlas, Uploader *uploader, UploadRequest *request, GLsizei width, GLsizei height,
+                     GLenum format, AtlasRegion *region);
+// Queues one rebuild of the mips after a batch of TextureAtlasAdd. Uploads run in order, so once
+// `request` is ready its fence covers the images before it too.
+bool TextureAtlasGenerateMipmaps(TextureAtlas *atlas, Uploader *uploader, UploadRequest *request);
+void TextureAtlasPrintStats(const TextureAtlas *atlas);
+#endif
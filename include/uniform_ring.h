@@ -0,0 +1,44 @@
+#ifndef UNIFORM_RING_H
+#define UNIFORM_RING_H
+
+#include <GL/gl.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define UNIFORM_RING_FRAMES 3     // blocks the GPU may still be reading while later frames write theirs
+#define UNIFORM_RING_MAX_BLOCK 64 // bytes of a block, which travels inline in the command list
+
+typedef struct RenderCommandList RenderCommandList;
+
+// One std140 uniform block per frame, in a single buffer cycled through UNIFORM_RING_FRAMES
+// sections and bound to a fixed binding point. Every program declaring the block reads it from
+// there, so a frame costs one write and one bind however many programs use it. The recording
+// thread copies the frame's values into the command list; the replaying thread writes them
+// into the next section unsynchronized, once the fence of the frame that last read it has passed.
+typedef struct UniformRing {
+  GLuint binding;
+  GLsizeiptr block_size;
+
+  // Replaying thread
+  GLuint buffer;
+  GLsizeiptr stride; // block_size rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+  GLsync fences[UNIFORM_RING_FRAMES];
+  size_t next;
+  size_t updates;
+  size_t stalls; // updates that found their section still being read
+} UniformRing;
+
+// Returns false if the block does not fit UNIFORM_RING_MAX_BLOCK
+bool UniformRingInit(UniformRing *ring, GLuint binding, GLsizeiptr block_size);
+// Needs the GL context
+void UniformRingDestroy(UniformRing *ring);
+// Needs the GL context. Points `program`'s block `name` at the ring's binding point; false if
+// the program has no such block.
+bool UniformRingBindProgram(const UniformRing *ring, GLuint program, const char *name);
+// Recording side: copies the ring's block_size bytes of `block`; draws recorded after it read them
+void UniformRingRecordUpdate(UniformRing *ring, RenderCommandList *list, const void *block);
+// Needs the GL context: writes `block` into the next section and binds it for every draw after
+// it. The replay of UniformRingRecordUpdate, or called directly by code that does not record.
+void UniformRingUpdate(UniformRing *ring, const void *block);
+void UniformRingPrintStats(const UniformRing *ring);
+#endif
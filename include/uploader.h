@@ -0,0 +1,79 @@
+#ifndef UPLOADER_H
+#define UPLOADER_H
+
+#include <GL/gl.h>
+#include <GLFW/glfw3.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define UPLOADER_QUEUE_SIZE 64
+
+// UPLOAD_TEXTURE_REGION writes into the existing texture in `object` instead of creating one;
+// UPLOAD_MIPMAPS rebuilds that texture's mip chain once a batch of regions is in, and has no data
+typedef enum UploadKind { UPLOAD_TEXTURE_2D, UPLOAD_BUFFER, UPLOAD_TEXTURE_REGION, UPLOAD_MIPMAPS } UploadKind;
+typedef enum UploadState { UPLOAD_PENDING, UPLOAD_READY, UPLOAD_FAILED } UploadState;
+
+typedef struct UploadRequest {
+  UploadKind kind;
+  const void *data;
+  union {
+    struct {
+      GLsizei width, height;
+      GLint internal_format;
+      GLenum format;
+      GLenum type;
+      bool mipmaps;
+    } texture;
+    struct {
+      GLenum target;
+      GLsizeiptr size;
+      GLenum usage;
+    } buffer;
+    struct {
+      GLenum target; // GL_TEXTURE_2D_ARRAY
+      GLint x, y, layer;
+      GLsizei width, height;
+      GLenum format;
+      GLenum type;
+      GLint padding; // texels around the region filled by repeating its edges, for GL_UNSIGNED_BYTE
+    } region;
+    struct {
+      GLenum target;
+    } mipmaps;
+  };
+  // Called on the uploading thread once `data` is no longer needed
+  void (*release)(void *user);
+  void *user;
+
+  // Results, valid once state is UPLOAD_READY. The fence must be waited on (and deleted) by the
+  // context that first uses `object`.
+  GLuint object;
+  GLsync fence;
+  atomic_int state;
+} UploadRequest;
+
+// Creates textures and buffers on a hidden window whose context shares objects with the main
+// one, driven by a background thread. Without a loader thread (threaded = false) requests run
+// inline on submit and need the main context to be current.
+typedef struct Uploader {
+  GLFWwindow *context;
+  bool threaded;
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  UploadRequest *queue[UPLOADER_QUEUE_SIZE];
+  size_t head, tail;
+  bool quit;
+  size_t uploads;
+  double upload_time;
+} Uploader;
+
+// Must be called on the main thread (GLFW window creation) with `share`'s context hints still set.
+bool UploaderStart(Uploader *uploader, GLFWwindow *share, bool threaded);
+void UploaderStop(Uploader *uploader);
+bool UploaderSubmit(Uploader *uploader, UploadRequest *request);
+UploadState UploadPoll(const UploadRequest *request);
+void UploaderPrintStats(const Uploader *uploader);
+#endif
@@ -0,0 +1,501 @@
+#ifndef VECMATH_H
+#define VECMATH_H
+
+// Header-only vector/matrix/quaternion math. Matrices are column-major to match GL.
+// The backend is picked from the target: SSE (x86-64 baseline), NEON, or plain C; the batch
+// routines additionally use AVX when compiled with it. Define VECMATH_FORCE_SCALAR to compare
+// against the reference C code.
+
+#include <math.h>
+#include <stddef.h>
+
+#if !defined(VECMATH_FORCE_SCALAR) && (defined(__SSE2__) || defined(_M_X64))
+#define VECMATH_SSE 1
+#include <immintrin.h>
+#if defined(__AVX__)
+#define VECMATH_AVX 1
+#endif
+#elif !defined(VECMATH_FORCE_SCALAR) && defined(__ARM_NEON)
+#define VECMATH_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER)
+#define VECMATH_ALIGN16 __declspec(align(16))
+#else
+#define VECMATH_ALIGN16 __attribute__((aligned(16)))
+#endif
+
+typedef struct Vec2 {
+  float x, y;
+} Vec2;
+
+typedef struct Vec3 {
+  float x, y, z;
+} Vec3;
+
+typedef union VECMATH_ALIGN16 Vec4 {
+  struct {
+    float x, y, z, w;
+  };
+  float v[4];
+#if defined(VECMATH_SSE)
+  __m128 m;
+#elif defined(VECMATH_NEON)
+  float32x4_t m;
+#endif
+} Vec4;
+
+typedef Vec4 Quat; // x, y, z imaginary, w real
+
+typedef union VECMATH_ALIGN16 Mat4 {
+  Vec4 cols[4];
+  float m[16]; // m[col * 4 + row]
+} Mat4;
+
+// Translation, rotation and scale of many objects as separate arrays
+typedef struct TransformSoA {
+  float *px, *py, *pz;
+  float *qx, *qy, *qz, *qw;
+  float *sx, *sy, *sz;
+} TransformSoA;
+
+// ---- Vec2 / Vec3 ----------------------------------------------------------------------------
+
+static inline Vec2 Vec2Make(float x, float y) { return (Vec2){x, y}; }
+static inline Vec2 Vec2Add(Vec2 a, Vec2 b) { return (Vec2){a.x + b.x, a.y + b.y}; }
+static inline Vec2 Vec2Sub(Vec2 a, Vec2 b) { return (Vec2){a.x - b.x, a.y - b.y}; }
+static inline Vec2 Vec2Scale(Vec2 a, float s) { return (Vec2){a.x * s, a.y * s}; }
+static inline float Vec2Dot(Vec2 a, Vec2 b) { return a.x * b.x + a.y * b.y; }
+static inline float Vec2Length(Vec2 a) { return sqrtf(Vec2Dot(a, a)); }
+
+static inline Vec3 Vec3Make(float x, float y, float z) { return (Vec3){x, y, z}; }
+static inline Vec3 Vec3Add(Vec3 a, Vec3 b) { return (Vec3){a.x + b.x, a.y + b.y, a.z + b.z}; }
+static inline Vec3 Vec3Sub(Vec3 a, Vec3 b) { return (Vec3){a.x - b.x, a.y - b.y, a.z - b.z}; }
+static inline Vec3 Vec3Mul(Vec3 a, Vec3 b) { return (Vec3){a.x * b.x, a.y * b.y, a.z * b.z}; }
+static inline Vec3 Vec3Scale(Vec3 a, float s) { return (Vec3){a.x * s, a.y * s, a.z * s}; }
+static inline float Vec3Dot(Vec3 a, Vec3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+static inline Vec3 Vec3Cross(Vec3 a, Vec3 b) {
+  return (Vec3){a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+static inline float Vec3Length(Vec3 a) { return sqrtf(Vec3Dot(a, a)); }
+static inline Vec3 Vec3Normalize(Vec3 a) {
+  float length = Vec3Length(a);
+  return length > 0.0f ? Vec3Scale(a, 1.0f / length) : a;
+}
+static inline Vec3 Vec3Lerp(Vec3 a, Vec3 b, float t) { return Vec3Add(a, Vec3Scale(Vec3Sub(b, a), t)); }
+
+// ---- Vec4 -----------------------------------------------------------------------------------
+
+static inline Vec4 Vec4Make(float x, float y, float z, float w) {
+  Vec4 r;
+#if defined(VECMATH_SSE)
+  r.m = _mm_setr_ps(x, y, z, w);
+#else
+  r.x = x;
+  r.y = y;
+  r.z = z;
+  r.w = w;
+#endif
+  return r;
+}
+
+static inline Vec4 Vec4Splat(float s) { return Vec4Make(s, s, s, s); }
+static inline Vec4 Vec4FromVec3(Vec3 v, float w) { return Vec4Make(v.x, v.y, v.z, w); }
+static inline Vec3 Vec4XYZ(Vec4 v) { return (Vec3){v.x, v.y, v.z}; }
+
+static inline Vec4 Vec4Add(Vec4 a, Vec4 b) {
+  Vec4 r;
+#if defined(VECMATH_SSE)
+  r.m = _mm_add_ps(a.m, b.m);
+#elif defined(VECMATH_NEON)
+  r.m = vaddq_f32(a.m, b.m);
+#else
+  for (int i = 0; i < 4; i++)
+    r.v[i] = a.v[i] + b.v[i];
+#endif
+  return r;
+}
+
+static inline Vec4 Vec4Sub(Vec4 a, Vec4 b) {
+  Vec4 r;
+#if defined(VECMATH_SSE)
+  r.m = _mm_sub_ps(a.m, b.m);
+#elif defined(VECMATH_NEON)
+  r.m = vsubq_f32(a.m, b.m);
+#else
+  for (int i = 0; i < 4; i++)
+    r.v[i] = a.v[i] - b.v[i];
+#endif
+  return r;
+}
+
+static inline Vec4 Vec4Mul(Vec4 a, Vec4 b) {
+  Vec4 r;
+#if defined(VECMATH_SSE)
+  r.m = _mm_mul_ps(a.m, b.m);
+#elif defined(VECMATH_NEON)
+  r.m = vmulq_f32(a.m, b.m);
+#else
+  for (int i = 0; i < 4; i++)
+    r.v[i] = a.v[i] * b.v[i];
+#endif
+  return r;
+}
+
+static inline Vec4 Vec4Scale(Vec4 a, float s) { return Vec4Mul(a, Vec4Splat(s)); }
+
+// a + b * c
+static inline Vec4 Vec4MulAdd(Vec4 a, Vec4 b, Vec4 c) {
+#if defined(VECMATH_NEON)
+  Vec4 r;
+  r.m = vmlaq_f32(a.m, b.m, c.m);
+  return r;
+#else
+  return Vec4Add(a, Vec4Mul(b, c));
+#endif
+}
+
+static inline float Vec4Dot(Vec4 a, Vec4 b) {
+  Vec4 p = Vec4Mul(a, b);
+  return (p.x + p.y) + (p.z + p.w);
+}
+
+static inline Vec4 Vec4Lerp(Vec4 a, Vec4 b, float t) { return Vec4MulAdd(a, Vec4Sub(b, a), Vec4Splat(t)); }
+
+// ---- Mat4 -----------------------------------------------------------------------------------
+
+static inline Mat4 Mat4Identity(void) {
+  Mat4 r;
+  r.cols[0] = Vec4Make(1, 0, 0, 0);
+  r.cols[1] = Vec4Make(0, 1, 0, 0);
+  r.cols[2] = Vec4Make(0, 0, 1, 0);
+  r.cols[3] = Vec4Make(0, 0, 0, 1);
+  return r;
+}
+
+static inline Vec4 Mat4MulVec4(const Mat4 *m, Vec4 v) {
+  Vec4 r = Vec4Mul(m->cols[0], Vec4Splat(v.x));
+  r = Vec4MulAdd(r, m->cols[1], Vec4Splat(v.y));
+  r = Vec4MulAdd(r, m->cols[2], Vec4Splat(v.z));
+  return Vec4MulAdd(r, m->cols[3], Vec4Splat(v.w));
+}
+
+static inline Vec3 Mat4TransformPoint(const Mat4 *m, Vec3 p) { return Vec4XYZ(Mat4MulVec4(m, Vec4FromVec3(p, 1.0f))); }
+
+static inline Vec3 Mat4TransformDirection(const Mat4 *m, Vec3 d) {
+  return Vec4XYZ(Mat4MulVec4(m, Vec4FromVec3(d, 0.0f)));
+}
+
+// a * b: applies b first
+static inline Mat4 Mat4Mul(const Mat4 *a, const Mat4 *b) {
+  Mat4 r;
+  for (int i = 0; i < 4; i++)
+    r.cols[i] = Mat4MulVec4(a, b->cols[i]);
+  return r;
+}
+
+static inline Mat4 Mat4Transpose(const Mat4 *m) {
+  Mat4 r = *m;
+#if defined(VECMATH_SSE)
+  _MM_TRANSPOSE4_PS(r.cols[0].m, r.cols[1].m, r.cols[2].m, r.cols[3].m);
+#else
+  for (int c = 0; c < 4; c++)
+    for (int row = 0; row < 4; row++)
+      r.m[c * 4 + row] = m->m[row * 4 + c];
+#endif
+  return r;
+}
+
+static inline Mat4 Mat4Translation(Vec3 t) {
+  Mat4 r = Mat4Identity();
+  r.cols[3] = Vec4FromVec3(t, 1.0f);
+  return r;
+}
+
+static inline Mat4 Mat4Scaling(Vec3 s) {
+  Mat4 r = Mat4Identity();
+  r.m[0] = s.x;
+  r.m[5] = s.y;
+  r.m[10] = s.z;
+  return r;
+}
+
+static inline Mat4 Mat4Perspective(float fovy_radians, float aspect, float near_plane, float far_plane) {
+  float f = 1.0f / tanf(fovy_radians * 0.5f);
+  Mat4 r;
+  r.cols[0] = Vec4Make(f / aspect, 0, 0, 0);
+  r.cols[1] = Vec4Make(0, f, 0, 0);
+  r.cols[2] = Vec4Make(0, 0, (far_plane + near_plane) / (near_plane - far_plane), -1);
+  r.cols[3] = Vec4Make(0, 0, 2.0f * far_plane * near_plane / (near_plane - far_plane), 0);
+  return r;
+}
+
+static inline Mat4 Mat4Ortho(float left, float right, float bottom, float top, float near_plane, float far_plane) {
+  Mat4 r = Mat4Identity();
+  r.m[0] = 2.0f / (right - left);
+  r.m[5] = 2.0f / (top - bottom);
+  r.m[10] = -2.0f / (far_plane - near_plane);
+  r.cols[3] = Vec4Make(-(right + left) / (right - left), -(top + bottom) / (top - bottom),
+                       -(far_plane + near_plane) / (far_plane - near_plane), 1);
+  return r;
+}
+
+static inline Mat4 Mat4LookAt(Vec3 eye, Vec3 target, Vec3 up) {
+  Vec3 f = Vec3Normalize(Vec3Sub(target, eye));
+  Vec3 s = Vec3Normalize(Vec3Cross(f, up));
+  Vec3 u = Vec3Cross(s, f);
+  Mat4 r;
+  r.cols[0] = Vec4Make(s.x, u.x, -f.x, 0);
+  r.cols[1] = Vec4Make(s.y, u.y, -f.y, 0);
+  r.cols[2] = Vec4Make(s.z, u.z, -f.z, 0);
+  r.cols[3] = Vec4Make(-Vec3Dot(s, eye), -Vec3Dot(u, eye), Vec3Dot(f, eye), 1);
+  return r;
+}
+
+// Inverse of a matrix made of rotation, scale and translation only
+static inline Mat4 Mat4InverseAffine(const Mat4 *m) {
+  Vec3 c0 = Vec4XYZ(m->cols[0]), c1 = Vec4XYZ(m->cols[1]), c2 = Vec4XYZ(m->cols[2]);
+  Vec3 r0 = Vec3Cross(c1, c2), r1 = Vec3Cross(c2, c0), r2 = Vec3Cross(c0, c1);
+  float inv_det = 1.0f / Vec3Dot(c0, r0);
+  r0 = Vec3Scale(r0, inv_det);
+  r1 = Vec3Scale(r1, inv_det);
+  r2 = Vec3Scale(r2, inv_det);
+  Vec3 t = Vec4XYZ(m->cols[3]);
+  Mat4 r;
+  r.cols[0] = Vec4Make(r0.x, r1.x, r2.x, 0);
+  r.cols[1] = Vec4Make(r0.y, r1.y, r2.y, 0);
+  r.cols[2] = Vec4Make(r0.z, r1.z, r2.z, 0);
+  r.cols[3] = Vec4Make(-Vec3Dot(r0, t), -Vec3Dot(r1, t), -Vec3Dot(r2, t), 1);
+  return r;
+}
+
+// ---- Quat -----------------------------------------------------------------------------------
+
+static inline Quat QuatIdentity(void) { return Vec4Make(0, 0, 0, 1); }
+
+static inline Quat QuatFromAxisAngle(Vec3 axis, float radians) {
+  Vec3 a = Vec3Normalize(axis);
+  float s = sinf(radians * 0.5f);
+  return Vec4Make(a.x * s, a.y * s, a.z * s, cosf(radians * 0.5f));
+}
+
+static inline Quat QuatMul(Quat a, Quat b) {
+  return Vec4Make(a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y, a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+                  a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w, a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z);
+}
+
+static inline Quat QuatNormalize(Quat q) {
+  float length = sqrtf(Vec4Dot(q, q));
+  return length > 0.0f ? Vec4Scale(q, 1.0f / length) : QuatIdentity();
+}
+
+static inline Quat QuatConjugate(Quat q) { return Vec4Make(-q.x, -q.y, -q.z, q.w); }
+
+static inline Vec3 QuatRotate(Quat q, Vec3 v) {
+  Vec3 u = {q.x, q.y, q.z};
+  Vec3 t = Vec3Scale(Vec3Cross(u, v), 2.0f);
+  return Vec3Add(Vec3Add(v, Vec3Scale(t, q.w)), Vec3Cross(u, t));
+}
+
+// Normalized lerp along the shortest arc; cheaper than slerp and fine for small steps
+static inline Quat QuatNlerp(Quat a, Quat b, float t) {
+  if (Vec4Dot(a, b) < 0.0f)
+    b = Vec4Scale(b, -1.0f);
+  return QuatNormalize(Vec4Lerp(a, b, t));
+}
+
+static inline Quat QuatSlerp(Quat a, Quat b, float t) {
+  float d = Vec4Dot(a, b);
+  if (d < 0.0f) {
+    b = Vec4Scale(b, -1.0f);
+    d = -d;
+  }
+  if (d > 0.9995f)
+    return QuatNlerp(a, b, t);
+  float theta = acosf(d);
+  float s = 1.0f / sinf(theta);
+  return Vec4Add(Vec4Scale(a, sinf((1.0f - t) * theta) * s), Vec4Scale(b, sinf(t * theta) * s));
+}
+
+static inline Mat4 Mat4FromTRS(Vec3 t, Quat q, Vec3 s) {
+  float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+  float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+  float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+  Mat4 r;
+  r.cols[0] = Vec4Make((1 - 2 * (yy + zz)) * s.x, 2 * (xy + wz) * s.x, 2 * (xz - wy) * s.x, 0);
+  r.cols[1] = Vec4Make(2 * (xy - wz) * s.y, (1 - 2 * (xx + zz)) * s.y, 2 * (yz + wx) * s.y, 0);
+  r.cols[2] = Vec4Make(2 * (xz + wy) * s.z, 2 * (yz - wx) * s.z, (1 - 2 * (xx + yy)) * s.z, 0);
+  r.cols[3] = Vec4Make(t.x, t.y, t.z, 1);
+  return r;
+}
+
+static inline Mat4 Mat4FromQuat(Quat q) { return Mat4FromTRS(Vec3Make(0, 0, 0), q, Vec3Make(1, 1, 1)); }
+
+// ---- Batch ----------------------------------------------------------------------------------
+
+// out = m * (x, y, z, 1) for `count` points stored as separate arrays. In and out may alias.
+static inline void Mat4TransformPointsSoA(const Mat4 *m, const float *x, const float *y, const float *z, float *out_x,
+                                          float *out_y, float *out_z, size_t count) {
+  const float *e = m->m;
+  size_t i = 0;
+#if defined(VECMATH_AVX)
+  for (; i + 8 <= count; i += 8) {
+    __m256 px = _mm256_loadu_ps(x + i), py = _mm256_loadu_ps(y + i), pz = _mm256_loadu_ps(z + i);
+    __m256 rx = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(e[0]), px), _mm256_set1_ps(e[12]));
+    __m256 ry = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(e[1]), px), _mm256_set1_ps(e[13]));
+    __m256 rz = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(e[2]), px), _mm256_set1_ps(e[14]));
+    rx = _mm256_add_ps(rx, _mm256_mul_ps(_mm256_set1_ps(e[4]), py));
+    ry = _mm256_add_ps(ry, _mm256_mul_ps(_mm256_set1_ps(e[5]), py));
+    rz = _mm256_add_ps(rz, _mm256_mul_ps(_mm256_set1_ps(e[6]), py));
+    rx = _mm256_add_ps(rx, _mm256_mul_ps(_mm256_set1_ps(e[8]), pz));
+    ry = _mm256_add_ps(ry, _mm256_mul_ps(_mm256_set1_ps(e[9]), pz));
+    rz = _mm256_add_ps(rz, _mm256_mul_ps(_mm256_set1_ps(e[10]), pz));
+    _mm256_storeu_ps(out_x + i, rx);
+    _mm256_storeu_ps(out_y + i, ry);
+    _mm256_storeu_ps(out_z + i, rz);
+  }
+#endif
+#if defined(VECMATH_SSE)
+  for (; i + 4 <= count; i += 4) {
+    __m128 px = _mm_loadu_ps(x + i), py = _mm_loadu_ps(y + i), pz = _mm_loadu_ps(z + i);
+    __m128 rx = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(e[0]), px), _mm_set1_ps(e[12]));
+    __m128 ry = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(e[1]), px), _mm_set1_ps(e[13]));
+    __m128 rz = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(e[2]), px), _mm_set1_ps(e[14]));
+    rx = _mm_add_ps(rx, _mm_mul_ps(_mm_set1_ps(e[4]), py));
+    ry = _mm_add_ps(ry, _mm_mul_ps(_mm_set1_ps(e[5]), py));
+    rz = _mm_add_ps(rz, _mm_mul_ps(_mm_set1_ps(e[6]), py));
+    rx = _mm_add_ps(rx, _mm_mul_ps(_mm_set1_ps(e[8]), pz));
+    ry = _mm_add_ps(ry, _mm_mul_ps(_mm_set1_ps(e[9]), pz));
+    rz = _mm_add_ps(rz, _mm_mul_ps(_mm_set1_ps(e[10]), pz));
+    _mm_storeu_ps(out_x + i, rx);
+    _mm_storeu_ps(out_y + i, ry);
+    _mm_storeu_ps(out_z + i, rz);
+  }
+#elif defined(VECMATH_NEON)
+  for (; i + 4 <= count; i += 4) {
+    float32x4_t px = vld1q_f32(x + i), py = vld1q_f32(y + i), pz = vld1q_f32(z + i);
+    float32x4_t rx = vmlaq_n_f32(vdupq_n_f32(e[12]), px, e[0]);
+    float32x4_t ry = vmlaq_n_f32(vdupq_n_f32(e[13]), px, e[1]);
+    float32x4_t rz = vmlaq_n_f32(vdupq_n_f32(e[14]), px, e[2]);
+    rx = vmlaq_n_f32(rx, py, e[4]);
+    ry = vmlaq_n_f32(ry, py, e[5]);
+    rz = vmlaq_n_f32(rz, py, e[6]);
+    rx = vmlaq_n_f32(rx, pz, e[8]);
+    ry = vmlaq_n_f32(ry, pz, e[9]);
+    rz = vmlaq_n_f32(rz, pz, e[10]);
+    vst1q_f32(out_x + i, rx);
+    vst1q_f32(out_y + i, ry);
+    vst1q_f32(out_z + i, rz);
+  }
+#endif
+  for (; i < count; i++) {
+    float px = x[i], py = y[i], pz = z[i];
+    out_x[i] = e[0] * px + e[4] * py + e[8] * pz + e[12];
+    out_y[i] = e[1] * px + e[5] * py + e[9] * pz + e[13];
+    out_z[i] = e[2] * px + e[6] * py + e[10] * pz + e[14];
+  }
+}
+
+// Interleaved variant of Mat4TransformPointsSoA
+static inline void Mat4TransformPoints(const Mat4 *m, const Vec3 *in, Vec3 *out, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    Vec4 r = Mat4MulVec4(m, Vec4Make(in[i].x, in[i].y, in[i].z, 1.0f));
+    out[i] = Vec4XYZ(r);
+  }
+}
+
+// Scalar reference for one lane of Mat4ComposeSoA
+static inline Mat4 Mat4ComposeOne(const TransformSoA *t, size_t i) {
+  return Mat4FromTRS(Vec3Make(t->px[i], t->py[i], t->pz[i]), Vec4Make(t->qx[i], t->qy[i], t->qz[i], t->qw[i]),
+                     Vec3Make(t->sx[i], t->sy[i], t->sz[i]));
+}
+
+// Builds `count` model matrices from SoA translation/rotation/scale (rotations must be unit
+// quaternions). SIMD lanes work on 4 objects at once and transpose on store.
+static inline void Mat4ComposeSoA(const TransformSoA *t, Mat4 *out, size_t count) {
+  size_t i = 0;
+#if defined(VECMATH_SSE)
+  for (; i + 4 <= count; i += 4) {
+    __m128 qx = _mm_loadu_ps(t->qx + i), qy = _mm_loadu_ps(t->qy + i), qz = _mm_loadu_ps(t->qz + i);
+    __m128 qw = _mm_loadu_ps(t->qw + i);
+    __m128 sx = _mm_loadu_ps(t->sx + i), sy = _mm_loadu_ps(t->sy + i), sz = _mm_loadu_ps(t->sz + i);
+    __m128 one = _mm_set1_ps(1.0f), two = _mm_set1_ps(2.0f);
+    __m128 xx = _mm_mul_ps(qx, qx), yy = _mm_mul_ps(qy, qy), zz = _mm_mul_ps(qz, qz);
+    __m128 xy = _mm_mul_ps(qx, qy), xz = _mm_mul_ps(qx, qz), yz = _mm_mul_ps(qy, qz);
+    __m128 wx = _mm_mul_ps(qw, qx), wy = _mm_mul_ps(qw, qy), wz = _mm_mul_ps(qw, qz);
+
+    __m128 c0x = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+    __m128 c0y = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+    __m128 c0z = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+    __m128 c1x = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+    __m128 c1y = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+    __m128 c1z = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+    __m128 c2x = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+    __m128 c2y = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+    __m128 c2z = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+    __m128 c3x = _mm_loadu_ps(t->px + i), c3y = _mm_loadu_ps(t->py + i), c3z = _mm_loadu_ps(t->pz + i);
+    __m128 zero = _mm_setzero_ps();
+
+    // Each group of four rows turns into one column of each of the four matrices
+    __m128 w0 = zero, w1 = one;
+    _MM_TRANSPOSE4_PS(c0x, c0y, c0z, w0);
+    out[i + 0].cols[0].m = c0x, out[i + 1].cols[0].m = c0y, out[i + 2].cols[0].m = c0z, out[i + 3].cols[0].m = w0;
+    w0 = zero;
+    _MM_TRANSPOSE4_PS(c1x, c1y, c1z, w0);
+    out[i + 0].cols[1].m = c1x, out[i + 1].cols[1].m = c1y, out[i + 2].cols[1].m = c1z, out[i + 3].cols[1].m = w0;
+    w0 = zero;
+    _MM_TRANSPOSE4_PS(c2x, c2y, c2z, w0);
+    out[i + 0].cols[2].m = c2x, out[i + 1].cols[2].m = c2y, out[i + 2].cols[2].m = c2z, out[i + 3].cols[2].m = w0;
+    _MM_TRANSPOSE4_PS(c3x, c3y, c3z, w1);
+    out[i + 0].cols[3].m = c3x, out[i + 1].cols[3].m = c3y, out[i + 2].cols[3].m = c3z, out[i + 3].cols[3].m = w1;
+  }
+#elif defined(VECMATH_NEON)
+  for (; i + 4 <= count; i += 4) {
+    float32x4_t qx = vld1q_f32(t->qx + i), qy = vld1q_f32(t->qy + i), qz = vld1q_f32(t->qz + i);
+    float32x4_t qw = vld1q_f32(t->qw + i);
+    float32x4_t sx = vld1q_f32(t->sx + i), sy = vld1q_f32(t->sy + i), sz = vld1q_f32(t->sz + i);
+    float32x4_t one = vdupq_n_f32(1.0f);
+    float32x4_t xx = vmulq_f32(qx, qx), yy = vmulq_f32(qy, qy), zz = vmulq_f32(qz, qz);
+    float32x4_t xy = vmulq_f32(qx, qy), xz = vmulq_f32(qx, qz), yz = vmulq_f32(qy, qz);
+    float32x4_t wx = vmulq_f32(qw, qx), wy = vmulq_f32(qw, qy), wz = vmulq_f32(qw, qz);
+
+    float32x4x4_t c0, c1, c2, c3;
+    c0.val[0] = vmulq_f32(vmlsq_n_f32(one, vaddq_f32(yy, zz), 2.0f), sx);
+    c0.val[1] = vmulq_f32(vmulq_n_f32(vaddq_f32(xy, wz), 2.0f), sx);
+    c0.val[2] = vmulq_f32(vmulq_n_f32(vsubq_f32(xz, wy), 2.0f), sx);
+    c0.val[3] = vdupq_n_f32(0.0f);
+    c1.val[0] = vmulq_f32(vmulq_n_f32(vsubq_f32(xy, wz), 2.0f), sy);
+    c1.val[1] = vmulq_f32(vmlsq_n_f32(one, vaddq_f32(xx, zz), 2.0f), sy);
+    c1.val[2] = vmulq_f32(vmulq_n_f32(vaddq_f32(yz, wx), 2.0f), sy);
+    c1.val[3] = vdupq_n_f32(0.0f);
+    c2.val[0] = vmulq_f32(vmulq_n_f32(vaddq_f32(xz, wy), 2.0f), sz);
+    c2.val[1] = vmulq_f32(vmulq_n_f32(vsubq_f32(yz, wx), 2.0f), sz);
+    c2.val[2] = vmulq_f32(vmlsq_n_f32(one, vaddq_f32(xx, yy), 2.0f), sz);
+    c2.val[3] = vdupq_n_f32(0.0f);
+    c3.val[0] = vld1q_f32(t->px + i);
+    c3.val[1] = vld1q_f32(t->py + i);
+    c3.val[2] = vld1q_f32(t->pz + i);
+    c3.val[3] = one;
+
+    // vst4q interleaves the four rows, which writes the same column of four consecutive matrices
+    float tmp[4][16];
+    vst4q_f32(tmp[0], c0);
+    vst4q_f32(tmp[1], c1);
+    vst4q_f32(tmp[2], c2);
+    vst4q_f32(tmp[3], c3);
+    for (int k = 0; k < 4; k++)
+      for (int c = 0; c < 4; c++)
+        out[i + k].cols[c].m = vld1q_f32(&tmp[c][k * 4]);
+  }
+#endif
+  for (; i < count; i++)
+    out[i] = Mat4ComposeOne(t, i);
+}
+
+// out[i] = a * b[i], e.g. view-projection times every model matrix
+static inline void Mat4MulBatch(const Mat4 *a, const Mat4 *b, Mat4 *out, size_t count) {
+  for (size_t i = 0; i < count; i++)
+    out[i] = Mat4Mul(a, &b[i]);
+}
+#endif
@@ -0,0 +1,64 @@
+#ifndef VERTEX_LAYOUT_H
+#define VERTEX_LAYOUT_H
+
+#include <GL/gl.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define VERTEX_MAX_ATTRIBUTES 8
+
+// Storage formats for a vertex attribute. Normalized integer formats read back as floats in
+// [0, 1] (UNORM) or [-1, 1] (SNORM); 10_10_10_2 packs xyz in 10 bits each plus a 2-bit w.
+typedef enum VertexFormat {
+  VERTEX_FORMAT_FLOAT1,
+  VERTEX_FORMAT_FLOAT2,
+  VERTEX_FORMAT_FLOAT3,
+  VERTEX_FORMAT_FLOAT4,
+  VERTEX_FORMAT_HALF2,
+  VERTEX_FORMAT_HALF4,
+  VERTEX_FORMAT_UNORM8X4,
+  VERTEX_FORMAT_SNORM8X4,
+  VERTEX_FORMAT_UNORM16X2,
+  VERTEX_FORMAT_SNORM16X2,
+  VERTEX_FORMAT_UNORM16X4,
+  VERTEX_FORMAT_SNORM16X4,
+  VERTEX_FORMAT_UNORM10_10_10_2,
+  VERTEX_FORMAT_SNORM10_10_10_2,
+  VERTEX_FORMAT_COUNT
+} VertexFormat;
+
+typedef struct VertexAttribute {
+  GLuint location;
+  VertexFormat format;
+  GLsizei offset;
+} VertexAttribute;
+
+// Interleaved layout; attributes are placed in the order they are added, 4-byte aligned
+typedef struct VertexLayout {
+  VertexAttribute attributes[VERTEX_MAX_ATTRIBUTES];
+  size_t count;
+  GLsizei stride;
+} VertexLayout;
+
+// Float input for one attribute: `components` floats per vertex, `stride` floats apart.
+// Components the format has but the source lacks are filled with 0, or 1 for w.
+typedef struct VertexSource {
+  const float *data;
+  int components;
+  size_t stride;
+} VertexSource;
+
+GLsizei VertexFormatSize(VertexFormat format);
+int VertexFormatComponents(VertexFormat format);
+
+void VertexLayoutInit(VertexLayout *layout);
+bool VertexLayoutAdd(VertexLayout *layout, GLuint location, VertexFormat format);
+// Sets up the attribute pointers of the bound vertex array for the bound GL_ARRAY_BUFFER
+void VertexLayoutApply(const VertexLayout *layout);
+// Quantizes float sources (one per attribute, in layout order) into interleaved vertices
+void VertexLayoutPack(const VertexLayout *layout, const VertexSource *sources, size_t vertex_count, void *out);
+
+uint16_t VertexFloatToHalf(float value);
+float VertexHalfToFloat(uint16_t half);
+#endif
@@ -0,0 +1,48 @@
+#ifndef VIDEO_OUT_H
+#define VIDEO_OUT_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stddef.h>
+
+#define VIDEO_REORDER_SIZE 16 // sequence numbers submitted at once, counting from the next one to write
+
+// A converted frame waiting for the ones before it
+typedef struct VideoFrame {
+  unsigned char *planes; // YuvImageSize bytes
+  bool ready;
+} VideoFrame;
+
+// Streams frames as uncompressed YUV 4:2:0 in a Y4M container, to a file or to a command's
+// standard input, e.g. "|ffmpeg -y -i - -c:v libx264 out.mp4". Frames are converted in parallel
+// on whichever threads submit them and written strictly in sequence order, so only the frames
+// in flight are held in memory.
+typedef struct VideoOutput {
+  FILE *file;
+  bool pipe;
+  unsigned fps;
+  int width, height; // from the first frame; frames of any other size are dropped
+  pthread_mutex_t mutex;
+  VideoFrame pending[VIDEO_REORDER_SIZE];
+  size_t next; // sequence number of the next frame to write
+  size_t written;
+  size_t dropped;
+  size_t bytes;
+  bool failed; // the file or pipe stopped taking data
+} VideoOutput;
+
+// `target` is a path, or a shell command after a leading '|'. Opening a pipe ignores SIGPIPE
+// so a command that exits early shows up as a write error instead of ending the process.
+bool VideoOutputOpen(VideoOutput *video, const char *target, unsigned fps);
+void VideoOutputClose(VideoOutput *video);
+// Converts RGBA rows top to bottom and writes the frame once every earlier sequence number
+// has been written. Thread-safe; each sequence number must be submitted exactly once, and
+// only while VideoOutputAccepts it.
+void VideoOutputSubmit(VideoOutput *video, size_t sequence, const unsigned char *rgba, int width, int height);
+// Whether `sequence` has a reorder slot of its own: it is less than VIDEO_REORDER_SIZE past
+// the next frame to write. Frames converted early wait in their slots for the ones before them,
+// so a producer must hold back later frames until this holds.
+bool VideoOutputAccepts(VideoOutput *video, size_t sequence);
+void VideoOutputPrintStats(const VideoOutput *video);
+#endif
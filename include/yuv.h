@@ -0,0 +1,24 @@
+#ifndef YUV_H
+#define YUV_H
+
+#include <stddef.h>
+
+// Planar 4:2:0 with full-range BT.601 (JPEG) coefficients: Y is width x height, U and V are
+// (width + 1) / 2 x (height + 1) / 2, each chroma sample the average of a 2x2 block
+typedef struct YuvImage {
+  unsigned char *y, *u, *v;
+  int width, height;
+} YuvImage;
+
+static inline int YuvChromaWidth(int width) { return (width + 1) / 2; }
+static inline int YuvChromaHeight(int height) { return (height + 1) / 2; }
+static inline size_t YuvImageSize(int width, int height) {
+  return (size_t)width * (size_t)height + 2 * (size_t)YuvChromaWidth(width) * (size_t)YuvChromaHeight(height);
+}
+
+// Points the planes into `buffer` (YuvImageSize bytes), back to back as Y4M stores them
+void YuvImageInit(YuvImage *image, unsigned char *buffer, int width, int height);
+// Converts RGBA rows top to bottom; 8 pixels of two rows at a time with SSE2 or NEON, in 8.8
+// fixed point, so results may differ from the exact conversion by one step
+void YuvFromRgba(const unsigned char *rgba, YuvImage *image);
+#endif
@@ -0,0 +1,23 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 uv;
+
+uniform sampler2D source;
+uniform vec4 texelSize;
+uniform vec4 params; // xy direction in texels
+
+// 9-tap Gaussian in 5 bilinear fetches; run once per axis
+const float offsets[3] = float[](0.0, 1.3846153846, 3.2307692308);
+const float weights[3] = float[](0.2270270270, 0.3162162162, 0.0702702703);
+
+void main()
+{
+    vec2 step = params.xy * texelSize.xy;
+    vec3 color = texture(source, uv).rgb * weights[0];
+    for (int i = 1; i < 3; i++) {
+        color += texture(source, uv + step * offsets[i]).rgb * weights[i];
+        color += texture(source, uv - step * offsets[i]).rgb * weights[i];
+    }
+    FragColor = vec4(color, 1.0);
+}
\ No newline at end of file
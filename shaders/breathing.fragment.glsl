@@ -1,9 +1,14 @@
 #version 330 core
 out vec4 FragColor;
-  
-uniform vec4 extColor;
+
+// Written once per frame by the uniform ring, shared by every animated material
+layout (std140) uniform Frame
+{
+    vec4 time;        // animation seconds, step, alpha, scale
+    vec4 breathColor;
+};
 
 void main()
 {
-    FragColor = extColor;
+    FragColor = breathColor;
 }
\ No newline at end of file
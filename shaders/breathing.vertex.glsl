@@ -1,7 +1,9 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
 
+uniform mat4 model;
+
 void main()
 {
-    gl_Position = vec4(aPos, 1.0);
+    gl_Position = model * vec4(aPos, 1.0);
 }
\ No newline at end of file
@@ -1,11 +1,13 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aColor;
-  
+
+uniform mat4 model;
+
 out vec3 ourColor;
 
 void main()
 {
-    gl_Position = vec4(aPos, 1.0);
+    gl_Position = model * vec4(aPos, 1.0);
     ourColor = aColor;
 }
\ No newline at end of file
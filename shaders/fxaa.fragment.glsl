@@ -0,0 +1,40 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 uv;
+
+uniform sampler2D source;
+uniform vec4 texelSize;
+
+const float SPAN_MAX = 8.0;
+const float REDUCE_MUL = 1.0 / 8.0;
+const float REDUCE_MIN = 1.0 / 128.0;
+
+float luma(vec3 color)
+{
+    return dot(color, vec3(0.299, 0.587, 0.114));
+}
+
+// FXAA: blur along the edge direction found from the luma of the four diagonal neighbours
+void main()
+{
+    vec2 texel = texelSize.xy;
+    float nw = luma(texture(source, uv + vec2(-1.0, -1.0) * texel).rgb);
+    float ne = luma(texture(source, uv + vec2(1.0, -1.0) * texel).rgb);
+    float sw = luma(texture(source, uv + vec2(-1.0, 1.0) * texel).rgb);
+    float se = luma(texture(source, uv + vec2(1.0, 1.0) * texel).rgb);
+    float m = luma(texture(source, uv).rgb);
+    float lo = min(m, min(min(nw, ne), min(sw, se)));
+    float hi = max(m, max(max(nw, ne), max(sw, se)));
+
+    vec2 dir = vec2(-((nw + ne) - (sw + se)), (nw + sw) - (ne + se));
+    float reduce = max((nw + ne + sw + se) * 0.25 * REDUCE_MUL, REDUCE_MIN);
+    float scale = 1.0 / (min(abs(dir.x), abs(dir.y)) + reduce);
+    dir = clamp(dir * scale, vec2(-SPAN_MAX), vec2(SPAN_MAX)) * texel;
+
+    vec3 a = 0.5 * (texture(source, uv + dir * (1.0 / 3.0 - 0.5)).rgb +
+                    texture(source, uv + dir * (2.0 / 3.0 - 0.5)).rgb);
+    vec3 b = a * 0.5 + 0.25 * (texture(source, uv - dir * 0.5).rgb + texture(source, uv + dir * 0.5).rgb);
+    float lb = luma(b);
+    FragColor = vec4((lb < lo || lb > hi) ? a : b, 1.0);
+}
\ No newline at end of file
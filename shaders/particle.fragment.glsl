@@ -0,0 +1,14 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 corner;
+in float fade;
+
+uniform vec4 color;
+
+// Soft round sprite, blended additively and fading out over the particle's life
+void main()
+{
+    float falloff = max(1.0 - dot(corner, corner), 0.0);
+    FragColor = vec4(color.rgb, color.a * falloff * fade);
+}
\ No newline at end of file
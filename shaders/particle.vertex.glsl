@@ -0,0 +1,18 @@
+#version 330 core
+layout (location = 0) in vec4 aPositionLife;     // per instance
+layout (location = 1) in vec4 aVelocityLifetime; // per instance
+
+uniform vec2 size; // half extent of a sprite in clip space
+
+out vec2 corner;
+out float fade;
+
+// One quad per instance, its corners from gl_VertexID as a triangle strip. Dead particles
+// collapse to a point and cover no pixels.
+void main()
+{
+    corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+    float alive = float(aPositionLife.w > 0.0);
+    fade = clamp(aPositionLife.w / max(aVelocityLifetime.w, 1e-6), 0.0, 1.0);
+    gl_Position = vec4(aPositionLife.xyz + vec3(corner * size * alive, 0.0), 1.0);
+}
\ No newline at end of file
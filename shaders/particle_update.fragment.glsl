@@ -0,0 +1,8 @@
+#version 330 core
+out vec4 FragColor;
+
+// Never runs: the update draws with GL_RASTERIZER_DISCARD, but programs are loaded in pairs
+void main()
+{
+    FragColor = vec4(0.0);
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#version 330 core
+layout (location = 0) in vec4 aPositionLife;     // xyz position, w seconds left
+layout (location = 1) in vec4 aVelocityLifetime; // xyz velocity, w seconds emitted with
+
+uniform float dt;
+uniform vec3 gravity;
+uniform float drag;
+
+// Captured by transform feedback into the other state buffer
+out vec4 positionLife;
+out vec4 velocityLifetime;
+
+// Dead particles keep a life of 0 and stay where they are until their slot is emitted into again
+void main()
+{
+    float alive = float(aPositionLife.w > 0.0);
+    vec3 velocity = (aVelocityLifetime.xyz + gravity * dt) * max(1.0 - drag * dt, 0.0);
+    velocity = mix(aVelocityLifetime.xyz, velocity, alive);
+    positionLife = vec4(aPositionLife.xyz + velocity * dt * alive, max(aPositionLife.w - dt, 0.0));
+    velocityLifetime = vec4(velocity, aVelocityLifetime.w);
+}
\ No newline at end of file
@@ -4,11 +4,17 @@ out vec4 FragColor;
 in vec3 ourColor;
 in vec2 TexCoord;
 
-uniform sampler2D texture0;
-uniform sampler2D texture1;
+// Both images are regions of one texture array: xy..zw is the region's UV rectangle
+uniform sampler2DArray atlas;
+uniform vec4 uvRect0;
+uniform vec4 uvRect1;
+uniform float layer0;
+uniform float layer1;
 uniform float mixAmount;
 
 void main()
 {
-    FragColor = mix(texture(texture0, TexCoord), texture(texture1, TexCoord), mixAmount);
+    vec4 texel0 = texture(atlas, vec3(mix(uvRect0.xy, uvRect0.zw, TexCoord), layer0));
+    vec4 texel1 = texture(atlas, vec3(mix(uvRect1.xy, uvRect1.zw, TexCoord), layer1));
+    FragColor = mix(texel0, texel1, mixAmount);
 }
\ No newline at end of file
@@ -2,13 +2,15 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aColor;
 layout (location = 2) in vec2 aTexCord;
-  
+
+uniform mat4 model;
+
 out vec3 ourColor;
 out vec2 TexCoord;
 
 void main()
 {
-    gl_Position = vec4(aPos, 1.0);
+    gl_Position = model * vec4(aPos, 1.0);
     ourColor = aColor;
     TexCoord = aTexCord;
 }
\ No newline at end of file
@@ -0,0 +1,18 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 uv;
+
+uniform sampler2D source;
+uniform vec4 params; // x exposure, y white point
+
+// Extended Reinhard on luminance: identity below 1 with a white point of 1, compresses above
+void main()
+{
+    vec3 color = texture(source, uv).rgb * params.x;
+    float luminance = dot(color, vec3(0.2126, 0.7152, 0.0722));
+    float white = params.y * params.y;
+    float mapped = luminance * (1.0 + luminance / white) / (1.0 + luminance);
+    color *= luminance > 0.0 ? mapped / luminance : 0.0;
+    FragColor = vec4(clamp(color, 0.0, 1.0), 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#include "animation.h"
+#include <stdio.h>
+#include <string.h>
+
+void AnimationClockInit(AnimationClock *clock, double step) {
+  memset(clock, 0, sizeof(*clock));
+  clock->step = step > 0.0 ? step : ANIMATION_DEFAULT_STEP;
+  clock->scale = 1.0;
+  clock->last = -1.0;
+}
+
+size_t AnimationClockAdvance(AnimationClock *clock, double now) {
+  double elapsed = clock->last < 0.0 ? 0.0 : now - clock->last;
+  clock->last = now;
+  if (clock->paused || elapsed <= 0.0)
+    return 0;
+  clock->accumulator += elapsed * clock->scale;
+
+  size_t steps = (size_t)(clock->accumulator / clock->step);
+  if (steps > ANIMATION_MAX_STEPS) {
+    clock->dropped += (double)(steps - ANIMATION_MAX_STEPS) * clock->step;
+    clock->accumulator -= (double)(steps - ANIMATION_MAX_STEPS) * clock->step;
+    steps = ANIMATION_MAX_STEPS;
+  }
+  clock->accumulator -= (double)steps * clock->step;
+  clock->time += (double)steps * clock->step;
+  clock->steps += steps;
+  return steps;
+}
+
+float AnimationClockAlpha(const AnimationClock *clock) {
+  float alpha = (float)(clock->accumulator / clock->step);
+  return alpha < 0.0f ? 0.0f : alpha > 1.0f ? 1.0f : alpha;
+}
+
+double AnimationClockRenderTime(const AnimationClock *clock) {
+  return clock->time - clock->step + AnimationClockAlpha(clock) * clock->step;
+}
+
+void AnimationClockSetPaused(AnimationClock *clock, bool paused) { clock->paused = paused; }
+
+void AnimationClockSetScale(AnimationClock *clock, double scale) { clock->scale = scale > 0.0 ? scale : 0.0; }
+
+void AnimationClockFrameUniforms(const AnimationClock *clock, FrameUniforms *uniforms) {
+  uniforms->time[0] = (float)AnimationClockRenderTime(clock);
+  uniforms->time[1] = (float)clock->step;
+  uniforms->time[2] = AnimationClockAlpha(clock);
+  uniforms->time[3] = clock->paused ? 0.0f : (float)clock->scale;
+}
+
+void AnimationClockPrintStats(const AnimationClock *clock) {
+  printf("Animation: %.2f s in %zu steps of %.2f ms, %.2f s dropped after hitches\n", clock->time, clock->steps,
+         1000.0 * clock->step, clock->dropped);
+}
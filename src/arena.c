@@ -0,0 +1,167 @@
+#include "arena.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct ArenaBlock {
+  unsigned char *base;
+  size_t capacity;
+} ArenaBlock;
+
+static _Thread_local Arena *thread_arena = NULL;
+
+// Blocks of every live arena, so scratch calls can tell another thread's allocations from the heap's
+static pthread_mutex_t blocks_mutex = PTHREAD_MUTEX_INITIALIZER;
+static ArenaBlock *blocks;
+static size_t block_count, block_capacity;
+
+static size_t alignUp(size_t value) { return (value + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1); }
+
+static bool addBlock(unsigned char *base, size_t capacity) {
+  pthread_mutex_lock(&blocks_mutex);
+  if (block_count == block_capacity) {
+    size_t grown_capacity = block_capacity ? block_capacity * 2 : 16;
+    ArenaBlock *grown = realloc(blocks, grown_capacity * sizeof(ArenaBlock));
+    if (!grown) {
+      pthread_mutex_unlock(&blocks_mutex);
+      return false;
+    }
+    blocks = grown;
+    block_capacity = grown_capacity;
+  }
+  blocks[block_count++] = (ArenaBlock){base, capacity};
+  pthread_mutex_unlock(&blocks_mutex);
+  return true;
+}
+
+static void removeBlock(const unsigned char *base) {
+  pthread_mutex_lock(&blocks_mutex);
+  for (size_t i = 0; i < block_count; i++) {
+    if (blocks[i].base == base) {
+      blocks[i] = blocks[--block_count];
+      break;
+    }
+  }
+  pthread_mutex_unlock(&blocks_mutex);
+}
+
+static bool inAnyArena(const void *ptr) {
+  uintptr_t p = (uintptr_t)ptr;
+  bool found = false;
+  pthread_mutex_lock(&blocks_mutex);
+  for (size_t i = 0; i < block_count && !found; i++)
+    found = p >= (uintptr_t)blocks[i].base && p < (uintptr_t)blocks[i].base + blocks[i].capacity;
+  pthread_mutex_unlock(&blocks_mutex);
+  return found;
+}
+
+bool ArenaInit(Arena *arena, size_t capacity) {
+  memset(arena, 0, sizeof(*arena));
+  arena->base = malloc(capacity);
+  if (!arena->base)
+    return false;
+  if (!addBlock(arena->base, capacity)) {
+    free(arena->base);
+    arena->base = NULL;
+    return false;
+  }
+  arena->capacity = capacity;
+  return true;
+}
+
+void ArenaDestroy(Arena *arena) {
+  if (thread_arena == arena)
+    thread_arena = NULL;
+  if (arena->base)
+    removeBlock(arena->base);
+  free(arena->base);
+  memset(arena, 0, sizeof(*arena));
+}
+
+void *ArenaAlloc(Arena *arena, size_t size) {
+  size_t start = alignUp(arena->offset);
+  if (start > arena->capacity || size > arena->capacity - start)
+    return NULL;
+  arena->last_offset = start;
+  arena->offset = start + size;
+  arena->stats.allocations++;
+  if (arena->offset > arena->stats.peak_bytes)
+    arena->stats.peak_bytes = arena->offset;
+  return arena->base + start;
+}
+
+void ArenaReset(Arena *arena) {
+  arena->offset = 0;
+  arena->last_offset = 0;
+  arena->stats.resets++;
+}
+
+bool ArenaOwns(const Arena *arena, const void *ptr) {
+  uintptr_t p = (uintptr_t)ptr, base = (uintptr_t)arena->base;
+  return arena->base && p >= base && p < base + arena->capacity;
+}
+
+void ArenaPrintStats(const Arena *arena, const char *name) {
+  printf("Arena %s: %zu allocations, %zu heap fallbacks, peak %zu / %zu bytes, %zu resets\n", name,
+         arena->stats.allocations, arena->stats.heap_fallbacks, arena->stats.peak_bytes, arena->capacity,
+         arena->stats.resets);
+}
+
+void ArenaBindThread(Arena *arena) { thread_arena = arena; }
+
+Arena *ArenaThreadCurrent(void) { return thread_arena; }
+
+void *ArenaScratchAlloc(size_t size) {
+  Arena *arena = thread_arena;
+  if (!arena)
+    return malloc(size);
+  void *ptr = ArenaAlloc(arena, size);
+  if (ptr)
+    return ptr;
+  arena->stats.heap_fallbacks++;
+  return malloc(size);
+}
+
+void *ArenaScratchRealloc(void *ptr, size_t old_size, size_t new_size) {
+  Arena *arena = thread_arena;
+  if (!ptr)
+    return ArenaScratchAlloc(new_size);
+  if (!arena || !ArenaOwns(arena, ptr)) {
+    if (!inAnyArena(ptr))
+      return realloc(ptr, new_size);
+    // Another thread's arena, which only its owner may touch: copy out, the original goes with its reset
+    void *moved = ArenaScratchAlloc(new_size);
+    if (moved)
+      memcpy(moved, ptr, old_size < new_size ? old_size : new_size);
+    return moved;
+  }
+
+  // The most recent allocation can grow in place
+  size_t start = (size_t)((unsigned char *)ptr - arena->base);
+  if (start == arena->last_offset && new_size <= arena->capacity - start) {
+    arena->offset = start + new_size;
+    if (arena->offset > arena->stats.peak_bytes)
+      arena->stats.peak_bytes = arena->offset;
+    return ptr;
+  }
+
+  void *grown = ArenaScratchAlloc(new_size);
+  if (grown)
+    memcpy(grown, ptr, old_size < new_size ? old_size : new_size);
+  return grown;
+}
+
+void ArenaScratchFree(void *ptr) {
+  Arena *arena = thread_arena;
+  if (!ptr)
+    return;
+  if (!arena || !ArenaOwns(arena, ptr)) {
+    if (!inAnyArena(ptr))
+      free(ptr);
+    return;
+  }
+  if ((unsigned char *)ptr - arena->base == (ptrdiff_t)arena->last_offset)
+    arena->offset = arena->last_offset;
+}
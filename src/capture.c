@@ -0,0 +1,202 @@
+#include "capture.h"
+#include "image_write.h"
+#include "render_commands.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+bool CaptureInit(Capture *capture, JobSystem *jobs, const char *directory, CaptureFormat format, bool every_frame) {
+  memset(capture, 0, sizeof(*capture));
+  snprintf(capture->directory, sizeof(capture->directory), "%s", directory);
+  capture->format = format;
+  capture->jobs = jobs;
+  capture->every_frame = every_frame;
+  return pthread_mutex_init(&capture->mutex, NULL) == 0;
+}
+
+void CaptureDestroy(Capture *capture) {
+  for (size_t i = 0; i < CAPTURE_RING_SIZE; i++) {
+    if (capture->ring[i].fence)
+      glDeleteSync(capture->ring[i].fence);
+    glDeleteBuffers(1, &capture->ring[i].buffer);
+  }
+  pthread_mutex_destroy(&capture->mutex);
+}
+
+void CaptureRequest(Capture *capture) { capture->requested = true; }
+
+void CaptureSetVideo(Capture *capture, VideoOutput *video) { capture->video = video; }
+
+// Copies the slot out, flipping GL's bottom-up rows, and queues it for the main thread
+static void resolveSlot(Capture *capture, CaptureSlot *slot) {
+  glDeleteSync(slot->fence);
+  slot->fence = 0;
+  CaptureFrame *frame = malloc(sizeof(*frame));
+  size_t row = (size_t)slot->width * 4;
+  unsigned char *pixels = malloc(row * (size_t)slot->height);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->buffer);
+  const unsigned char *mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot->size, GL_MAP_READ_BIT);
+  if (!frame || !pixels || !mapped) {
+    if (mapped)
+      glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    free(frame);
+    free(pixels);
+    atomic_fetch_add(&capture->failed, 1);
+    return;
+  }
+  for (GLsizei y = 0; y < slot->height; y++)
+    memcpy(pixels + (size_t)y * row, mapped + (size_t)(slot->height - 1 - y) * row, row);
+  glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  *frame = (CaptureFrame){capture, pixels, slot->width, slot->height, slot->frame, 0, NULL};
+  pthread_mutex_lock(&capture->mutex);
+  if (capture->ready_tail)
+    capture->ready_tail->next = frame;
+  else
+    capture->ready_head = frame;
+  capture->ready_tail = frame;
+  pthread_mutex_unlock(&capture->mutex);
+}
+
+// Resolves finished slots oldest first, stopping at the first one still in flight so frames
+// are handed on in order. With `wait`, blocks on each instead.
+static void collect(Capture *capture, bool wait) {
+  for (size_t i = 0; i < CAPTURE_RING_SIZE; i++) {
+    CaptureSlot *slot = &capture->ring[(capture->next_slot + i) % CAPTURE_RING_SIZE];
+    if (!slot->fence)
+      continue;
+    GLenum status = glClientWaitSync(slot->fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+                                     wait ? GL_TIMEOUT_IGNORED : 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+      return;
+    resolveSlot(capture, slot);
+  }
+}
+
+// A frame marked for capture, read back where the recording thread put it in the list
+typedef struct ReadbackCommand {
+  Capture *capture;
+  GLsizei width, height;
+  size_t frame;
+} ReadbackCommand;
+
+// Starts this frame's copy and hands on every earlier one the GPU has finished
+static void readback(const void *payload) {
+  const ReadbackCommand *command = payload;
+  Capture *capture = command->capture;
+  CaptureSlot *slot = &capture->ring[capture->next_slot];
+  if (slot->fence) {
+    // Every slot is in flight: this one is the oldest, so waiting for it keeps the order
+    capture->stalls++;
+    glClientWaitSync(slot->fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+    collect(capture, false);
+  }
+  capture->next_slot = (capture->next_slot + 1) % CAPTURE_RING_SIZE;
+
+  if (!slot->buffer)
+    glGenBuffers(1, &slot->buffer);
+  GLsizeiptr size = (GLsizeiptr)command->width * command->height * 4;
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->buffer);
+  if (slot->size != size) {
+    glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+    slot->size = size;
+  }
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+  glReadBuffer(GL_BACK);
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glReadPixels(0, 0, command->width, command->height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  slot->width = command->width;
+  slot->height = command->height;
+  slot->frame = command->frame;
+  capture->readbacks++;
+
+  collect(capture, false);
+}
+
+void CaptureRecord(Capture *capture, RenderCommandList *list, GLsizei width, GLsizei height) {
+  size_t frame = capture->frame++;
+  if (!(capture->every_frame || capture->requested) || width <= 0 || height <= 0)
+    return;
+  capture->requested = false;
+  ReadbackCommand *command = RenderCmdCallback(list, readback, sizeof(*command));
+  if (command)
+    *command = (ReadbackCommand){capture, width, height, frame};
+}
+
+static void encodeJob(void *data) {
+  CaptureFrame *frame = data;
+  Capture *capture = frame->capture;
+  if (capture->video) {
+    VideoOutputSubmit(capture->video, frame->sequence, frame->pixels, frame->width, frame->height);
+    free(frame->pixels);
+    free(frame);
+    return;
+  }
+  bool qoi = capture->format == CAPTURE_FORMAT_QOI;
+  unsigned char *encoded;
+  size_t size = qoi ? ImageEncodeQoi(frame->pixels, frame->width, frame->height, &encoded)
+                    : ImageEncodePng(frame->pixels, frame->width, frame->height, &encoded);
+  char path[1100];
+  snprintf(path, sizeof(path), "%s/frame_%06zu.%s", capture->directory, frame->frame, qoi ? "qoi" : "png");
+  bool ok = ImageWriteFile(path, encoded, size);
+  atomic_fetch_add(ok ? &capture->written : &capture->failed, 1);
+  if (ok)
+    atomic_fetch_add(&capture->bytes, size);
+  free(encoded);
+  free(frame->pixels);
+  free(frame);
+}
+
+void CaptureDispatch(Capture *capture) {
+  pthread_mutex_lock(&capture->mutex);
+  CaptureFrame *frame = capture->ready_head;
+  capture->ready_head = capture->ready_tail = NULL;
+  pthread_mutex_unlock(&capture->mutex);
+
+  // Created with the first frame, so runs that never capture leave no directory behind
+  if (frame && !capture->video && !capture->directory_ready) {
+    if (mkdir(capture->directory, 0755) != 0 && errno != EEXIST)
+      printf("Capture: could not create %s\n", capture->directory);
+    capture->directory_ready = true;
+  }
+  while (frame) {
+    CaptureFrame *next = frame->next;
+    // Each queued frame holds a full copy, so let the encoders catch up rather than pile them up.
+    // Frames converted out of order also wait in the video's reorder window, without counting
+    // as encodes: once every encode is done, every frame before this one has been written.
+    if (atomic_load(&capture->encoding.value) >= CAPTURE_MAX_PENDING ||
+        (capture->video && !VideoOutputAccepts(capture->video, capture->sequence))) {
+      capture->waits++;
+      JobsWait(capture->jobs, &capture->encoding);
+    }
+    frame->sequence = capture->sequence++;
+    JobsRun(capture->jobs, encodeJob, frame, &capture->encoding);
+    frame = next;
+  }
+}
+
+void CaptureFinish(Capture *capture) {
+  collect(capture, true);
+  CaptureDispatch(capture);
+  JobsWait(capture->jobs, &capture->encoding);
+}
+
+void CapturePrintStats(const Capture *capture) {
+  if (capture->readbacks == 0)
+    return;
+  printf("Capture: %zu readbacks, %zu stalled on the ring, %zu encoder waits", capture->readbacks, capture->stalls,
+         capture->waits);
+  if (capture->video) {
+    printf("\n");
+    VideoOutputPrintStats(capture->video);
+    return;
+  }
+  printf(", %zu frames written to %s (%.1f MiB), %zu failed\n", atomic_load(&capture->written), capture->directory,
+         (double)atomic_load(&capture->bytes) / (1024.0 * 1024.0), atomic_load(&capture->failed));
+}
@@ -0,0 +1,322 @@
+#include "culling.h"
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(VECMATH_SSE) && (defined(__GNUC__) || defined(__clang__))
+// The AVX path is compiled regardless of -mavx and picked at runtime
+#define CULL_AVX_DISPATCH 1
+#endif
+
+bool CullerInit(Culler *culler, size_t capacity, bool occlusion) {
+  memset(culler, 0, sizeof(*culler));
+  culler->capacity = capacity;
+  culler->occlusion = occlusion;
+  culler->cx = malloc(capacity * sizeof(float));
+  culler->cy = malloc(capacity * sizeof(float));
+  culler->cz = malloc(capacity * sizeof(float));
+  culler->radius = malloc(capacity * sizeof(float));
+  culler->visible = malloc(capacity * sizeof(uint32_t));
+  culler->depth = malloc(CULL_DEPTH_WIDTH * CULL_DEPTH_HEIGHT * sizeof(float));
+  if (!culler->cx || !culler->cy || !culler->cz || !culler->radius || !culler->visible || !culler->depth) {
+    CullerDestroy(culler);
+    return false;
+  }
+  culler->view = Mat4Identity();
+  culler->projection = Mat4Identity();
+  CullerSetCamera(culler, &culler->view, &culler->projection);
+
+#if defined(CULL_AVX_DISPATCH)
+  culler->backend = __builtin_cpu_supports("avx") ? "AVX" : "SSE";
+#elif defined(VECMATH_NEON)
+  culler->backend = "NEON";
+#else
+  culler->backend = "scalar";
+#endif
+  return true;
+}
+
+void CullerDestroy(Culler *culler) {
+  free(culler->cx);
+  free(culler->cy);
+  free(culler->cz);
+  free(culler->radius);
+  free(culler->visible);
+  free(culler->depth);
+  memset(culler, 0, sizeof(*culler));
+}
+
+void CullExtractPlanes(const Mat4 *view_projection, Vec4 planes[6]) {
+  // Gribb-Hartmann: the planes are sums/differences of the view-projection rows
+  float row[4][4];
+  for (int r = 0; r < 4; r++)
+    for (int c = 0; c < 4; c++)
+      row[r][c] = view_projection->m[c * 4 + r];
+  for (int p = 0; p < 6; p++) {
+    float sign = (p & 1) ? -1.0f : 1.0f;
+    const float *axis = row[p / 2];
+    float x = row[3][0] + sign * axis[0], y = row[3][1] + sign * axis[1];
+    float z = row[3][2] + sign * axis[2], w = row[3][3] + sign * axis[3];
+    float length = sqrtf(x * x + y * y + z * z);
+    planes[p] = Vec4Make(x / length, y / length, z / length, w / length);
+  }
+}
+
+void CullerSetCamera(Culler *culler, const Mat4 *view, const Mat4 *projection) {
+  culler->view = *view;
+  culler->projection = *projection;
+  Mat4 vp = Mat4Mul(projection, view);
+  CullExtractPlanes(&vp, culler->planes);
+}
+
+void CullerUpdateBounds(Culler *culler, const Scene *scene, const Vec4 *mesh_spheres) {
+  for (size_t i = 0; i < scene->count; i++) {
+    const Mat4 *world = &scene->world[i];
+    Vec4 local = mesh_spheres[scene->mesh[i]];
+    Vec3 center = Mat4TransformPoint(world, Vec3Make(local.x, local.y, local.z));
+    float scale = 0.0f;
+    for (int c = 0; c < 3; c++) {
+      const float *axis = world->cols[c].v;
+      float length = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+      scale = length > scale ? length : scale;
+    }
+    culler->cx[i] = center.x;
+    culler->cy[i] = center.y;
+    culler->cz[i] = center.z;
+    culler->radius[i] = local.w * sqrtf(scale);
+  }
+}
+
+static unsigned visibilityBits(const uint32_t *visibility, uint32_t mask, size_t n) {
+  unsigned bits = 0;
+  for (size_t j = 0; j < n; j++)
+    bits |= (unsigned)((visibility[j] & mask) != 0) << j;
+  return bits;
+}
+
+// Branchless append of the set bits as slot indices
+static size_t appendBits(uint32_t *out, size_t n, size_t base, unsigned bits, size_t width) {
+  for (size_t j = 0; j < width; j++) {
+    out[n] = (uint32_t)(base + j);
+    n += (bits >> j) & 1;
+  }
+  return n;
+}
+
+static size_t frustumScalar(const Culler *c, const uint32_t *visibility, uint32_t mask, size_t begin, size_t end,
+                            uint32_t *out, size_t n) {
+  for (size_t i = begin; i < end; i++) {
+    unsigned inside = (visibility[i] & mask) != 0;
+    for (int p = 0; p < 6; p++) {
+      const Vec4 *plane = &c->planes[p];
+      float d = c->cx[i] * plane->x + c->cy[i] * plane->y + c->cz[i] * plane->z + plane->w;
+      inside &= d >= -c->radius[i];
+    }
+    out[n] = (uint32_t)i;
+    n += inside;
+  }
+  return n;
+}
+
+#if defined(CULL_AVX_DISPATCH)
+__attribute__((target("avx"))) static size_t frustumAvx(const Culler *c, const uint32_t *visibility, uint32_t mask,
+                                                         size_t count, uint32_t *out) {
+  __m256 px[6], py[6], pz[6], pw[6];
+  for (int p = 0; p < 6; p++) {
+    px[p] = _mm256_set1_ps(c->planes[p].x);
+    py[p] = _mm256_set1_ps(c->planes[p].y);
+    pz[p] = _mm256_set1_ps(c->planes[p].z);
+    pw[p] = _mm256_set1_ps(c->planes[p].w);
+  }
+  size_t n = 0, i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 x = _mm256_loadu_ps(c->cx + i), y = _mm256_loadu_ps(c->cy + i), z = _mm256_loadu_ps(c->cz + i);
+    __m256 neg_r = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(c->radius + i));
+    __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    for (int p = 0; p < 6; p++) {
+      __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, px[p]), _mm256_mul_ps(y, py[p])),
+                               _mm256_add_ps(_mm256_mul_ps(z, pz[p]), pw[p]));
+      inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, neg_r, _CMP_GE_OQ));
+    }
+    unsigned bits = (unsigned)_mm256_movemask_ps(inside) & visibilityBits(visibility + i, mask, 8);
+    n = appendBits(out, n, i, bits, 8);
+  }
+  return frustumScalar(c, visibility, mask, i, count, out, n);
+}
+#endif
+
+#if defined(VECMATH_SSE) || defined(VECMATH_NEON)
+static size_t frustum4(const Culler *c, const uint32_t *visibility, uint32_t mask, size_t count, uint32_t *out) {
+  size_t n = 0, i = 0;
+  for (; i + 4 <= count; i += 4) {
+#if defined(VECMATH_SSE)
+    __m128 x = _mm_loadu_ps(c->cx + i), y = _mm_loadu_ps(c->cy + i), z = _mm_loadu_ps(c->cz + i);
+    __m128 neg_r = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(c->radius + i));
+    __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    for (int p = 0; p < 6; p++) {
+      const Vec4 *plane = &c->planes[p];
+      __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane->x)), _mm_mul_ps(y, _mm_set1_ps(plane->y))),
+                            _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane->z)), _mm_set1_ps(plane->w)));
+      inside = _mm_and_ps(inside, _mm_cmpge_ps(d, neg_r));
+    }
+    unsigned bits = (unsigned)_mm_movemask_ps(inside);
+#else
+    float32x4_t x = vld1q_f32(c->cx + i), y = vld1q_f32(c->cy + i), z = vld1q_f32(c->cz + i);
+    float32x4_t neg_r = vnegq_f32(vld1q_f32(c->radius + i));
+    uint32x4_t inside = vdupq_n_u32(0xffffffffu);
+    for (int p = 0; p < 6; p++) {
+      const Vec4 *plane = &c->planes[p];
+      float32x4_t d = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(plane->w), x, plane->x), y, plane->y), z,
+                                  plane->z);
+      inside = vandq_u32(inside, vcgeq_f32(d, neg_r));
+    }
+    static const uint32_t lane_bits[4] = {1, 2, 4, 8};
+    unsigned bits = vaddvq_u32(vandq_u32(inside, vld1q_u32(lane_bits)));
+#endif
+    bits &= visibilityBits(visibility + i, mask, 4);
+    n = appendBits(out, n, i, bits, 4);
+  }
+  return frustumScalar(c, visibility, mask, i, count, out, n);
+}
+#endif
+
+static size_t cullFrustum(const Culler *c, const uint32_t *visibility, uint32_t mask, size_t count, uint32_t *out) {
+#if defined(CULL_AVX_DISPATCH)
+  if (__builtin_cpu_supports("avx"))
+    return frustumAvx(c, visibility, mask, count, out);
+#endif
+#if defined(VECMATH_SSE) || defined(VECMATH_NEON)
+  return frustum4(c, visibility, mask, count, out);
+#else
+  return frustumScalar(c, visibility, mask, 0, count, out, 0);
+#endif
+}
+
+// ---- Occlusion --------------------------------------------------------------------------------
+// Occluders write the front face of their sphere's inscribed cube, which faces the camera in view
+// space and so projects to an exact rectangle. Occludees test the screen rectangle of their
+// sphere's view-space box at its nearest depth; both sides err towards "visible".
+
+typedef struct ViewSphere {
+  float x, y, depth, radius;
+} ViewSphere;
+
+static ViewSphere viewSphere(const Culler *c, uint32_t slot) {
+  Vec3 v = Mat4TransformPoint(&c->view, Vec3Make(c->cx[slot], c->cy[slot], c->cz[slot]));
+  return (ViewSphere){v.x, v.y, -v.z, c->radius[slot]};
+}
+
+static float nearPlane(const Mat4 *projection) { return projection->m[14] / (projection->m[10] - 1.0f); }
+
+static float toPixelX(const Culler *c, float x, float depth) {
+  float ndc = c->projection.m[0] * x / depth - c->projection.m[8];
+  return (ndc * 0.5f + 0.5f) * CULL_DEPTH_WIDTH;
+}
+
+static float toPixelY(const Culler *c, float y, float depth) {
+  float ndc = c->projection.m[5] * y / depth - c->projection.m[9];
+  return (ndc * 0.5f + 0.5f) * CULL_DEPTH_HEIGHT;
+}
+
+static int clampInt(int value, int lo, int hi) { return value < lo ? lo : value > hi ? hi : value; }
+
+static void rasterizeOccluder(Culler *c, uint32_t slot, float near_plane) {
+  ViewSphere s = viewSphere(c, slot);
+  float half = s.radius * 0.57735027f;
+  float face = s.depth - half;
+  if (face <= near_plane)
+    return;
+
+  // Only texels fully covered by the face
+  int x0 = clampInt((int)ceilf(toPixelX(c, s.x - half, face)), 0, CULL_DEPTH_WIDTH);
+  int x1 = clampInt((int)floorf(toPixelX(c, s.x + half, face)), 0, CULL_DEPTH_WIDTH);
+  int y0 = clampInt((int)ceilf(toPixelY(c, s.y - half, face)), 0, CULL_DEPTH_HEIGHT);
+  int y1 = clampInt((int)floorf(toPixelY(c, s.y + half, face)), 0, CULL_DEPTH_HEIGHT);
+  for (int y = y0; y < y1; y++) {
+    float *row = c->depth + y * CULL_DEPTH_WIDTH;
+    for (int x = x0; x < x1; x++)
+      row[x] = face < row[x] ? face : row[x];
+  }
+}
+
+static bool occluded(const Culler *c, uint32_t slot, float near_plane) {
+  ViewSphere s = viewSphere(c, slot);
+  float nearest = s.depth - s.radius;
+  if (nearest <= near_plane)
+    return false;
+
+  // x / depth over the view-space box is extremal at its corners
+  float lo = FLT_MAX, hi = -FLT_MAX, bottom = FLT_MAX, top = -FLT_MAX;
+  for (int corner = 0; corner < 4; corner++) {
+    float depth = (corner & 1) ? s.depth + s.radius : nearest;
+    float offset = (corner & 2) ? s.radius : -s.radius;
+    float px = toPixelX(c, s.x + offset, depth), py = toPixelY(c, s.y + offset, depth);
+    lo = px < lo ? px : lo;
+    hi = px > hi ? px : hi;
+    bottom = py < bottom ? py : bottom;
+    top = py > top ? py : top;
+  }
+  int x0 = clampInt((int)floorf(lo), 0, CULL_DEPTH_WIDTH), x1 = clampInt((int)ceilf(hi), 0, CULL_DEPTH_WIDTH);
+  int y0 = clampInt((int)floorf(bottom), 0, CULL_DEPTH_HEIGHT), y1 = clampInt((int)ceilf(top), 0, CULL_DEPTH_HEIGHT);
+  if (x0 >= x1 || y0 >= y1)
+    return false;
+  for (int y = y0; y < y1; y++) {
+    const float *row = c->depth + y * CULL_DEPTH_WIDTH;
+    for (int x = x0; x < x1; x++)
+      if (row[x] >= nearest)
+        return false;
+  }
+  return true;
+}
+
+static size_t cullOcclusion(Culler *c, const Scene *scene, size_t count) {
+  float near_plane = nearPlane(&c->projection);
+  for (size_t i = 0; i < CULL_DEPTH_WIDTH * CULL_DEPTH_HEIGHT; i++)
+    c->depth[i] = FLT_MAX;
+  for (size_t i = 0; i < count; i++)
+    if (scene->visibility[c->visible[i]] & VISIBILITY_OCCLUDER)
+      rasterizeOccluder(c, c->visible[i], near_plane);
+
+  size_t n = 0;
+  for (size_t i = 0; i < count; i++) {
+    c->visible[n] = c->visible[i];
+    n += !occluded(c, c->visible[i], near_plane);
+  }
+  return n;
+}
+
+size_t CullerRun(Culler *culler, const Scene *scene, uint32_t mask) {
+  CullStats stats = {0};
+  for (size_t i = 0; i < scene->count; i++)
+    stats.tested += (scene->visibility[i] & mask) != 0;
+
+  size_t count = cullFrustum(culler, scene->visibility, mask, scene->count, culler->visible);
+  stats.frustum_culled = stats.tested - count;
+  // The depth reconstruction assumes a perspective projection
+  if (culler->occlusion && culler->projection.m[11] < 0.0f && culler->projection.m[15] == 0.0f) {
+    size_t remaining = cullOcclusion(culler, scene, count);
+    stats.occlusion_culled = count - remaining;
+    count = remaining;
+  }
+  stats.visible = count;
+  culler->visible_count = count;
+
+  culler->last = stats;
+  culler->total.tested += stats.tested;
+  culler->total.frustum_culled += stats.frustum_culled;
+  culler->total.occlusion_culled += stats.occlusion_culled;
+  culler->total.visible += stats.visible;
+  culler->frames++;
+  return count;
+}
+
+void CullerPrintStats(const Culler *culler) {
+  if (culler->frames == 0)
+    return;
+  double frames = (double)culler->frames;
+  printf("Culling (%s): per frame %.1f tested, %.1f frustum culled, %.1f occluded, %.1f visible\n", culler->backend,
+         culler->total.tested / frames, culler->total.frustum_culled / frames,
+         culler->total.occlusion_culled / frames, culler->total.visible / frames);
+}
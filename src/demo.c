@@ -0,0 +1,534 @@
+#include "demo.h"
+#include "image.h"
+#include "lod.h"
+#include "mesh_cache.h"
+#include "shaders.h"
+#include "vertex_layout.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static bool fail(const char *what) {
+  printf("Demo: %s\n", what);
+  return false;
+}
+
+static ShaderLoadResult loadShader(const Pack *assets, const char *vertex_path, const char *fragment_path,
+                                   GLuint *program) {
+  if (assets)
+    return ShaderLoadFromPack(assets, vertex_path, fragment_path, program);
+  return ShaderLoadFromDisk(vertex_path, fragment_path, program);
+}
+
+static unsigned char *loadImage(const Pack *assets, const char *path, int *width, int *height, int *channels) {
+  if (!assets)
+    return stbi_load(path, width, height, channels, 0);
+
+  PackEntry entry;
+  if (PackFind(assets, path, &entry) != PACK_SUCCESS)
+    return NULL;
+  if (entry.codec == PACK_CODEC_NONE)
+    return stbi_load_from_memory(entry.data, (int)entry.size, width, height, channels, 0);
+
+  unsigned char *encoded = ArenaScratchAlloc(entry.size);
+  unsigned char *pixels = NULL;
+  if (encoded && PackDecompress(&entry, encoded, entry.size) == PACK_SUCCESS)
+    pixels = stbi_load_from_memory(encoded, (int)entry.size, width, height, channels, 0);
+  ArenaScratchFree(encoded);
+  return pixels;
+}
+
+// Reads an asset into scratch memory (or points into the pack); free with ArenaScratchFree
+static const void *readAsset(const Pack *assets, const char *path, size_t *size, void **scratch) {
+  *scratch = NULL;
+  PackEntry entry;
+  if (assets) {
+    if (PackFind(assets, path, &entry) != PACK_SUCCESS)
+      return NULL;
+    *size = entry.size;
+    if (entry.codec == PACK_CODEC_NONE)
+      return entry.data;
+    *scratch = ArenaScratchAlloc(entry.size);
+    if (!*scratch || PackDecompress(&entry, *scratch, entry.size) != PACK_SUCCESS)
+      return NULL;
+    return *scratch;
+  }
+
+  FILE *file = fopen(path, "rb");
+  if (!file)
+    return NULL;
+  fseek(file, 0, SEEK_END);
+  long length = ftell(file);
+  rewind(file);
+  *scratch = ArenaScratchAlloc(length > 0 ? (size_t)length : 1);
+  bool read = *scratch && fread(*scratch, 1, (size_t)length, file) == (size_t)length;
+  fclose(file);
+  *size = (size_t)length;
+  return read ? *scratch : NULL;
+}
+
+// Vertex attributes by location: 0 position, 1 color, 2 uv
+static void meshSources(const Mesh *mesh, const VertexLayout *layout, VertexSource *sources) {
+  for (size_t a = 0; a < layout->count; a++) {
+    switch (layout->attributes[a].location) {
+    case 0:
+      sources[a] = (VertexSource){mesh->positions, 3, 3};
+      break;
+    case 1:
+      sources[a] = (VertexSource){mesh->colors, mesh->colors ? 3 : 0, 3};
+      break;
+    default:
+      sources[a] = (VertexSource){mesh->uvs, mesh->uvs ? 2 : 0, 2};
+      break;
+    }
+  }
+}
+
+// Loads `path` through its binary cache, `<path>.meshcache`, looked up like any other asset.
+// A missing or stale cache is rebuilt from the source and, for loose files, written back so
+// the next launch skips parsing.
+static bool loadMesh(const Pack *assets, const char *path, const VertexLayout *layout, MeshCache *cache) {
+  void *scratch;
+  size_t size;
+  const void *source = readAsset(assets, path, &size, &scratch);
+  if (!source) {
+    ArenaScratchFree(scratch);
+    return false;
+  }
+  uint64_t source_hash = MeshCacheHash(source, size);
+
+  char cache_path[4096];
+  snprintf(cache_path, sizeof(cache_path), "%s.meshcache", path);
+  MeshCacheResult result = MESH_CACHE_FAILED_OPEN;
+  PackEntry entry;
+  if (!assets)
+    result = MeshCacheOpen(cache_path, source_hash, layout, 1, cache);
+  else if (PackFind(assets, cache_path, &entry) == PACK_SUCCESS && entry.codec == PACK_CODEC_NONE)
+    result = MeshCacheView(entry.data, entry.size, source_hash, layout, 1, cache);
+  if (result == MESH_CACHE_SUCCESS) {
+    printf("Mesh %s: %u vertices, %u triangles from cache\n", path, cache->header->vertex_count,
+           cache->header->index_count / 3);
+    ArenaScratchFree(scratch);
+    return true;
+  }
+
+  Mesh mesh;
+  MeshImportStats stats;
+  MeshResult imported = MeshImport(path, source, size, &mesh, &stats);
+  ArenaScratchFree(scratch);
+  if (imported != MESH_SUCCESS)
+    return false;
+  MeshPrintStats(path, &mesh, &stats);
+  VertexSource sources[VERTEX_MAX_ATTRIBUTES];
+  meshSources(&mesh, layout, sources);
+  MeshCacheStreamDesc stream = {layout, sources};
+  MeshLodChain lods;
+  result = MESH_CACHE_FAILED_WRITE;
+  if (MeshBuildLods(&mesh, MESH_MAX_LODS, &lods)) {
+    result = MeshCacheBuild(source_hash, &mesh, &stream, 1, NULL, 0, &lods, cache);
+    MeshLodChainFree(&lods);
+  }
+  MeshFree(&mesh);
+  if (result != MESH_CACHE_SUCCESS)
+    return false;
+  if (!assets && MeshCacheWrite(cache_path, cache) != MESH_CACHE_SUCCESS)
+    printf("Mesh %s: could not write %s\n", path, cache_path);
+  return true;
+}
+
+static void decodeImageJob(void *data) {
+  DemoImage *job = data;
+  Arena *previous = ArenaThreadCurrent();
+  ArenaBindThread(&job->arena);
+  job->pixels = loadImage(job->assets, job->path, &job->width, &job->height, &job->channels);
+  ArenaBindThread(previous);
+}
+
+static void releaseImage(void *data) {
+  DemoImage *job = data;
+  ArenaPrintStats(&job->arena, job->path);
+  ArenaDestroy(&job->arena);
+}
+
+static bool requestTexture(Uploader *uploader, TextureAtlas *atlas, UploadRequest *request, DemoImage *image,
+                           GLenum format, AtlasRegion *region) {
+  memset(request, 0, sizeof(*request));
+  request->data = image->pixels;
+  request->release = releaseImage;
+  request->user = image;
+  return TextureAtlasAdd(atlas, uploader, request, image->width, image->height, format, region);
+}
+
+static DemoMeshDraw meshDraw(GLuint vertex_array, const MeshCache *cache) {
+  DemoMeshDraw draw = {vertex_array, true, cache->header->lod_count, {0}, {0}, {0}};
+  if (draw.lod_count > MESH_MAX_LODS)
+    draw.lod_count = MESH_MAX_LODS;
+  for (uint32_t l = 0; l < draw.lod_count; l++) {
+    draw.first[l] = (GLint)cache->lods[l].index_offset;
+    draw.count[l] = (GLsizei)cache->lods[l].index_count;
+    draw.error[l] = cache->lods[l].error;
+  }
+  return draw;
+}
+
+// Uploads a cached mesh straight from its mapping into the bound vertex array
+static void uploadMesh(const MeshCache *cache, const VertexLayout *layout, GLuint vertex_buffer,
+                       GLuint index_buffer) {
+  glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+  glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)cache->header->streams[0].size, MeshCacheStreamData(cache, 0),
+               GL_STATIC_DRAW);
+  VertexLayoutApply(layout);
+  // An EBO stores indices of what vertices (contained in a VBO) to draw (indexed drawing)
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)(cache->header->index_count * sizeof(uint32_t)), cache->indices,
+               GL_STATIC_DRAW);
+}
+
+static float breathAt(double time) { return sinf((float)time) * 0.5f + 0.5f; }
+
+static void setupTexturedProgram(RenderCommandList *list, void *user) {
+  Demo *demo = user;
+  const float *uv0 = demo->region0.uv, *uv1 = demo->region1.uv;
+  RenderCmdUniform1i(list, demo->atlasLocation, 0);
+  RenderCmdUniform4f(list, demo->uvRect0Location, uv0[0], uv0[1], uv0[2], uv0[3]);
+  RenderCmdUniform4f(list, demo->uvRect1Location, uv1[0], uv1[1], uv1[2], uv1[3]);
+  RenderCmdUniform1f(list, demo->layer0Location, (float)demo->region0.layer);
+  RenderCmdUniform1f(list, demo->layer1Location, (float)demo->region1.layer);
+  RenderCmdUniform1f(list, demo->mixAmountLocation, demo->texture_mix);
+}
+
+// Shaders and GL state; every other asset is read into `arena`
+static bool loadPrograms(Demo *demo, Arena *arena) {
+  if (loadShader(demo->assets, "shaders/fixed.vertex.glsl", "shaders/fixed.fragment.glsl", &demo->fShader) !=
+      SUCCESS)
+    return fail("could not compile the fixed shader");
+  ArenaReset(arena);
+  if (loadShader(demo->assets, "shaders/texture.vertex.glsl", "shaders/texture.fragment.glsl", &demo->tShader) !=
+      SUCCESS)
+    return fail("could not compile the texture shader");
+  ArenaReset(arena);
+  if (loadShader(demo->assets, "shaders/breathing.vertex.glsl", "shaders/breathing.fragment.glsl",
+                 &demo->bShader) != SUCCESS)
+    return fail("could not compile the breathing shader");
+  ArenaReset(arena);
+  if (!UniformRingInit(&demo->frame_uniforms, FRAME_UNIFORM_BINDING, sizeof(FrameUniforms)))
+    return fail("frame uniforms do not fit the uniform ring");
+  if (!UniformRingBindProgram(&demo->frame_uniforms, demo->bShader, "Frame"))
+    return fail("the breathing shader has no Frame block");
+  AnimationClockInit(&demo->clock, ANIMATION_DEFAULT_STEP);
+  demo->breath_previous = demo->breath_current = breathAt(0.0);
+
+  demo->atlasLocation = glGetUniformLocation(demo->tShader, "atlas");
+  demo->uvRect0Location = glGetUniformLocation(demo->tShader, "uvRect0");
+  demo->uvRect1Location = glGetUniformLocation(demo->tShader, "uvRect1");
+  demo->layer0Location = glGetUniformLocation(demo->tShader, "layer0");
+  demo->layer1Location = glGetUniformLocation(demo->tShader, "layer1");
+  demo->mixAmountLocation = glGetUniformLocation(demo->tShader, "mixAmount");
+  demo->materials[DEMO_MATERIAL_VERTEX_COLOR] =
+      (DemoMaterial){demo->fShader, glGetUniformLocation(demo->fShader, "model"), DEMO_TEXTURE_SET_NONE};
+  demo->materials[DEMO_MATERIAL_TEXTURED] =
+      (DemoMaterial){demo->tShader, glGetUniformLocation(demo->tShader, "model"), DEMO_TEXTURE_SET_CONTAINER};
+  demo->materials[DEMO_MATERIAL_BREATHING] =
+      (DemoMaterial){demo->bShader, glGetUniformLocation(demo->bShader, "model"), DEMO_TEXTURE_SET_NONE};
+  if (!RenderQueueInit(&demo->queue, 64))
+    return fail("could not allocate the render queue");
+  RenderQueueSetProgram(&demo->queue, DEMO_MATERIAL_VERTEX_COLOR, demo->fShader, NULL, NULL);
+  RenderQueueSetProgram(&demo->queue, DEMO_MATERIAL_TEXTURED, demo->tShader, setupTexturedProgram, demo);
+  RenderQueueSetProgram(&demo->queue, DEMO_MATERIAL_BREATHING, demo->bShader, NULL, NULL);
+  RenderTargetPoolInit(&demo->targets);
+  RenderGraphInit(&demo->graph);
+  if (!PostChainInit(&demo->post))
+    return fail("could not create the post-process chain");
+  return true;
+}
+
+bool DemoLoad(Demo *demo, const Pack *assets, Uploader *uploader, JobSystem *jobs, bool occlusion) {
+  memset(demo, 0, sizeof(*demo));
+  demo->assets = assets;
+  demo->polygon_mode = GL_FILL;
+  demo->texture_mix = 0.2f;
+  demo->lod_pixel_error = LOD_DEFAULT_PIXEL_ERROR;
+
+  // Images decode on the workers while shaders compile here
+  demo->images[0] = (DemoImage){.path = "data/container.jpg", .assets = assets};
+  demo->images[1] = (DemoImage){.path = "data/awesomeface.png", .assets = assets};
+  JobCounter images_decoded = {0};
+  for (size_t i = 0; i < sizeof(demo->images) / sizeof(demo->images[0]); i++) {
+    if (!ArenaInit(&demo->images[i].arena, 8 * 1024 * 1024))
+      return fail("could not allocate an image arena");
+    JobsRun(jobs, decodeImageJob, &demo->images[i], &images_decoded);
+  }
+
+  // Every other asset is read into this arena, which is reset once the GPU has a copy
+  Arena load_arena;
+  if (!ArenaInit(&load_arena, 1024 * 1024)) {
+    JobsWait(jobs, &images_decoded);
+    return fail("could not allocate the load arena");
+  }
+  Arena *previous_arena = ArenaThreadCurrent();
+  ArenaBindThread(&load_arena);
+
+  // Rectangle: 16 bytes per vertex instead of 32 with half positions, 8-bit colors and 16-bit UVs.
+  // The triangle has no UVs.
+  VertexLayout rect_layout, tri_layout;
+  VertexLayoutInit(&rect_layout);
+  VertexLayoutAdd(&rect_layout, 0, VERTEX_FORMAT_HALF4);
+  VertexLayoutAdd(&rect_layout, 1, VERTEX_FORMAT_UNORM8X4);
+  VertexLayoutAdd(&rect_layout, 2, VERTEX_FORMAT_UNORM16X2);
+  VertexLayoutInit(&tri_layout);
+  VertexLayoutAdd(&tri_layout, 0, VERTEX_FORMAT_HALF4);
+  VertexLayoutAdd(&tri_layout, 1, VERTEX_FORMAT_UNORM8X4);
+  MeshCache rectangle_mesh, triangle_mesh;
+  bool loaded = loadMesh(assets, "data/rectangle.obj", &rect_layout, &rectangle_mesh);
+  if (loaded && !loadMesh(assets, "data/triangle.obj", &tri_layout, &triangle_mesh)) {
+    MeshCacheClose(&rectangle_mesh);
+    loaded = false;
+  }
+  if (!loaded)
+    fail("could not load the meshes");
+  else if (!loadPrograms(demo, &load_arena))
+    loaded = false;
+  ArenaReset(&load_arena);
+
+  if (loaded) {
+    glGenBuffers(4, demo->buffers);
+    glGenVertexArrays(1, &demo->VAO_rect);
+    glGenVertexArrays(1, &demo->VAO_tri);
+    // vertex array must be bound before buffers! attributes are linked to a buffer
+    glBindVertexArray(demo->VAO_rect);
+    uploadMesh(&rectangle_mesh, &rect_layout, demo->buffers[0], demo->buffers[1]);
+    glBindVertexArray(demo->VAO_tri);
+    uploadMesh(&triangle_mesh, &tri_layout, demo->buffers[2], demo->buffers[3]);
+    glBindVertexArray(0); // reset bound vao
+
+    const float *sphere = triangle_mesh.header->sphere;
+    demo->meshes[DEMO_MESH_TRIANGLE] = meshDraw(demo->VAO_tri, &triangle_mesh);
+    demo->mesh_bounds[DEMO_MESH_TRIANGLE] = Vec4Make(sphere[0], sphere[1], sphere[2], sphere[3]);
+    sphere = rectangle_mesh.header->sphere;
+    demo->meshes[DEMO_MESH_RECTANGLE] = meshDraw(demo->VAO_rect, &rectangle_mesh);
+    demo->mesh_bounds[DEMO_MESH_RECTANGLE] = Vec4Make(sphere[0], sphere[1], sphere[2], sphere[3]);
+    MeshCacheClose(&triangle_mesh);
+    MeshCacheClose(&rectangle_mesh);
+  }
+  ArenaPrintStats(&load_arena, "load");
+  ArenaBindThread(previous_arena);
+  ArenaDestroy(&load_arena);
+
+  // Textures go to the uploader; with a loader thread the upload overlaps the first frames
+  JobsWait(jobs, &images_decoded);
+  if (!loaded)
+    return false;
+  if (!demo->images[0].pixels || !demo->images[1].pixels)
+    return fail("could not load the textures");
+  if (!TextureAtlasInit(&demo->atlas, 1024, 1024, 4, 4))
+    return fail("could not create the texture atlas");
+  if (!requestTexture(uploader, &demo->atlas, &demo->texture0, &demo->images[0], GL_RGB, &demo->region0) ||
+      !requestTexture(uploader, &demo->atlas, &demo->texture1, &demo->images[1], GL_RGBA, &demo->region1))
+    return fail("the texture atlas is full");
+  if (!TextureAtlasGenerateMipmaps(&demo->atlas, uploader, &demo->texture_mips))
+    return fail("could not queue the texture atlas mipmaps");
+
+  // The shapes are placed directly in clip space, so the camera stays at identity. The occlusion
+  // pass only runs under a perspective projection.
+  if (!SceneInit(&demo->entities, 16) || !CullerInit(&demo->culler, demo->entities.capacity, occlusion))
+    return fail("could not allocate the scene");
+  demo->triangle = SceneCreateEntity(&demo->entities);
+  SceneSetMesh(&demo->entities, demo->triangle, DEMO_MESH_TRIANGLE);
+  SceneSetMaterial(&demo->entities, demo->triangle, DEMO_MATERIAL_VERTEX_COLOR);
+  SceneSetVisibility(&demo->entities, demo->triangle, 0);
+  demo->rectangle = SceneCreateEntity(&demo->entities);
+  SceneSetMesh(&demo->entities, demo->rectangle, DEMO_MESH_RECTANGLE);
+  SceneSetMaterial(&demo->entities, demo->rectangle, DEMO_MATERIAL_TEXTURED);
+  return true;
+}
+
+void DemoDestroy(Demo *demo) {
+  UniformRingDestroy(&demo->frame_uniforms);
+  ParticleSystemDestroy(&demo->particles);
+  PostChainDestroy(&demo->post);
+  RenderTargetPoolDestroy(&demo->targets);
+  TextureAtlasDestroy(&demo->atlas);
+  glDeleteVertexArrays(1, &demo->VAO_rect);
+  glDeleteVertexArrays(1, &demo->VAO_tri);
+  glDeleteBuffers(4, demo->buffers);
+  RenderQueueDestroy(&demo->queue);
+  CullerDestroy(&demo->culler);
+  SceneDestroy(&demo->entities);
+}
+
+bool DemoBuildPostChain(Demo *demo, const char *passes) {
+  char list[256];
+  snprintf(list, sizeof(list), "%s", passes);
+  GLuint tonemap = 0, fxaa = 0, blur = 0;
+  for (char *name = strtok(list, ", "); name; name = strtok(NULL, ", ")) {
+    ShaderLoadResult res = SUCCESS;
+    if (strcmp(name, "tonemap") == 0) {
+      if (!tonemap)
+        res = loadShader(demo->assets, "shaders/post.vertex.glsl", "shaders/tonemap.fragment.glsl", &tonemap);
+      PostPass *pass = PostChainAdd(&demo->post, "tonemap", tonemap, 1.0f, GL_RGBA8);
+      if (pass)
+        pass->params[0] = pass->params[1] = 1.0f; // exposure, white point
+    } else if (strcmp(name, "fxaa") == 0) {
+      if (!fxaa)
+        res = loadShader(demo->assets, "shaders/post.vertex.glsl", "shaders/fxaa.fragment.glsl", &fxaa);
+      PostChainAdd(&demo->post, "fxaa", fxaa, 1.0f, GL_RGBA8);
+    } else if (strcmp(name, "blur") == 0) {
+      if (!blur)
+        res = loadShader(demo->assets, "shaders/post.vertex.glsl", "shaders/blur.fragment.glsl", &blur);
+      PostPass *horizontal = PostChainAdd(&demo->post, "blur horizontal", blur, 1.0f, GL_RGBA8);
+      PostPass *vertical = PostChainAdd(&demo->post, "blur vertical", blur, 1.0f, GL_RGBA8);
+      if (horizontal && vertical) {
+        horizontal->params[0] = 1.0f;
+        vertical->params[1] = 1.0f;
+      }
+    } else if (strcmp(name, "none") != 0) {
+      printf("Post chain: unknown pass '%s'\n", name);
+    }
+    if (res != SUCCESS)
+      return fail("could not compile a post-process shader");
+  }
+  return true;
+}
+
+bool DemoStartParticles(Demo *demo, size_t capacity, ParticleBackend backend, JobSystem *jobs) {
+  GLuint update = 0, draw;
+  if (backend == PARTICLE_BACKEND_GPU) {
+    static const char *const varyings[] = {"positionLife", "velocityLifetime"};
+    if (loadShader(demo->assets, "shaders/particle_update.vertex.glsl", "shaders/particle_update.fragment.glsl",
+                   &update) != SUCCESS)
+      return fail("could not compile the particle update shader");
+    if (ShaderCaptureVaryings(update, varyings, 2) != SUCCESS)
+      return fail("could not link the particle update shader for transform feedback");
+  }
+  if (loadShader(demo->assets, "shaders/particle.vertex.glsl", "shaders/particle.fragment.glsl", &draw) != SUCCESS)
+    return fail("could not compile the particle shader");
+  ParticleSystem *particles = &demo->particles;
+  if (!ParticleSystemInit(particles, backend, capacity, jobs, update, draw))
+    return fail("could not allocate the particles");
+  particles->emitter.position = Vec3Make(0.0f, -0.8f, 0.0f);
+  particles->emitter.velocity = Vec3Make(0.0f, 1.6f, 0.0f);
+  particles->emitter.spread = 0.5f;
+  particles->emitter.lifetime = 2.0f;
+  particles->emitter.rate = (float)capacity / particles->emitter.lifetime;
+  particles->gravity = Vec3Make(0.0f, -1.5f, 0.0f);
+  particles->drag = 0.1f;
+  return true;
+}
+
+// Animated state only changes in fixed steps; recording blends the last two
+void DemoUpdate(Demo *demo, double now) {
+  AnimationClock *clock = &demo->clock;
+  size_t steps = AnimationClockAdvance(clock, now);
+  demo->animation_dt = (float)((double)steps * clock->step);
+  for (size_t i = 0; i < steps; i++) {
+    demo->breath_previous = demo->breath_current;
+    demo->breath_current = breathAt(clock->time - (double)(steps - 1 - i) * clock->step);
+  }
+  SceneUpdateTransforms(&demo->entities);
+}
+
+void DemoCull(Demo *demo) {
+  CullerUpdateBounds(&demo->culler, &demo->entities, demo->mesh_bounds);
+  CullerRun(&demo->culler, &demo->entities, VISIBILITY_VISIBLE);
+}
+
+// Textures come from the uploader; the replaying thread waits on their fences once
+static bool texturesReady(RenderCommandList *list, Demo *demo) {
+  if (demo->textures_synced)
+    return true;
+  if (UploadPoll(&demo->texture0) != UPLOAD_READY || UploadPoll(&demo->texture1) != UPLOAD_READY ||
+      UploadPoll(&demo->texture_mips) != UPLOAD_READY)
+    return false;
+  RenderCmdWaitSync(list, demo->texture0.fence);
+  RenderCmdWaitSync(list, demo->texture1.fence);
+  RenderCmdWaitSync(list, demo->texture_mips.fence);
+  // Both images live in the atlas, so the set is a single binding
+  RenderQueueSetTextures(&demo->queue, DEMO_TEXTURE_SET_CONTAINER, GL_TEXTURE_2D_ARRAY, &demo->atlas.texture, 1);
+  demo->textures_synced = true;
+  return true;
+}
+
+// Draws go through the queue so state only changes where the sort key does
+static void scenePass(RenderCommandList *list, const RenderGraphContext *context, void *user) {
+  Demo *demo = user;
+  RenderCmdClear(list, 0.2f, 0.3f, 0.3f, 1.0f, GL_COLOR_BUFFER_BIT | (context->depth ? GL_DEPTH_BUFFER_BIT : 0));
+  RenderCmdPolygonMode(list, demo->polygon_mode);
+
+  Scene *entities = &demo->entities;
+  bool textures_ready = texturesReady(list, demo);
+  RenderQueueReset(&demo->queue);
+  LodSelector lods;
+  LodSelectorInit(&lods, &demo->culler.view, &demo->culler.projection, context->height, demo->lod_pixel_error);
+  for (size_t i = 0; i < demo->culler.visible_count; i++) {
+    uint32_t slot = demo->culler.visible[i];
+    const DemoMaterial *material = &demo->materials[entities->material[slot]];
+    if (material->textureSet != DEMO_TEXTURE_SET_NONE && !textures_ready)
+      continue;
+
+    const DemoMeshDraw *mesh = &demo->meshes[entities->mesh[slot]];
+    Vec4 bounds = demo->mesh_bounds[entities->mesh[slot]];
+    uint32_t lod = LodSelect(&lods, &entities->world[slot], Vec4XYZ(bounds), bounds.w, mesh->error, mesh->lod_count);
+    // the shapes sit in clip space, so z maps straight to depth
+    float depth = entities->world[slot].m[14] * 0.5f + 0.5f;
+    uint64_t key = RenderKeyMake(0, entities->material[slot], material->textureSet, entities->mesh[slot], depth);
+    RenderDraw *draw = RenderQueuePush(&demo->queue, key);
+    if (!draw)
+      break;
+    draw->vertex_array = mesh->vertex_array;
+    draw->mode = GL_TRIANGLES;
+    draw->first = mesh->first[lod];
+    draw->count = mesh->count[lod];
+    draw->index_type = mesh->indexed ? GL_UNSIGNED_INT : 0;
+    draw->model_location = material->modelLocation;
+    memcpy(draw->model, entities->world[slot].m, sizeof(draw->model));
+  }
+  RenderQueueSort(&demo->queue);
+  RenderQueueSubmit(&demo->queue, list);
+  if (demo->particles.capacity > 0)
+    ParticleSystemRecordDraw(&demo->particles, list, context->width, context->height);
+}
+
+bool DemoRecordFrame(Demo *demo, RenderCommandList *list, GLsizei width, GLsizei height) {
+  // Every animated material reads these from the same block, whatever program draws it
+  FrameUniforms uniforms;
+  AnimationClockFrameUniforms(&demo->clock, &uniforms);
+  float breath = AnimationLerp(demo->breath_previous, demo->breath_current, uniforms.time[2]);
+  memcpy(uniforms.breath_color, (float[4]){0.0f, breath, 0.0f, 1.0f}, sizeof(uniforms.breath_color));
+  UniformRingRecordUpdate(&demo->frame_uniforms, list, &uniforms);
+  if (demo->particles.capacity > 0)
+    ParticleSystemRecordUpdate(&demo->particles, list, demo->animation_dt);
+
+  RenderGraph *graph = &demo->graph;
+  RenderGraphReset(graph);
+  RenderGraphResource backbuffer = RenderGraphImportBackbuffer(graph, width, height);
+  RenderGraphPassId pass = RenderGraphAddPass(graph, "scene", scenePass, demo);
+  if (demo->post.count == 0) {
+    RenderGraphWrite(graph, pass, backbuffer);
+  } else {
+    RenderTargetDesc color = {width, height, POST_SCENE_FORMAT};
+    RenderTargetDesc depth = {width, height, POST_DEPTH_FORMAT};
+    RenderGraphResource scene_color = RenderGraphCreateTexture(graph, "scene color", &color);
+    RenderGraphWrite(graph, pass, scene_color);
+    RenderGraphWrite(graph, pass, RenderGraphCreateTexture(graph, "scene depth", &depth));
+    PostChainDeclare(&demo->post, graph, scene_color, backbuffer);
+  }
+  // Nothing to draw into while minimized
+  bool drawn = width > 0 && height > 0 && RenderGraphCompile(graph);
+  if (drawn)
+    RenderGraphExecute(graph, list, &demo->targets);
+  RenderTargetPoolEndFrame(&demo->targets, list);
+  return drawn;
+}
+
+void DemoPrintStats(const Demo *demo) {
+  RenderGraphPrintStats(&demo->graph);
+  RenderTargetPoolPrintStats(&demo->targets);
+  AnimationClockPrintStats(&demo->clock);
+  UniformRingPrintStats(&demo->frame_uniforms);
+  if (demo->particles.capacity > 0)
+    ParticleSystemPrintStats(&demo->particles);
+  CullerPrintStats(&demo->culler);
+  RenderQueuePrintStats(&demo->queue);
+  TextureAtlasPrintStats(&demo->atlas);
+}
@@ -0,0 +1,66 @@
+#include "frame.h"
+#include <GLFW/glfw3.h>
+#include <stdio.h>
+#include <string.h>
+
+static size_t findStage(const FrameLoop *loop, const char *name) {
+  for (size_t i = 0; i < loop->stage_count; i++) {
+    if (strcmp(loop->stages[i].name, name) == 0)
+      return i;
+  }
+  return loop->stage_count;
+}
+
+void FrameLoopInit(FrameLoop *loop) { memset(loop, 0, sizeof(*loop)); }
+
+bool FrameLoopAddStage(FrameLoop *loop, const char *name, FrameStageFn run, void *user) {
+  return FrameLoopInsertStage(loop, NULL, name, run, user);
+}
+
+bool FrameLoopInsertStage(FrameLoop *loop, const char *before, const char *name, FrameStageFn run, void *user) {
+  if (loop->stage_count == FRAME_MAX_STAGES)
+    return false;
+
+  size_t index = before ? findStage(loop, before) : loop->stage_count;
+  memmove(&loop->stages[index + 1], &loop->stages[index], (loop->stage_count - index) * sizeof(FrameStage));
+  FrameStage stage = {name, run, user, 0.0, 0.0, 0.0};
+  loop->stages[index] = stage;
+  loop->stage_count++;
+  return true;
+}
+
+bool FrameLoopRemoveStage(FrameLoop *loop, const char *name) {
+  size_t index = findStage(loop, name);
+  if (index == loop->stage_count)
+    return false;
+  memmove(&loop->stages[index], &loop->stages[index + 1], (loop->stage_count - index - 1) * sizeof(FrameStage));
+  loop->stage_count--;
+  return true;
+}
+
+void FrameLoopRunFrame(FrameLoop *loop) {
+  double start = glfwGetTime();
+  for (size_t i = 0; i < loop->stage_count; i++) {
+    FrameStage *stage = &loop->stages[i];
+    stage->run(stage->user);
+
+    double end = glfwGetTime();
+    stage->last_time = end - start;
+    stage->total_time += stage->last_time;
+    if (stage->last_time > stage->max_time)
+      stage->max_time = stage->last_time;
+    start = end;
+  }
+  loop->frames++;
+}
+
+void FrameLoopPrintTimings(const FrameLoop *loop) {
+  if (loop->frames == 0)
+    return;
+  printf("Frame stages over %zu frames:\n", loop->frames);
+  for (size_t i = 0; i < loop->stage_count; i++) {
+    const FrameStage *stage = &loop->stages[i];
+    printf("  %-12s avg %8.3f ms  max %8.3f ms\n", stage->name, 1000.0 * stage->total_time / (double)loop->frames,
+           1000.0 * stage->max_time);
+  }
+}
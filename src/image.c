@@ -0,0 +1,8 @@
+#include "arena.h"
+
+// stb_image scratch and result buffers come from the calling thread's arena when one is bound
+#define STBI_MALLOC(sz) ArenaScratchAlloc(sz)
+#define STBI_REALLOC_SIZED(p, oldsz, newsz) ArenaScratchRealloc(p, oldsz, newsz)
+#define STBI_FREE(p) ArenaScratchFree(p)
+#define STB_IMAGE_IMPLEMENTATION
+#include "image.h"
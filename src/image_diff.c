@@ -0,0 +1,135 @@
+#include "image_diff.h"
+#include "vecmath.h"
+#include <math.h>
+#include <string.h>
+
+#define YIQ_MAX_DELTA 35215.0f // delta between black and white
+#define DIFF_FLUSH_PIXELS 4096 // float lane sums are moved to the double total this often
+
+float ImageDiffPixel(const unsigned char *a, const unsigned char *b) {
+  float dr = (float)a[0] - (float)b[0];
+  float dg = (float)a[1] - (float)b[1];
+  float db = (float)a[2] - (float)b[2];
+  float y = 0.29889531f * dr + 0.58662247f * dg + 0.11448223f * db;
+  float i = 0.59597799f * dr - 0.27417610f * dg - 0.32180189f * db;
+  float q = 0.21147017f * dr - 0.52261711f * dg + 0.31114694f * db;
+  return sqrtf((0.5053f * y * y + 0.299f * i * i + 0.1957f * q * q) / YIQ_MAX_DELTA);
+}
+
+static void diffScalar(const unsigned char *a, const unsigned char *b, size_t begin, size_t end, float threshold,
+                       ImageDiffStats *stats, double *sum) {
+  for (size_t p = begin; p < end; p++) {
+    const unsigned char *pa = a + p * 4, *pb = b + p * 4;
+    for (int c = 0; c < 3; c++) {
+      unsigned d = pa[c] > pb[c] ? pa[c] - pb[c] : pb[c] - pa[c];
+      if (d > stats->max_channel)
+        stats->max_channel = d;
+    }
+    float error = ImageDiffPixel(pa, pb);
+    *sum += error;
+    stats->differing += error > threshold;
+    if (error > stats->max_error)
+      stats->max_error = error;
+  }
+}
+
+void ImageDiff(const unsigned char *a, const unsigned char *b, size_t pixel_count, float threshold,
+               ImageDiffStats *stats) {
+  memset(stats, 0, sizeof(*stats));
+  stats->pixels = pixel_count;
+  double sum = 0.0;
+  size_t p = 0;
+
+#if defined(VECMATH_SSE)
+  const __m128i byte_mask = _mm_set1_epi32(0xff), rgb_mask = _mm_set1_epi32(0x00ffffff);
+  const __m128 limit = _mm_set1_ps(threshold), scale = _mm_set1_ps(1.0f / YIQ_MAX_DELTA);
+  __m128i channel_max = _mm_setzero_si128(), differing = _mm_setzero_si128();
+  __m128 error_max = _mm_setzero_ps();
+  while (p + 4 <= pixel_count) {
+    size_t end = p + DIFF_FLUSH_PIXELS < pixel_count ? p + DIFF_FLUSH_PIXELS : pixel_count;
+    __m128 lane_sum = _mm_setzero_ps();
+    for (; p + 4 <= end; p += 4) {
+      __m128i va = _mm_loadu_si128((const __m128i *)(a + p * 4));
+      __m128i vb = _mm_loadu_si128((const __m128i *)(b + p * 4));
+      __m128i absolute = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+      channel_max = _mm_max_epu8(channel_max, _mm_and_si128(absolute, rgb_mask));
+      __m128 dr = _mm_sub_ps(_mm_cvtepi32_ps(_mm_and_si128(va, byte_mask)),
+                             _mm_cvtepi32_ps(_mm_and_si128(vb, byte_mask)));
+      __m128 dg = _mm_sub_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(va, 8), byte_mask)),
+                             _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(vb, 8), byte_mask)));
+      __m128 db = _mm_sub_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(va, 16), byte_mask)),
+                             _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(vb, 16), byte_mask)));
+      __m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, _mm_set1_ps(0.29889531f)),
+                                       _mm_mul_ps(dg, _mm_set1_ps(0.58662247f))),
+                            _mm_mul_ps(db, _mm_set1_ps(0.11448223f)));
+      __m128 i = _mm_sub_ps(_mm_sub_ps(_mm_mul_ps(dr, _mm_set1_ps(0.59597799f)),
+                                       _mm_mul_ps(dg, _mm_set1_ps(0.27417610f))),
+                            _mm_mul_ps(db, _mm_set1_ps(0.32180189f)));
+      __m128 q = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(dr, _mm_set1_ps(0.21147017f)),
+                                       _mm_mul_ps(dg, _mm_set1_ps(0.52261711f))),
+                            _mm_mul_ps(db, _mm_set1_ps(0.31114694f)));
+      __m128 delta = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(y, y), _mm_set1_ps(0.5053f)),
+                                           _mm_mul_ps(_mm_mul_ps(i, i), _mm_set1_ps(0.299f))),
+                                _mm_mul_ps(_mm_mul_ps(q, q), _mm_set1_ps(0.1957f)));
+      __m128 error = _mm_sqrt_ps(_mm_mul_ps(delta, scale));
+      lane_sum = _mm_add_ps(lane_sum, error);
+      error_max = _mm_max_ps(error_max, error);
+      // A true comparison is all ones, i.e. -1
+      differing = _mm_sub_epi32(differing, _mm_castps_si128(_mm_cmpgt_ps(error, limit)));
+    }
+    VECMATH_ALIGN16 float sums[4];
+    _mm_store_ps(sums, lane_sum);
+    sum += (double)sums[0] + sums[1] + sums[2] + sums[3];
+  }
+  VECMATH_ALIGN16 unsigned char channels[16];
+  VECMATH_ALIGN16 float maxima[4];
+  VECMATH_ALIGN16 unsigned counts[4];
+  _mm_store_si128((__m128i *)channels, channel_max);
+  _mm_store_ps(maxima, error_max);
+  _mm_store_si128((__m128i *)counts, differing);
+  for (int k = 0; k < 16; k++)
+    stats->max_channel = channels[k] > stats->max_channel ? channels[k] : stats->max_channel;
+  for (int k = 0; k < 4; k++) {
+    stats->max_error = maxima[k] > stats->max_error ? maxima[k] : stats->max_error;
+    stats->differing += counts[k];
+  }
+#elif defined(VECMATH_NEON) && defined(__aarch64__)
+  const uint32x4_t byte_mask = vdupq_n_u32(0xff);
+  const uint8x16_t rgb_mask = vreinterpretq_u8_u32(vdupq_n_u32(0x00ffffff));
+  const float32x4_t limit = vdupq_n_f32(threshold);
+  uint8x16_t channel_max = vdupq_n_u8(0);
+  uint32x4_t differing = vdupq_n_u32(0);
+  float32x4_t error_max = vdupq_n_f32(0.0f);
+  while (p + 4 <= pixel_count) {
+    size_t end = p + DIFF_FLUSH_PIXELS < pixel_count ? p + DIFF_FLUSH_PIXELS : pixel_count;
+    float32x4_t lane_sum = vdupq_n_f32(0.0f);
+    for (; p + 4 <= end; p += 4) {
+      uint8x16_t va = vld1q_u8(a + p * 4), vb = vld1q_u8(b + p * 4);
+      channel_max = vmaxq_u8(channel_max, vandq_u8(vabdq_u8(va, vb), rgb_mask));
+      uint32x4_t wa = vreinterpretq_u32_u8(va), wb = vreinterpretq_u32_u8(vb);
+      float32x4_t dr = vsubq_f32(vcvtq_f32_u32(vandq_u32(wa, byte_mask)), vcvtq_f32_u32(vandq_u32(wb, byte_mask)));
+      float32x4_t dg = vsubq_f32(vcvtq_f32_u32(vandq_u32(vshrq_n_u32(wa, 8), byte_mask)),
+                                 vcvtq_f32_u32(vandq_u32(vshrq_n_u32(wb, 8), byte_mask)));
+      float32x4_t db = vsubq_f32(vcvtq_f32_u32(vandq_u32(vshrq_n_u32(wa, 16), byte_mask)),
+                                 vcvtq_f32_u32(vandq_u32(vshrq_n_u32(wb, 16), byte_mask)));
+      float32x4_t y = vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(dr, 0.29889531f), dg, 0.58662247f), db, 0.11448223f);
+      float32x4_t i = vmlsq_n_f32(vmlsq_n_f32(vmulq_n_f32(dr, 0.59597799f), dg, 0.27417610f), db, 0.32180189f);
+      float32x4_t q = vmlaq_n_f32(vmlsq_n_f32(vmulq_n_f32(dr, 0.21147017f), dg, 0.52261711f), db, 0.31114694f);
+      float32x4_t delta =
+          vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(vmulq_f32(y, y), 0.5053f), vmulq_f32(i, i), 0.299f), vmulq_f32(q, q),
+                      0.1957f);
+      float32x4_t error = vsqrtq_f32(vmulq_n_f32(delta, 1.0f / YIQ_MAX_DELTA));
+      lane_sum = vaddq_f32(lane_sum, error);
+      error_max = vmaxq_f32(error_max, error);
+      differing = vsubq_u32(differing, vcgtq_f32(error, limit));
+    }
+    sum += (double)vaddvq_f32(lane_sum);
+  }
+  stats->max_channel = vmaxvq_u8(channel_max);
+  stats->max_error = vmaxvq_f32(error_max);
+  stats->differing = vaddvq_u32(differing);
+#endif
+
+  diffScalar(a, b, p, pixel_count, threshold, stats, &sum);
+  stats->mean_error = pixel_count ? sum / (double)pixel_count : 0.0;
+}
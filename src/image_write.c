@@ -0,0 +1,243 @@
+#include "image_write.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+static unsigned char *putBE32(unsigned char *out, uint32_t value) {
+  out[0] = (unsigned char)(value >> 24);
+  out[1] = (unsigned char)(value >> 16);
+  out[2] = (unsigned char)(value >> 8);
+  out[3] = (unsigned char)value;
+  return out + 4;
+}
+
+// ---- QOI ------------------------------------------------------------------------------------
+// https://qoiformat.org/qoi-specification.pdf
+
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF 0x40
+#define QOI_OP_LUMA 0x80
+#define QOI_OP_RUN 0xc0
+#define QOI_OP_RGB 0xfe
+#define QOI_OP_RGBA 0xff
+
+typedef union QoiPixel {
+  struct {
+    unsigned char r, g, b, a;
+  };
+  uint32_t value;
+} QoiPixel;
+
+static unsigned qoiHash(QoiPixel p) { return (p.r * 3u + p.g * 5u + p.b * 7u + p.a * 11u) % 64u; }
+
+size_t ImageEncodeQoi(const unsigned char *rgba, int width, int height, unsigned char **encoded) {
+  size_t pixels = (size_t)width * (size_t)height;
+  unsigned char *out = malloc(14 + pixels * 5 + 8);
+  *encoded = out;
+  if (!out)
+    return 0;
+  memcpy(out, "qoif", 4);
+  unsigned char *p = putBE32(putBE32(out + 4, (uint32_t)width), (uint32_t)height);
+  *p++ = 4; // channels
+  *p++ = 0; // sRGB with linear alpha
+
+  QoiPixel index[64];
+  memset(index, 0, sizeof(index));
+  QoiPixel previous = {.a = 255};
+  unsigned run = 0;
+  for (size_t i = 0; i < pixels; i++) {
+    QoiPixel px;
+    memcpy(&px, rgba + i * 4, 4);
+    if (px.value == previous.value) {
+      if (++run == 62 || i + 1 == pixels) {
+        *p++ = (unsigned char)(QOI_OP_RUN | (run - 1));
+        run = 0;
+      }
+      continue;
+    }
+    if (run > 0) {
+      *p++ = (unsigned char)(QOI_OP_RUN | (run - 1));
+      run = 0;
+    }
+    unsigned slot = qoiHash(px);
+    if (index[slot].value == px.value) {
+      *p++ = (unsigned char)(QOI_OP_INDEX | slot);
+      previous = px;
+      continue;
+    }
+    index[slot] = px;
+    if (px.a == previous.a) {
+      int vr = (signed char)(px.r - previous.r), vg = (signed char)(px.g - previous.g);
+      int vb = (signed char)(px.b - previous.b);
+      int vg_r = vr - vg, vg_b = vb - vg;
+      if (vr >= -2 && vr <= 1 && vg >= -2 && vg <= 1 && vb >= -2 && vb <= 1) {
+        *p++ = (unsigned char)(QOI_OP_DIFF | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2));
+      } else if (vg_r >= -8 && vg_r <= 7 && vg >= -32 && vg <= 31 && vg_b >= -8 && vg_b <= 7) {
+        *p++ = (unsigned char)(QOI_OP_LUMA | (vg + 32));
+        *p++ = (unsigned char)((vg_r + 8) << 4 | (vg_b + 8));
+      } else {
+        *p++ = QOI_OP_RGB;
+        *p++ = px.r;
+        *p++ = px.g;
+        *p++ = px.b;
+      }
+    } else {
+      *p++ = QOI_OP_RGBA;
+      memcpy(p, &px, 4);
+      p += 4;
+    }
+    previous = px;
+  }
+  static const unsigned char end[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+  memcpy(p, end, sizeof(end));
+  return (size_t)(p + sizeof(end) - out);
+}
+
+// ---- PNG ------------------------------------------------------------------------------------
+
+typedef struct Crc32 {
+  uint32_t table[256];
+} Crc32;
+
+// Built per image; a kilobyte of work next to megabytes of pixels, and no shared state
+static void crcInit(Crc32 *crc) {
+  for (uint32_t n = 0; n < 256; n++) {
+    uint32_t c = n;
+    for (int k = 0; k < 8; k++)
+      c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+    crc->table[n] = c;
+  }
+}
+
+static uint32_t crcUpdate(const Crc32 *crc, uint32_t c, const unsigned char *data, size_t size) {
+  c = ~c;
+  for (size_t i = 0; i < size; i++)
+    c = crc->table[(c ^ data[i]) & 0xff] ^ (c >> 8);
+  return ~c;
+}
+
+static unsigned char *putChunk(const Crc32 *crc, unsigned char *out, const char *type, const unsigned char *data,
+                               size_t size) {
+  out = putBE32(out, (uint32_t)size);
+  memcpy(out, type, 4);
+  if (size && out + 4 != data)
+    memmove(out + 4, data, size);
+  uint32_t c = crcUpdate(crc, 0, out, 4 + size);
+  return putBE32(out + 4 + size, c);
+}
+
+#ifndef HAVE_ZLIB
+// zlib stream made of stored deflate blocks
+static size_t storeDeflate(const unsigned char *data, size_t size, unsigned char *out) {
+  unsigned char *p = out;
+  *p++ = 0x78;
+  *p++ = 0x01;
+  uint32_t a = 1, b = 0;
+  for (size_t offset = 0; offset < size || offset == 0;) {
+    size_t length = size - offset < 65535 ? size - offset : 65535;
+    *p++ = offset + length == size;
+    p[0] = (unsigned char)length;
+    p[1] = (unsigned char)(length >> 8);
+    p[2] = (unsigned char)~length;
+    p[3] = (unsigned char)(~length >> 8);
+    memcpy(p + 4, data + offset, length);
+    p += 4 + length;
+    for (size_t i = 0; i < length; i++) {
+      a = (a + data[offset + i]) % 65521;
+      b = (b + a) % 65521;
+    }
+    offset += length;
+    if (size == 0)
+      break;
+  }
+  return (size_t)(putBE32(p, b << 16 | a) - out);
+}
+#endif
+
+size_t ImageEncodePng(const unsigned char *rgba, int width, int height, unsigned char **encoded) {
+  *encoded = NULL;
+  size_t row = (size_t)width * 4;
+  size_t raw_size = (row + 1) * (size_t)height;
+  unsigned char *raw = malloc(raw_size);
+  if (!raw)
+    return 0;
+  // Sub filter: each byte minus the same channel of the pixel to its left
+  for (int y = 0; y < height; y++) {
+    const unsigned char *src = rgba + (size_t)y * row;
+    unsigned char *dst = raw + (size_t)y * (row + 1);
+    dst[0] = 1;
+    memcpy(dst + 1, src, 4 < row ? 4 : row);
+    for (size_t x = 4; x < row; x++)
+      dst[1 + x] = (unsigned char)(src[x] - src[x - 4]);
+  }
+
+#ifdef HAVE_ZLIB
+  size_t bound = compressBound((uLong)raw_size);
+#else
+  size_t bound = raw_size + raw_size / 65535 * 5 + 5 + 6;
+#endif
+  unsigned char *out = malloc(8 + 25 + 12 + bound + 12);
+  if (!out) {
+    free(raw);
+    return 0;
+  }
+  Crc32 crc;
+  crcInit(&crc);
+  static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+  memcpy(out, signature, 8);
+  unsigned char header[13];
+  putBE32(putBE32(header, (uint32_t)width), (uint32_t)height);
+  header[8] = 8;  // bits per channel
+  header[9] = 6;  // RGBA
+  header[10] = 0; // deflate
+  header[11] = 0; // adaptive filtering
+  header[12] = 0; // no interlace
+  unsigned char *p = putChunk(&crc, out + 8, "IHDR", header, sizeof(header));
+
+  unsigned char *idat = p + 8;
+#ifdef HAVE_ZLIB
+  uLongf deflated = (uLongf)bound;
+  bool ok = compress2(idat, &deflated, raw, (uLong)raw_size, Z_BEST_SPEED) == Z_OK;
+#else
+  size_t deflated = storeDeflate(raw, raw_size, idat);
+  bool ok = true;
+#endif
+  free(raw);
+  if (!ok) {
+    free(out);
+    return 0;
+  }
+  p = putChunk(&crc, p, "IDAT", idat, (size_t)deflated);
+  p = putChunk(&crc, p, "IEND", NULL, 0);
+  *encoded = out;
+  return (size_t)(p - out);
+}
+
+bool ImageWriteFile(const char *path, const void *data, size_t size) {
+  FILE *file = size ? fopen(path, "wb") : NULL;
+  bool ok = file && fwrite(data, 1, size, file) == size;
+  if (file && fclose(file) != 0)
+    ok = false;
+  return ok;
+}
+
+bool ImageWriteQoi(const char *path, const unsigned char *rgba, int width, int height) {
+  unsigned char *data;
+  size_t size = ImageEncodeQoi(rgba, width, height, &data);
+  bool ok = ImageWriteFile(path, data, size);
+  free(data);
+  return ok;
+}
+
+bool ImageWritePng(const char *path, const unsigned char *rgba, int width, int height) {
+  unsigned char *data;
+  size_t size = ImageEncodePng(rgba, width, height, &data);
+  bool ok = ImageWriteFile(path, data, size);
+  free(data);
+  return ok;
+}
@@ -0,0 +1,277 @@
+#include "jobs.h"
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define JOBS_QUEUE_MASK (JOBS_QUEUE_SIZE - 1)
+#define JOBS_SPINS_BEFORE_SLEEP 64
+
+static _Thread_local int worker_index = -1;
+
+static bool dequePush(JobDeque *deque, const Job *job) {
+  long long b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+  long long t = atomic_load_explicit(&deque->top, memory_order_acquire);
+  if (b - t >= JOBS_QUEUE_SIZE)
+    return false;
+  deque->slots[b & JOBS_QUEUE_MASK] = *job;
+  atomic_thread_fence(memory_order_release);
+  atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+  return true;
+}
+
+static bool dequePop(JobDeque *deque, Job *out) {
+  long long b = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+  atomic_store_explicit(&deque->bottom, b, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+  long long t = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+  if (t > b) {
+    atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+    return false;
+  }
+  *out = deque->slots[b & JOBS_QUEUE_MASK];
+  bool taken = true;
+  if (t == b) {
+    // Last element: race the thieves for it
+    taken = atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1, memory_order_seq_cst,
+                                                    memory_order_relaxed);
+    atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+  }
+  return taken;
+}
+
+// The job is copied before claiming it: once top moves past the slot the owner may reuse it.
+// A copy torn by such a reuse is thrown away, because the claim then fails.
+static bool dequeSteal(JobDeque *deque, Job *out) {
+  long long t = atomic_load_explicit(&deque->top, memory_order_acquire);
+  atomic_thread_fence(memory_order_seq_cst);
+  long long b = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+  if (t >= b)
+    return false;
+  *out = deque->slots[t & JOBS_QUEUE_MASK];
+  return atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+}
+
+static void wakeOne(JobSystem *jobs) {
+  if (atomic_load(&jobs->sleeping) > 0) {
+    pthread_mutex_lock(&jobs->mutex);
+    pthread_cond_signal(&jobs->wake);
+    pthread_mutex_unlock(&jobs->mutex);
+  }
+}
+
+static void push(JobSystem *jobs, JobWorker *self, const Job *job);
+
+// Queues every waiting job whose dependency has reached zero
+static void releaseWaiting(JobSystem *jobs, JobWorker *self) {
+  JobWaiter *released = NULL;
+  pthread_mutex_lock(&jobs->waiting_mutex);
+  for (JobWaiter **link = &jobs->waiting; *link;) {
+    JobWaiter *waiter = *link;
+    if (atomic_load(&waiter->job.dependency->value) == 0) {
+      *link = waiter->next;
+      waiter->next = released;
+      released = waiter;
+      atomic_fetch_sub(&jobs->waiting_count, 1);
+    } else {
+      link = &waiter->next;
+    }
+  }
+  pthread_mutex_unlock(&jobs->waiting_mutex);
+  while (released) {
+    JobWaiter *next = released->next;
+    push(jobs, self, &released->job);
+    free(released);
+    released = next;
+  }
+}
+
+// The counter is not touched after its decrement: whoever waits on it may be gone once it is zero
+static void execute(JobSystem *jobs, JobWorker *self, const Job *job) {
+  if (job->range_fn)
+    job->range_fn(job->data, job->begin, job->end);
+  else
+    job->fn(job->data);
+  self->executed++;
+  if (job->counter && atomic_fetch_sub(&job->counter->value, 1) == 1 && atomic_load(&jobs->waiting_count) > 0)
+    releaseWaiting(jobs, self);
+}
+
+// Takes a job from the own deque, or steals one from a random victim
+static bool take(JobSystem *jobs, JobWorker *self, Job *out) {
+  bool found = dequePop(&self->deque, out);
+  if (!found && jobs->worker_count > 1) {
+    int first = (int)(rand_r(&self->steal_seed) % (unsigned)jobs->worker_count);
+    for (int i = 0; i < jobs->worker_count && !found; i++) {
+      JobWorker *victim = &jobs->workers[(first + i) % jobs->worker_count];
+      if (victim != self)
+        found = dequeSteal(&victim->deque, out);
+    }
+    if (found)
+      self->stolen++;
+  }
+  if (!found)
+    return false;
+  atomic_fetch_sub(&jobs->queued, 1);
+  return true;
+}
+
+// Only jobs that can start are queued, so a full queue can always be drained here
+static void push(JobSystem *jobs, JobWorker *self, const Job *job) {
+  if (!dequePush(&self->deque, job)) {
+    // Queue full: run it here rather than dropping it
+    execute(jobs, self, job);
+    return;
+  }
+  atomic_fetch_add(&jobs->queued, 1);
+  wakeOne(jobs);
+}
+
+static bool runOne(JobSystem *jobs, JobWorker *self) {
+  Job job;
+  if (!take(jobs, self, &job))
+    return false;
+  execute(jobs, self, &job);
+  return true;
+}
+
+static void *workerMain(void *arg) {
+  JobWorker *self = arg;
+  JobSystem *jobs = self->system;
+  worker_index = (int)(self - jobs->workers);
+
+  int idle = 0;
+  while (!atomic_load(&jobs->quit)) {
+    if (runOne(jobs, self)) {
+      idle = 0;
+      continue;
+    }
+    if (++idle < JOBS_SPINS_BEFORE_SLEEP) {
+      sched_yield();
+      continue;
+    }
+    pthread_mutex_lock(&jobs->mutex);
+    atomic_fetch_add(&jobs->sleeping, 1);
+    while (atomic_load(&jobs->queued) == 0 && !atomic_load(&jobs->quit))
+      pthread_cond_wait(&jobs->wake, &jobs->mutex);
+    atomic_fetch_sub(&jobs->sleeping, 1);
+    pthread_mutex_unlock(&jobs->mutex);
+    idle = 0;
+  }
+  return NULL;
+}
+
+bool JobSystemInit(JobSystem *jobs, int worker_count) {
+  memset(jobs, 0, sizeof(*jobs));
+  if (worker_count <= 0)
+    worker_count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (worker_count < 1)
+    worker_count = 1;
+  if (worker_count > JOBS_MAX_WORKERS)
+    worker_count = JOBS_MAX_WORKERS;
+
+  jobs->workers = calloc((size_t)worker_count, sizeof(JobWorker));
+  if (!jobs->workers)
+    return false;
+  for (int i = 0; i < worker_count; i++) {
+    jobs->workers[i].system = jobs;
+    jobs->workers[i].steal_seed = 0x9e3779b9u * (unsigned)(i + 1);
+  }
+  pthread_mutex_init(&jobs->mutex, NULL);
+  pthread_cond_init(&jobs->wake, NULL);
+  pthread_mutex_init(&jobs->waiting_mutex, NULL);
+
+  worker_index = 0;
+  jobs->worker_count = 1;
+  for (int i = 1; i < worker_count; i++) {
+    if (pthread_create(&jobs->threads[i], NULL, workerMain, &jobs->workers[i]) != 0)
+      break;
+    jobs->worker_count++;
+  }
+  return true;
+}
+
+void JobSystemShutdown(JobSystem *jobs) {
+  pthread_mutex_lock(&jobs->mutex);
+  atomic_store(&jobs->quit, true);
+  pthread_cond_broadcast(&jobs->wake);
+  pthread_mutex_unlock(&jobs->mutex);
+  for (int i = 1; i < jobs->worker_count; i++)
+    pthread_join(jobs->threads[i], NULL);
+
+  // Jobs still waiting never run
+  while (jobs->waiting) {
+    JobWaiter *next = jobs->waiting->next;
+    free(jobs->waiting);
+    jobs->waiting = next;
+  }
+  pthread_mutex_destroy(&jobs->waiting_mutex);
+  pthread_cond_destroy(&jobs->wake);
+  pthread_mutex_destroy(&jobs->mutex);
+  free(jobs->workers);
+  worker_index = -1;
+  memset(jobs, 0, sizeof(*jobs));
+}
+
+int JobsWorkerIndex(void) { return worker_index; }
+
+void JobsRun(JobSystem *jobs, JobFn fn, void *data, JobCounter *counter) {
+  JobsRunAfter(jobs, NULL, fn, data, counter);
+}
+
+// A waiter is added before its dependency is checked again, and a counter reaching zero checks
+// for waiters after its decrement, so one of the two always releases it
+void JobsRunAfter(JobSystem *jobs, JobCounter *dependency, JobFn fn, void *data, JobCounter *counter) {
+  Job job = {fn, NULL, 0, 0, data, counter, dependency};
+  JobWorker *self = &jobs->workers[worker_index];
+  if (counter)
+    atomic_fetch_add_explicit(&counter->value, 1, memory_order_relaxed);
+  if (!dependency || atomic_load(&dependency->value) == 0) {
+    push(jobs, self, &job);
+    return;
+  }
+  JobWaiter *waiter = malloc(sizeof(*waiter));
+  if (!waiter) {
+    // No memory to park it: wait for the dependency here instead
+    JobsWait(jobs, dependency);
+    push(jobs, self, &job);
+    return;
+  }
+  waiter->job = job;
+  pthread_mutex_lock(&jobs->waiting_mutex);
+  waiter->next = jobs->waiting;
+  jobs->waiting = waiter;
+  atomic_fetch_add(&jobs->waiting_count, 1);
+  pthread_mutex_unlock(&jobs->waiting_mutex);
+  if (atomic_load(&dependency->value) == 0)
+    releaseWaiting(jobs, self);
+}
+
+void JobsParallelFor(JobSystem *jobs, size_t count, size_t grain, JobRangeFn fn, void *data, JobCounter *counter) {
+  if (grain == 0)
+    grain = 1;
+  JobWorker *self = &jobs->workers[worker_index];
+  for (size_t begin = 0; begin < count; begin += grain) {
+    size_t end = begin + grain < count ? begin + grain : count;
+    Job job = {NULL, fn, begin, end, data, counter, NULL};
+    if (counter)
+      atomic_fetch_add_explicit(&counter->value, 1, memory_order_relaxed);
+    push(jobs, self, &job);
+  }
+}
+
+void JobsWait(JobSystem *jobs, JobCounter *counter) {
+  JobWorker *self = &jobs->workers[worker_index];
+  while (atomic_load_explicit(&counter->value, memory_order_acquire) > 0) {
+    if (!runOne(jobs, self))
+      sched_yield();
+  }
+}
+
+void JobSystemPrintStats(const JobSystem *jobs) {
+  printf("Job system: %d workers\n", jobs->worker_count);
+  for (int i = 0; i < jobs->worker_count; i++)
+    printf("  worker %2d: %zu jobs run, %zu stolen\n", i, jobs->workers[i].executed, jobs->workers[i].stolen);
+}
@@ -0,0 +1,44 @@
+#include "lod.h"
+#include <math.h>
+
+void LodSelectorInit(LodSelector *selector, const Mat4 *view, const Mat4 *projection, int viewport_height,
+                     float pixel_error) {
+  selector->view_projection = Mat4Mul(projection, view);
+  selector->pixels_per_unit = projection->m[5] * 0.5f * (float)viewport_height;
+  // A perspective projection has w = -z_view, and its near plane at m[14] / (m[10] - 1);
+  // an orthographic one keeps w at 1
+  float near_w = projection->m[11] != 0.0f ? projection->m[14] / (projection->m[10] - 1.0f) : 1.0f;
+  selector->near_w = near_w > 1e-6f ? near_w : 1e-6f;
+  selector->pixel_error = pixel_error;
+}
+
+// Pixels per object-space unit at the sphere's point with the smallest clip w, which is never
+// taken closer than the near plane
+static float pixelScale(const LodSelector *selector, const Mat4 *world, Vec3 center, float radius) {
+  Vec4 clip = Mat4MulVec4(&selector->view_projection, Vec4FromVec3(Mat4TransformPoint(world, center), 1.0f));
+  // Non-uniform scale takes its largest axis, which overestimates the error and errs towards detail
+  float scale = 0.0f;
+  for (int c = 0; c < 3; c++) {
+    const float *axis = &world->m[c * 4];
+    scale = fmaxf(scale, axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+  }
+  scale = sqrtf(scale);
+  // How fast w changes per world unit, towards the eye
+  const float *m = selector->view_projection.m;
+  float w_per_unit = sqrtf(m[3] * m[3] + m[7] * m[7] + m[11] * m[11]);
+  float w = fmaxf(clip.w - radius * scale * w_per_unit, selector->near_w);
+  return scale * fabsf(selector->pixels_per_unit) / w;
+}
+
+float LodProjectedError(const LodSelector *selector, const Mat4 *world, Vec3 center, float radius, float error) {
+  return error * pixelScale(selector, world, center, radius);
+}
+
+uint32_t LodSelect(const LodSelector *selector, const Mat4 *world, Vec3 center, float radius, const float *errors,
+                   uint32_t lod_count) {
+  float scale = pixelScale(selector, world, center, radius);
+  uint32_t lod = lod_count ? lod_count - 1 : 0;
+  while (lod > 0 && errors[lod] * scale > selector->pixel_error)
+    lod--;
+  return lod;
+}
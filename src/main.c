@@ -1,20 +1,57 @@
-#include "image.h"
-#include "shaders.h"
+#include "capture.h"
+#include "demo.h"
+#include "frame.h"
+#include "jobs.h"
+#include "pack.h"
+#include "pacing.h"
+#include "render_thread.h"
+#include "uploader.h"
 #include <GL/gl.h>
 #include <GLFW/glfw3.h>
 #include <assert.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static Pack assets;
+static FramePacer pacer;
+static RenderThread renderer;
+static Capture capture;
+static VideoOutput video;
+static double frame_input_time = -1.0;
+static int viewport_width = 800, viewport_height = 600;
+static Demo demo;
+
+// Looks for the asset archive in $ASSET_PACK, next to the executable, then in the working directory.
+// Without one, assets are read as loose files relative to the working directory.
+static void openAssetPack(void) {
+  const char *env = getenv("ASSET_PACK");
+  if (env && PackOpen(env, &assets) == PACK_SUCCESS)
+    return;
+
+  char path[4096];
+  ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - sizeof("assets.pack"));
+  if (length > 0) {
+    path[length] = '\0';
+    char *slash = strrchr(path, '/');
+    if (slash) {
+      strcpy(slash + 1, "assets.pack");
+      if (PackOpen(path, &assets) == PACK_SUCCESS)
+        return;
+    }
+  }
 
-typedef enum Color { STILL, GRADIENT } ShaderColor;
-typedef enum Shape { TRI, RECT } Shape;
-
-static enum Color color = STILL;
-static enum Shape shape = RECT;
-static GLenum mode = GL_FILL;
-static float texture_mix = 0.2;
+  if (PackOpen("assets.pack", &assets) != PACK_SUCCESS)
+    printf("No asset pack found, loading loose files\n");
+}
 
-void frameBufferSizeCallback(GLFWwindow *window, int width, int height) { glViewport(0, 0, width, height); }
+// Runs on the main thread, which does not own the GL context; the render stage records the change.
+void frameBufferSizeCallback(GLFWwindow *window, int width, int height) {
+  viewport_width = width;
+  viewport_height = height;
+}
 
 void processInput(GLFWwindow *window) {
   if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
@@ -22,48 +59,156 @@ void processInput(GLFWwindow *window) {
 
   static bool wKeyWasPressed = false;
   if ((glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) && !wKeyWasPressed) {
-    mode = mode == GL_LINE ? GL_FILL : GL_LINE;
+    FramePacerMarkInput(&pacer);
+    demo.polygon_mode = demo.polygon_mode == GL_LINE ? GL_FILL : GL_LINE;
   }
 
   static bool cKeyWasPressed = false;
   if ((glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS) && !cKeyWasPressed) {
-    color = (color == STILL) ? GRADIENT : STILL;
+    FramePacerMarkInput(&pacer);
+    // Switches the triangle between its vertex colours and the breathing material
+    bool breathing = SceneGetMaterial(&demo.entities, demo.triangle) == DEMO_MATERIAL_BREATHING;
+    SceneSetMaterial(&demo.entities, demo.triangle, breathing ? DEMO_MATERIAL_VERTEX_COLOR : DEMO_MATERIAL_BREATHING);
   }
 
   static bool sKeyWasPressed = false;
   if ((glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) && !sKeyWasPressed) {
-    shape = (shape == TRI) ? RECT : TRI;
+    FramePacerMarkInput(&pacer);
+    // Swaps which of the two shapes is shown
+    SceneSetVisibility(&demo.entities, demo.triangle,
+                       SceneGetVisibility(&demo.entities, demo.triangle) ^ VISIBILITY_VISIBLE);
+    SceneSetVisibility(&demo.entities, demo.rectangle,
+                       SceneGetVisibility(&demo.entities, demo.rectangle) ^ VISIBILITY_VISIBLE);
+  }
+
+  static bool pKeyWasPressed = false;
+  if ((glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS) && !pKeyWasPressed) {
+    FramePacerMarkInput(&pacer);
+    AnimationClockSetPaused(&demo.clock, !demo.clock.paused);
+  }
+
+  // [ and ] halve and double the speed of animation
+  static bool leftBracketKeyWasPressed = false;
+  if ((glfwGetKey(window, GLFW_KEY_LEFT_BRACKET) == GLFW_PRESS) && !leftBracketKeyWasPressed) {
+    FramePacerMarkInput(&pacer);
+    AnimationClockSetScale(&demo.clock, demo.clock.scale * 0.5);
+  }
+
+  static bool rightBracketKeyWasPressed = false;
+  if ((glfwGetKey(window, GLFW_KEY_RIGHT_BRACKET) == GLFW_PRESS) && !rightBracketKeyWasPressed) {
+    FramePacerMarkInput(&pacer);
+    AnimationClockSetScale(&demo.clock, demo.clock.scale * 2.0);
   }
 
+  static bool f12KeyWasPressed = false;
+  if ((glfwGetKey(window, GLFW_KEY_F12) == GLFW_PRESS) && !f12KeyWasPressed)
+    CaptureRequest(&capture);
+
   static bool upKeyWasPressed = false;
   if ((glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) && !upKeyWasPressed) {
-    texture_mix += 0.1f;
-    if (texture_mix > 1.0f) {
-      texture_mix = 1.0f;
+    FramePacerMarkInput(&pacer);
+    demo.texture_mix += 0.1f;
+    if (demo.texture_mix > 1.0f) {
+      demo.texture_mix = 1.0f;
     }
   }
 
   static bool downKeyWasPressed = false;
   if ((glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) && !downKeyWasPressed) {
-    texture_mix -= 0.1f;
-    if (texture_mix < 0.0f) {
-      texture_mix = 0.0f;
+    FramePacerMarkInput(&pacer);
+    demo.texture_mix -= 0.1f;
+    if (demo.texture_mix < 0.0f) {
+      demo.texture_mix = 0.0f;
     }
   }
 
   wKeyWasPressed = (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) ? true : false;
   cKeyWasPressed = (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS) ? true : false;
   sKeyWasPressed = (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) ? true : false;
+  pKeyWasPressed = (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS) ? true : false;
+  leftBracketKeyWasPressed = (glfwGetKey(window, GLFW_KEY_LEFT_BRACKET) == GLFW_PRESS) ? true : false;
+  rightBracketKeyWasPressed = (glfwGetKey(window, GLFW_KEY_RIGHT_BRACKET) == GLFW_PRESS) ? true : false;
+  f12KeyWasPressed = (glfwGetKey(window, GLFW_KEY_F12) == GLFW_PRESS) ? true : false;
   upKeyWasPressed = (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) ? true : false;
   downKeyWasPressed = (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) ? true : false;
 }
 
+static void pollStage(void *user) { glfwPollEvents(); }
+
+static void inputStage(void *user) { processInput(user); }
+
+static void updateStage(void *user) {
+  frame_input_time = FramePacerBeginFrame(&pacer);
+  DemoUpdate(user, glfwGetTime());
+}
+
+static void cullStage(void *user) { DemoCull(user); }
+
+// Records the frame; the GL calls happen when the render thread replays the list. The size
+// comes from frameBufferSizeCallback.
+static void renderStage(void *user) {
+  RenderCommandList *list = RenderThreadBeginFrame(&renderer);
+  list->input_time = frame_input_time;
+  if (DemoRecordFrame(user, list, viewport_width, viewport_height))
+    CaptureRecord(&capture, list, viewport_width, viewport_height);
+}
+
+static void presentStage(void *user) {
+  RenderThreadSubmit(&renderer);
+  // Encodes whatever the render thread has read back by now, on the workers
+  CaptureDispatch(&capture);
+}
+
+static bool envFlag(const char *name, bool fallback) {
+  const char *value = getenv(name);
+  return value ? atoi(value) != 0 : fallback;
+}
+
+// Software rasterizers run vertex shaders on the CPU anyway, without the job system's SIMD kernels
+static bool softwareRenderer(void) {
+  const char *renderer = (const char *)glGetString(GL_RENDERER);
+  return renderer && (strstr(renderer, "llvmpipe") || strstr(renderer, "softpipe") || strstr(renderer, "SwiftShader"));
+}
+
+// PARTICLES=n adds a fountain of n particles, emitted as fast as they die. PARTICLE_BACKEND=cpu
+// or gpu picks where they are simulated, by default the CPU on software renderers.
+static void startParticles(JobSystem *jobs) {
+  const char *env = getenv("PARTICLES");
+  long capacity = env ? atol(env) : 0;
+  if (capacity <= 0)
+    return;
+  const char *backend_name = getenv("PARTICLE_BACKEND");
+  ParticleBackend backend = softwareRenderer() ? PARTICLE_BACKEND_CPU : PARTICLE_BACKEND_GPU;
+  if (backend_name && strcmp(backend_name, "cpu") == 0)
+    backend = PARTICLE_BACKEND_CPU;
+  else if (backend_name && strcmp(backend_name, "gpu") == 0)
+    backend = PARTICLE_BACKEND_GPU;
+  else if (backend_name)
+    printf("PARTICLE_BACKEND: unknown backend '%s'\n", backend_name);
+  bool particles_ready = DemoStartParticles(&demo, (size_t)capacity, backend, jobs);
+  assert(particles_ready && "Failed to start particles");
+}
+
 int main() {
+  // HEADLESS=1 renders without a display (e.g. on llvmpipe), FRAME_COUNT=n stops after n frames
+  bool headless = envFlag("HEADLESS", false);
+#ifdef GLFW_PLATFORM_NULL
+  if (headless)
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#endif
   glfwInit();
 
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  if (headless) {
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef GLFW_EGL_CONTEXT_API
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+#endif
+  }
+  const char *frame_count = getenv("FRAME_COUNT");
+  size_t max_frames = frame_count ? (size_t)atol(frame_count) : 0;
 
   GLFWwindow *window = glfwCreateWindow(800, 600, "LearnOpenGL", NULL, NULL);
   if (window == NULL) {
@@ -71,137 +216,81 @@ int main() {
     return -1;
   }
   glfwMakeContextCurrent(window);
-  glViewport(0, 0, 800, 600);
+  glfwGetFramebufferSize(window, &viewport_width, &viewport_height);
+  glViewport(0, 0, viewport_width, viewport_height);
   glfwSetFramebufferSizeCallback(window, frameBufferSizeCallback);
-
-  float rectangle_vp[] = {
-      // positions          // colors           // texture coords
-      0.5f,  0.5f,  0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, // top right
-      0.5f,  -0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, // bottom right
-      -0.5f, -0.5f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, // bottom left
-      -0.5f, 0.5f,  0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f  // top left
-  };
-
-  GLfloat triangle_vp[] = {
-      // positions         // colors
-      0.5f,  -0.5f, 0.0f, 1.0f, 0.0f, 0.0f, // bottom right
-      -0.5f, -0.5f, 0.0f, 0.0f, 1.0f, 0.0f, // bottom left
-      0.0f,  0.5f,  0.0f, 0.0f, 0.0f, 1.0f  // top
-  };
-
-  GLuint indices[] = {0, 1, 3, 1, 2, 3};
-
-  GLuint fShader;
-  ShaderLoadResult res;
-  res = ShaderLoadFromDisk("shaders/fixed.vertex.glsl", "shaders/fixed.fragment.glsl", &fShader);
-  assert(res == SUCCESS && "Failed to compile fixed shader");
-  GLuint tShader;
-  res = ShaderLoadFromDisk("shaders/texture.vertex.glsl", "shaders/texture.fragment.glsl", &tShader);
-  assert(res == SUCCESS && "Failed to compile texture shader");
-
-  GLint tex0Location = glGetUniformLocation(tShader, "texture0");
-  GLint tex1Location = glGetUniformLocation(tShader, "texture1");
-  GLint mixAmountLocation = glGetUniformLocation(tShader, "mixAmount");
-
-  GLuint VBO_rect;
-  GLuint VBO_tria;
-  GLuint EBO_rect;
-  GLuint VAO_rect;
-  GLuint VAO_tri;
-  glGenBuffers(1, &VBO_rect);
-  glGenBuffers(1, &VBO_tria);
-  glGenBuffers(1, &EBO_rect);
-  glGenVertexArrays(1, &VAO_rect);
-  glGenVertexArrays(1, &VAO_tri);
-
-  // Configure rectangle VAO
-  glBindVertexArray(VAO_rect); // vertex array must be bound before buffers! attributes are linked to a buffer
-  glBindBuffer(GL_ARRAY_BUFFER, VBO_rect);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(rectangle_vp), rectangle_vp, GL_STATIC_DRAW);
-
-  // An EBO stores indices of what vertices (contained in a VBO) to draw (indexed drawing)
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO_rect);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), 0);
-  glEnableVertexAttribArray(0); // select defined vertex array to parse the VBO buffer
-
-  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(3 * sizeof(float)));
-  glEnableVertexAttribArray(1);
-
-  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(6 * sizeof(float)));
-  glEnableVertexAttribArray(2);
-
-  // Load textures
-  int width, height, nrChannels;
-
-  GLuint texture0;
-  glGenTextures(1, &texture0);
-  glBindTexture(GL_TEXTURE_2D, texture0);
-
-  // stbi_set_flip_vertically_on_load(true);
-  unsigned char *wood = stbi_load("data/container.jpg", &width, &height, &nrChannels, 0);
-  assert(wood != NULL && "Failed to load wood texture");
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, wood);
-  glGenerateMipmap(GL_TEXTURE_2D);
-
-  stbi_image_free(wood);
-
-  GLuint texture1;
-  glGenTextures(1, &texture1);
-  glBindTexture(GL_TEXTURE_2D, texture1);
-
-  unsigned char *face = stbi_load("data/awesomeface.png", &width, &height, &nrChannels, 0);
-  assert(face != NULL && "Failed to load face texture");
-
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, face);
-  glGenerateMipmap(GL_TEXTURE_2D);
-
-  stbi_image_free(face);
-
-  // Configure triangle VAO
-  glBindVertexArray(VAO_tri);
-
-  glBindBuffer(GL_ARRAY_BUFFER, VBO_tria);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(triangle_vp), triangle_vp, GL_STATIC_DRAW);
-
-  // position
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), 0);
-  glEnableVertexAttribArray(0);
-
-  // color
-  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)(3 * sizeof(float)));
-  glEnableVertexAttribArray(1);
-
-  glBindVertexArray(0); // reset bound vao
-
-  while (!glfwWindowShouldClose(window)) {
-    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
-
-    glPolygonMode(GL_FRONT_AND_BACK, mode);
-
-    if (shape == TRI) {
-      glUseProgram(fShader);
-      glBindVertexArray(VAO_tri);
-      glDrawArrays(GL_TRIANGLES, 0, 3);
-    } else {
-      glUniform1i(tex0Location, 0);
-      glUniform1i(tex1Location, 1);
-      glUniform1f(mixAmountLocation, texture_mix);
-      glActiveTexture(GL_TEXTURE0);
-      glBindTexture(GL_TEXTURE_2D, texture0);
-      glActiveTexture(GL_TEXTURE1);
-      glBindTexture(GL_TEXTURE_2D, texture1);
-      glUseProgram(tShader);
-      glBindVertexArray(VAO_rect);
-      glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-    }
-
-    processInput(window);
-    glfwSwapBuffers(window);
-    glfwPollEvents();
+  FramePacerInit(&pacer, FramePacerConfigFromEnv());
+  openAssetPack();
+
+  Uploader uploader;
+  bool uploader_ready = UploaderStart(&uploader, window, envFlag("UPLOAD_THREAD", true));
+  assert(uploader_ready && "Failed to start uploader");
+
+  JobSystem jobs;
+  bool jobs_ready = JobSystemInit(&jobs, 0);
+  assert(jobs_ready && "Failed to start job system");
+
+  // F12 saves the next frame; CAPTURE_FRAMES=1 saves every frame, e.g. for a HEADLESS regression run.
+  // CAPTURE_DIR (default "captures") and CAPTURE_FORMAT (png or qoi) pick where and how.
+  // CAPTURE_VIDEO streams every frame as Y4M instead, to a file or to "|<command>", e.g.
+  // CAPTURE_VIDEO="|ffmpeg -y -i - out.mp4"; the stream runs at FRAME_TARGET_FPS, or 60.
+  const char *capture_dir = getenv("CAPTURE_DIR");
+  const char *capture_format = getenv("CAPTURE_FORMAT");
+  const char *capture_video = getenv("CAPTURE_VIDEO");
+  bool capture_ready =
+      CaptureInit(&capture, &jobs, capture_dir ? capture_dir : "captures",
+                  capture_format && strcmp(capture_format, "qoi") == 0 ? CAPTURE_FORMAT_QOI : CAPTURE_FORMAT_PNG,
+                  capture_video || envFlag("CAPTURE_FRAMES", false));
+  assert(capture_ready && "Failed to set up frame capture");
+  if (capture_video) {
+    bool video_ready = VideoOutputOpen(&video, capture_video, (unsigned)(pacer.config.target_fps + 0.5));
+    assert(video_ready && "Failed to open CAPTURE_VIDEO");
+    CaptureSetVideo(&capture, &video);
   }
 
+  // CULL_OCCLUSION=1 enables the depth pass, which only runs under a perspective projection
+  bool demo_ready = DemoLoad(&demo, assets.base ? &assets : NULL, &uploader, &jobs, envFlag("CULL_OCCLUSION", false));
+  assert(demo_ready && "Failed to load the scene");
+  // POST_CHAIN lists the passes in order, e.g. "tonemap,fxaa,blur"; unset or "none" draws straight to the window
+  const char *post_chain = getenv("POST_CHAIN");
+  bool post_ready = DemoBuildPostChain(&demo, post_chain ? post_chain : DEMO_DEFAULT_POST_CHAIN);
+  assert(post_ready && "Failed to compile post-process shader");
+  startParticles(&jobs);
+  // LOD_PIXEL_ERROR is how far, in pixels, a simplified level may deviate before a finer one is drawn
+  const char *lod_pixel_error = getenv("LOD_PIXEL_ERROR");
+  if (lod_pixel_error)
+    demo.lod_pixel_error = (float)atof(lod_pixel_error);
+
+  // Input is sampled before the frame is built so a key press shows up in the very next present
+  FrameLoop loop;
+  FrameLoopInit(&loop);
+  FrameLoopAddStage(&loop, "poll", pollStage, NULL);
+  FrameLoopAddStage(&loop, "input", inputStage, window);
+  FrameLoopAddStage(&loop, "update", updateStage, &demo);
+  FrameLoopAddStage(&loop, "cull", cullStage, &demo);
+  FrameLoopAddStage(&loop, "render", renderStage, &demo);
+  FrameLoopAddStage(&loop, "present", presentStage, NULL);
+
+  // The main thread keeps GLFW events and simulation; GL moves to the render thread from here on
+  bool renderer_ready = RenderThreadStart(&renderer, window, &pacer, envFlag("RENDER_THREAD", true));
+  assert(renderer_ready && "Failed to start renderer");
+
+  while (!glfwWindowShouldClose(window) && (max_frames == 0 || loop.frames < max_frames))
+    FrameLoopRunFrame(&loop);
+
+  RenderThreadStop(&renderer);
+  CaptureFinish(&capture);
+  VideoOutputClose(&video);
+  CapturePrintStats(&capture);
+  CaptureDestroy(&capture);
+  UploaderStop(&uploader);
+  UploaderPrintStats(&uploader);
+  JobSystemShutdown(&jobs);
+  FrameLoopPrintTimings(&loop);
+  RenderThreadPrintStats(&renderer);
+  FramePacerPrintStats(&pacer);
+  DemoPrintStats(&demo);
+  DemoDestroy(&demo);
+  PackClose(&assets);
   return 0;
 }
@@ -0,0 +1,335 @@
+#include "mesh.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void MeshFree(Mesh *mesh) {
+  free(mesh->positions);
+  free(mesh->normals);
+  free(mesh->uvs);
+  free(mesh->colors);
+  free(mesh->indices);
+  memset(mesh, 0, sizeof(*mesh));
+}
+
+// ---- Welding ----------------------------------------------------------------------------------
+
+typedef struct VertexStream {
+  float *data;
+  size_t components;
+} VertexStream;
+
+static size_t meshStreams(Mesh *mesh, VertexStream *streams) {
+  size_t count = 0;
+  if (mesh->positions)
+    streams[count++] = (VertexStream){mesh->positions, 3};
+  if (mesh->normals)
+    streams[count++] = (VertexStream){mesh->normals, 3};
+  if (mesh->uvs)
+    streams[count++] = (VertexStream){mesh->uvs, 2};
+  if (mesh->colors)
+    streams[count++] = (VertexStream){mesh->colors, 3};
+  return count;
+}
+
+static uint32_t hashVertex(const VertexStream *streams, size_t stream_count, size_t v) {
+  uint32_t hash = 2166136261u;
+  for (size_t s = 0; s < stream_count; s++) {
+    const float *value = streams[s].data + v * streams[s].components;
+    for (size_t c = 0; c < streams[s].components; c++) {
+      uint32_t bits;
+      memcpy(&bits, &value[c], sizeof(bits));
+      hash = (hash ^ bits) * 16777619u;
+    }
+  }
+  return hash ^ (hash >> 15);
+}
+
+static bool equalVertex(const VertexStream *streams, size_t stream_count, size_t a, size_t b) {
+  for (size_t s = 0; s < stream_count; s++) {
+    size_t n = streams[s].components;
+    if (memcmp(streams[s].data + a * n, streams[s].data + b * n, n * sizeof(float)) != 0)
+      return false;
+  }
+  return true;
+}
+
+bool MeshWeld(Mesh *mesh) {
+  VertexStream streams[4];
+  size_t stream_count = meshStreams(mesh, streams);
+  size_t capacity = 1;
+  while (capacity < mesh->vertex_count * 2)
+    capacity <<= 1;
+  uint32_t *table = malloc(capacity * sizeof(uint32_t));
+  uint32_t *remap = malloc((mesh->vertex_count ? mesh->vertex_count : 1) * sizeof(uint32_t));
+  if (!table || !remap) {
+    free(table);
+    free(remap);
+    return false;
+  }
+  memset(table, 0xff, capacity * sizeof(uint32_t));
+
+  // Unique vertices are compacted in place; a kept vertex never moves forward
+  size_t unique = 0;
+  for (size_t v = 0; v < mesh->vertex_count; v++) {
+    size_t slot = hashVertex(streams, stream_count, v) & (capacity - 1);
+    while (table[slot] != UINT32_MAX && !equalVertex(streams, stream_count, table[slot], v))
+      slot = (slot + 1) & (capacity - 1);
+    if (table[slot] == UINT32_MAX) {
+      for (size_t s = 0; s < stream_count; s++) {
+        size_t n = streams[s].components;
+        memmove(streams[s].data + unique * n, streams[s].data + v * n, n * sizeof(float));
+      }
+      table[slot] = (uint32_t)unique++;
+    }
+    remap[v] = table[slot];
+  }
+  for (size_t i = 0; i < mesh->index_count; i++)
+    mesh->indices[i] = remap[mesh->indices[i]];
+  mesh->vertex_count = unique;
+  free(table);
+  free(remap);
+  return true;
+}
+
+// ---- Vertex cache -----------------------------------------------------------------------------
+// Tom Forsyth, "Linear-Speed Vertex Cache Optimisation" (2006), with his suggested constants.
+
+#define FORSYTH_CACHE_DECAY_POWER 1.5f
+#define FORSYTH_LAST_TRIANGLE_SCORE 0.75f
+#define FORSYTH_VALENCE_BOOST_SCALE 2.0f
+#define FORSYTH_VALENCE_BOOST_POWER 0.5f
+#define FORSYTH_VALENCE_TABLE 32
+
+static float cache_scores[MESH_CACHE_SIZE];
+static float valence_scores[FORSYTH_VALENCE_TABLE];
+
+static void initScoreTables(void) {
+  if (valence_scores[1] != 0.0f)
+    return;
+  for (int i = 0; i < MESH_CACHE_SIZE; i++) {
+    // The three most recent vertices belong to the last triangle, so their reuse scores lower
+    cache_scores[i] = i < 3 ? FORSYTH_LAST_TRIANGLE_SCORE
+                            : powf(1.0f - (float)(i - 3) / (float)(MESH_CACHE_SIZE - 3), FORSYTH_CACHE_DECAY_POWER);
+  }
+  for (int i = 1; i < FORSYTH_VALENCE_TABLE; i++)
+    valence_scores[i] = FORSYTH_VALENCE_BOOST_SCALE * powf((float)i, -FORSYTH_VALENCE_BOOST_POWER);
+}
+
+static float vertexScore(int cache_position, uint32_t remaining) {
+  if (remaining == 0)
+    return -1.0f;
+  float score = cache_position >= 0 ? cache_scores[cache_position] : 0.0f;
+  return score + (remaining < FORSYTH_VALENCE_TABLE
+                      ? valence_scores[remaining]
+                      : FORSYTH_VALENCE_BOOST_SCALE * powf((float)remaining, -FORSYTH_VALENCE_BOOST_POWER));
+}
+
+typedef struct ForsythState {
+  uint32_t *remaining; // triangles not yet emitted, kept at the front of each adjacency range
+  uint32_t *offsets;
+  uint32_t *adjacency;
+  int32_t *cache_position;
+  float *vertex_scores;
+  float *triangle_scores;
+  bool *emitted;
+  uint32_t *output;
+} ForsythState;
+
+static void forsythOrder(ForsythState *state, const uint32_t *indices, size_t index_count, size_t vertex_count) {
+  uint32_t *remaining = state->remaining, *offsets = state->offsets, *adjacency = state->adjacency;
+  int32_t *cache_position = state->cache_position;
+  float *vertex_scores = state->vertex_scores, *triangle_scores = state->triangle_scores;
+  bool *emitted = state->emitted;
+  uint32_t *output = state->output;
+  size_t triangle_count = index_count / 3;
+
+  for (size_t i = 0; i < index_count; i++)
+    remaining[indices[i]]++;
+  uint32_t offset = 0;
+  for (size_t v = 0; v < vertex_count; v++) {
+    offsets[v] = offset;
+    offset += remaining[v];
+    remaining[v] = 0;
+  }
+  for (size_t i = 0; i < index_count; i++) {
+    uint32_t v = indices[i];
+    adjacency[offsets[v] + remaining[v]++] = (uint32_t)(i / 3);
+  }
+  for (size_t v = 0; v < vertex_count; v++) {
+    cache_position[v] = -1;
+    vertex_scores[v] = vertexScore(-1, remaining[v]);
+  }
+  for (size_t t = 0; t < triangle_count; t++)
+    triangle_scores[t] = vertex_scores[indices[t * 3]] + vertex_scores[indices[t * 3 + 1]] +
+                         vertex_scores[indices[t * 3 + 2]];
+
+  uint32_t cache[MESH_CACHE_SIZE + 3], next_cache[MESH_CACHE_SIZE + 3];
+  size_t cache_count = 0;
+  size_t best = SIZE_MAX, cursor = 0;
+  for (size_t t = 0; t < triangle_count; t++)
+    if (best == SIZE_MAX || triangle_scores[t] > triangle_scores[best])
+      best = t;
+
+  for (size_t written = 0; written < triangle_count; written++) {
+    if (best == SIZE_MAX) {
+      // Dead end: nothing in the cache has triangles left, continue in input order
+      while (emitted[cursor])
+        cursor++;
+      best = cursor;
+    }
+    const uint32_t *tri = &indices[best * 3];
+    memcpy(&output[written * 3], tri, 3 * sizeof(uint32_t));
+    emitted[best] = true;
+
+    for (int k = 0; k < 3; k++) {
+      uint32_t v = tri[k];
+      uint32_t *list = &adjacency[offsets[v]];
+      for (uint32_t j = 0; j < remaining[v];) {
+        if (list[j] == best)
+          list[j] = list[--remaining[v]];
+        else
+          j++;
+      }
+    }
+
+    // The triangle's vertices move to the front of the LRU cache
+    size_t next_count = 0;
+    for (int k = 0; k < 3; k++)
+      next_cache[next_count++] = tri[k];
+    for (size_t j = 0; j < cache_count; j++) {
+      uint32_t v = cache[j];
+      if (v != tri[0] && v != tri[1] && v != tri[2])
+        next_cache[next_count++] = v;
+    }
+
+    for (size_t j = 0; j < next_count; j++) {
+      uint32_t v = next_cache[j];
+      cache_position[v] = j < MESH_CACHE_SIZE ? (int32_t)j : -1;
+      float score = vertexScore(cache_position[v], remaining[v]);
+      float delta = score - vertex_scores[v];
+      vertex_scores[v] = score;
+      for (uint32_t a = 0; a < remaining[v]; a++)
+        triangle_scores[adjacency[offsets[v] + a]] += delta;
+    }
+
+    best = SIZE_MAX;
+    float best_score = -1.0f;
+    for (size_t j = 0; j < next_count && j < MESH_CACHE_SIZE; j++) {
+      uint32_t v = next_cache[j];
+      for (uint32_t a = 0; a < remaining[v]; a++) {
+        uint32_t t = adjacency[offsets[v] + a];
+        if (triangle_scores[t] > best_score) {
+          best_score = triangle_scores[t];
+          best = t;
+        }
+      }
+    }
+    cache_count = next_count < MESH_CACHE_SIZE ? next_count : MESH_CACHE_SIZE;
+    memcpy(cache, next_cache, cache_count * sizeof(uint32_t));
+  }
+}
+
+bool MeshOptimizeVertexCache(uint32_t *indices, size_t index_count, size_t vertex_count) {
+  initScoreTables();
+  size_t triangle_count = index_count / 3;
+  ForsythState state = {
+      .remaining = calloc(vertex_count + 1, sizeof(uint32_t)),
+      .offsets = malloc((vertex_count + 1) * sizeof(uint32_t)),
+      .adjacency = malloc((index_count + 1) * sizeof(uint32_t)),
+      .cache_position = malloc((vertex_count + 1) * sizeof(int32_t)),
+      .vertex_scores = malloc((vertex_count + 1) * sizeof(float)),
+      .triangle_scores = malloc((triangle_count + 1) * sizeof(float)),
+      .emitted = calloc(triangle_count + 1, sizeof(bool)),
+      .output = malloc((index_count + 1) * sizeof(uint32_t)),
+  };
+  bool ok = state.remaining && state.offsets && state.adjacency && state.cache_position && state.vertex_scores &&
+            state.triangle_scores && state.emitted && state.output;
+  if (ok) {
+    forsythOrder(&state, indices, index_count, vertex_count);
+    memcpy(indices, state.output, triangle_count * 3 * sizeof(uint32_t));
+  }
+  free(state.remaining);
+  free(state.offsets);
+  free(state.adjacency);
+  free(state.cache_position);
+  free(state.vertex_scores);
+  free(state.triangle_scores);
+  free(state.emitted);
+  free(state.output);
+  return ok;
+}
+
+// ---- Vertex fetch -----------------------------------------------------------------------------
+
+bool MeshOptimizeVertexFetch(Mesh *mesh) {
+  uint32_t *remap = malloc((mesh->vertex_count ? mesh->vertex_count : 1) * sizeof(uint32_t));
+  if (!remap)
+    return false;
+  memset(remap, 0xff, mesh->vertex_count * sizeof(uint32_t));
+  uint32_t next = 0;
+  for (size_t i = 0; i < mesh->index_count; i++)
+    if (remap[mesh->indices[i]] == UINT32_MAX)
+      remap[mesh->indices[i]] = next++;
+
+  VertexStream streams[4];
+  float *reordered[4] = {NULL};
+  size_t stream_count = meshStreams(mesh, streams);
+  for (size_t s = 0; s < stream_count; s++) {
+    reordered[s] = malloc((next ? next : 1) * streams[s].components * sizeof(float));
+    if (!reordered[s]) {
+      for (size_t f = 0; f < s; f++)
+        free(reordered[f]);
+      free(remap);
+      return false;
+    }
+  }
+
+  for (size_t s = 0; s < stream_count; s++) {
+    size_t n = streams[s].components;
+    for (size_t v = 0; v < mesh->vertex_count; v++)
+      if (remap[v] != UINT32_MAX)
+        memcpy(reordered[s] + remap[v] * n, streams[s].data + v * n, n * sizeof(float));
+  }
+  float **fields[] = {&mesh->positions, &mesh->normals, &mesh->uvs, &mesh->colors};
+  for (size_t f = 0, s = 0; f < sizeof(fields) / sizeof(fields[0]); f++) {
+    if (*fields[f]) {
+      free(*fields[f]);
+      *fields[f] = reordered[s++];
+    }
+  }
+  for (size_t i = 0; i < mesh->index_count; i++)
+    mesh->indices[i] = remap[mesh->indices[i]];
+  mesh->vertex_count = next;
+  free(remap);
+  return true;
+}
+
+double MeshAcmr(const uint32_t *indices, size_t index_count, size_t vertex_count, unsigned cache_size) {
+  if (index_count < 3)
+    return 0.0;
+  // A vertex is cached while fewer than cache_size misses happened since it was loaded
+  uint32_t *loaded_at = calloc(vertex_count ? vertex_count : 1, sizeof(uint32_t));
+  if (!loaded_at)
+    return 0.0;
+  uint32_t time = cache_size + 1;
+  size_t misses = 0;
+  for (size_t i = 0; i < index_count; i++) {
+    uint32_t v = indices[i];
+    if (time - loaded_at[v] > cache_size) {
+      loaded_at[v] = time++;
+      misses++;
+    }
+  }
+  free(loaded_at);
+  return (double)misses / (double)(index_count / 3);
+}
+
+void MeshPrintStats(const char *name, const Mesh *mesh, const MeshImportStats *stats) {
+  printf("Mesh %s: %zu vertices from %zu corners, %zu triangles\n", name, mesh->vertex_count, stats->corners,
+         mesh->index_count / 3);
+  printf("  parse %.2f ms (%.1f MB/s), optimize %.2f ms, ACMR %.3f -> %.3f (FIFO %d)\n", 1000.0 * stats->parse_time,
+         stats->parse_time > 0.0 ? (double)stats->bytes / stats->parse_time * 1e-6 : 0.0,
+         1000.0 * stats->optimize_time, stats->acmr_before, stats->acmr_after, MESH_ACMR_CACHE_SIZE);
+}
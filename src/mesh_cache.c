@@ -0,0 +1,284 @@
+#include "mesh_cache.h"
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+static uint64_t mix(uint64_t lane, uint64_t value) {
+  return rotl(lane ^ (value * 0xbf58476d1ce4e5b9ull), 31) * 0x94d049bb133111ebull;
+}
+
+uint64_t MeshCacheHash(const void *data, size_t size) {
+  const unsigned char *p = data;
+  // Four independent lanes keep the multiplies from serializing
+  uint64_t lanes[4] = {0x9e3779b97f4a7c15ull, 0xc2b2ae3d27d4eb4full, 0x165667b19e3779f9ull, 0x27d4eb2f165667c5ull};
+  size_t remaining = size;
+  for (; remaining >= 32; p += 32, remaining -= 32) {
+    for (int l = 0; l < 4; l++) {
+      uint64_t value;
+      memcpy(&value, p + 8 * l, sizeof(value));
+      lanes[l] = mix(lanes[l], value);
+    }
+  }
+  uint64_t hash = (uint64_t)size;
+  for (int l = 0; l < 4; l++)
+    hash = mix(hash, lanes[l]);
+  for (; remaining >= 8; p += 8, remaining -= 8) {
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    hash = mix(hash, value);
+  }
+  if (remaining) {
+    uint64_t value = 0;
+    memcpy(&value, p, remaining);
+    hash = mix(hash, value);
+  }
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdull;
+  return hash ^ (hash >> 33);
+}
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment) { return (value + alignment - 1) / alignment * alignment; }
+
+static size_t tablesSize(const MeshCacheHeader *header) {
+  return (size_t)header->submesh_count * sizeof(MeshCacheSubmesh) + (size_t)header->lod_count * sizeof(MeshCacheLod);
+}
+
+// Covers the header and the submesh and LOD tables that follow it
+static uint64_t headerChecksum(const MeshCacheHeader *header, const void *tables) {
+  MeshCacheHeader copy = *header;
+  copy.checksum = 0;
+  return MeshCacheHash(&copy, sizeof(copy)) ^ rotl(MeshCacheHash(tables, tablesSize(header)), 17);
+}
+
+// Sphere around the AABB center of the referenced vertices
+static void boundRange(const Mesh *mesh, const uint32_t *indices, size_t count, float min[3], float max[3],
+                       float sphere[4]) {
+  for (int c = 0; c < 3; c++) {
+    min[c] = INFINITY;
+    max[c] = -INFINITY;
+  }
+  for (size_t i = 0; i < count; i++) {
+    const float *p = mesh->positions + 3 * (size_t)indices[i];
+    for (int c = 0; c < 3; c++) {
+      min[c] = fminf(min[c], p[c]);
+      max[c] = fmaxf(max[c], p[c]);
+    }
+  }
+  float radius2 = 0.0f;
+  for (int c = 0; c < 3; c++)
+    sphere[c] = count ? 0.5f * (min[c] + max[c]) : 0.0f;
+  for (size_t i = 0; i < count; i++) {
+    const float *p = mesh->positions + 3 * (size_t)indices[i];
+    float dx = p[0] - sphere[0], dy = p[1] - sphere[1], dz = p[2] - sphere[2];
+    radius2 = fmaxf(radius2, dx * dx + dy * dy + dz * dz);
+  }
+  sphere[3] = sqrtf(radius2);
+  if (!count)
+    for (int c = 0; c < 3; c++)
+      min[c] = max[c] = 0.0f;
+}
+
+MeshCacheResult MeshCacheBuild(uint64_t source_hash, const Mesh *mesh, const MeshCacheStreamDesc *streams,
+                               size_t stream_count, const MeshCacheSubmesh *submeshes, size_t submesh_count,
+                               const MeshLodChain *lods, MeshCache *cache) {
+  memset(cache, 0, sizeof(*cache));
+  if (stream_count > MESH_CACHE_MAX_STREAMS || !mesh->positions || mesh->vertex_count > UINT32_MAX ||
+      mesh->index_count > UINT32_MAX || (lods && lods->index_count > UINT32_MAX))
+    return MESH_CACHE_FAILED_FORMAT;
+  MeshLodChain single = {mesh->indices, mesh->index_count, {0}, {mesh->index_count}, {0.0f}, 1};
+  if (!lods)
+    lods = &single;
+  MeshCacheSubmesh whole = {0, (uint32_t)mesh->index_count, {0}};
+  if (!submeshes) {
+    submeshes = &whole;
+    submesh_count = 1;
+  }
+  for (size_t s = 0; s < submesh_count; s++)
+    if ((uint64_t)submeshes[s].index_offset + submeshes[s].index_count > mesh->index_count)
+      return MESH_CACHE_FAILED_FORMAT;
+
+  MeshCacheHeader header = {0};
+  header.magic = MESH_CACHE_MAGIC;
+  header.version = MESH_CACHE_VERSION;
+  header.source_hash = source_hash;
+  header.vertex_count = (uint32_t)mesh->vertex_count;
+  header.index_count = (uint32_t)lods->index_count;
+  header.stream_count = (uint32_t)stream_count;
+  header.submesh_count = (uint32_t)submesh_count;
+  header.lod_count = (uint32_t)lods->lod_count;
+  boundRange(mesh, mesh->indices, mesh->index_count, header.bounds_min, header.bounds_max, header.sphere);
+
+  uint64_t cursor = sizeof(header) + tablesSize(&header);
+  for (size_t s = 0; s < stream_count; s++) {
+    const VertexLayout *layout = streams[s].layout;
+    MeshCacheStream *stream = &header.streams[s];
+    stream->offset = alignUp(cursor, MESH_CACHE_ALIGNMENT);
+    stream->size = (uint64_t)layout->stride * mesh->vertex_count;
+    stream->stride = (uint32_t)layout->stride;
+    stream->attribute_count = (uint32_t)layout->count;
+    for (size_t a = 0; a < layout->count; a++)
+      stream->attributes[a] =
+          (MeshCacheAttribute){(uint16_t)layout->attributes[a].location, (uint16_t)layout->attributes[a].format};
+    cursor = stream->offset + stream->size;
+  }
+  header.index_offset = alignUp(cursor, MESH_CACHE_ALIGNMENT);
+  header.file_size = header.index_offset + lods->index_count * sizeof(uint32_t);
+
+  // Zeroed so the alignment padding is deterministic
+  unsigned char *data = calloc(1, header.file_size);
+  if (!data)
+    return MESH_CACHE_FAILED_WRITE;
+  MeshCacheSubmesh *table = (MeshCacheSubmesh *)(data + sizeof(header));
+  for (size_t s = 0; s < submesh_count; s++) {
+    float min[3], max[3];
+    table[s] = submeshes[s];
+    boundRange(mesh, mesh->indices + table[s].index_offset, table[s].index_count, min, max, table[s].sphere);
+  }
+  MeshCacheLod *lod_table = (MeshCacheLod *)(table + submesh_count);
+  for (size_t l = 0; l < lods->lod_count; l++)
+    lod_table[l] = (MeshCacheLod){(uint32_t)lods->offsets[l], (uint32_t)lods->counts[l], lods->errors[l], 0};
+  for (size_t s = 0; s < stream_count; s++)
+    VertexLayoutPack(streams[s].layout, streams[s].sources, mesh->vertex_count, data + header.streams[s].offset);
+  memcpy(data + header.index_offset, lods->indices, lods->index_count * sizeof(uint32_t));
+  header.checksum = headerChecksum(&header, table);
+  memcpy(data, &header, sizeof(header));
+
+  cache->base = data;
+  cache->size = header.file_size;
+  cache->owned = true;
+  cache->header = (const MeshCacheHeader *)data;
+  cache->submeshes = table;
+  cache->lods = lod_table;
+  cache->indices = (const uint32_t *)(data + header.index_offset);
+  return MESH_CACHE_SUCCESS;
+}
+
+MeshCacheResult MeshCacheWrite(const char *path, const MeshCache *cache) {
+  // Written beside the target and renamed, so a reader never maps a half-written cache
+  char temporary[4096];
+  snprintf(temporary, sizeof(temporary), "%s.tmp", path);
+  FILE *file = fopen(temporary, "wb");
+  if (!file)
+    return MESH_CACHE_FAILED_WRITE;
+  bool written = fwrite(cache->base, 1, cache->size, file) == cache->size;
+  if (fclose(file) != 0 || !written || rename(temporary, path) != 0) {
+    remove(temporary);
+    return MESH_CACHE_FAILED_WRITE;
+  }
+  return MESH_CACHE_SUCCESS;
+}
+
+static bool layoutMatches(const MeshCacheStream *stream, const VertexLayout *layout) {
+  if (stream->attribute_count != layout->count || stream->stride != (uint32_t)layout->stride)
+    return false;
+  for (size_t a = 0; a < layout->count; a++)
+    if (stream->attributes[a].location != layout->attributes[a].location ||
+        stream->attributes[a].format != layout->attributes[a].format)
+      return false;
+  return true;
+}
+
+MeshCacheResult MeshCacheView(const void *data, size_t size, uint64_t source_hash, const VertexLayout *layouts,
+                              size_t layout_count, MeshCache *cache) {
+  memset(cache, 0, sizeof(*cache));
+  const MeshCacheHeader *header = data;
+  if (size < sizeof(MeshCacheHeader) || (uintptr_t)data % sizeof(uint64_t) != 0)
+    return MESH_CACHE_FAILED_FORMAT;
+  uint64_t table_end = sizeof(MeshCacheHeader) + (uint64_t)header->submesh_count * sizeof(MeshCacheSubmesh) +
+                       (uint64_t)header->lod_count * sizeof(MeshCacheLod);
+  if (header->magic != MESH_CACHE_MAGIC || header->version != MESH_CACHE_VERSION || header->file_size != size ||
+      header->stream_count > MESH_CACHE_MAX_STREAMS || header->lod_count == 0 || table_end > size ||
+      header->index_offset % 4 != 0 || header->index_offset + (uint64_t)header->index_count * sizeof(uint32_t) > size)
+    return MESH_CACHE_FAILED_FORMAT;
+  const MeshCacheSubmesh *submeshes = (const MeshCacheSubmesh *)(header + 1);
+  const MeshCacheLod *lods = (const MeshCacheLod *)(submeshes + header->submesh_count);
+  if (header->checksum != headerChecksum(header, submeshes))
+    return MESH_CACHE_FAILED_FORMAT;
+
+  for (uint32_t s = 0; s < header->stream_count; s++) {
+    const MeshCacheStream *stream = &header->streams[s];
+    if (stream->attribute_count > VERTEX_MAX_ATTRIBUTES || stream->offset + stream->size > size ||
+        stream->size != (uint64_t)stream->stride * header->vertex_count)
+      return MESH_CACHE_FAILED_FORMAT;
+    for (uint32_t a = 0; a < stream->attribute_count; a++)
+      if (stream->attributes[a].format >= VERTEX_FORMAT_COUNT)
+        return MESH_CACHE_FAILED_FORMAT;
+  }
+  if (lods[0].index_offset != 0)
+    return MESH_CACHE_FAILED_FORMAT;
+  for (uint32_t l = 0; l < header->lod_count; l++)
+    if ((uint64_t)lods[l].index_offset + lods[l].index_count > header->index_count)
+      return MESH_CACHE_FAILED_FORMAT;
+  for (uint32_t s = 0; s < header->submesh_count; s++)
+    if ((uint64_t)submeshes[s].index_offset + submeshes[s].index_count > lods[0].index_count)
+      return MESH_CACHE_FAILED_FORMAT;
+
+  if (header->source_hash != source_hash)
+    return MESH_CACHE_FAILED_STALE;
+  if (layouts) {
+    if (layout_count != header->stream_count)
+      return MESH_CACHE_FAILED_STALE;
+    for (size_t s = 0; s < layout_count; s++)
+      if (!layoutMatches(&header->streams[s], &layouts[s]))
+        return MESH_CACHE_FAILED_STALE;
+  }
+
+  cache->base = data;
+  cache->size = size;
+  cache->header = header;
+  cache->submeshes = submeshes;
+  cache->lods = lods;
+  cache->indices = (const uint32_t *)(cache->base + header->index_offset);
+  return MESH_CACHE_SUCCESS;
+}
+
+MeshCacheResult MeshCacheOpen(const char *path, uint64_t source_hash, const VertexLayout *layouts,
+                              size_t layout_count, MeshCache *cache) {
+  memset(cache, 0, sizeof(*cache));
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return MESH_CACHE_FAILED_OPEN;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(MeshCacheHeader)) {
+    close(fd);
+    return MESH_CACHE_FAILED_FORMAT;
+  }
+  void *base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED)
+    return MESH_CACHE_FAILED_OPEN;
+
+  MeshCacheResult result = MeshCacheView(base, (size_t)st.st_size, source_hash, layouts, layout_count, cache);
+  if (result != MESH_CACHE_SUCCESS) {
+    munmap(base, (size_t)st.st_size);
+    return result;
+  }
+  cache->mapped = true;
+  return MESH_CACHE_SUCCESS;
+}
+
+void MeshCacheClose(MeshCache *cache) {
+  if (cache->mapped)
+    munmap((void *)cache->base, cache->size);
+  else if (cache->owned)
+    free((void *)cache->base);
+  memset(cache, 0, sizeof(*cache));
+}
+
+const void *MeshCacheStreamData(const MeshCache *cache, size_t stream) {
+  return cache->base + cache->header->streams[stream].offset;
+}
+
+void MeshCacheStreamLayout(const MeshCache *cache, size_t stream, VertexLayout *layout) {
+  const MeshCacheStream *source = &cache->header->streams[stream];
+  VertexLayoutInit(layout);
+  for (uint32_t a = 0; a < source->attribute_count; a++)
+    VertexLayoutAdd(layout, source->attributes[a].location, (VertexFormat)source->attributes[a].format);
+}
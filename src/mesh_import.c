@@ -0,0 +1,759 @@
+#include "clock.h"
+#include "mesh.h"
+#include <fcntl.h>
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef struct FloatArray {
+  float *data;
+  size_t count;
+  size_t capacity;
+} FloatArray;
+
+static bool floatArrayReserve(FloatArray *array, size_t extra) {
+  if (extra > SIZE_MAX / sizeof(float) - array->count)
+    return false;
+  size_t needed = array->count + extra;
+  if (needed <= array->capacity)
+    return true;
+  size_t capacity = array->capacity ? array->capacity : 1024;
+  while (capacity < needed)
+    capacity = capacity <= SIZE_MAX / sizeof(float) / 2 ? capacity * 2 : needed;
+  float *data = realloc(array->data, capacity * sizeof(float));
+  if (!data)
+    return false;
+  array->data = data;
+  array->capacity = capacity;
+  return true;
+}
+
+typedef struct IndexArray {
+  uint32_t *data;
+  size_t count;
+  size_t capacity;
+} IndexArray;
+
+static bool indexArrayPush(IndexArray *array, uint32_t value) {
+  if (array->count == array->capacity) {
+    if (array->capacity > SIZE_MAX / sizeof(uint32_t) / 2)
+      return false;
+    size_t capacity = array->capacity ? array->capacity * 2 : 1024;
+    uint32_t *data = realloc(array->data, capacity * sizeof(uint32_t));
+    if (!data)
+      return false;
+    array->data = data;
+    array->capacity = capacity;
+  }
+  array->data[array->count++] = value;
+  return true;
+}
+
+// ---- OBJ --------------------------------------------------------------------------------------
+
+static const char *skipSpaces(const char *p, const char *end) {
+  while (p < end && (*p == ' ' || *p == '\t'))
+    p++;
+  return p;
+}
+
+static const char *skipLine(const char *p, const char *end) {
+  const char *newline = memchr(p, '\n', (size_t)(end - p));
+  return newline ? newline + 1 : end;
+}
+
+static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+// Decimal mantissa with a power-of-ten exponent; exact for the short values exporters write
+static const char *parseFloat(const char *p, const char *end, float *out) {
+  static const double powers[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+  p = skipSpaces(p, end);
+  bool negative = p < end && *p == '-';
+  if (p < end && (*p == '-' || *p == '+'))
+    p++;
+  uint64_t mantissa = 0;
+  int exponent = 0, digits = 0;
+  for (; p < end && isDigit(*p); p++, digits++) {
+    if (mantissa < 1000000000000000000ull)
+      mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+    else
+      exponent++;
+  }
+  if (p < end && *p == '.') {
+    for (p++; p < end && isDigit(*p); p++, digits++) {
+      if (mantissa < 1000000000000000000ull) {
+        mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+        exponent--;
+      }
+    }
+  }
+  if (digits == 0)
+    return NULL;
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    p++;
+    bool negative_exponent = p < end && *p == '-';
+    if (p < end && (*p == '-' || *p == '+'))
+      p++;
+    int value = 0;
+    for (; p < end && isDigit(*p); p++)
+      value = value < 10000 ? value * 10 + (*p - '0') : value;
+    exponent += negative_exponent ? -value : value;
+  }
+  double result = (double)mantissa;
+  if (exponent < 0)
+    result = -exponent <= 22 ? result / powers[-exponent] : result * pow(10.0, exponent);
+  else if (exponent > 0)
+    result = exponent <= 22 ? result * powers[exponent] : result * pow(10.0, exponent);
+  *out = (float)(negative ? -result : result);
+  return p;
+}
+
+static const char *parseInt(const char *p, const char *end, long *out) {
+  bool negative = p < end && *p == '-';
+  if (p < end && (*p == '-' || *p == '+'))
+    p++;
+  if (p == end || !isDigit(*p))
+    return NULL;
+  long value = 0;
+  for (; p < end && isDigit(*p); p++) {
+    if (value > (LONG_MAX - (*p - '0')) / 10)
+      return NULL;
+    value = value * 10 + (*p - '0');
+  }
+  *out = negative ? -value : value;
+  return p;
+}
+
+// OBJ indices are 1-based, or relative to the end when negative
+static bool resolveIndex(long index, size_t count, uint32_t *out) {
+  long resolved = index > 0 ? index - 1 : (long)count + index;
+  if (index == 0 || resolved < 0 || (size_t)resolved >= count)
+    return false;
+  *out = (uint32_t)resolved;
+  return true;
+}
+
+typedef struct ObjCorner {
+  uint32_t position, uv, normal; // uv/normal are UINT32_MAX when absent
+} ObjCorner;
+
+// Welds face corners on their (position, uv, normal) index triple while parsing
+typedef struct ObjParser {
+  FloatArray positions, colors, uvs, normals; // as declared in the file
+  FloatArray out_positions, out_colors, out_uvs, out_normals;
+  IndexArray indices;
+  ObjCorner *keys;
+  uint32_t *values;
+  size_t table_capacity;
+  size_t vertex_count;
+  size_t corners;
+  bool has_uvs, has_normals;
+} ObjParser;
+
+static uint32_t hashCorner(ObjCorner c) {
+  uint32_t hash = c.position * 0x9e3779b1u ^ (c.uv + 0x7f4a7c15u) * 0x85ebca6bu;
+  hash ^= (c.normal + 0x165667b1u) * 0xc2b2ae35u;
+  return hash ^ (hash >> 16);
+}
+
+static bool growCornerTable(ObjParser *parser) {
+  size_t capacity = parser->table_capacity ? parser->table_capacity * 2 : 4096;
+  ObjCorner *keys = malloc(capacity * sizeof(ObjCorner));
+  uint32_t *values = malloc(capacity * sizeof(uint32_t));
+  if (!keys || !values) {
+    free(keys);
+    free(values);
+    return false;
+  }
+  memset(values, 0xff, capacity * sizeof(uint32_t));
+  for (size_t i = 0; i < parser->table_capacity; i++) {
+    if (parser->values[i] == UINT32_MAX)
+      continue;
+    size_t slot = hashCorner(parser->keys[i]) & (capacity - 1);
+    while (values[slot] != UINT32_MAX)
+      slot = (slot + 1) & (capacity - 1);
+    keys[slot] = parser->keys[i];
+    values[slot] = parser->values[i];
+  }
+  free(parser->keys);
+  free(parser->values);
+  parser->keys = keys;
+  parser->values = values;
+  parser->table_capacity = capacity;
+  return true;
+}
+
+static bool appendFloats(FloatArray *dst, const FloatArray *src, uint32_t index, size_t components, float fallback) {
+  if (!floatArrayReserve(dst, components))
+    return false;
+  bool present = index != UINT32_MAX && (size_t)index * components < src->count;
+  for (size_t c = 0; c < components; c++)
+    dst->data[dst->count++] = present ? src->data[index * components + c] : fallback;
+  return true;
+}
+
+static bool weldCorner(ObjParser *parser, ObjCorner corner, uint32_t *index) {
+  parser->corners++;
+  if (parser->vertex_count * 2 >= parser->table_capacity && !growCornerTable(parser))
+    return false;
+  size_t slot = hashCorner(corner) & (parser->table_capacity - 1);
+  while (parser->values[slot] != UINT32_MAX) {
+    ObjCorner *key = &parser->keys[slot];
+    if (key->position == corner.position && key->uv == corner.uv && key->normal == corner.normal) {
+      *index = parser->values[slot];
+      return true;
+    }
+    slot = (slot + 1) & (parser->table_capacity - 1);
+  }
+
+  *index = (uint32_t)parser->vertex_count++;
+  parser->keys[slot] = corner;
+  parser->values[slot] = *index;
+  // Vertices declared without a colour come out white
+  return appendFloats(&parser->out_positions, &parser->positions, corner.position, 3, 0.0f) &&
+         appendFloats(&parser->out_colors, &parser->colors, corner.position, 3, 1.0f) &&
+         appendFloats(&parser->out_uvs, &parser->uvs, corner.uv, 2, 0.0f) &&
+         appendFloats(&parser->out_normals, &parser->normals, corner.normal, 3, 0.0f);
+}
+
+static const char *parseCorner(ObjParser *parser, const char *p, const char *end, ObjCorner *corner) {
+  long value;
+  p = parseInt(p, end, &value);
+  if (!p || !resolveIndex(value, parser->positions.count / 3, &corner->position))
+    return NULL;
+  corner->uv = corner->normal = UINT32_MAX;
+  if (p < end && *p == '/') {
+    p++;
+    if (p < end && *p != '/') {
+      p = parseInt(p, end, &value);
+      if (!p || !resolveIndex(value, parser->uvs.count / 2, &corner->uv))
+        return NULL;
+      parser->has_uvs = true;
+    }
+    if (p < end && *p == '/') {
+      p = parseInt(p + 1, end, &value);
+      if (!p || !resolveIndex(value, parser->normals.count / 3, &corner->normal))
+        return NULL;
+      parser->has_normals = true;
+    }
+  }
+  return p;
+}
+
+static const char *parseFloats(const char *p, const char *end, FloatArray *array, size_t count) {
+  if (!floatArrayReserve(array, count))
+    return NULL;
+  for (size_t i = 0; i < count; i++) {
+    if (!(p = parseFloat(p, end, &array->data[array->count + i])))
+      return NULL;
+  }
+  array->count += count;
+  return p;
+}
+
+static MeshResult parseObjLine(ObjParser *parser, const char *p, const char *end) {
+  if (p[0] == 'v' && p + 1 < end && (p[1] == ' ' || p[1] == '\t')) {
+    if (!(p = parseFloats(p + 1, end, &parser->positions, 3)))
+      return MESH_FAILED_FORMAT;
+    // Optional per-vertex colour extension: v x y z r g b
+    p = skipSpaces(p, end);
+    if (p < end && *p != '\n' && *p != '\r' && *p != '#') {
+      // earlier vertices without a colour are padded so colours stay indexed like positions
+      while (parser->colors.count < parser->positions.count - 3) {
+        if (!floatArrayReserve(&parser->colors, 1))
+          return MESH_FAILED_MEMORY;
+        parser->colors.data[parser->colors.count++] = 1.0f;
+      }
+      if (!parseFloats(p, end, &parser->colors, 3))
+        return MESH_FAILED_FORMAT;
+    }
+  } else if (p[0] == 'v' && p + 2 < end && p[1] == 't') {
+    if (!(p = parseFloats(p + 2, end, &parser->uvs, 2)))
+      return MESH_FAILED_FORMAT;
+  } else if (p[0] == 'v' && p + 2 < end && p[1] == 'n') {
+    if (!parseFloats(p + 2, end, &parser->normals, 3))
+      return MESH_FAILED_FORMAT;
+  } else if (p[0] == 'f' && p + 1 < end && (p[1] == ' ' || p[1] == '\t')) {
+    // Polygons are fanned around their first corner
+    uint32_t first = 0, previous = 0;
+    size_t corner_count = 0;
+    for (p = skipSpaces(p + 1, end); p < end && *p != '\n' && *p != '\r' && *p != '#'; p = skipSpaces(p, end)) {
+      ObjCorner corner;
+      uint32_t index;
+      if (!(p = parseCorner(parser, p, end, &corner)))
+        return MESH_FAILED_FORMAT;
+      if (!weldCorner(parser, corner, &index))
+        return MESH_FAILED_MEMORY;
+      if (corner_count >= 2 && first != previous && previous != index && index != first) {
+        if (!indexArrayPush(&parser->indices, first) || !indexArrayPush(&parser->indices, previous) ||
+            !indexArrayPush(&parser->indices, index))
+          return MESH_FAILED_MEMORY;
+      }
+      if (corner_count++ == 0)
+        first = index;
+      previous = index;
+    }
+  }
+  return MESH_SUCCESS;
+}
+
+static void objParserFree(ObjParser *parser) {
+  free(parser->positions.data);
+  free(parser->colors.data);
+  free(parser->uvs.data);
+  free(parser->normals.data);
+  free(parser->out_positions.data);
+  free(parser->out_colors.data);
+  free(parser->out_uvs.data);
+  free(parser->out_normals.data);
+  free(parser->indices.data);
+  free(parser->keys);
+  free(parser->values);
+}
+
+static MeshResult importObj(const char *data, size_t size, Mesh *mesh, size_t *corners) {
+  ObjParser parser = {0};
+  const char *end = data + size;
+  MeshResult result = MESH_SUCCESS;
+  for (const char *p = data; p < end && result == MESH_SUCCESS; p = skipLine(p, end)) {
+    p = skipSpaces(p, end);
+    if (p < end)
+      result = parseObjLine(&parser, p, end);
+  }
+  if (result == MESH_SUCCESS && parser.indices.count == 0)
+    result = MESH_FAILED_FORMAT;
+  if (result != MESH_SUCCESS) {
+    objParserFree(&parser);
+    return result;
+  }
+
+  // Ownership of the welded arrays moves to the mesh
+  mesh->positions = parser.out_positions.data;
+  mesh->colors = parser.colors.count ? parser.out_colors.data : NULL;
+  mesh->uvs = parser.has_uvs ? parser.out_uvs.data : NULL;
+  mesh->normals = parser.has_normals ? parser.out_normals.data : NULL;
+  mesh->indices = parser.indices.data;
+  mesh->vertex_count = parser.vertex_count;
+  mesh->index_count = parser.indices.count;
+  *corners = parser.corners;
+  if (!mesh->colors)
+    free(parser.out_colors.data);
+  if (!mesh->uvs)
+    free(parser.out_uvs.data);
+  if (!mesh->normals)
+    free(parser.out_normals.data);
+  parser.out_positions.data = parser.out_colors.data = parser.out_uvs.data = parser.out_normals.data = NULL;
+  parser.indices.data = NULL;
+  objParserFree(&parser);
+  return MESH_SUCCESS;
+}
+
+// ---- glTF binary ------------------------------------------------------------------------------
+
+#define GLB_MAGIC 0x46546c67u // "glTF"
+#define GLB_CHUNK_JSON 0x4e4f534au
+#define GLB_CHUNK_BIN 0x004e4942u
+
+typedef enum JsonType { JSON_OBJECT, JSON_ARRAY, JSON_STRING, JSON_PRIMITIVE } JsonType;
+
+// Flat pre-order token list; a container's children are the tokens that start before its end
+typedef struct JsonToken {
+  JsonType type;
+  uint32_t start, end; // strings exclude the quotes
+  int32_t parent;
+} JsonToken;
+
+typedef struct Json {
+  const char *text;
+  JsonToken *tokens;
+  int count;
+} Json;
+
+static bool jsonTokenize(Json *json, size_t length) {
+  // Every token starts on its own character
+  json->tokens = malloc((length + 1) * sizeof(JsonToken));
+  if (!json->tokens)
+    return false;
+  const char *text = json->text;
+  int parent = -1;
+  json->count = 0;
+  for (size_t i = 0; i < length; i++) {
+    char c = text[i];
+    JsonToken *token = &json->tokens[json->count];
+    switch (c) {
+    case '{':
+    case '[':
+      *token = (JsonToken){c == '{' ? JSON_OBJECT : JSON_ARRAY, (uint32_t)i, 0, parent};
+      parent = json->count++;
+      break;
+    case '}':
+    case ']':
+      if (parent < 0)
+        return false;
+      json->tokens[parent].end = (uint32_t)i + 1;
+      parent = json->tokens[parent].parent;
+      break;
+    case '"': {
+      size_t j = i + 1;
+      while (j < length && text[j] != '"')
+        j += text[j] == '\\' ? 2 : 1;
+      if (j >= length)
+        return false;
+      *token = (JsonToken){JSON_STRING, (uint32_t)i + 1, (uint32_t)j, parent};
+      json->count++;
+      i = j;
+      break;
+    }
+    case ' ':
+    case '\t':
+    case '\n':
+    case '\r':
+    case ':':
+    case ',':
+      break;
+    default: {
+      size_t j = i;
+      while (j < length && !strchr(",]} \t\r\n", text[j]))
+        j++;
+      *token = (JsonToken){JSON_PRIMITIVE, (uint32_t)i, (uint32_t)j, parent};
+      json->count++;
+      i = j - 1;
+      break;
+    }
+    }
+  }
+  return parent == -1 && json->count > 0 && json->tokens[0].type == JSON_OBJECT;
+}
+
+static int jsonNext(const Json *json, int index) {
+  const JsonToken *token = &json->tokens[index];
+  if (token->type != JSON_OBJECT && token->type != JSON_ARRAY)
+    return index + 1;
+  int next = index + 1;
+  while (next < json->count && json->tokens[next].start < token->end)
+    next++;
+  return next;
+}
+
+static int jsonFind(const Json *json, int object, const char *key) {
+  if (object < 0 || json->tokens[object].type != JSON_OBJECT)
+    return -1;
+  size_t key_length = strlen(key);
+  for (int i = object + 1; i + 1 < json->count && json->tokens[i].start < json->tokens[object].end;
+       i = jsonNext(json, i + 1)) {
+    const JsonToken *name = &json->tokens[i];
+    if (name->end - name->start == key_length && memcmp(json->text + name->start, key, key_length) == 0)
+      return i + 1;
+  }
+  return -1;
+}
+
+static int jsonAt(const Json *json, int array, int n) {
+  if (array < 0 || n < 0 || json->tokens[array].type != JSON_ARRAY)
+    return -1;
+  int i = array + 1;
+  for (int k = 0; k < n && i < json->count && json->tokens[i].start < json->tokens[array].end; k++)
+    i = jsonNext(json, i);
+  return i < json->count && json->tokens[i].start < json->tokens[array].end ? i : -1;
+}
+
+static long jsonInt(const Json *json, int token, long fallback) {
+  if (token < 0 || json->tokens[token].type != JSON_PRIMITIVE)
+    return fallback;
+  long value;
+  const char *start = json->text + json->tokens[token].start;
+  return parseInt(start, json->text + json->tokens[token].end, &value) ? value : fallback;
+}
+
+// An array index, or -1 for anything jsonAt cannot take
+static int jsonIndex(const Json *json, int token) {
+  long value = jsonInt(json, token, -1);
+  return value >= 0 && value <= INT_MAX ? (int)value : -1;
+}
+
+static bool jsonEquals(const Json *json, int token, const char *value) {
+  size_t length = strlen(value);
+  return token >= 0 && json->tokens[token].end - json->tokens[token].start == length &&
+         memcmp(json->text + json->tokens[token].start, value, length) == 0;
+}
+
+typedef struct GlbAccessor {
+  const unsigned char *data;
+  size_t count;
+  size_t components;
+  size_t stride;
+  long component_type;
+  bool normalized;
+} GlbAccessor;
+
+static size_t componentSize(long component_type) {
+  switch (component_type) {
+  case 5120: // BYTE
+  case 5121: // UNSIGNED_BYTE
+    return 1;
+  case 5122: // SHORT
+  case 5123: // UNSIGNED_SHORT
+    return 2;
+  case 5125: // UNSIGNED_INT
+  case 5126: // FLOAT
+    return 4;
+  default:
+    return 0;
+  }
+}
+
+// Every size comes from the file, so the accessor is only taken once all of its elements are
+// known to lie inside its buffer view, and the view inside the binary chunk
+static bool glbAccessor(const Json *json, int root, int index, const unsigned char *bin, size_t bin_size,
+                        GlbAccessor *accessor) {
+  int token = jsonAt(json, jsonFind(json, root, "accessors"), index);
+  if (token < 0)
+    return false;
+  int view = jsonAt(json, jsonFind(json, root, "bufferViews"), jsonIndex(json, jsonFind(json, token, "bufferView")));
+  if (view < 0 || jsonInt(json, jsonFind(json, view, "buffer"), 0) != 0)
+    return false;
+
+  int type = jsonFind(json, token, "type");
+  accessor->components = jsonEquals(json, type, "SCALAR") ? 1
+                         : jsonEquals(json, type, "VEC2") ? 2
+                         : jsonEquals(json, type, "VEC3") ? 3
+                         : jsonEquals(json, type, "VEC4") ? 4
+                                                          : 0;
+  accessor->component_type = jsonInt(json, jsonFind(json, token, "componentType"), 0);
+  accessor->normalized = jsonEquals(json, jsonFind(json, token, "normalized"), "true");
+  size_t element = accessor->components * componentSize(accessor->component_type);
+  long count = jsonInt(json, jsonFind(json, token, "count"), 0);
+  long stride = jsonInt(json, jsonFind(json, view, "byteStride"), (long)element);
+  long view_offset = jsonInt(json, jsonFind(json, view, "byteOffset"), 0);
+  long view_length = jsonInt(json, jsonFind(json, view, "byteLength"), 0);
+  long offset = jsonInt(json, jsonFind(json, token, "byteOffset"), 0);
+  if (element == 0 || count <= 0 || stride < (long)element || view_offset < 0 || view_length < 0 || offset < 0 ||
+      (size_t)view_offset > bin_size || (size_t)view_length > bin_size - (size_t)view_offset ||
+      (size_t)offset > (size_t)view_length || element > (size_t)view_length - (size_t)offset)
+    return false;
+  size_t available = (size_t)view_length - (size_t)offset;
+  if ((size_t)count > (available - element) / (size_t)stride + 1)
+    return false;
+  accessor->count = (size_t)count;
+  accessor->stride = (size_t)stride;
+  accessor->data = bin + view_offset + offset;
+  return true;
+}
+
+static float readComponent(const GlbAccessor *accessor, size_t element, size_t component) {
+  size_t offset = element * accessor->stride + component * componentSize(accessor->component_type);
+  const unsigned char *p = accessor->data + offset;
+  switch (accessor->component_type) {
+  case 5126: {
+    float value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+  }
+  case 5121:
+    return accessor->normalized ? *p / 255.0f : (float)*p;
+  case 5123: {
+    uint16_t value;
+    memcpy(&value, p, sizeof(value));
+    return accessor->normalized ? value / 65535.0f : (float)value;
+  }
+  case 5120:
+    return accessor->normalized ? fmaxf((int8_t)*p / 127.0f, -1.0f) : (float)(int8_t)*p;
+  case 5122: {
+    int16_t value;
+    memcpy(&value, p, sizeof(value));
+    return accessor->normalized ? fmaxf(value / 32767.0f, -1.0f) : (float)value;
+  }
+  default:
+    return 0.0f;
+  }
+}
+
+static uint32_t readIndex(const GlbAccessor *accessor, size_t element) {
+  const unsigned char *p = accessor->data + element * accessor->stride;
+  if (accessor->component_type == 5121)
+    return *p;
+  if (accessor->component_type == 5123) {
+    uint16_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+  }
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+// Appends `components` floats per vertex, or the fallback when the primitive lacks the attribute
+static bool appendAccessor(FloatArray *array, const GlbAccessor *accessor, size_t count, size_t components,
+                           float fallback) {
+  if (!floatArrayReserve(array, count * components))
+    return false;
+  for (size_t v = 0; v < count; v++)
+    for (size_t c = 0; c < components; c++)
+      array->data[array->count++] =
+          accessor && c < accessor->components ? readComponent(accessor, v, c) : fallback;
+  return true;
+}
+
+static MeshResult importGlbPrimitive(const Json *json, int root, int primitive, const unsigned char *bin,
+                                     size_t bin_size, FloatArray *streams, bool *present, IndexArray *indices) {
+  if (jsonInt(json, jsonFind(json, primitive, "mode"), 4) != 4)
+    return MESH_SUCCESS; // only triangle lists
+  int attributes = jsonFind(json, primitive, "attributes");
+  static const char *names[4] = {"POSITION", "NORMAL", "TEXCOORD_0", "COLOR_0"};
+  static const size_t components[4] = {3, 3, 2, 3};
+  static const float fallbacks[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+  GlbAccessor accessors[4];
+  bool found[4];
+  for (int a = 0; a < 4; a++) {
+    int token = jsonFind(json, attributes, names[a]);
+    found[a] = token >= 0 && glbAccessor(json, root, jsonIndex(json, token), bin, bin_size, &accessors[a]);
+  }
+  if (!found[0] || accessors[0].components != 3)
+    return MESH_FAILED_FORMAT;
+
+  size_t base = streams[0].count / 3, count = accessors[0].count;
+  for (int a = 0; a < 4; a++) {
+    present[a] |= found[a];
+    if (found[a] && accessors[a].count < count)
+      return MESH_FAILED_FORMAT;
+    if (!appendAccessor(&streams[a], found[a] ? &accessors[a] : NULL, count, components[a], fallbacks[a]))
+      return MESH_FAILED_MEMORY;
+  }
+
+  int index_token = jsonFind(json, primitive, "indices");
+  GlbAccessor index_accessor;
+  bool indexed = index_token >= 0;
+  if (indexed && (!glbAccessor(json, root, jsonIndex(json, index_token), bin, bin_size, &index_accessor) ||
+                  index_accessor.components != 1 ||
+                  (index_accessor.component_type != 5121 && index_accessor.component_type != 5123 &&
+                   index_accessor.component_type != 5125)))
+    return MESH_FAILED_FORMAT;
+  size_t index_count = indexed ? index_accessor.count : count;
+  for (size_t i = 0; i + 2 < index_count; i += 3) {
+    uint32_t tri[3];
+    for (int k = 0; k < 3; k++) {
+      tri[k] = indexed ? readIndex(&index_accessor, i + k) : (uint32_t)(i + k);
+      if (tri[k] >= count)
+        return MESH_FAILED_FORMAT;
+    }
+    for (int k = 0; k < 3; k++)
+      if (!indexArrayPush(indices, (uint32_t)base + tri[k]))
+        return MESH_FAILED_MEMORY;
+  }
+  return MESH_SUCCESS;
+}
+
+static MeshResult importGlb(const unsigned char *data, size_t size, Mesh *mesh, size_t *corners) {
+  uint32_t header[5];
+  if (size < 28)
+    return MESH_FAILED_FORMAT;
+  memcpy(header, data, sizeof(header));
+  uint32_t json_length = header[3];
+  if (header[0] != GLB_MAGIC || header[1] != 2 || header[2] > size || header[4] != GLB_CHUNK_JSON ||
+      20ull + json_length + 8 > header[2])
+    return MESH_FAILED_FORMAT;
+  uint32_t bin_header[2];
+  memcpy(bin_header, data + 20 + json_length, sizeof(bin_header));
+  const unsigned char *bin = data + 28 + json_length;
+  if (bin_header[1] != GLB_CHUNK_BIN || 28ull + json_length + bin_header[0] > header[2])
+    return MESH_FAILED_FORMAT;
+
+  Json json = {(const char *)data + 20, NULL, 0};
+  if (!jsonTokenize(&json, json_length)) {
+    free(json.tokens);
+    return MESH_FAILED_FORMAT;
+  }
+
+  FloatArray streams[4] = {{0}};
+  bool present[4] = {false};
+  IndexArray indices = {0};
+  MeshResult result = MESH_SUCCESS;
+  int meshes = jsonFind(&json, 0, "meshes");
+  for (int m = 0; result == MESH_SUCCESS && jsonAt(&json, meshes, m) >= 0; m++) {
+    int primitives = jsonFind(&json, jsonAt(&json, meshes, m), "primitives");
+    for (int p = 0; result == MESH_SUCCESS && jsonAt(&json, primitives, p) >= 0; p++)
+      result = importGlbPrimitive(&json, 0, jsonAt(&json, primitives, p), bin, bin_header[0], streams, present,
+                                  &indices);
+  }
+  free(json.tokens);
+  if (result == MESH_SUCCESS && indices.count == 0)
+    result = MESH_FAILED_FORMAT;
+  if (result != MESH_SUCCESS) {
+    for (int a = 0; a < 4; a++)
+      free(streams[a].data);
+    free(indices.data);
+    return result;
+  }
+
+  float **fields[4] = {&mesh->positions, &mesh->normals, &mesh->uvs, &mesh->colors};
+  for (int a = 0; a < 4; a++) {
+    *fields[a] = present[a] ? streams[a].data : NULL;
+    if (!present[a])
+      free(streams[a].data);
+  }
+  mesh->indices = indices.data;
+  mesh->vertex_count = streams[0].count / 3;
+  mesh->index_count = indices.count;
+  *corners = mesh->vertex_count;
+  // Exporters commonly split vertices per primitive or per face; merge the identical ones
+  return MeshWeld(mesh) ? MESH_SUCCESS : MESH_FAILED_MEMORY;
+}
+
+// ---- Entry points -----------------------------------------------------------------------------
+
+static bool hasExtension(const char *name, const char *extension) {
+  size_t length = strlen(name), extension_length = strlen(extension);
+  return length >= extension_length && strcmp(name + length - extension_length, extension) == 0;
+}
+
+MeshResult MeshImport(const char *name, const void *data, size_t size, Mesh *mesh, MeshImportStats *stats) {
+  memset(mesh, 0, sizeof(*mesh));
+  MeshImportStats local;
+  if (!stats)
+    stats = &local;
+  memset(stats, 0, sizeof(*stats));
+  stats->bytes = size;
+
+  double start = ClockNow();
+  MeshResult result = hasExtension(name, ".glb") ? importGlb(data, size, mesh, &stats->corners)
+                                                 : importObj(data, size, mesh, &stats->corners);
+  stats->parse_time = ClockNow() - start;
+  if (result != MESH_SUCCESS)
+    return result;
+
+  start = ClockNow();
+  stats->acmr_before = MeshAcmr(mesh->indices, mesh->index_count, mesh->vertex_count, MESH_ACMR_CACHE_SIZE);
+  if (!MeshOptimizeVertexCache(mesh->indices, mesh->index_count, mesh->vertex_count) ||
+      !MeshOptimizeVertexFetch(mesh)) {
+    MeshFree(mesh);
+    return MESH_FAILED_MEMORY;
+  }
+  stats->acmr_after = MeshAcmr(mesh->indices, mesh->index_count, mesh->vertex_count, MESH_ACMR_CACHE_SIZE);
+  stats->optimize_time = ClockNow() - start;
+  return MESH_SUCCESS;
+}
+
+MeshResult MeshImportFile(const char *path, Mesh *mesh, MeshImportStats *stats) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return MESH_FAILED_OPEN;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return MESH_FAILED_FORMAT;
+  }
+  void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+    return MESH_FAILED_OPEN;
+  // The parsers only walk forward through the file
+  madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+  MeshResult result = MeshImport(path, data, (size_t)st.st_size, mesh, stats);
+  munmap(data, (size_t)st.st_size);
+  return result;
+}
@@ -0,0 +1,456 @@
+#include "mesh.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Garland & Heckbert, "Surface Simplification Using Quadric Error Metrics" (1997), as half-edge
+// collapses onto existing vertices so the vertex buffer is shared by every level of detail.
+// Collapses run in passes of independent edges ordered by cost, which avoids a priority queue
+// with updates and keeps each pass a linear sweep.
+
+#define SIMPLIFY_ATTRIBUTE_WEIGHT 0.01f // error of a unit attribute change, relative to the extent squared
+#define SIMPLIFY_MIN_FLIP_COSINE 0.25f  // triangles may not turn further than ~75 degrees
+#define SIMPLIFY_LOCKED 1
+#define SIMPLIFY_TOUCHED 2
+
+typedef struct Quadric {
+  float a00, a11, a22, a10, a20, a21;
+  float b0, b1, b2, c;
+  float w; // accumulated area, so errors are area-weighted averages of squared distances
+} Quadric;
+
+typedef struct Collapse {
+  float cost;
+  uint32_t from; // vertex removed by the collapse
+} Collapse;
+
+typedef struct SimplifyState {
+  const Mesh *mesh;
+  float *positions;    // normalized into the unit cube
+  uint32_t *canonical; // first vertex with the same position
+  uint32_t *wedges;    // vertices sharing each canonical position
+  uint8_t *flags;
+  Quadric *quadrics; // by canonical vertex
+  uint32_t *offsets; // triangles around each canonical vertex
+  uint32_t *adjacency;
+  float *best_cost;
+  uint32_t *best_target;
+  uint32_t *collapse;
+  Collapse *candidates;
+  uint64_t *edges; // open-addressing set of directed canonical edges
+  size_t edge_capacity;
+} SimplifyState;
+
+float MeshExtent(const Mesh *mesh) {
+  float min[3] = {INFINITY, INFINITY, INFINITY}, max[3] = {-INFINITY, -INFINITY, -INFINITY};
+  for (size_t v = 0; v < mesh->vertex_count; v++)
+    for (int c = 0; c < 3; c++) {
+      min[c] = fminf(min[c], mesh->positions[v * 3 + c]);
+      max[c] = fmaxf(max[c], mesh->positions[v * 3 + c]);
+    }
+  float extent = 0.0f;
+  for (int c = 0; c < 3; c++)
+    extent = fmaxf(extent, max[c] - min[c]);
+  return mesh->vertex_count ? extent : 0.0f;
+}
+
+static void quadricAddPlane(Quadric *q, const float n[3], float d, float w) {
+  q->a00 += w * n[0] * n[0];
+  q->a11 += w * n[1] * n[1];
+  q->a22 += w * n[2] * n[2];
+  q->a10 += w * n[1] * n[0];
+  q->a20 += w * n[2] * n[0];
+  q->a21 += w * n[2] * n[1];
+  q->b0 += w * n[0] * d;
+  q->b1 += w * n[1] * d;
+  q->b2 += w * n[2] * d;
+  q->c += w * d * d;
+  q->w += w;
+}
+
+static void quadricAdd(Quadric *q, const Quadric *r) {
+  q->a00 += r->a00;
+  q->a11 += r->a11;
+  q->a22 += r->a22;
+  q->a10 += r->a10;
+  q->a20 += r->a20;
+  q->a21 += r->a21;
+  q->b0 += r->b0;
+  q->b1 += r->b1;
+  q->b2 += r->b2;
+  q->c += r->c;
+  q->w += r->w;
+}
+
+static float quadricError(const Quadric *q, const float *p) {
+  float x = p[0], y = p[1], z = p[2];
+  float rx = q->a00 * x + q->a10 * y + q->a20 * z;
+  float ry = q->a10 * x + q->a11 * y + q->a21 * z;
+  float rz = q->a20 * x + q->a21 * y + q->a22 * z;
+  float error = rx * x + ry * y + rz * z + 2.0f * (q->b0 * x + q->b1 * y + q->b2 * z) + q->c;
+  return fabsf(error) / (q->w > 0.0f ? q->w : 1.0f);
+}
+
+static void triangleNormal(const float *a, const float *b, const float *c, float n[3]) {
+  float e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+  float e2[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+  n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+  n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+  n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+static float attributeDistance(const Mesh *mesh, uint32_t a, uint32_t b) {
+  float distance = 0.0f;
+  const float *streams[3] = {mesh->normals, mesh->uvs, mesh->colors};
+  const size_t components[3] = {3, 2, 3};
+  for (int s = 0; s < 3; s++) {
+    if (!streams[s])
+      continue;
+    for (size_t c = 0; c < components[s]; c++) {
+      float delta = streams[s][a * components[s] + c] - streams[s][b * components[s] + c];
+      distance += delta * delta;
+    }
+  }
+  return distance;
+}
+
+static uint64_t edgeHash(uint64_t key) {
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdull;
+  return key ^ (key >> 33);
+}
+
+// Returns 1 when the directed edge is already in the set
+static uint32_t edgeInsert(SimplifyState *state, uint32_t a, uint32_t b, bool insert) {
+  uint64_t key = ((uint64_t)a << 32 | b) + 1; // 0 marks an empty slot
+  size_t mask = state->edge_capacity - 1;
+  for (size_t slot = edgeHash(key) & mask;; slot = (slot + 1) & mask) {
+    if (state->edges[slot] == key)
+      return 1;
+    if (state->edges[slot] == 0) {
+      if (insert)
+        state->edges[slot] = key;
+      return 0;
+    }
+  }
+}
+
+static bool mergePositions(SimplifyState *state) {
+  const Mesh *mesh = state->mesh;
+  size_t capacity = 1;
+  while (capacity < mesh->vertex_count * 2)
+    capacity <<= 1;
+  uint32_t *table = malloc(capacity * sizeof(uint32_t));
+  if (!table)
+    return false;
+  memset(table, 0xff, capacity * sizeof(uint32_t));
+  for (size_t v = 0; v < mesh->vertex_count; v++) {
+    const float *p = &mesh->positions[v * 3];
+    uint32_t bits[3];
+    memcpy(bits, p, sizeof(bits));
+    uint32_t hash = (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+    size_t slot = (hash ^ (hash >> 15)) & (capacity - 1);
+    while (table[slot] != UINT32_MAX && memcmp(&mesh->positions[table[slot] * 3], p, 3 * sizeof(float)) != 0)
+      slot = (slot + 1) & (capacity - 1);
+    if (table[slot] == UINT32_MAX)
+      table[slot] = (uint32_t)v;
+    state->canonical[v] = table[slot];
+    state->wedges[table[slot]]++;
+  }
+  free(table);
+  return true;
+}
+
+// Border and non-manifold edges, and positions split by attribute seams, are never removed
+static void classify(SimplifyState *state, const uint32_t *indices, size_t index_count) {
+  const uint32_t *canonical = state->canonical;
+  for (size_t v = 0; v < state->mesh->vertex_count; v++)
+    if (state->wedges[v] > 1)
+      state->flags[v] |= SIMPLIFY_LOCKED;
+  for (size_t i = 0; i < index_count; i += 3)
+    for (int k = 0; k < 3; k++) {
+      uint32_t a = canonical[indices[i + k]], b = canonical[indices[i + (k + 1) % 3]];
+      if (edgeInsert(state, a, b, true)) {
+        state->flags[a] |= SIMPLIFY_LOCKED;
+        state->flags[b] |= SIMPLIFY_LOCKED;
+      }
+    }
+  for (size_t i = 0; i < index_count; i += 3)
+    for (int k = 0; k < 3; k++) {
+      uint32_t a = canonical[indices[i + k]], b = canonical[indices[i + (k + 1) % 3]];
+      if (!edgeInsert(state, b, a, false)) {
+        state->flags[a] |= SIMPLIFY_LOCKED;
+        state->flags[b] |= SIMPLIFY_LOCKED;
+      }
+    }
+}
+
+static void accumulateQuadrics(SimplifyState *state, const uint32_t *indices, size_t index_count) {
+  for (size_t i = 0; i < index_count; i += 3) {
+    const float *p0 = &state->positions[indices[i] * 3], *p1 = &state->positions[indices[i + 1] * 3],
+                *p2 = &state->positions[indices[i + 2] * 3];
+    float n[3];
+    triangleNormal(p0, p1, p2, n);
+    float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    if (length == 0.0f)
+      continue;
+    for (int c = 0; c < 3; c++)
+      n[c] /= length;
+    float d = -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]);
+    for (int k = 0; k < 3; k++)
+      quadricAddPlane(&state->quadrics[state->canonical[indices[i + k]]], n, d, 0.5f * length);
+  }
+}
+
+static size_t removeDegenerate(const SimplifyState *state, uint32_t *indices, size_t index_count) {
+  size_t kept = 0;
+  for (size_t i = 0; i < index_count; i += 3) {
+    uint32_t a = state->canonical[indices[i]], b = state->canonical[indices[i + 1]],
+             c = state->canonical[indices[i + 2]];
+    if (a != b && b != c && c != a) {
+      memmove(&indices[kept], &indices[i], 3 * sizeof(uint32_t));
+      kept += 3;
+    }
+  }
+  return kept;
+}
+
+static void buildAdjacency(SimplifyState *state, const uint32_t *indices, size_t index_count) {
+  size_t vertex_count = state->mesh->vertex_count;
+  memset(state->offsets, 0, (vertex_count + 1) * sizeof(uint32_t));
+  for (size_t i = 0; i < index_count; i++)
+    state->offsets[state->canonical[indices[i]] + 1]++;
+  for (size_t v = 0; v < vertex_count; v++)
+    state->offsets[v + 1] += state->offsets[v];
+  for (size_t i = 0; i < index_count; i++)
+    state->adjacency[state->offsets[state->canonical[indices[i]]]++] = (uint32_t)(i / 3);
+  // The fill advanced each offset to the start of the next vertex; shift them back
+  for (size_t v = vertex_count; v > 0; v--)
+    state->offsets[v] = state->offsets[v - 1];
+  state->offsets[0] = 0;
+}
+
+// Moving `from` onto `to` must not turn any surviving triangle around `from` inside out
+static bool collapseFlips(const SimplifyState *state, const uint32_t *indices, uint32_t from, uint32_t to) {
+  uint32_t from_canonical = state->canonical[from], to_canonical = state->canonical[to];
+  const float *target = &state->positions[to * 3];
+  for (uint32_t a = state->offsets[from_canonical]; a < state->offsets[from_canonical + 1]; a++) {
+    const uint32_t *tri = &indices[state->adjacency[a] * 3];
+    const float *before[3], *after[3];
+    bool collapses = false;
+    for (int k = 0; k < 3; k++) {
+      uint32_t c = state->canonical[tri[k]];
+      collapses |= c == to_canonical;
+      before[k] = &state->positions[tri[k] * 3];
+      after[k] = c == from_canonical ? target : before[k];
+    }
+    if (collapses)
+      continue;
+    float n0[3], n1[3];
+    triangleNormal(before[0], before[1], before[2], n0);
+    triangleNormal(after[0], after[1], after[2], n1);
+    float dot = n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2];
+    float length0 = n0[0] * n0[0] + n0[1] * n0[1] + n0[2] * n0[2];
+    float length1 = n1[0] * n1[0] + n1[1] * n1[1] + n1[2] * n1[2];
+    if (dot <= SIMPLIFY_MIN_FLIP_COSINE * sqrtf(length0 * length1))
+      return true;
+  }
+  return false;
+}
+
+static int compareCollapses(const void *a, const void *b) {
+  float ca = ((const Collapse *)a)->cost, cb = ((const Collapse *)b)->cost;
+  return (ca > cb) - (ca < cb);
+}
+
+static void considerEdge(SimplifyState *state, uint32_t from, uint32_t to) {
+  uint32_t u = state->canonical[from];
+  if (state->flags[u] & SIMPLIFY_LOCKED)
+    return;
+  Quadric q = state->quadrics[u];
+  quadricAdd(&q, &state->quadrics[state->canonical[to]]);
+  float cost = quadricError(&q, &state->positions[to * 3]) +
+               SIMPLIFY_ATTRIBUTE_WEIGHT * attributeDistance(state->mesh, from, to);
+  if (cost < state->best_cost[u]) {
+    state->best_cost[u] = cost;
+    state->best_target[u] = to;
+  }
+}
+
+// One pass of independent collapses; returns how many were applied
+static size_t simplifyPass(SimplifyState *state, uint32_t *indices, size_t *index_count, size_t target_index_count,
+                           float error_limit, float *max_error) {
+  size_t vertex_count = state->mesh->vertex_count;
+  buildAdjacency(state, indices, *index_count);
+  for (size_t v = 0; v < vertex_count; v++) {
+    state->best_cost[v] = INFINITY;
+    state->flags[v] &= (uint8_t)~SIMPLIFY_TOUCHED;
+  }
+  for (size_t i = 0; i < *index_count; i += 3)
+    for (int k = 0; k < 3; k++) {
+      considerEdge(state, indices[i + k], indices[i + (k + 1) % 3]);
+      considerEdge(state, indices[i + k], indices[i + (k + 2) % 3]);
+    }
+
+  size_t candidate_count = 0;
+  for (size_t v = 0; v < vertex_count; v++)
+    if (state->best_cost[v] <= error_limit) {
+      // A collapsible position has a single wedge, so its canonical vertex is the one to remove
+      state->candidates[candidate_count++] = (Collapse){state->best_cost[v], (uint32_t)v};
+    }
+  qsort(state->candidates, candidate_count, sizeof(Collapse), compareCollapses);
+
+  size_t triangles = *index_count / 3, goal = target_index_count / 3, collapses = 0;
+  for (size_t c = 0; c < candidate_count && triangles > goal; c++) {
+    uint32_t from = state->candidates[c].from, to = state->best_target[from];
+    uint32_t to_canonical = state->canonical[to];
+    if ((state->flags[from] | state->flags[to_canonical]) & SIMPLIFY_TOUCHED)
+      continue;
+    if (collapseFlips(state, indices, from, to))
+      continue;
+
+    // Everything around the removed vertex changes shape, so it sits out the rest of the pass
+    for (uint32_t a = state->offsets[from]; a < state->offsets[from + 1]; a++) {
+      const uint32_t *tri = &indices[state->adjacency[a] * 3];
+      bool shared = false;
+      for (int k = 0; k < 3; k++) {
+        uint32_t n = state->canonical[tri[k]];
+        shared |= n == to_canonical;
+        state->flags[n] |= SIMPLIFY_TOUCHED;
+      }
+      triangles -= shared;
+    }
+    quadricAdd(&state->quadrics[to_canonical], &state->quadrics[from]);
+    state->collapse[from] = to;
+    *max_error = fmaxf(*max_error, state->candidates[c].cost);
+    collapses++;
+  }
+
+  for (size_t i = 0; i < *index_count; i++)
+    if (state->collapse[indices[i]] != UINT32_MAX)
+      indices[i] = state->collapse[indices[i]];
+  // The removed vertices are no longer referenced, so their collapse entries can stay
+  *index_count = removeDegenerate(state, indices, *index_count);
+  return collapses;
+}
+
+static void simplifyFree(SimplifyState *state) {
+  free(state->positions);
+  free(state->canonical);
+  free(state->wedges);
+  free(state->flags);
+  free(state->quadrics);
+  free(state->offsets);
+  free(state->adjacency);
+  free(state->best_cost);
+  free(state->best_target);
+  free(state->collapse);
+  free(state->candidates);
+  free(state->edges);
+}
+
+size_t MeshSimplify(const Mesh *mesh, const uint32_t *indices, size_t index_count, uint32_t *destination,
+                    size_t target_index_count, float target_error, float *result_error) {
+  size_t vertex_count = mesh->vertex_count, slots = vertex_count + 1;
+  SimplifyState state = {
+      .mesh = mesh,
+      .positions = malloc(slots * 3 * sizeof(float)),
+      .canonical = malloc(slots * sizeof(uint32_t)),
+      .wedges = calloc(slots, sizeof(uint32_t)),
+      .flags = calloc(slots, sizeof(uint8_t)),
+      .quadrics = calloc(slots, sizeof(Quadric)),
+      .offsets = malloc((slots + 1) * sizeof(uint32_t)),
+      .adjacency = malloc((index_count + 1) * sizeof(uint32_t)),
+      .best_cost = malloc(slots * sizeof(float)),
+      .best_target = malloc(slots * sizeof(uint32_t)),
+      .collapse = malloc(slots * sizeof(uint32_t)),
+      .candidates = malloc(slots * sizeof(Collapse)),
+  };
+  state.edge_capacity = 1;
+  while (state.edge_capacity < index_count * 2)
+    state.edge_capacity <<= 1;
+  state.edges = calloc(state.edge_capacity, sizeof(uint64_t));
+  *result_error = 0.0f;
+  memcpy(destination, indices, index_count * sizeof(uint32_t));
+  bool ok = state.positions && state.canonical && state.wedges && state.flags && state.quadrics && state.offsets &&
+            state.adjacency && state.best_cost && state.best_target && state.collapse && state.candidates &&
+            state.edges && mergePositions(&state);
+  if (!ok) {
+    simplifyFree(&state);
+    return index_count;
+  }
+
+  float extent = MeshExtent(mesh);
+  float scale = extent > 0.0f ? 1.0f / extent : 1.0f;
+  for (size_t v = 0; v < vertex_count * 3; v++)
+    state.positions[v] = mesh->positions[v] * scale;
+  memset(state.collapse, 0xff, slots * sizeof(uint32_t));
+
+  size_t count = removeDegenerate(&state, destination, index_count);
+  classify(&state, destination, count);
+  accumulateQuadrics(&state, destination, count);
+  // Errors are squared distances in the unit cube
+  float error_limit = target_error * target_error, max_error = 0.0f;
+  while (count > target_index_count) {
+    if (simplifyPass(&state, destination, &count, target_index_count, error_limit, &max_error) == 0)
+      break;
+  }
+  *result_error = sqrtf(max_error) * extent;
+  simplifyFree(&state);
+  return count;
+}
+
+// ---- Level of detail chains -------------------------------------------------------------------
+
+bool MeshBuildLods(const Mesh *mesh, size_t max_lods, MeshLodChain *chain) {
+  memset(chain, 0, sizeof(*chain));
+  if (max_lods > MESH_MAX_LODS)
+    max_lods = MESH_MAX_LODS;
+  uint32_t *scratch = malloc((mesh->index_count + 1) * sizeof(uint32_t));
+  chain->indices = malloc((mesh->index_count + 1) * sizeof(uint32_t));
+  if (!scratch || !chain->indices) {
+    free(scratch);
+    MeshLodChainFree(chain);
+    return false;
+  }
+  memcpy(chain->indices, mesh->indices, mesh->index_count * sizeof(uint32_t));
+  chain->counts[0] = mesh->index_count;
+  chain->lod_count = 1;
+
+  size_t total = mesh->index_count;
+  while (chain->lod_count < max_lods) {
+    size_t previous = chain->lod_count - 1;
+    size_t target = chain->counts[previous] / 6 * 3;
+    if (target < 3 * MESH_LOD_MIN_TRIANGLES)
+      break;
+    float error;
+    size_t count = MeshSimplify(mesh, chain->indices + chain->offsets[previous], chain->counts[previous], scratch,
+                                target, 1.0f, &error);
+    // Stop once the simplifier is only held up by locked borders and seams
+    if (count > chain->counts[previous] * 3 / 4)
+      break;
+    uint32_t *indices = realloc(chain->indices, (total + count) * sizeof(uint32_t));
+    if (!indices) {
+      free(scratch);
+      MeshLodChainFree(chain);
+      return false;
+    }
+    chain->indices = indices;
+    MeshOptimizeVertexCache(scratch, count, mesh->vertex_count);
+    memcpy(chain->indices + total, scratch, count * sizeof(uint32_t));
+    size_t level = chain->lod_count++;
+    chain->offsets[level] = total;
+    chain->counts[level] = count;
+    // Each level is simplified from the one before, so errors add up along the chain
+    chain->errors[level] = chain->errors[previous] + error;
+    total += count;
+  }
+  chain->index_count = total;
+  free(scratch);
+  return true;
+}
+
+void MeshLodChainFree(MeshLodChain *chain) {
+  free(chain->indices);
+  memset(chain, 0, sizeof(*chain));
+}
@@ -0,0 +1,304 @@
+#include "meshlet.h"
+#include "culling.h"
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static Vec3 position(const Mesh *mesh, uint32_t index) {
+  const float *p = mesh->positions + (size_t)index * 3;
+  return Vec3Make(p[0], p[1], p[2]);
+}
+
+// Bounding sphere around the AABB centre, and the cone of face normals
+static void computeBounds(const Mesh *mesh, Meshlet *meshlet, const uint32_t *indices) {
+  Vec3 lo = Vec3Make(FLT_MAX, FLT_MAX, FLT_MAX), hi = Vec3Make(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+  size_t corners = (size_t)meshlet->triangle_count * 3;
+  for (size_t i = 0; i < corners; i++) {
+    Vec3 p = position(mesh, indices[i]);
+    lo = Vec3Make(fminf(lo.x, p.x), fminf(lo.y, p.y), fminf(lo.z, p.z));
+    hi = Vec3Make(fmaxf(hi.x, p.x), fmaxf(hi.y, p.y), fmaxf(hi.z, p.z));
+  }
+  Vec3 center = Vec3Scale(Vec3Add(lo, hi), 0.5f);
+  float radius = 0.0f;
+  for (size_t i = 0; i < corners; i++)
+    radius = fmaxf(radius, Vec3Length(Vec3Sub(position(mesh, indices[i]), center)));
+
+  Vec3 normals[MESHLET_MAX_TRIANGLES];
+  size_t normal_count = 0;
+  Vec3 sum = Vec3Make(0, 0, 0);
+  for (uint32_t t = 0; t < meshlet->triangle_count; t++) {
+    Vec3 a = position(mesh, indices[t * 3]), b = position(mesh, indices[t * 3 + 1]);
+    Vec3 c = position(mesh, indices[t * 3 + 2]);
+    Vec3 n = Vec3Cross(Vec3Sub(b, a), Vec3Sub(c, a));
+    float length = Vec3Length(n);
+    if (length <= 0.0f)
+      continue;
+    normals[normal_count] = Vec3Scale(n, 1.0f / length);
+    sum = Vec3Add(sum, normals[normal_count++]);
+  }
+
+  float cutoff = 1.0f;
+  Vec3 axis = Vec3Make(0, 0, 0);
+  float sum_length = Vec3Length(sum);
+  if (normal_count > 0 && sum_length > 1e-6f) {
+    axis = Vec3Scale(sum, 1.0f / sum_length);
+    float min_dot = 1.0f;
+    for (size_t i = 0; i < normal_count; i++)
+      min_dot = fminf(min_dot, Vec3Dot(normals[i], axis));
+    // Normals spread over a hemisphere or more can always face the eye
+    cutoff = min_dot <= 0.0f ? 1.0f : sqrtf(1.0f - min_dot * min_dot);
+  }
+
+  memcpy(meshlet->center, &center, sizeof(meshlet->center));
+  meshlet->radius = radius;
+  memcpy(meshlet->cone_axis, &axis, sizeof(meshlet->cone_axis));
+  meshlet->cone_cutoff = cutoff;
+}
+
+// Distinct vertices of the triangle not yet in meshlet `id`
+static uint32_t countNew(const uint32_t *stamp, uint32_t id, const uint32_t *tri) {
+  return (stamp[tri[0]] != id) + (stamp[tri[1]] != id && tri[1] != tri[0]) +
+         (stamp[tri[2]] != id && tri[2] != tri[0] && tri[2] != tri[1]);
+}
+
+static bool pushMeshlet(const Mesh *mesh, MeshletSet *set, size_t *capacity, Meshlet *meshlet) {
+  if (set->count == *capacity) {
+    Meshlet *meshlets = realloc(set->meshlets, *capacity * 2 * sizeof(Meshlet));
+    if (!meshlets) {
+      MeshletSetFree(set);
+      return false;
+    }
+    set->meshlets = meshlets;
+    *capacity *= 2;
+  }
+  computeBounds(mesh, meshlet, set->indices + meshlet->index_offset);
+  set->meshlets[set->count++] = *meshlet;
+  return true;
+}
+
+bool MeshletBuild(const Mesh *mesh, const uint32_t *indices, size_t index_count, MeshletSet *set) {
+  memset(set, 0, sizeof(*set));
+  size_t triangle_count = index_count / 3;
+  size_t capacity = triangle_count / MESHLET_MAX_TRIANGLES + 16;
+  uint32_t *stamp = calloc(mesh->vertex_count ? mesh->vertex_count : 1, sizeof(uint32_t));
+  set->indices = malloc((triangle_count ? triangle_count * 3 : 1) * sizeof(uint32_t));
+  set->meshlets = malloc(capacity * sizeof(Meshlet));
+  if (!stamp || !set->indices || !set->meshlets) {
+    free(stamp);
+    MeshletSetFree(set);
+    return false;
+  }
+  set->index_count = triangle_count * 3;
+  memcpy(set->indices, indices, set->index_count * sizeof(uint32_t));
+
+  // Greedy in the given order: the vertex cache order already keeps neighbouring triangles together
+  Meshlet current = {0};
+  uint32_t id = 1;
+  for (size_t t = 0; t < triangle_count; t++) {
+    const uint32_t *tri = set->indices + t * 3;
+    uint32_t fresh = countNew(stamp, id, tri);
+    if (current.vertex_count + fresh > MESHLET_MAX_VERTICES || current.triangle_count == MESHLET_MAX_TRIANGLES) {
+      if (!pushMeshlet(mesh, set, &capacity, &current)) {
+        free(stamp);
+        return false;
+      }
+      memset(&current, 0, sizeof(current));
+      current.index_offset = (uint32_t)(t * 3);
+      id++;
+      fresh = countNew(stamp, id, tri);
+    }
+    stamp[tri[0]] = stamp[tri[1]] = stamp[tri[2]] = id;
+    current.vertex_count += fresh;
+    current.triangle_count++;
+  }
+  bool ok = current.triangle_count == 0 || pushMeshlet(mesh, set, &capacity, &current);
+  free(stamp);
+  return ok;
+}
+
+void MeshletSetFree(MeshletSet *set) {
+  free(set->meshlets);
+  free(set->indices);
+  memset(set, 0, sizeof(*set));
+}
+
+void MeshletCullerInit(MeshletCuller *culler) {
+  memset(culler, 0, sizeof(*culler));
+  Mat4 identity = Mat4Identity();
+  MeshletCullerSetCamera(culler, &identity, &identity);
+}
+
+void MeshletCullerDestroy(MeshletCuller *culler) {
+  free(culler->instances);
+  free(culler->scratch);
+  free(culler->chunk_counts);
+  memset(culler, 0, sizeof(*culler));
+}
+
+void MeshletCullerSetCamera(MeshletCuller *culler, const Mat4 *view, const Mat4 *projection) {
+  Mat4 vp = Mat4Mul(projection, view);
+  CullExtractPlanes(&vp, culler->planes);
+  Mat4 camera = Mat4InverseAffine(view);
+  culler->eye = Vec4XYZ(camera.cols[3]);
+}
+
+static bool reserve(void **data, size_t *capacity, size_t count, size_t size) {
+  if (count <= *capacity)
+    return true;
+  void *grown = realloc(*data, count * size);
+  if (!grown)
+    return false;
+  *data = grown;
+  *capacity = count;
+  return true;
+}
+
+static MeshletInstance prepareInstance(const Mat4 *world) {
+  MeshletInstance instance = {*world, 0.0f, false};
+  Vec3 axes[3];
+  float lo = FLT_MAX, hi = 0.0f;
+  for (int c = 0; c < 3; c++) {
+    axes[c] = Vec4XYZ(world->cols[c]);
+    float length = Vec3Dot(axes[c], axes[c]);
+    lo = fminf(lo, length);
+    hi = fmaxf(hi, length);
+  }
+  instance.scale = sqrtf(hi);
+  // Cones only hold under rotation and uniform scale; mirroring also flips the winding
+  float tolerance = 1e-3f * hi;
+  instance.similar = hi > 0.0f && hi - lo <= tolerance && fabsf(Vec3Dot(axes[0], axes[1])) <= tolerance &&
+                     fabsf(Vec3Dot(axes[1], axes[2])) <= tolerance && fabsf(Vec3Dot(axes[0], axes[2])) <= tolerance &&
+                     Vec3Dot(Vec3Cross(axes[0], axes[1]), axes[2]) > 0.0f;
+  return instance;
+}
+
+// The whole sphere sits behind the plane of every triangle in the cluster
+static bool facesAway(Vec3 eye, const Mat4 *world, const Meshlet *meshlet, Vec3 center, float radius, float scale) {
+  if (meshlet->cone_cutoff >= 1.0f)
+    return false;
+  Vec3 axis = Mat4TransformDirection(world, Vec3Make(meshlet->cone_axis[0], meshlet->cone_axis[1],
+                                                     meshlet->cone_axis[2])); // length `scale`
+  Vec3 to_center = Vec3Sub(center, eye);
+  return Vec3Dot(to_center, axis) >= (meshlet->cone_cutoff * Vec3Length(to_center) + radius) * scale;
+}
+
+typedef struct CullJob {
+  MeshletCuller *culler;
+  const MeshletSet *set;
+  size_t grain;
+} CullJob;
+
+static void cullRange(void *data, size_t begin, size_t end) {
+  const CullJob *job = data;
+  MeshletCuller *culler = job->culler;
+  const MeshletSet *set = job->set;
+  MeshletDrawCommand *out = culler->scratch + begin;
+  size_t n = 0, frustum = 0, backface = 0;
+  size_t instance_index = begin / set->count, meshlet_index = begin % set->count;
+  for (size_t i = begin; i < end; i++) {
+    const MeshletInstance *instance = &culler->instances[instance_index];
+    const Meshlet *meshlet = &set->meshlets[meshlet_index];
+    Vec3 center = Mat4TransformPoint(&instance->world, Vec3Make(meshlet->center[0], meshlet->center[1],
+                                                                meshlet->center[2]));
+    float radius = meshlet->radius * instance->scale;
+
+    bool inside = true;
+    for (int p = 0; p < 6; p++) {
+      const Vec4 *plane = &culler->planes[p];
+      inside &= center.x * plane->x + center.y * plane->y + center.z * plane->z + plane->w >= -radius;
+    }
+    if (!inside) {
+      frustum++;
+    } else if (instance->similar && facesAway(culler->eye, &instance->world, meshlet, center, radius,
+                                              instance->scale)) {
+      backface++;
+    } else {
+      out[n++] = (MeshletDrawCommand){meshlet->triangle_count * 3, 1, meshlet->index_offset, 0,
+                                      (uint32_t)instance_index};
+    }
+    if (++meshlet_index == set->count) {
+      meshlet_index = 0;
+      instance_index++;
+    }
+  }
+  culler->chunk_counts[begin / job->grain] = (uint32_t)n;
+  atomic_fetch_add_explicit(&culler->frustum_culled, frustum, memory_order_relaxed);
+  atomic_fetch_add_explicit(&culler->backface_culled, backface, memory_order_relaxed);
+}
+
+size_t MeshletCull(MeshletCuller *culler, JobSystem *jobs, const MeshletSet *set, const Mat4 *worlds,
+                   size_t instance_count) {
+  culler->commands = culler->scratch;
+  culler->command_count = 0;
+  memset(&culler->last, 0, sizeof(culler->last));
+  size_t total = set->count * instance_count;
+  if (total == 0)
+    return 0;
+  size_t grain = MESHLET_CULL_GRAIN;
+  size_t chunks = (total + grain - 1) / grain;
+  if (!reserve((void **)&culler->instances, &culler->instance_capacity, instance_count, sizeof(MeshletInstance)) ||
+      !reserve((void **)&culler->scratch, &culler->scratch_capacity, total, sizeof(MeshletDrawCommand)) ||
+      !reserve((void **)&culler->chunk_counts, &culler->chunk_capacity, chunks, sizeof(uint32_t)))
+    return 0;
+  culler->commands = culler->scratch;
+
+  for (size_t i = 0; i < instance_count; i++)
+    culler->instances[i] = prepareInstance(&worlds[i]);
+  atomic_store_explicit(&culler->frustum_culled, 0, memory_order_relaxed);
+  atomic_store_explicit(&culler->backface_culled, 0, memory_order_relaxed);
+
+  CullJob job = {culler, set, grain};
+  JobCounter counter = {0};
+  JobsParallelFor(jobs, total, grain, cullRange, &job, &counter);
+  JobsWait(jobs, &counter);
+
+  // Compact the per-chunk survivors in place, merging ranges that continue each other
+  size_t n = 0;
+  for (size_t c = 0; c < chunks; c++) {
+    const MeshletDrawCommand *chunk = culler->scratch + c * grain;
+    for (uint32_t i = 0; i < culler->chunk_counts[c]; i++) {
+      MeshletDrawCommand *last = n ? &culler->commands[n - 1] : NULL;
+      if (last && last->base_instance == chunk[i].base_instance &&
+          last->first_index + last->count == chunk[i].first_index) {
+        last->count += chunk[i].count;
+      } else {
+        culler->commands[n++] = chunk[i];
+      }
+      culler->last.visible++;
+    }
+  }
+  culler->command_count = n;
+  culler->last.tested = total;
+  culler->last.frustum_culled = atomic_load_explicit(&culler->frustum_culled, memory_order_relaxed);
+  culler->last.backface_culled = atomic_load_explicit(&culler->backface_culled, memory_order_relaxed);
+  return n;
+}
+
+void MeshletRecordDraws(const MeshletCuller *culler, const Mat4 *worlds, GLint model_location,
+                        RenderCommandList *list) {
+  uint32_t instance = UINT32_MAX;
+  for (size_t i = 0; i < culler->command_count; i++) {
+    const MeshletDrawCommand *command = &culler->commands[i];
+    if (command->base_instance != instance) {
+      instance = command->base_instance;
+      RenderCmdUniformMatrix4fv(list, model_location, worlds[instance].m);
+    }
+    RenderCmdDrawElements(list, GL_TRIANGLES, (GLsizei)command->count, GL_UNSIGNED_INT,
+                          (size_t)command->first_index * sizeof(uint32_t));
+  }
+}
+
+void MeshletPrintStats(const MeshletSet *set) {
+  size_t vertices = 0, triangles = 0, coned = 0;
+  for (size_t i = 0; i < set->count; i++) {
+    vertices += set->meshlets[i].vertex_count;
+    triangles += set->meshlets[i].triangle_count;
+    coned += set->meshlets[i].cone_cutoff < 1.0f;
+  }
+  double count = set->count ? (double)set->count : 1.0;
+  printf("Meshlets: %zu, %.1f vertices / %.1f triangles on average (limits %d / %d), %.0f%% back-face cullable\n",
+         set->count, (double)vertices / count, (double)triangles / count, MESHLET_MAX_VERTICES,
+         MESHLET_MAX_TRIANGLES, 100.0 * (double)coned / count);
+}
@@ -0,0 +1,103 @@
+#include "pacing.h"
+#include <GLFW/glfw3.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+FramePacerConfig FramePacerConfigFromEnv(void) {
+  FramePacerConfig config = {1, 0.0, 0.002};
+  const char *interval = getenv("FRAME_SWAP_INTERVAL");
+  if (interval)
+    config.swap_interval = atoi(interval);
+  const char *fps = getenv("FRAME_TARGET_FPS");
+  if (fps)
+    config.target_fps = atof(fps);
+  return config;
+}
+
+int FramePacerInit(FramePacer *pacer, FramePacerConfig config) {
+  memset(pacer, 0, sizeof(*pacer));
+  pacer->config = config;
+  pacer->pending_input = -1.0;
+  pacer->next_deadline = glfwGetTime();
+  return FramePacerSetSwapInterval(pacer, config.swap_interval);
+}
+
+int FramePacerSetSwapInterval(FramePacer *pacer, int interval) {
+  if (interval < 0 && !glfwExtensionSupported("GLX_EXT_swap_control_tear") &&
+      !glfwExtensionSupported("WGL_EXT_swap_control_tear")) {
+    printf("Adaptive vsync not supported, falling back to vsync\n");
+    interval = 1;
+  }
+  glfwSwapInterval(interval);
+  pacer->applied_swap_interval = interval;
+  return interval;
+}
+
+void FramePacerMarkInput(FramePacer *pacer) {
+  if (pacer->pending_input < 0.0)
+    pacer->pending_input = glfwGetTime();
+}
+
+double FramePacerBeginFrame(FramePacer *pacer) {
+  double input_time = pacer->pending_input;
+  pacer->pending_input = -1.0;
+  return input_time;
+}
+
+// Resumes after signals only; any other failure gives up on the sleep, the spin after it still waits
+static void sleepFor(double seconds) {
+  if (!(seconds > 0.0))
+    return;
+  struct timespec duration;
+  duration.tv_sec = (time_t)seconds;
+  duration.tv_nsec = (long)((seconds - (double)duration.tv_sec) * 1e9);
+  if (duration.tv_nsec > 999999999L)
+    duration.tv_nsec = 999999999L;
+  while (nanosleep(&duration, &duration) != 0 && errno == EINTR) {
+  }
+}
+
+void FramePacerLimit(FramePacer *pacer) {
+  if (pacer->config.target_fps <= 0.0)
+    return;
+
+  double period = 1.0 / pacer->config.target_fps;
+  double now = glfwGetTime();
+  pacer->next_deadline += period;
+  if (pacer->next_deadline < now) {
+    // Missed the slot; restart the schedule rather than bursting to catch up
+    pacer->next_deadline = now;
+    return;
+  }
+
+  // The OS sleep is only accurate to a scheduler tick, so stop early and spin the rest
+  double sleep = pacer->next_deadline - now - pacer->config.spin_threshold;
+  if (sleep > 0.0)
+    sleepFor(sleep);
+  while (glfwGetTime() < pacer->next_deadline) {
+  }
+}
+
+void FramePacerPresented(FramePacer *pacer, double input_time) {
+  pacer->frames++;
+  if (input_time < 0.0)
+    return;
+
+  double latency = glfwGetTime() - input_time;
+  pacer->latency_samples++;
+  pacer->latency_total += latency;
+  if (latency > pacer->latency_max)
+    pacer->latency_max = latency;
+}
+
+void FramePacerPrintStats(const FramePacer *pacer) {
+  printf("Frame pacing: swap interval %d, target %.1f fps, %zu frames\n", pacer->applied_swap_interval,
+         pacer->config.target_fps, pacer->frames);
+  if (pacer->latency_samples > 0)
+    printf("Input to present latency: avg %.2f ms, max %.2f ms over %zu inputs\n",
+           1000.0 * pacer->latency_total / (double)pacer->latency_samples, 1000.0 * pacer->latency_max,
+           pacer->latency_samples);
+}
@@ -0,0 +1,142 @@
+#include "pack.h"
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef HAVE_LZ4
+#include <lz4.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+uint64_t PackHashPath(const char *path) {
+  // FNV-1a, 64 bit
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (const unsigned char *c = (const unsigned char *)path; *c; c++) {
+    hash ^= *c;
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+int PackCodecAvailable(PackCodec codec) {
+  switch (codec) {
+  case PACK_CODEC_NONE:
+    return 1;
+#ifdef HAVE_LZ4
+  case PACK_CODEC_LZ4:
+    return 1;
+#endif
+#ifdef HAVE_ZSTD
+  case PACK_CODEC_ZSTD:
+    return 1;
+#endif
+  default:
+    return 0;
+  }
+}
+
+PackResult PackOpen(const char *path, Pack *pack) {
+  memset(pack, 0, sizeof(*pack));
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return PACK_FAILED_OPEN;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(PackHeader)) {
+    close(fd);
+    return PACK_FAILED_FORMAT;
+  }
+  void *base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd); // the mapping keeps the file referenced
+  if (base == MAP_FAILED)
+    return PACK_FAILED_OPEN;
+
+  // Offsets and sizes come from the file: each is checked against the room left after the offset,
+  // so no sum of them can wrap
+  const PackHeader *header = base;
+  size_t size = (size_t)st.st_size;
+  if (header->magic != PACK_MAGIC || header->version != PACK_VERSION || header->file_size != size ||
+      header->toc_offset % sizeof(uint64_t) != 0 || header->toc_offset > size ||
+      header->entry_count > (size - header->toc_offset) / sizeof(PackTocEntry) || header->names_offset > size ||
+      header->names_size > size - header->names_offset) {
+    munmap(base, size);
+    return PACK_FAILED_FORMAT;
+  }
+
+  pack->base = base;
+  pack->size = size;
+  pack->header = header;
+  pack->toc = (const PackTocEntry *)(pack->base + header->toc_offset);
+  pack->names = (const char *)(pack->base + header->names_offset);
+  return PACK_SUCCESS;
+}
+
+void PackClose(Pack *pack) {
+  if (pack->base)
+    munmap((void *)pack->base, pack->size);
+  memset(pack, 0, sizeof(*pack));
+}
+
+PackResult PackFind(const Pack *pack, const char *path, PackEntry *entry) {
+  if (!pack->base)
+    return PACK_FAILED_NOT_FOUND;
+
+  uint64_t hash = PackHashPath(path);
+  uint64_t names_size = pack->header->names_size;
+  uint32_t lo = 0, hi = pack->header->entry_count;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (pack->toc[mid].hash < hash)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  // Walk every entry sharing the hash and confirm with the stored path
+  for (uint32_t i = lo; i < pack->header->entry_count && pack->toc[i].hash == hash; i++) {
+    const PackTocEntry *toc = &pack->toc[i];
+    // The name has to end inside the table before it can be compared
+    size_t names_left = toc->name_offset < names_size ? (size_t)(names_size - toc->name_offset) : 0;
+    if (!names_left || !memchr(pack->names + toc->name_offset, '\0', names_left) ||
+        strcmp(pack->names + toc->name_offset, path) != 0)
+      continue;
+    if (toc->offset > pack->size || toc->stored_size > pack->size - toc->offset ||
+        (toc->codec == PACK_CODEC_NONE && toc->size != toc->stored_size))
+      return PACK_FAILED_FORMAT;
+    entry->data = pack->base + toc->offset;
+    entry->size = toc->size;
+    entry->stored_size = toc->stored_size;
+    entry->codec = (PackCodec)toc->codec;
+    return PACK_SUCCESS;
+  }
+  return PACK_FAILED_NOT_FOUND;
+}
+
+PackResult PackDecompress(const PackEntry *entry, void *dst, size_t dst_size) {
+  if (dst_size < entry->size)
+    return PACK_FAILED_CODEC;
+
+  switch (entry->codec) {
+  case PACK_CODEC_NONE:
+    memcpy(dst, entry->data, entry->size);
+    return PACK_SUCCESS;
+#ifdef HAVE_LZ4
+  case PACK_CODEC_LZ4: {
+    int n = LZ4_decompress_safe(entry->data, dst, (int)entry->stored_size, (int)dst_size);
+    return n == (int)entry->size ? PACK_SUCCESS : PACK_FAILED_CODEC;
+  }
+#endif
+#ifdef HAVE_ZSTD
+  case PACK_CODEC_ZSTD: {
+    size_t n = ZSTD_decompress(dst, dst_size, entry->data, entry->stored_size);
+    return (!ZSTD_isError(n) && n == entry->size) ? PACK_SUCCESS : PACK_FAILED_CODEC;
+  }
+#endif
+  default:
+    return PACK_FAILED_CODEC;
+  }
+}
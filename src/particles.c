@@ -0,0 +1,523 @@
+#include "particles.h"
+#include "render_commands.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ZERO_CHUNK 4096 // particles cleared per upload when the buffers are created
+
+// The CPU backend's arrays, in one block per state
+static bool allocateSoA(ParticleSoA *soa, size_t capacity) {
+  float *block = malloc(8 * capacity * sizeof(float));
+  if (!block)
+    return false;
+  float **arrays[8] = {&soa->x, &soa->y, &soa->z, &soa->vx, &soa->vy, &soa->vz, &soa->life, &soa->lifetime};
+  for (size_t i = 0; i < 8; i++)
+    *arrays[i] = block + i * capacity;
+  return true;
+}
+
+static bool allocateCpu(ParticleSystem *system) {
+  size_t chunks = (system->capacity + PARTICLE_CPU_GRAIN - 1) / PARTICLE_CPU_GRAIN;
+  system->chunk_live = malloc((chunks + 1) * sizeof(size_t));
+  if (!system->chunk_live || !allocateSoA(&system->state[0], system->capacity) ||
+      !allocateSoA(&system->state[1], system->capacity))
+    return false;
+  for (size_t i = 0; i < PARTICLE_EMIT_FRAMES; i++) {
+    system->sprites[i] = malloc(system->capacity * sizeof(ParticleSprite));
+    if (!system->sprites[i])
+      return false;
+  }
+  return true;
+}
+
+// Instance counts are GLsizei and buffer sizes GLsizeiptr, and a Particle is as large as one
+// in SoA form. The CPU backend's chunk count needs no limit: the job system runs chunks that
+// do not fit the queue on the submitting worker.
+static bool fitsCapacity(size_t capacity) {
+  return capacity > 0 && capacity <= INT32_MAX && capacity <= PTRDIFF_MAX / sizeof(Particle);
+}
+
+bool ParticleSystemInit(ParticleSystem *system, ParticleBackend backend, size_t capacity, JobSystem *jobs,
+                        GLuint update_program, GLuint draw_program) {
+  memset(system, 0, sizeof(*system));
+  if (!fitsCapacity(capacity) || (backend == PARTICLE_BACKEND_CPU && !jobs))
+    return false;
+  system->backend = backend;
+  system->capacity = capacity;
+  system->jobs = jobs;
+  system->emitter = (ParticleEmitter){Vec3Make(0.0f, 0.0f, 0.0f), Vec3Make(0.0f, 1.0f, 0.0f), 0.25f, 0.0f, 1.0f};
+  system->gravity = Vec3Make(0.0f, -1.0f, 0.0f);
+  system->size = 0.01f;
+  memcpy(system->color, (float[4]){1.0f, 0.6f, 0.2f, 0.5f}, sizeof(system->color));
+  system->random = 0x9e3779b9u;
+  system->update_program = update_program;
+  system->draw_program = draw_program;
+  size_t batch_size = capacity < PARTICLE_MAX_EMIT ? capacity : PARTICLE_MAX_EMIT;
+  for (size_t i = 0; i < PARTICLE_EMIT_FRAMES; i++) {
+    system->batches[i] = malloc(batch_size * sizeof(Particle));
+    if (!system->batches[i]) {
+      ParticleSystemDestroy(system);
+      return false;
+    }
+  }
+  if (backend == PARTICLE_BACKEND_CPU && !allocateCpu(system)) {
+    ParticleSystemDestroy(system);
+    return false;
+  }
+  return true;
+}
+
+void ParticleSystemDestroy(ParticleSystem *system) {
+  for (size_t i = 0; i < PARTICLE_EMIT_FRAMES; i++) {
+    free(system->batches[i]);
+    free(system->sprites[i]);
+    system->batches[i] = NULL;
+    system->sprites[i] = NULL;
+  }
+  for (size_t i = 0; i < 2; i++) {
+    free(system->state[i].x);
+    memset(&system->state[i], 0, sizeof(system->state[i]));
+  }
+  free(system->chunk_live);
+  system->chunk_live = NULL;
+  if (system->buffers[0]) {
+    glDeleteVertexArrays(2, system->update_arrays);
+    glDeleteVertexArrays(2, system->draw_arrays);
+    glDeleteBuffers(2, system->buffers);
+    system->buffers[0] = system->buffers[1] = 0;
+  }
+}
+
+// xorshift32, in [-1, 1)
+static float randomSigned(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return (float)(x >> 8) * (2.0f / 16777216.0f) - 1.0f;
+}
+
+static void emit(ParticleSystem *system, Particle *particle) {
+  const ParticleEmitter *emitter = &system->emitter;
+  float x, y, z;
+  do {
+    x = randomSigned(&system->random);
+    y = randomSigned(&system->random);
+    z = randomSigned(&system->random);
+  } while (x * x + y * y + z * z > 1.0f);
+  float lifetime = emitter->lifetime * (1.0f + 0.25f * randomSigned(&system->random));
+  *particle = (Particle){{emitter->position.x, emitter->position.y, emitter->position.z},
+                         lifetime,
+                         {emitter->velocity.x + x * emitter->spread, emitter->velocity.y + y * emitter->spread,
+                          emitter->velocity.z + z * emitter->spread},
+                         lifetime};
+}
+
+// v = (v + g dt) (1 - drag dt), p += v dt, life -= dt, like shaders/particle_update.vertex.glsl
+static void integrate(const ParticleSystem *system, const ParticleSoA *s, size_t begin, size_t end) {
+  float dt = system->dt, damping = 1.0f - system->drag * dt;
+  damping = damping > 0.0f ? damping : 0.0f;
+  float gx = system->gravity.x * dt, gy = system->gravity.y * dt, gz = system->gravity.z * dt;
+  size_t i = begin;
+#if defined(VECMATH_AVX)
+  {
+    __m256 vdt = _mm256_set1_ps(dt), vdamping = _mm256_set1_ps(damping), zero = _mm256_setzero_ps();
+    __m256 vgx = _mm256_set1_ps(gx), vgy = _mm256_set1_ps(gy), vgz = _mm256_set1_ps(gz);
+    for (; i + 8 <= end; i += 8) {
+      __m256 vx = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(s->vx + i), vgx), vdamping);
+      __m256 vy = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(s->vy + i), vgy), vdamping);
+      __m256 vz = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(s->vz + i), vgz), vdamping);
+      _mm256_storeu_ps(s->vx + i, vx);
+      _mm256_storeu_ps(s->vy + i, vy);
+      _mm256_storeu_ps(s->vz + i, vz);
+      _mm256_storeu_ps(s->x + i, _mm256_add_ps(_mm256_loadu_ps(s->x + i), _mm256_mul_ps(vx, vdt)));
+      _mm256_storeu_ps(s->y + i, _mm256_add_ps(_mm256_loadu_ps(s->y + i), _mm256_mul_ps(vy, vdt)));
+      _mm256_storeu_ps(s->z + i, _mm256_add_ps(_mm256_loadu_ps(s->z + i), _mm256_mul_ps(vz, vdt)));
+      _mm256_storeu_ps(s->life + i, _mm256_max_ps(_mm256_sub_ps(_mm256_loadu_ps(s->life + i), vdt), zero));
+    }
+  }
+#endif
+#if defined(VECMATH_SSE)
+  {
+    __m128 vdt = _mm_set1_ps(dt), vdamping = _mm_set1_ps(damping), zero = _mm_setzero_ps();
+    __m128 vgx = _mm_set1_ps(gx), vgy = _mm_set1_ps(gy), vgz = _mm_set1_ps(gz);
+    for (; i + 4 <= end; i += 4) {
+      __m128 vx = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(s->vx + i), vgx), vdamping);
+      __m128 vy = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(s->vy + i), vgy), vdamping);
+      __m128 vz = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(s->vz + i), vgz), vdamping);
+      _mm_storeu_ps(s->vx + i, vx);
+      _mm_storeu_ps(s->vy + i, vy);
+      _mm_storeu_ps(s->vz + i, vz);
+      _mm_storeu_ps(s->x + i, _mm_add_ps(_mm_loadu_ps(s->x + i), _mm_mul_ps(vx, vdt)));
+      _mm_storeu_ps(s->y + i, _mm_add_ps(_mm_loadu_ps(s->y + i), _mm_mul_ps(vy, vdt)));
+      _mm_storeu_ps(s->z + i, _mm_add_ps(_mm_loadu_ps(s->z + i), _mm_mul_ps(vz, vdt)));
+      _mm_storeu_ps(s->life + i, _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(s->life + i), vdt), zero));
+    }
+  }
+#elif defined(VECMATH_NEON)
+  {
+    float32x4_t vdt = vdupq_n_f32(dt), zero = vdupq_n_f32(0.0f);
+    for (; i + 4 <= end; i += 4) {
+      float32x4_t vx = vmulq_n_f32(vaddq_f32(vld1q_f32(s->vx + i), vdupq_n_f32(gx)), damping);
+      float32x4_t vy = vmulq_n_f32(vaddq_f32(vld1q_f32(s->vy + i), vdupq_n_f32(gy)), damping);
+      float32x4_t vz = vmulq_n_f32(vaddq_f32(vld1q_f32(s->vz + i), vdupq_n_f32(gz)), damping);
+      vst1q_f32(s->vx + i, vx);
+      vst1q_f32(s->vy + i, vy);
+      vst1q_f32(s->vz + i, vz);
+      vst1q_f32(s->x + i, vmlaq_f32(vld1q_f32(s->x + i), vx, vdt));
+      vst1q_f32(s->y + i, vmlaq_f32(vld1q_f32(s->y + i), vy, vdt));
+      vst1q_f32(s->z + i, vmlaq_f32(vld1q_f32(s->z + i), vz, vdt));
+      vst1q_f32(s->life + i, vmaxq_f32(vsubq_f32(vld1q_f32(s->life + i), vdt), zero));
+    }
+  }
+#endif
+  for (; i < end; i++) {
+    s->vx[i] = (s->vx[i] + gx) * damping;
+    s->vy[i] = (s->vy[i] + gy) * damping;
+    s->vz[i] = (s->vz[i] + gz) * damping;
+    s->x[i] += s->vx[i] * dt;
+    s->y[i] += s->vy[i] * dt;
+    s->z[i] += s->vz[i] * dt;
+    float life = s->life[i] - dt;
+    s->life[i] = life > 0.0f ? life : 0.0f;
+  }
+}
+
+// Moves the survivors of [begin, end) to its front, in order. Every particle is copied and the
+// write position only advances past live ones, so there is no branch to mispredict; writes stay
+// at or behind the read position, inside the range.
+static size_t compact(const ParticleSoA *s, size_t begin, size_t end) {
+  size_t out = begin;
+  for (size_t i = begin; i < end; i++) {
+    bool alive = s->life[i] > 0.0f;
+    s->x[out] = s->x[i];
+    s->y[out] = s->y[i];
+    s->z[out] = s->z[i];
+    s->vx[out] = s->vx[i];
+    s->vy[out] = s->vy[i];
+    s->vz[out] = s->vz[i];
+    s->life[out] = s->life[i];
+    s->lifetime[out] = s->lifetime[i];
+    out += alive;
+  }
+  return out - begin;
+}
+
+static void simulateJob(void *data, size_t begin, size_t end) {
+  ParticleSystem *system = data;
+  const ParticleSoA *s = &system->state[system->current_state];
+  integrate(system, s, begin, end);
+  system->chunk_live[begin / PARTICLE_CPU_GRAIN] = compact(s, begin, end);
+}
+
+// Four sprites at a time: position and fade as four registers, transposed into rows
+static void writeSprites(const ParticleSoA *s, size_t begin, size_t count, ParticleSprite *sprites) {
+  size_t i = 0;
+#if defined(VECMATH_SSE)
+  const __m128 min_lifetime = _mm_set1_ps(1e-6f);
+  for (; i + 4 <= count; i += 4) {
+    size_t p = begin + i;
+    __m128 x = _mm_loadu_ps(s->x + p), y = _mm_loadu_ps(s->y + p), z = _mm_loadu_ps(s->z + p);
+    __m128 fade = _mm_div_ps(_mm_loadu_ps(s->life + p), _mm_max_ps(_mm_loadu_ps(s->lifetime + p), min_lifetime));
+    _MM_TRANSPOSE4_PS(x, y, z, fade);
+    _mm_storeu_ps(sprites[i].position, x);
+    _mm_storeu_ps(sprites[i + 1].position, y);
+    _mm_storeu_ps(sprites[i + 2].position, z);
+    _mm_storeu_ps(sprites[i + 3].position, fade);
+  }
+#elif defined(VECMATH_NEON)
+  const float32x4_t min_lifetime = vdupq_n_f32(1e-6f);
+  for (; i + 4 <= count; i += 4) {
+    size_t p = begin + i;
+    float32x4_t lifetime = vmaxq_f32(vld1q_f32(s->lifetime + p), min_lifetime);
+    float32x4_t reciprocal = vrecpeq_f32(lifetime);
+    reciprocal = vmulq_f32(reciprocal, vrecpsq_f32(lifetime, reciprocal));
+    reciprocal = vmulq_f32(reciprocal, vrecpsq_f32(lifetime, reciprocal));
+    float32x4x4_t rows = {{vld1q_f32(s->x + p), vld1q_f32(s->y + p), vld1q_f32(s->z + p),
+                           vmulq_f32(vld1q_f32(s->life + p), reciprocal)}};
+    vst4q_f32(sprites[i].position, rows);
+  }
+#endif
+  for (; i < count; i++) {
+    size_t p = begin + i;
+    float lifetime = s->lifetime[p] > 1e-6f ? s->lifetime[p] : 1e-6f;
+    sprites[i] = (ParticleSprite){{s->x[p], s->y[p], s->z[p]}, s->life[p] / lifetime};
+  }
+}
+
+// Packs each chunk's survivors into the other state, closing the gaps between chunks, and
+// writes them as sprites for the upload
+typedef struct GatherJob {
+  ParticleSystem *system;
+  ParticleSprite *sprites;
+} GatherJob;
+
+static void gatherJob(void *data, size_t begin, size_t end) {
+  GatherJob *job = data;
+  ParticleSystem *system = job->system;
+  const ParticleSoA *from = &system->state[system->current_state];
+  const ParticleSoA *to = &system->state[system->current_state ^ 1];
+  size_t chunk = begin / PARTICLE_CPU_GRAIN;
+  size_t offset = system->chunk_live[chunk], count = system->chunk_live[chunk + 1] - offset;
+  const float *source[8] = {from->x, from->y, from->z, from->vx, from->vy, from->vz, from->life, from->lifetime};
+  float *target[8] = {to->x, to->y, to->z, to->vx, to->vy, to->vz, to->life, to->lifetime};
+  for (size_t a = 0; a < 8; a++)
+    memcpy(target[a] + offset, source[a] + begin, count * sizeof(float));
+  writeSprites(to, offset, count, job->sprites + offset);
+}
+
+// Appends what was emitted, then integrates, compacts and gathers on the job system. Returns
+// the sprites of the survivors, `live` of them.
+static ParticleSprite *simulateCpu(ParticleSystem *system, const Particle *emitted, size_t count, float dt) {
+  const ParticleSoA *s = &system->state[system->current_state];
+  size_t room = system->capacity - system->live;
+  if (count > room) {
+    system->dropped += count - room;
+    count = room;
+  }
+  for (size_t i = 0, p = system->live; i < count; i++, p++) {
+    const Particle *particle = &emitted[i];
+    s->x[p] = particle->position[0];
+    s->y[p] = particle->position[1];
+    s->z[p] = particle->position[2];
+    s->vx[p] = particle->velocity[0];
+    s->vy[p] = particle->velocity[1];
+    s->vz[p] = particle->velocity[2];
+    s->life[p] = particle->life;
+    s->lifetime[p] = particle->lifetime;
+  }
+  system->emitted += count;
+  size_t total = system->live + count;
+  system->dt = dt > 0.0f ? dt : 0.0f;
+
+  JobCounter done = {0};
+  JobsParallelFor(system->jobs, total, PARTICLE_CPU_GRAIN, simulateJob, system, &done);
+  JobsWait(system->jobs, &done);
+  size_t chunks = (total + PARTICLE_CPU_GRAIN - 1) / PARTICLE_CPU_GRAIN, live = 0;
+  for (size_t c = 0; c < chunks; c++) {
+    size_t survivors = system->chunk_live[c];
+    system->chunk_live[c] = live;
+    live += survivors;
+  }
+  system->chunk_live[chunks] = live;
+
+  GatherJob gather = {system, system->sprites[(system->frames - 1) % PARTICLE_EMIT_FRAMES]};
+  JobsParallelFor(system->jobs, total, PARTICLE_CPU_GRAIN, gatherJob, &gather, &done);
+  JobsWait(system->jobs, &done);
+  system->current_state ^= 1;
+  system->live = live;
+  return gather.sprites;
+}
+
+// Both state buffers start out as dead particles
+static void clearBuffer(GLuint buffer, size_t capacity) {
+  static const Particle zero[ZERO_CHUNK];
+  glBindBuffer(GL_ARRAY_BUFFER, buffer);
+  glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(capacity * sizeof(Particle)), NULL, GL_DYNAMIC_COPY);
+  for (size_t i = 0; i < capacity; i += ZERO_CHUNK) {
+    size_t count = capacity - i < ZERO_CHUNK ? capacity - i : ZERO_CHUNK;
+    glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)(i * sizeof(Particle)), (GLsizeiptr)(count * sizeof(Particle)), zero);
+  }
+}
+
+static void particleAttributes(GLuint divisor) {
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Particle), (const void *)offsetof(Particle, position));
+  glVertexAttribDivisor(0, divisor);
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Particle), (const void *)offsetof(Particle, velocity));
+  glVertexAttribDivisor(1, divisor);
+}
+
+// One stream buffer, orphaned on every upload, drawn one sprite per instance. The sprite's
+// fade takes the place of life left, so the lifetime attribute is a constant 1.
+static void createStream(ParticleSystem *system) {
+  glGenBuffers(1, system->buffers);
+  glGenVertexArrays(1, system->draw_arrays);
+  glBindVertexArray(system->draw_arrays[0]);
+  glBindBuffer(GL_ARRAY_BUFFER, system->buffers[0]);
+  glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(system->capacity * sizeof(ParticleSprite)), NULL, GL_STREAM_DRAW);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleSprite), NULL);
+  glVertexAttribDivisor(0, 1);
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+static void createObjects(ParticleSystem *system) {
+  system->size_location = glGetUniformLocation(system->draw_program, "size");
+  system->color_location = glGetUniformLocation(system->draw_program, "color");
+  if (system->backend == PARTICLE_BACKEND_CPU) {
+    createStream(system);
+    return;
+  }
+  system->dt_location = glGetUniformLocation(system->update_program, "dt");
+  system->gravity_location = glGetUniformLocation(system->update_program, "gravity");
+  system->drag_location = glGetUniformLocation(system->update_program, "drag");
+  glGenBuffers(2, system->buffers);
+  glGenVertexArrays(2, system->update_arrays);
+  glGenVertexArrays(2, system->draw_arrays);
+  for (int i = 0; i < 2; i++) {
+    clearBuffer(system->buffers[i], system->capacity);
+    // The update reads one particle per vertex, the draw one per instance of a 4-vertex strip
+    glBindVertexArray(system->update_arrays[i]);
+    particleAttributes(0);
+    glBindVertexArray(system->draw_arrays[i]);
+    particleAttributes(1);
+  }
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+static void streamSprites(ParticleSystem *system, const ParticleSprite *sprites, size_t count) {
+  GLsizeiptr size = (GLsizeiptr)(count * sizeof(ParticleSprite));
+  system->draw_count = count;
+  system->updates++;
+  if (count == 0)
+    return;
+  glBindBuffer(GL_ARRAY_BUFFER, system->buffers[0]);
+  void *mapped = glMapBufferRange(GL_ARRAY_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+  if (mapped) {
+    memcpy(mapped, sprites, (size_t)size);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+  } else {
+    glBufferSubData(GL_ARRAY_BUFFER, 0, size, sprites);
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Replaying side. `data` is the GPU backend's emitted Particles, or the CPU backend's ParticleSprites
+static void update(ParticleSystem *system, const void *data, size_t count, size_t first, float dt) {
+  if (!system->buffers[0])
+    createObjects(system);
+  if (system->backend == PARTICLE_BACKEND_CPU) {
+    streamSprites(system, data, count);
+    return;
+  }
+  const Particle *emitted = data;
+
+  // New particles replace the oldest slots of the latest state, wrapping at the end
+  glBindBuffer(GL_ARRAY_BUFFER, system->buffers[system->current]);
+  size_t head = system->capacity - first < count ? system->capacity - first : count;
+  glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)(first * sizeof(Particle)), (GLsizeiptr)(head * sizeof(Particle)),
+                  emitted);
+  if (head < count)
+    glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)((count - head) * sizeof(Particle)), emitted + head);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  if (dt <= 0.0f)
+    return;
+
+  int next = system->current ^ 1;
+  glUseProgram(system->update_program);
+  glUniform1f(system->dt_location, dt);
+  glUniform3f(system->gravity_location, system->gravity.x, system->gravity.y, system->gravity.z);
+  glUniform1f(system->drag_location, system->drag);
+  glEnable(GL_RASTERIZER_DISCARD);
+  glBindVertexArray(system->update_arrays[system->current]);
+  glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, system->buffers[next]);
+  glBeginTransformFeedback(GL_POINTS);
+  glDrawArrays(GL_POINTS, 0, (GLsizei)system->capacity);
+  glEndTransformFeedback();
+  glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+  glBindVertexArray(0);
+  glDisable(GL_RASTERIZER_DISCARD);
+  system->current = next;
+  system->updates++;
+}
+
+static void draw(ParticleSystem *system, const float *size) {
+  if (!system->buffers[0])
+    createObjects(system);
+  glUseProgram(system->draw_program);
+  glUniform2f(system->size_location, size[0], size[1]);
+  glUniform4fv(system->color_location, 1, system->color);
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+  size_t count = system->capacity;
+  if (system->backend == PARTICLE_BACKEND_CPU) {
+    count = system->draw_count;
+    glVertexAttrib4f(1, 0.0f, 0.0f, 0.0f, 1.0f);
+  }
+  glBindVertexArray(system->draw_arrays[system->current]);
+  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)count);
+  glBindVertexArray(0);
+  glDisable(GL_BLEND);
+}
+
+// Commands the recording side leaves for the replay
+typedef struct UpdateCommand {
+  ParticleSystem *system;
+  const void *data; // emitted particles or sprites, kept by the system for a few frames
+  uint32_t count, first;
+  float dt;
+} UpdateCommand;
+
+typedef struct DrawCommand {
+  ParticleSystem *system;
+  float size[2];
+} DrawCommand;
+
+static void replayUpdate(const void *payload) {
+  const UpdateCommand *command = payload;
+  update(command->system, command->data, command->count, command->first, command->dt);
+}
+
+static void replayDraw(const void *payload) {
+  const DrawCommand *command = payload;
+  draw(command->system, command->size);
+}
+
+void ParticleSystemRecordUpdate(ParticleSystem *system, RenderCommandList *list, float dt) {
+  size_t limit = system->capacity < PARTICLE_MAX_EMIT ? system->capacity : PARTICLE_MAX_EMIT;
+  system->emit_accumulator += system->emitter.rate * (dt > 0.0f ? dt : 0.0f);
+  size_t count = (size_t)system->emit_accumulator;
+  system->emit_accumulator -= (float)count;
+  if (count > limit) {
+    system->dropped += count - limit;
+    count = limit;
+  }
+
+  Particle *batch = system->batches[system->frames++ % PARTICLE_EMIT_FRAMES];
+  for (size_t i = 0; i < count; i++)
+    emit(system, &batch[i]);
+  if (count == 0 && dt <= 0.0f)
+    return;
+  UpdateCommand *command = RenderCmdCallback(list, replayUpdate, sizeof(*command));
+  if (!command)
+    return;
+  command->system = system;
+  command->dt = dt;
+  if (system->backend == PARTICLE_BACKEND_CPU) {
+    command->data = simulateCpu(system, batch, count, dt);
+    command->count = (uint32_t)system->live;
+    command->first = 0;
+    return;
+  }
+  command->data = batch;
+  command->count = (uint32_t)count;
+  command->first = (uint32_t)system->cursor;
+  system->cursor = (system->cursor + count) % system->capacity;
+  system->emitted += count;
+}
+
+void ParticleSystemRecordDraw(ParticleSystem *system, RenderCommandList *list, GLsizei width, GLsizei height) {
+  if (width <= 0 || height <= 0)
+    return;
+  DrawCommand *command = RenderCmdCallback(list, replayDraw, sizeof(*command));
+  if (command) {
+    command->system = system;
+    command->size[0] = system->size * (float)height / (float)width;
+    command->size[1] = system->size;
+  }
+}
+
+void ParticleSystemPrintStats(const ParticleSystem *system) {
+  printf("Particles (%s): %zu slots, %zu emitted over %zu frames (%.1f per frame), %zu dropped, %zu updates",
+         system->backend == PARTICLE_BACKEND_CPU ? "CPU" : "GPU", system->capacity, system->emitted, system->frames,
+         system->frames ? (double)system->emitted / (double)system->frames : 0.0, system->dropped, system->updates);
+  if (system->backend == PARTICLE_BACKEND_CPU)
+    printf(", %zu live", system->live);
+  printf("\n");
+}
@@ -0,0 +1,66 @@
+#include "post_process.h"
+#include <string.h>
+
+bool PostChainInit(PostChain *chain) {
+  memset(chain, 0, sizeof(*chain));
+  glGenVertexArrays(1, &chain->vertex_array);
+  return chain->vertex_array != 0;
+}
+
+void PostChainDestroy(PostChain *chain) {
+  glDeleteVertexArrays(1, &chain->vertex_array);
+  memset(chain, 0, sizeof(*chain));
+}
+
+PostPass *PostChainAdd(PostChain *chain, const char *name, GLuint program, float scale, GLenum format) {
+  if (chain->count == POST_MAX_PASSES)
+    return NULL;
+  PostPass *pass = &chain->passes[chain->count++];
+  memset(pass, 0, sizeof(*pass));
+  pass->name = name;
+  pass->program = program;
+  pass->vertex_array = chain->vertex_array;
+  pass->source_location = glGetUniformLocation(program, "source");
+  pass->texel_size_location = glGetUniformLocation(program, "texelSize");
+  pass->params_location = glGetUniformLocation(program, "params");
+  pass->scale = scale;
+  pass->format = format;
+  return pass;
+}
+
+static GLsizei scaled(GLsizei size, float scale) {
+  GLsizei result = (GLsizei)((float)size * scale + 0.5f);
+  return result > 0 ? result : 1;
+}
+
+static void runPass(RenderCommandList *list, const RenderGraphContext *context, void *user) {
+  const PostPass *pass = user;
+  const RenderTargetDesc *source = RenderGraphTextureDesc(context->graph, context->pass->reads[0]);
+  RenderCmdPolygonMode(list, GL_FILL);
+  RenderCmdBindVertexArray(list, pass->vertex_array);
+  RenderCmdUseProgram(list, pass->program);
+  RenderCmdUniform1i(list, pass->source_location, 0);
+  RenderCmdUniform4f(list, pass->texel_size_location, 1.0f / (float)source->width, 1.0f / (float)source->height,
+                     (float)source->width, (float)source->height);
+  RenderCmdUniform4f(list, pass->params_location, pass->params[0], pass->params[1], pass->params[2],
+                     pass->params[3]);
+  RenderCmdDrawArrays(list, GL_TRIANGLES, 0, 3);
+}
+
+void PostChainDeclare(const PostChain *chain, RenderGraph *graph, RenderGraphResource scene,
+                      RenderGraphResource output) {
+  const RenderTargetDesc *screen = RenderGraphTextureDesc(graph, output);
+  RenderGraphResource input = scene;
+  for (size_t i = 0; i < chain->count; i++) {
+    const PostPass *pass = &chain->passes[i];
+    RenderGraphResource target = output;
+    if (i + 1 < chain->count) {
+      RenderTargetDesc desc = {scaled(screen->width, pass->scale), scaled(screen->height, pass->scale), pass->format};
+      target = RenderGraphCreateTexture(graph, pass->name, &desc);
+    }
+    RenderGraphPassId id = RenderGraphAddPass(graph, pass->name, runPass, (void *)pass);
+    RenderGraphRead(graph, id, input);
+    RenderGraphWrite(graph, id, target);
+    input = target;
+  }
+}
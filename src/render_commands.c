@@ -0,0 +1,220 @@
+#include "render_commands.h"
+#include <stdlib.h>
+#include <string.h>
+
+bool RenderCommandListInit(RenderCommandList *list, size_t capacity) {
+  memset(list, 0, sizeof(*list));
+  list->commands = malloc(capacity * sizeof(RenderCommand));
+  if (!list->commands)
+    return false;
+  list->capacity = capacity;
+  list->input_time = -1.0;
+  return true;
+}
+
+void RenderCommandListDestroy(RenderCommandList *list) {
+  free(list->commands);
+  memset(list, 0, sizeof(*list));
+}
+
+void RenderCommandListReset(RenderCommandList *list) {
+  list->count = 0;
+  list->input_time = -1.0;
+}
+
+RenderCommand *RenderCommandPush(RenderCommandList *list, RenderCommandType type) {
+  if (list->count == list->capacity) {
+    size_t capacity = list->capacity ? list->capacity * 2 : 64;
+    RenderCommand *commands = realloc(list->commands, capacity * sizeof(RenderCommand));
+    if (!commands)
+      return NULL;
+    list->commands = commands;
+    list->capacity = capacity;
+  }
+  RenderCommand *command = &list->commands[list->count++];
+  command->type = type;
+  return command;
+}
+
+void RenderCommandListExecute(const RenderCommandList *list) {
+  for (size_t i = 0; i < list->count; i++) {
+    const RenderCommand *c = &list->commands[i];
+    switch (c->type) {
+    case RENDER_CMD_VIEWPORT:
+      glViewport(c->viewport.x, c->viewport.y, c->viewport.width, c->viewport.height);
+      break;
+    case RENDER_CMD_CLEAR:
+      glClearColor(c->clear.r, c->clear.g, c->clear.b, c->clear.a);
+      glClear(c->clear.mask);
+      break;
+    case RENDER_CMD_POLYGON_MODE:
+      glPolygonMode(GL_FRONT_AND_BACK, c->polygon_mode);
+      break;
+    case RENDER_CMD_USE_PROGRAM:
+      glUseProgram(c->program);
+      break;
+    case RENDER_CMD_UNIFORM_1I:
+      glUniform1i(c->uniform_1i.location, c->uniform_1i.value);
+      break;
+    case RENDER_CMD_UNIFORM_1F:
+      glUniform1f(c->uniform_1f.location, c->uniform_1f.value);
+      break;
+    case RENDER_CMD_UNIFORM_4F:
+      glUniform4fv(c->uniform_4f.location, 1, c->uniform_4f.value);
+      break;
+    case RENDER_CMD_UNIFORM_MATRIX_4FV:
+      glUniformMatrix4fv(c->uniform_matrix_4fv.location, 1, GL_FALSE, c->uniform_matrix_4fv.value);
+      break;
+    case RENDER_CMD_BIND_TEXTURE:
+      glActiveTexture(c->bind_texture.unit);
+      glBindTexture(c->bind_texture.target, c->bind_texture.texture);
+      break;
+    case RENDER_CMD_BIND_VERTEX_ARRAY:
+      glBindVertexArray(c->vertex_array);
+      break;
+    case RENDER_CMD_DRAW_ARRAYS:
+      glDrawArrays(c->draw_arrays.mode, c->draw_arrays.first, c->draw_arrays.count);
+      break;
+    case RENDER_CMD_DRAW_ELEMENTS:
+      glDrawElements(c->draw_elements.mode, c->draw_elements.count, c->draw_elements.index_type,
+                     (const void *)c->draw_elements.offset);
+      break;
+    case RENDER_CMD_WAIT_SYNC:
+      glWaitSync(c->sync, 0, GL_TIMEOUT_IGNORED);
+      glDeleteSync(c->sync);
+      break;
+    case RENDER_CMD_BIND_RENDER_TARGET:
+      RenderTargetPoolBind(c->render_target.pool, c->render_target.color, &c->render_target.color_desc,
+                           c->render_target.depth, &c->render_target.depth_desc);
+      break;
+    case RENDER_CMD_BIND_RENDER_TARGET_TEXTURE:
+      glActiveTexture(c->render_target.unit);
+      RenderTargetPoolBindTexture(c->render_target.pool, c->render_target.color, &c->render_target.color_desc);
+      break;
+    case RENDER_CMD_EVICT_RENDER_TARGET:
+      RenderTargetPoolEvict(c->render_target.pool, c->render_target.color);
+      break;
+    case RENDER_CMD_CALLBACK:
+      c->callback.callback(c->callback.payload.bytes);
+      break;
+    }
+  }
+}
+
+void RenderCmdViewport(RenderCommandList *list, GLint x, GLint y, GLsizei width, GLsizei height) {
+  RenderCommand *c = RenderCommandPush(list, RENDER_CMD_VIEWPORT);
+  if (c) {
+    c->viewport.x = x;
+    c->viewport.y = y;
+    c->viewport.width = width;
+    c->viewport.height = height;
+  }
+}
+
+void RenderCmdClear(RenderCommandList *list, GLfloat r, GLfloat g, GLfloat b, GLfloat a, GLbitfield mask) {
+  RenderCommand *c = RenderCommandPush(list, RENDER_CMD_CLEAR);
+  if (c) {
+    c->clear.r = r;
+    c->clear.g = g;
+    c->clear.b = b;
+    c->clear.a = a;
+    c->clear.mask = mask;
+  }
+}
+
+void RenderCmdPolygonMode(RenderCommandList *list, GLenum mode) {
+  RenderCommand *c = RenderCommandPush(list, RENDER_CMD_POLYGON_MODE);
+  if (c)
+    c->polygon_mode = mode;
+}
+
+void RenderCmdUseProgram(RenderCommandList *list, GLuint program) {
+  RenderCommand *c = RenderCommandPush(list, RENDER_CMD_USE_PROGRAM);
+  if (c)
+    c->program = program;
+}
+
+void RenderCmdUniform1i(RenderCommandList *list, GLint location, GLint value) {
+  RenderCommand *c = RenderCommandPush(list, RENDER_CMD_UNIFORM_1I);
+  if (c) {
+    c->uniform_1i.location = location;
+    c->uniform_1i.value = value;
+  }
+}
+
+void RenderCmdUniform1f(RenderCommandList *list, GLint location, GLfloat value) {
+  RenderCommand *c = RenderCommandPush(list, RENDER_CMD_UNIFORM_1F);
+  if (c) {
+    c->uniform_1f.location = location;
+    c->uniform_1f.value = value;
+  }
+}
+
+void RenderCmdUniform4f(RenderCommandList *list, GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w) {
+  RenderCommand *c = RenderCommandPush(list, RENDER_CMD_UNIFORM_4F);
+  if (c) {
+    c->uniform_4f.location = location;
+    c->uniform_4f.value[0] = x;
+    c->uniform_4f.value[1] = y;
+    c->uniform_4f.value[2] = z;
+    c->uniform_4f.value[3] = w;
+  }
+}
+
+void RenderCmdUniformMatrix4fv(RenderCommandList *list, GLint location, const GLfloat *value) {
+  RenderCommand *c = RenderCommandPush(list, RENDER_CMD_UNIFORM_MATRIX_4FV);
+  if (c) {
+    c->uniform_matrix_4fv.location = location;
+    memcpy(c->uniform_matrix_4fv.value, value, sizeof(c->uniform_matrix_4fv.value));
+  }
+}
+
+void RenderCmdBindTexture(RenderCommandList *list, GLenum unit, GLenum target, GLuint texture) {
+  RenderCommand *c = RenderCommandPush(list, RENDER_CMD_BIND_TEXTURE);
+  if (c) {
+    c->bind_texture.unit = unit;
+    c->bind_texture.target = target;
+    c->bind_texture.texture = texture;
+  }
+}
+
+void RenderCmdBindVertexArray(RenderCommandList *list, GLuint vertex_array) {
+  RenderCommand *c = RenderCommandPush(list, RENDER_CMD_BIND_VERTEX_ARRAY);
+  if (c)
+    c->vertex_array = vertex_array;
+}
+
+void RenderCmdDrawArrays(RenderCommandList *list, GLenum mode, GLint first, GLsizei count) {
+  RenderCommand *c = RenderCommandPush(list, RENDER_CMD_DRAW_ARRAYS);
+  if (c) {
+    c->draw_arrays.mode = mode;
+    c->draw_arrays.first = first;
+    c->draw_arrays.count = count;
+  }
+}
+
+void RenderCmdDrawElements(RenderCommandList *list, GLenum mode, GLsizei count, GLenum index_type, size_t offset) {
+  RenderCommand *c = RenderCommandPush(list, RENDER_CMD_DRAW_ELEMENTS);
+  if (c) {
+    c->draw_elements.mode = mode;
+    c->draw_elements.count = count;
+    c->draw_elements.index_type = index_type;
+    c->draw_elements.offset = offset;
+  }
+}
+
+void RenderCmdWaitSync(RenderCommandList *list, GLsync sync) {
+  RenderCommand *c = RenderCommandPush(list, RENDER_CMD_WAIT_SYNC);
+  if (c)
+    c->sync = sync;
+}
+
+void *RenderCmdCallback(RenderCommandList *list, RenderCallback callback, size_t size) {
+  if (size > RENDER_CMD_PAYLOAD_SIZE)
+    return NULL;
+  RenderCommand *c = RenderCommandPush(list, RENDER_CMD_CALLBACK);
+  if (!c)
+    return NULL;
+  c->callback.callback = callback;
+  return c->callback.payload.bytes;
+}
@@ -0,0 +1,297 @@
+#include "render_graph.h"
+#include <stdio.h>
+#include <string.h>
+
+void RenderGraphInit(RenderGraph *graph) { memset(graph, 0, sizeof(*graph)); }
+
+void RenderGraphReset(RenderGraph *graph) {
+  graph->texture_count = 0;
+  graph->pass_count = 0;
+  graph->overflow = false;
+}
+
+static RenderGraphResource addTexture(RenderGraph *graph, const char *name, const RenderTargetDesc *desc,
+                                      bool imported) {
+  if (graph->texture_count == RENDER_GRAPH_MAX_TEXTURES) {
+    graph->overflow = true;
+    return RENDER_GRAPH_NONE;
+  }
+  graph->textures[graph->texture_count] = (RenderGraphTexture){name, *desc, imported};
+  return (RenderGraphResource)graph->texture_count++;
+}
+
+RenderGraphResource RenderGraphImportBackbuffer(RenderGraph *graph, GLsizei width, GLsizei height) {
+  RenderTargetDesc desc = {width, height, 0};
+  return addTexture(graph, "backbuffer", &desc, true);
+}
+
+RenderGraphResource RenderGraphCreateTexture(RenderGraph *graph, const char *name, const RenderTargetDesc *desc) {
+  return addTexture(graph, name, desc, false);
+}
+
+RenderGraphPassId RenderGraphAddPass(RenderGraph *graph, const char *name, RenderGraphExecuteFn execute, void *user) {
+  if (graph->pass_count == RENDER_GRAPH_MAX_PASSES) {
+    graph->overflow = true;
+    return RENDER_GRAPH_NONE;
+  }
+  RenderGraphPass *pass = &graph->passes[graph->pass_count];
+  memset(pass, 0, sizeof(*pass));
+  pass->name = name;
+  pass->execute = execute;
+  pass->user = user;
+  return (RenderGraphPassId)graph->pass_count++;
+}
+
+void RenderGraphRead(RenderGraph *graph, RenderGraphPassId pass, RenderGraphResource texture) {
+  if (pass >= graph->pass_count || texture >= graph->texture_count ||
+      graph->passes[pass].read_count == RENDER_GRAPH_MAX_READS) {
+    graph->overflow = true;
+    return;
+  }
+  RenderGraphPass *p = &graph->passes[pass];
+  p->reads[p->read_count++] = texture;
+}
+
+void RenderGraphWrite(RenderGraph *graph, RenderGraphPassId pass, RenderGraphResource texture) {
+  if (pass >= graph->pass_count || texture >= graph->texture_count ||
+      graph->passes[pass].write_count == RENDER_GRAPH_MAX_WRITES) {
+    graph->overflow = true;
+    return;
+  }
+  RenderGraphPass *p = &graph->passes[pass];
+  p->writes[p->write_count++] = texture;
+}
+
+void RenderGraphSetSideEffect(RenderGraph *graph, RenderGraphPassId pass) {
+  if (pass < graph->pass_count)
+    graph->passes[pass].side_effect = true;
+}
+
+const RenderTargetDesc *RenderGraphTextureDesc(const RenderGraph *graph, RenderGraphResource texture) {
+  return &graph->textures[texture].desc;
+}
+
+static uint64_t hashBytes(uint64_t hash, const void *data, size_t size) {
+  const unsigned char *bytes = data;
+  for (size_t i = 0; i < size; i++)
+    hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+  return hash;
+}
+
+// Everything the plan depends on; names, callbacks and user data can change freely
+static uint64_t declarationHash(const RenderGraph *graph) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  hash = hashBytes(hash, &graph->texture_count, sizeof(graph->texture_count));
+  hash = hashBytes(hash, &graph->pass_count, sizeof(graph->pass_count));
+  for (size_t t = 0; t < graph->texture_count; t++) {
+    const RenderGraphTexture *texture = &graph->textures[t];
+    hash = hashBytes(hash, &texture->desc, sizeof(texture->desc));
+    hash = hashBytes(hash, &texture->imported, sizeof(texture->imported));
+  }
+  for (size_t p = 0; p < graph->pass_count; p++) {
+    const RenderGraphPass *pass = &graph->passes[p];
+    hash = hashBytes(hash, pass->reads, pass->read_count * sizeof(pass->reads[0]));
+    hash = hashBytes(hash, pass->writes, pass->write_count * sizeof(pass->writes[0]));
+    uint8_t shape[3] = {pass->read_count, pass->write_count, pass->side_effect};
+    hash = hashBytes(hash, shape, sizeof(shape));
+  }
+  return hash;
+}
+
+static bool writes(const RenderGraphPass *pass, RenderGraphResource texture) {
+  for (uint8_t w = 0; w < pass->write_count; w++)
+    if (pass->writes[w] == texture)
+      return true;
+  return false;
+}
+
+// depends[p] has bit q set when pass p must run after pass q. Readers see the texture once
+// every writer is done; several writers of one texture keep their declaration order.
+static void buildDependencies(const RenderGraph *graph, uint32_t *depends) {
+  for (size_t p = 0; p < graph->pass_count; p++) {
+    const RenderGraphPass *pass = &graph->passes[p];
+    depends[p] = 0;
+    for (size_t q = 0; q < graph->pass_count; q++) {
+      if (q == p)
+        continue;
+      const RenderGraphPass *other = &graph->passes[q];
+      for (uint8_t r = 0; r < pass->read_count; r++)
+        if (writes(other, pass->reads[r]) && (q < p || !writes(pass, pass->reads[r])))
+          depends[p] |= 1u << q;
+      for (uint8_t w = 0; w < pass->write_count; w++)
+        if (q < p && writes(other, pass->writes[w]))
+          depends[p] |= 1u << q;
+    }
+  }
+}
+
+static void assignStorage(RenderGraph *graph) {
+  RenderGraphStats *stats = &graph->stats;
+  uint16_t sorted[RENDER_GRAPH_MAX_TEXTURES];
+  size_t count = 0;
+  for (size_t t = 0; t < graph->texture_count; t++) {
+    graph->physical_of[t] = RENDER_GRAPH_NONE;
+    if (graph->textures[t].imported || graph->first_use[t] == RENDER_GRAPH_NONE)
+      continue;
+    // Insertion sort by the start of the lifetime
+    size_t i = count++;
+    while (i > 0 && graph->first_use[sorted[i - 1]] > graph->first_use[t]) {
+      sorted[i] = sorted[i - 1];
+      i--;
+    }
+    sorted[i] = (uint16_t)t;
+  }
+
+  // Greedy interval colouring: a slot is free again once its last reader has run
+  uint16_t busy_until[RENDER_GRAPH_MAX_TEXTURES];
+  graph->physical_count = 0;
+  for (size_t i = 0; i < count; i++) {
+    uint16_t t = sorted[i];
+    const RenderTargetDesc *desc = &graph->textures[t].desc;
+    size_t slot = 0;
+    while (slot < graph->physical_count &&
+           (busy_until[slot] >= graph->first_use[t] || !RenderTargetDescEqual(&graph->physical[slot], desc)))
+      slot++;
+    if (slot == graph->physical_count)
+      graph->physical[graph->physical_count++] = *desc;
+    busy_until[slot] = graph->last_use[t];
+    graph->physical_of[t] = (uint16_t)slot;
+    stats->naive_bytes += RenderTargetBytes(desc);
+  }
+  stats->textures = count;
+  stats->physical = graph->physical_count;
+  for (size_t slot = 0; slot < graph->physical_count; slot++)
+    stats->physical_bytes += RenderTargetBytes(&graph->physical[slot]);
+
+  // What a heap that places any format anywhere would need: the most bytes alive at once
+  for (size_t position = 0; position < graph->order_count; position++) {
+    size_t live = 0;
+    for (size_t i = 0; i < count; i++)
+      if (graph->first_use[sorted[i]] <= position && graph->last_use[sorted[i]] >= position)
+        live += RenderTargetBytes(&graph->textures[sorted[i]].desc);
+    if (live > stats->peak_live_bytes)
+      stats->peak_live_bytes = live;
+  }
+}
+
+bool RenderGraphCompile(RenderGraph *graph) {
+  if (graph->overflow)
+    return false;
+  uint64_t hash = declarationHash(graph);
+  if (graph->compiled_hash != 0 && hash == graph->compiled_hash)
+    return true;
+  graph->compiled_hash = 0;
+  graph->compiles++;
+  memset(&graph->stats, 0, sizeof(graph->stats));
+  graph->stats.passes = graph->pass_count;
+
+  uint32_t depends[RENDER_GRAPH_MAX_PASSES];
+  buildDependencies(graph, depends);
+
+  // Live passes: side effects and everything they transitively depend on
+  uint32_t live = 0;
+  for (size_t p = 0; p < graph->pass_count; p++) {
+    const RenderGraphPass *pass = &graph->passes[p];
+    bool needed = pass->side_effect;
+    for (uint8_t w = 0; w < pass->write_count; w++)
+      needed |= graph->textures[pass->writes[w]].imported;
+    live |= (uint32_t)needed << p;
+  }
+  for (uint32_t previous = 0; previous != live;) {
+    previous = live;
+    for (size_t p = 0; p < graph->pass_count; p++)
+      if (live & (1u << p))
+        live |= depends[p];
+  }
+
+  // Kahn's algorithm, ties broken by declaration order
+  uint32_t done = 0;
+  graph->order_count = 0;
+  for (size_t p = 0; p < graph->pass_count; p++) {
+    graph->culled[p] = !(live & (1u << p));
+    graph->stats.culled += graph->culled[p];
+  }
+  while (done != live) {
+    size_t p = 0;
+    while (p < graph->pass_count && (!(live & ~done & (1u << p)) || (depends[p] & live & ~done)))
+      p++;
+    if (p == graph->pass_count) {
+      printf("Render graph: dependency cycle\n");
+      return false;
+    }
+    done |= 1u << p;
+    graph->order[graph->order_count++] = (RenderGraphPassId)p;
+  }
+
+  for (size_t t = 0; t < graph->texture_count; t++)
+    graph->first_use[t] = graph->last_use[t] = RENDER_GRAPH_NONE;
+  for (size_t position = 0; position < graph->order_count; position++) {
+    const RenderGraphPass *pass = &graph->passes[graph->order[position]];
+    RenderGraphResource used[RENDER_GRAPH_MAX_READS + RENDER_GRAPH_MAX_WRITES];
+    memcpy(used, pass->reads, pass->read_count * sizeof(used[0]));
+    memcpy(used + pass->read_count, pass->writes, pass->write_count * sizeof(used[0]));
+    for (size_t i = 0; i < (size_t)pass->read_count + pass->write_count; i++) {
+      if (graph->first_use[used[i]] == RENDER_GRAPH_NONE)
+        graph->first_use[used[i]] = (uint16_t)position;
+      graph->last_use[used[i]] = (uint16_t)position;
+    }
+  }
+  assignStorage(graph);
+  graph->compiled_hash = hash;
+  return true;
+}
+
+void RenderGraphExecute(RenderGraph *graph, RenderCommandList *list, RenderTargetPool *pool) {
+  graph->frames++;
+  size_t acquired = 0;
+  for (; acquired < graph->physical_count; acquired++) {
+    graph->slots[acquired] = RenderTargetAcquire(pool, &graph->physical[acquired]);
+    if (graph->slots[acquired] == RENDER_TARGET_NONE)
+      break;
+  }
+
+  for (size_t position = 0; acquired == graph->physical_count && position < graph->order_count; position++) {
+    const RenderGraphPass *pass = &graph->passes[graph->order[position]];
+    RenderGraphContext context = {graph, pass, 0, 0, false};
+    RenderTargetHandle color = RENDER_TARGET_NONE, depth = RENDER_TARGET_NONE;
+    bool backbuffer = false;
+    for (uint8_t w = 0; w < pass->write_count; w++) {
+      const RenderGraphTexture *texture = &graph->textures[pass->writes[w]];
+      context.width = texture->desc.width;
+      context.height = texture->desc.height;
+      if (texture->imported) {
+        backbuffer = true;
+        break;
+      }
+      RenderTargetHandle slot = graph->slots[graph->physical_of[pass->writes[w]]];
+      if (RenderTargetIsDepth(texture->desc.format))
+        depth = slot;
+      else
+        color = slot;
+    }
+    // The default framebuffer brings its own attachments
+    if (backbuffer)
+      color = depth = RENDER_TARGET_NONE;
+    if (pass->write_count > 0)
+      RenderCmdBindRenderTarget(list, pool, color, depth, context.width, context.height);
+    context.depth = depth != RENDER_TARGET_NONE;
+    for (uint8_t r = 0; r < pass->read_count; r++)
+      if (!graph->textures[pass->reads[r]].imported)
+        RenderCmdBindRenderTargetTexture(list, pool, GL_TEXTURE0 + r, graph->slots[graph->physical_of[pass->reads[r]]]);
+    pass->execute(list, &context, pass->user);
+  }
+
+  for (size_t slot = 0; slot < acquired; slot++)
+    RenderTargetRelease(pool, graph->slots[slot]);
+}
+
+void RenderGraphPrintStats(const RenderGraph *graph) {
+  if (graph->frames == 0)
+    return;
+  const RenderGraphStats *s = &graph->stats;
+  const double mib = 1.0 / (1024.0 * 1024.0);
+  printf("Render graph: %zu passes (%zu culled), %zu transient textures in %zu slots, %zu compiles in %zu frames\n",
+         s->passes, s->culled, s->textures, s->physical, graph->compiles, graph->frames);
+  printf("Render graph memory: %.1f MiB allocated, %.1f MiB peak live, %.1f MiB without aliasing\n",
+         (double)s->physical_bytes * mib, (double)s->peak_live_bytes * mib, (double)s->naive_bytes * mib);
+}
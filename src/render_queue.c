@@ -0,0 +1,187 @@
+#include "render_queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+uint64_t RenderKeyMake(unsigned layer, unsigned program, unsigned texture_set, unsigned geometry, float depth) {
+  // depth in [0, 1], quantized to 24 bits
+  depth = depth < 0.0f ? 0.0f : depth > 1.0f ? 1.0f : depth;
+  uint64_t quantized = (uint64_t)(depth * (float)0xffffff);
+  return ((uint64_t)(layer & 0xf) << RENDER_KEY_LAYER_SHIFT) |
+         ((uint64_t)(program & 0xff) << RENDER_KEY_PROGRAM_SHIFT) |
+         ((uint64_t)(texture_set & 0xfff) << RENDER_KEY_TEXTURE_SHIFT) |
+         ((uint64_t)(geometry & 0xffff) << RENDER_KEY_GEOMETRY_SHIFT) | quantized;
+}
+
+static unsigned keyProgram(uint64_t key) { return (unsigned)(key >> RENDER_KEY_PROGRAM_SHIFT) & 0xff; }
+static unsigned keyTextureSet(uint64_t key) { return (unsigned)(key >> RENDER_KEY_TEXTURE_SHIFT) & 0xfff; }
+static unsigned keyGeometry(uint64_t key) { return (unsigned)(key >> RENDER_KEY_GEOMETRY_SHIFT) & 0xffff; }
+
+static bool reserve(RenderQueue *queue, size_t capacity) {
+  uint64_t *keys = realloc(queue->keys, capacity * sizeof(uint64_t));
+  if (keys)
+    queue->keys = keys;
+  uint32_t *order = realloc(queue->order, capacity * sizeof(uint32_t));
+  if (order)
+    queue->order = order;
+  uint64_t *scratch_keys = realloc(queue->scratch_keys, capacity * sizeof(uint64_t));
+  if (scratch_keys)
+    queue->scratch_keys = scratch_keys;
+  uint32_t *scratch_order = realloc(queue->scratch_order, capacity * sizeof(uint32_t));
+  if (scratch_order)
+    queue->scratch_order = scratch_order;
+  RenderDraw *draws = realloc(queue->draws, capacity * sizeof(RenderDraw));
+  if (draws)
+    queue->draws = draws;
+  if (!keys || !order || !scratch_keys || !scratch_order || !draws)
+    return false;
+  queue->capacity = capacity;
+  return true;
+}
+
+bool RenderQueueInit(RenderQueue *queue, size_t capacity) {
+  memset(queue, 0, sizeof(*queue));
+  queue->texture_sets = calloc(RENDER_QUEUE_MAX_TEXTURE_SETS, sizeof(RenderTextureSet));
+  if (!queue->texture_sets || !reserve(queue, capacity ? capacity : 64)) {
+    RenderQueueDestroy(queue);
+    return false;
+  }
+  return true;
+}
+
+void RenderQueueDestroy(RenderQueue *queue) {
+  free(queue->keys);
+  free(queue->order);
+  free(queue->scratch_keys);
+  free(queue->scratch_order);
+  free(queue->draws);
+  free(queue->texture_sets);
+  memset(queue, 0, sizeof(*queue));
+}
+
+void RenderQueueReset(RenderQueue *queue) { queue->count = 0; }
+
+void RenderQueueSetProgram(RenderQueue *queue, unsigned id, GLuint program, RenderProgramSetupFn setup, void *user) {
+  if (id < RENDER_QUEUE_MAX_PROGRAMS)
+    queue->programs[id] = (RenderProgram){program, setup, user};
+}
+
+void RenderQueueSetTextures(RenderQueue *queue, unsigned id, GLenum target, const GLuint *textures, unsigned count) {
+  if (id == 0 || id >= RENDER_QUEUE_MAX_TEXTURE_SETS || count > RENDER_TEXTURE_SET_SIZE)
+    return;
+  RenderTextureSet *set = &queue->texture_sets[id];
+  set->target = target;
+  set->count = count;
+  memcpy(set->textures, textures, count * sizeof(GLuint));
+}
+
+static size_t indexSize(GLenum index_type) {
+  return index_type == GL_UNSIGNED_INT ? 4 : index_type == GL_UNSIGNED_SHORT ? 2 : 1;
+}
+
+RenderDraw *RenderQueuePush(RenderQueue *queue, uint64_t key) {
+  if (queue->count == queue->capacity && !reserve(queue, queue->capacity * 2))
+    return NULL;
+  size_t index = queue->count++;
+  queue->keys[index] = key;
+  queue->order[index] = (uint32_t)index;
+  return &queue->draws[index];
+}
+
+void RenderQueueSort(RenderQueue *queue) {
+  uint64_t *keys = queue->keys, *keys_out = queue->scratch_keys;
+  uint32_t *order = queue->order, *order_out = queue->scratch_order;
+  size_t count = queue->count;
+
+  // One histogram sweep for all eight digits
+  size_t histogram[8][256] = {{0}};
+  for (size_t i = 0; i < count; i++)
+    for (int digit = 0; digit < 8; digit++)
+      histogram[digit][(keys[i] >> (digit * 8)) & 0xff]++;
+
+  for (int digit = 0; digit < 8; digit++) {
+    size_t *buckets = histogram[digit];
+    if (count == 0 || buckets[(keys[0] >> (digit * 8)) & 0xff] == count)
+      continue; // every key has the same byte here
+    size_t offset = 0;
+    for (int b = 0; b < 256; b++) {
+      size_t n = buckets[b];
+      buckets[b] = offset;
+      offset += n;
+    }
+    for (size_t i = 0; i < count; i++) {
+      size_t dst = buckets[(keys[i] >> (digit * 8)) & 0xff]++;
+      keys_out[dst] = keys[i];
+      order_out[dst] = order[i];
+    }
+    uint64_t *swap_keys = keys;
+    keys = keys_out;
+    keys_out = swap_keys;
+    uint32_t *swap_order = order;
+    order = order_out;
+    order_out = swap_order;
+  }
+
+  // Keep the sorted data in the primary arrays
+  queue->keys = keys;
+  queue->scratch_keys = keys_out;
+  queue->order = order;
+  queue->scratch_order = order_out;
+}
+
+void RenderQueueSubmit(RenderQueue *queue, RenderCommandList *list) {
+  RenderQueueStats stats = {queue->count, 0, 0, 0};
+  unsigned program = RENDER_QUEUE_MAX_PROGRAMS, texture_set = 0, geometry = 0;
+  bool geometry_bound = false;
+
+  for (size_t i = 0; i < queue->count; i++) {
+    uint64_t key = queue->keys[i];
+    const RenderDraw *draw = &queue->draws[queue->order[i]];
+
+    if (keyProgram(key) != program) {
+      program = keyProgram(key);
+      const RenderProgram *p = &queue->programs[program];
+      RenderCmdUseProgram(list, p->program);
+      if (p->setup)
+        p->setup(list, p->user);
+      stats.program_switches++;
+    }
+    unsigned set_id = keyTextureSet(key);
+    if (set_id != 0 && set_id != texture_set) {
+      texture_set = set_id;
+      const RenderTextureSet *set = &queue->texture_sets[set_id];
+      for (unsigned unit = 0; unit < set->count; unit++)
+        RenderCmdBindTexture(list, GL_TEXTURE0 + unit, set->target, set->textures[unit]);
+      stats.texture_switches++;
+    }
+    if (!geometry_bound || keyGeometry(key) != geometry) {
+      geometry = keyGeometry(key);
+      geometry_bound = true;
+      RenderCmdBindVertexArray(list, draw->vertex_array);
+      stats.vertex_array_switches++;
+    }
+
+    RenderCmdUniformMatrix4fv(list, draw->model_location, draw->model);
+    if (draw->index_type)
+      RenderCmdDrawElements(list, draw->mode, draw->count, draw->index_type,
+                            (size_t)draw->first * indexSize(draw->index_type));
+    else
+      RenderCmdDrawArrays(list, draw->mode, draw->first, draw->count);
+  }
+
+  queue->last = stats;
+  queue->total.draws += stats.draws;
+  queue->total.program_switches += stats.program_switches;
+  queue->total.texture_switches += stats.texture_switches;
+  queue->total.vertex_array_switches += stats.vertex_array_switches;
+  queue->frames++;
+}
+
+void RenderQueuePrintStats(const RenderQueue *queue) {
+  if (queue->frames == 0)
+    return;
+  double frames = (double)queue->frames;
+  printf("Render queue: per frame %.1f draws, %.1f program, %.1f texture, %.1f vertex array switches\n",
+         queue->total.draws / frames, queue->total.program_switches / frames, queue->total.texture_switches / frames,
+         queue->total.vertex_array_switches / frames);
+}
@@ -0,0 +1,246 @@
+#include "render_target.h"
+#include "render_commands.h"
+#include <stdio.h>
+#include <string.h>
+
+typedef struct FormatInfo {
+  GLenum format;
+  GLenum type;
+  size_t bytes;
+} FormatInfo;
+
+static FormatInfo formatInfo(GLenum internal_format) {
+  switch (internal_format) {
+  case GL_RGBA16F:
+    return (FormatInfo){GL_RGBA, GL_HALF_FLOAT, 8};
+  case GL_RGBA32F:
+    return (FormatInfo){GL_RGBA, GL_FLOAT, 16};
+  case GL_R11F_G11F_B10F:
+    return (FormatInfo){GL_RGB, GL_FLOAT, 4};
+  case GL_DEPTH24_STENCIL8:
+    return (FormatInfo){GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, 4};
+  case GL_DEPTH32F_STENCIL8:
+    return (FormatInfo){GL_DEPTH_STENCIL, GL_FLOAT_32_UNSIGNED_INT_24_8_REV, 8};
+  case GL_DEPTH_COMPONENT16:
+    return (FormatInfo){GL_DEPTH_COMPONENT, GL_UNSIGNED_SHORT, 2};
+  case GL_DEPTH_COMPONENT24:
+    return (FormatInfo){GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, 4};
+  case GL_DEPTH_COMPONENT32F:
+    return (FormatInfo){GL_DEPTH_COMPONENT, GL_FLOAT, 4};
+  default:
+    return (FormatInfo){GL_RGBA, GL_UNSIGNED_BYTE, 4};
+  }
+}
+
+bool RenderTargetDescEqual(const RenderTargetDesc *a, const RenderTargetDesc *b) {
+  return a->width == b->width && a->height == b->height && a->format == b->format;
+}
+
+bool RenderTargetIsDepth(GLenum format) {
+  return format == GL_DEPTH24_STENCIL8 || format == GL_DEPTH32F_STENCIL8 || format == GL_DEPTH_COMPONENT16 ||
+         format == GL_DEPTH_COMPONENT24 || format == GL_DEPTH_COMPONENT32F;
+}
+
+size_t RenderTargetBytes(const RenderTargetDesc *desc) {
+  return (size_t)desc->width * (size_t)desc->height * formatInfo(desc->format).bytes;
+}
+
+void RenderTargetPoolInit(RenderTargetPool *pool) { memset(pool, 0, sizeof(*pool)); }
+
+void RenderTargetPoolDestroy(RenderTargetPool *pool) {
+  for (size_t i = 0; i < pool->framebuffer_count; i++)
+    glDeleteFramebuffers(1, &pool->framebuffers[i].framebuffer);
+  for (size_t s = 0; s < RENDER_TARGET_MAX; s++)
+    if (pool->storage[s].texture)
+      glDeleteTextures(1, &pool->storage[s].texture);
+  memset(pool, 0, sizeof(*pool));
+}
+
+// ---- Recording ------------------------------------------------------------------------------
+
+RenderTargetHandle RenderTargetAcquire(RenderTargetPool *pool, const RenderTargetDesc *desc) {
+  pool->acquires++;
+  RenderTargetHandle empty = RENDER_TARGET_NONE;
+  for (RenderTargetHandle s = 0; s < RENDER_TARGET_MAX; s++) {
+    if (pool->last_used[s] == 0) {
+      if (empty == RENDER_TARGET_NONE)
+        empty = s;
+    } else if (!pool->in_use[s] && RenderTargetDescEqual(&pool->descs[s], desc)) {
+      pool->reuses += pool->released[s];
+      pool->in_use[s] = true;
+      pool->last_used[s] = pool->frame + 1;
+      return s;
+    }
+  }
+  if (empty != RENDER_TARGET_NONE) {
+    pool->descs[empty] = *desc;
+    pool->in_use[empty] = true;
+    pool->released[empty] = false;
+    pool->last_used[empty] = pool->frame + 1;
+  }
+  return empty;
+}
+
+void RenderTargetRelease(RenderTargetPool *pool, RenderTargetHandle target) {
+  if (target >= RENDER_TARGET_MAX)
+    return;
+  pool->in_use[target] = false;
+  pool->released[target] = true;
+}
+
+void RenderTargetPoolEndFrame(RenderTargetPool *pool, RenderCommandList *list) {
+  pool->frame++;
+  for (RenderTargetHandle s = 0; s < RENDER_TARGET_MAX; s++) {
+    pool->released[s] = false;
+    if (pool->last_used[s] == 0 || pool->in_use[s] || pool->frame - pool->last_used[s] < RENDER_TARGET_EVICT_FRAMES)
+      continue;
+    pool->last_used[s] = 0;
+    RenderCommand *c = RenderCommandPush(list, RENDER_CMD_EVICT_RENDER_TARGET);
+    if (c) {
+      c->render_target.pool = pool;
+      c->render_target.color = s;
+    }
+  }
+}
+
+void RenderCmdBindRenderTarget(RenderCommandList *list, RenderTargetPool *pool, RenderTargetHandle color,
+                               RenderTargetHandle depth, GLsizei width, GLsizei height) {
+  RenderCommand *c = RenderCommandPush(list, RENDER_CMD_BIND_RENDER_TARGET);
+  if (!c)
+    return;
+  c->render_target.pool = pool;
+  c->render_target.color = color;
+  c->render_target.depth = depth;
+  c->render_target.color_desc = (RenderTargetDesc){width, height, 0};
+  if (color != RENDER_TARGET_NONE)
+    c->render_target.color_desc = pool->descs[color];
+  if (depth != RENDER_TARGET_NONE)
+    c->render_target.depth_desc = pool->descs[depth];
+}
+
+void RenderCmdBindRenderTargetTexture(RenderCommandList *list, RenderTargetPool *pool, GLenum unit,
+                                      RenderTargetHandle target) {
+  RenderCommand *c = RenderCommandPush(list, RENDER_CMD_BIND_RENDER_TARGET_TEXTURE);
+  if (c) {
+    c->render_target.pool = pool;
+    c->render_target.color = target;
+    c->render_target.unit = unit;
+    c->render_target.color_desc = pool->descs[target];
+  }
+}
+
+// ---- Replay ---------------------------------------------------------------------------------
+
+// (Re)allocates a slot's texture when the description recorded for it has changed
+static GLuint realize(RenderTargetPool *pool, RenderTargetHandle target, const RenderTargetDesc *desc) {
+  RenderTargetStorage *storage = &pool->storage[target];
+  if (storage->texture && RenderTargetDescEqual(&storage->desc, desc))
+    return storage->texture;
+  if (storage->texture)
+    pool->bytes -= RenderTargetBytes(&storage->desc);
+  else
+    glGenTextures(1, &storage->texture);
+
+  FormatInfo info = formatInfo(desc->format);
+  glBindTexture(GL_TEXTURE_2D, storage->texture);
+  glTexImage2D(GL_TEXTURE_2D, 0, (GLint)desc->format, desc->width, desc->height, 0, info.format, info.type, NULL);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  storage->desc = *desc;
+  pool->allocations++;
+  pool->bytes += RenderTargetBytes(desc);
+  if (pool->bytes > pool->peak_bytes)
+    pool->peak_bytes = pool->bytes;
+  return storage->texture;
+}
+
+static RenderTargetFramebuffer *framebufferFor(RenderTargetPool *pool, RenderTargetHandle color,
+                                               RenderTargetHandle depth) {
+  for (size_t i = 0; i < pool->framebuffer_count; i++) {
+    RenderTargetFramebuffer *fb = &pool->framebuffers[i];
+    if (fb->color == color && fb->depth == depth)
+      return fb;
+  }
+  // Full: recycle the oldest combination
+  if (pool->framebuffer_count == RENDER_TARGET_MAX_FRAMEBUFFERS) {
+    glDeleteFramebuffers(1, &pool->framebuffers[0].framebuffer);
+    memmove(pool->framebuffers, pool->framebuffers + 1, (pool->framebuffer_count - 1) * sizeof(pool->framebuffers[0]));
+    pool->framebuffer_count--;
+  }
+  RenderTargetFramebuffer *fb = &pool->framebuffers[pool->framebuffer_count++];
+  *fb = (RenderTargetFramebuffer){color, depth, 0, 0, 0};
+  glGenFramebuffers(1, &fb->framebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, fb->framebuffer);
+  if (color == RENDER_TARGET_NONE) {
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+  }
+  return fb;
+}
+
+void RenderTargetPoolBind(RenderTargetPool *pool, RenderTargetHandle color, const RenderTargetDesc *color_desc,
+                          RenderTargetHandle depth, const RenderTargetDesc *depth_desc) {
+  if (color == RENDER_TARGET_NONE && depth == RENDER_TARGET_NONE) {
+    glBindFramebuffer(GL_FRAMEBUFFER, pool->backbuffer);
+    glViewport(0, 0, color_desc->width, color_desc->height);
+    return;
+  }
+  GLuint color_texture = color != RENDER_TARGET_NONE ? realize(pool, color, color_desc) : 0;
+  GLuint depth_texture = depth != RENDER_TARGET_NONE ? realize(pool, depth, depth_desc) : 0;
+  RenderTargetFramebuffer *fb = framebufferFor(pool, color, depth);
+  glBindFramebuffer(GL_FRAMEBUFFER, fb->framebuffer);
+  bool changed = false;
+  if (fb->color_texture != color_texture) {
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color_texture, 0);
+    fb->color_texture = color_texture;
+    changed = true;
+  }
+  if (fb->depth_texture != depth_texture) {
+    GLenum attachment = depth_desc->format == GL_DEPTH24_STENCIL8 || depth_desc->format == GL_DEPTH32F_STENCIL8
+                            ? GL_DEPTH_STENCIL_ATTACHMENT
+                            : GL_DEPTH_ATTACHMENT;
+    glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, depth_texture, 0);
+    fb->depth_texture = depth_texture;
+    changed = true;
+  }
+  if (changed && glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    printf("Render target: framebuffer %u is incomplete\n", fb->framebuffer);
+
+  const RenderTargetDesc *size = color != RENDER_TARGET_NONE ? color_desc : depth_desc;
+  glViewport(0, 0, size->width, size->height);
+}
+
+void RenderTargetPoolBindTexture(RenderTargetPool *pool, RenderTargetHandle target, const RenderTargetDesc *desc) {
+  glBindTexture(GL_TEXTURE_2D, realize(pool, target, desc));
+}
+
+void RenderTargetPoolEvict(RenderTargetPool *pool, RenderTargetHandle target) {
+  RenderTargetStorage *storage = &pool->storage[target];
+  if (!storage->texture)
+    return;
+  for (size_t i = 0; i < pool->framebuffer_count;) {
+    RenderTargetFramebuffer *fb = &pool->framebuffers[i];
+    if (fb->color == target || fb->depth == target) {
+      glDeleteFramebuffers(1, &fb->framebuffer);
+      *fb = pool->framebuffers[--pool->framebuffer_count];
+    } else {
+      i++;
+    }
+  }
+  glDeleteTextures(1, &storage->texture);
+  pool->bytes -= RenderTargetBytes(&storage->desc);
+  memset(storage, 0, sizeof(*storage));
+}
+
+void RenderTargetPoolPrintStats(const RenderTargetPool *pool) {
+  if (pool->acquires == 0)
+    return;
+  size_t slots = 0;
+  for (size_t s = 0; s < RENDER_TARGET_MAX; s++)
+    slots += pool->storage[s].texture != 0;
+  printf("Render targets: %zu slots, %.1f MiB (peak %.1f MiB), %zu allocations, %zu of %zu acquires aliased\n", slots,
+         (double)pool->bytes / (1024.0 * 1024.0), (double)pool->peak_bytes / (1024.0 * 1024.0), pool->allocations,
+         pool->reuses, pool->acquires);
+}
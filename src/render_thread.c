@@ -0,0 +1,120 @@
+#include "render_thread.h"
+#include <stdio.h>
+#include <string.h>
+
+static void present(RenderThread *renderer, const RenderCommandList *list) {
+  RenderCommandListExecute(list);
+  FramePacerLimit(renderer->pacer);
+  glfwSwapBuffers(renderer->window);
+  FramePacerPresented(renderer->pacer, list->input_time);
+}
+
+static void *renderThreadMain(void *arg) {
+  RenderThread *renderer = arg;
+  glfwMakeContextCurrent(renderer->window);
+
+  pthread_mutex_lock(&renderer->mutex);
+  for (;;) {
+    while (renderer->pending < 0 && !renderer->quit)
+      pthread_cond_wait(&renderer->cond, &renderer->mutex);
+    if (renderer->pending < 0)
+      break; // quit with nothing left to draw
+
+    renderer->replaying = renderer->pending;
+    renderer->pending = -1;
+    pthread_cond_broadcast(&renderer->cond);
+    pthread_mutex_unlock(&renderer->mutex);
+
+    present(renderer, &renderer->lists[renderer->replaying]);
+
+    pthread_mutex_lock(&renderer->mutex);
+    renderer->replaying = -1;
+    renderer->frames++;
+    pthread_cond_broadcast(&renderer->cond);
+  }
+  pthread_mutex_unlock(&renderer->mutex);
+
+  glfwMakeContextCurrent(NULL);
+  return NULL;
+}
+
+bool RenderThreadStart(RenderThread *renderer, GLFWwindow *window, FramePacer *pacer, bool threaded) {
+  memset(renderer, 0, sizeof(*renderer));
+  renderer->window = window;
+  renderer->pacer = pacer;
+  renderer->threaded = threaded;
+  renderer->pending = -1;
+  renderer->replaying = -1;
+  if (!RenderCommandListInit(&renderer->lists[0], 256))
+    return false;
+  if (!RenderCommandListInit(&renderer->lists[1], 256)) {
+    RenderCommandListDestroy(&renderer->lists[0]);
+    return false;
+  }
+  if (!threaded)
+    return true;
+
+  pthread_mutex_init(&renderer->mutex, NULL);
+  pthread_cond_init(&renderer->cond, NULL);
+  glfwMakeContextCurrent(NULL);
+  if (pthread_create(&renderer->thread, NULL, renderThreadMain, renderer) != 0) {
+    glfwMakeContextCurrent(window);
+    renderer->threaded = false;
+    printf("Failed to start render thread, rendering inline\n");
+  }
+  return true;
+}
+
+void RenderThreadStop(RenderThread *renderer) {
+  if (renderer->threaded) {
+    pthread_mutex_lock(&renderer->mutex);
+    renderer->quit = true;
+    pthread_cond_broadcast(&renderer->cond);
+    pthread_mutex_unlock(&renderer->mutex);
+    pthread_join(renderer->thread, NULL);
+    pthread_cond_destroy(&renderer->cond);
+    pthread_mutex_destroy(&renderer->mutex);
+    glfwMakeContextCurrent(renderer->window);
+  }
+  RenderCommandListDestroy(&renderer->lists[0]);
+  RenderCommandListDestroy(&renderer->lists[1]);
+}
+
+RenderCommandList *RenderThreadBeginFrame(RenderThread *renderer) {
+  RenderCommandList *list = &renderer->lists[renderer->recording];
+  if (renderer->threaded) {
+    // The list may still be replaying from two frames ago
+    double start = glfwGetTime();
+    pthread_mutex_lock(&renderer->mutex);
+    while (renderer->replaying == renderer->recording)
+      pthread_cond_wait(&renderer->cond, &renderer->mutex);
+    pthread_mutex_unlock(&renderer->mutex);
+    renderer->submit_wait += glfwGetTime() - start;
+  }
+  RenderCommandListReset(list);
+  return list;
+}
+
+void RenderThreadSubmit(RenderThread *renderer) {
+  if (!renderer->threaded) {
+    present(renderer, &renderer->lists[renderer->recording]);
+    renderer->frames++;
+    return;
+  }
+
+  // Simulation may run at most one frame ahead of the render thread
+  double start = glfwGetTime();
+  pthread_mutex_lock(&renderer->mutex);
+  while (renderer->pending >= 0)
+    pthread_cond_wait(&renderer->cond, &renderer->mutex);
+  renderer->pending = renderer->recording;
+  renderer->recording ^= 1;
+  pthread_cond_broadcast(&renderer->cond);
+  pthread_mutex_unlock(&renderer->mutex);
+  renderer->submit_wait += glfwGetTime() - start;
+}
+
+void RenderThreadPrintStats(const RenderThread *renderer) {
+  printf("Renderer: %s, %zu frames presented, recording thread waited %.2f ms total\n",
+         renderer->threaded ? "threaded" : "inline", renderer->frames, 1000.0 * renderer->submit_wait);
+}
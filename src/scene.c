@@ -0,0 +1,177 @@
+#include "scene.h"
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t entityIndex(EntityId id) { return (uint32_t)id & ENTITY_INDEX_MASK; }
+static uint32_t entityGeneration(EntityId id) { return (uint32_t)(id >> ENTITY_GENERATION_SHIFT); }
+static EntityId makeEntity(uint32_t index, uint32_t generation) {
+  return ((EntityId)generation << ENTITY_GENERATION_SHIFT) | index;
+}
+
+bool SceneInit(Scene *scene, size_t capacity) {
+  memset(scene, 0, sizeof(*scene));
+  if (capacity > SCENE_MAX_ENTITIES)
+    return false;
+  scene->capacity = capacity;
+
+  float **fields[] = {&scene->transform.px, &scene->transform.py, &scene->transform.pz, &scene->transform.qx,
+                      &scene->transform.qy, &scene->transform.qz, &scene->transform.qw, &scene->transform.sx,
+                      &scene->transform.sy, &scene->transform.sz};
+  bool ok = true;
+  for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++)
+    ok &= (*fields[i] = malloc(capacity * sizeof(float))) != NULL;
+  // aligned_alloc wants a size that is a multiple of the alignment, which Mat4 always is
+  ok &= (scene->world = aligned_alloc(_Alignof(Mat4), (capacity ? capacity : 1) * sizeof(Mat4))) != NULL;
+  ok &= (scene->mesh = malloc(capacity * sizeof(MeshHandle))) != NULL;
+  ok &= (scene->material = malloc(capacity * sizeof(MaterialHandle))) != NULL;
+  ok &= (scene->visibility = malloc(capacity * sizeof(uint32_t))) != NULL;
+  ok &= (scene->entity = malloc(capacity * sizeof(EntityId))) != NULL;
+  ok &= (scene->slot_of = malloc(capacity * sizeof(uint32_t))) != NULL;
+  ok &= (scene->generation = calloc(capacity ? capacity : 1, sizeof(uint32_t))) != NULL;
+  ok &= (scene->free_indices = malloc(capacity * sizeof(uint32_t))) != NULL;
+  if (!ok) {
+    SceneDestroy(scene);
+    return false;
+  }
+  return true;
+}
+
+void SceneDestroy(Scene *scene) {
+  float *fields[] = {scene->transform.px, scene->transform.py, scene->transform.pz, scene->transform.qx,
+                     scene->transform.qy, scene->transform.qz, scene->transform.qw, scene->transform.sx,
+                     scene->transform.sy, scene->transform.sz};
+  for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++)
+    free(fields[i]);
+  free(scene->world);
+  free(scene->mesh);
+  free(scene->material);
+  free(scene->visibility);
+  free(scene->entity);
+  free(scene->slot_of);
+  free(scene->generation);
+  free(scene->free_indices);
+  memset(scene, 0, sizeof(*scene));
+}
+
+EntityId SceneCreateEntity(Scene *scene) {
+  if (scene->count == scene->capacity)
+    return ENTITY_NONE;
+
+  uint32_t index = scene->free_count > 0 ? scene->free_indices[--scene->free_count] : (uint32_t)scene->next_index++;
+  EntityId id = makeEntity(index, scene->generation[index]);
+  size_t slot = scene->count++;
+  scene->slot_of[index] = (uint32_t)slot;
+  scene->entity[slot] = id;
+
+  TransformSoA *t = &scene->transform;
+  t->px[slot] = t->py[slot] = t->pz[slot] = 0.0f;
+  t->qx[slot] = t->qy[slot] = t->qz[slot] = 0.0f;
+  t->qw[slot] = 1.0f;
+  t->sx[slot] = t->sy[slot] = t->sz[slot] = 1.0f;
+  scene->world[slot] = Mat4Identity();
+  scene->mesh[slot] = 0;
+  scene->material[slot] = 0;
+  scene->visibility[slot] = VISIBILITY_VISIBLE;
+  return id;
+}
+
+bool SceneAlive(const Scene *scene, EntityId id) {
+  uint32_t index = entityIndex(id);
+  return id != ENTITY_NONE && index < scene->next_index && scene->generation[index] == entityGeneration(id) &&
+         scene->slot_of[index] < scene->count && scene->entity[scene->slot_of[index]] == id;
+}
+
+size_t SceneSlot(const Scene *scene, EntityId id) {
+  return SceneAlive(scene, id) ? scene->slot_of[entityIndex(id)] : SIZE_MAX;
+}
+
+bool SceneDestroyEntity(Scene *scene, EntityId id) {
+  size_t slot = SceneSlot(scene, id);
+  if (slot == SIZE_MAX)
+    return false;
+
+  // Swap-remove: the last entity takes over the freed slot
+  size_t last = --scene->count;
+  if (slot != last) {
+    TransformSoA *t = &scene->transform;
+    float *fields[] = {t->px, t->py, t->pz, t->qx, t->qy, t->qz, t->qw, t->sx, t->sy, t->sz};
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++)
+      fields[i][slot] = fields[i][last];
+    scene->world[slot] = scene->world[last];
+    scene->mesh[slot] = scene->mesh[last];
+    scene->material[slot] = scene->material[last];
+    scene->visibility[slot] = scene->visibility[last];
+    scene->entity[slot] = scene->entity[last];
+    scene->slot_of[entityIndex(scene->entity[slot])] = (uint32_t)slot;
+  }
+
+  uint32_t index = entityIndex(id);
+  scene->generation[index]++;
+  scene->free_indices[scene->free_count++] = index;
+  return true;
+}
+
+void SceneSetTransform(Scene *scene, EntityId id, Vec3 position, Quat rotation, Vec3 scale) {
+  size_t slot = SceneSlot(scene, id);
+  if (slot == SIZE_MAX)
+    return;
+  TransformSoA *t = &scene->transform;
+  t->px[slot] = position.x;
+  t->py[slot] = position.y;
+  t->pz[slot] = position.z;
+  t->qx[slot] = rotation.x;
+  t->qy[slot] = rotation.y;
+  t->qz[slot] = rotation.z;
+  t->qw[slot] = rotation.w;
+  t->sx[slot] = scale.x;
+  t->sy[slot] = scale.y;
+  t->sz[slot] = scale.z;
+}
+
+void SceneSetMesh(Scene *scene, EntityId id, MeshHandle mesh) {
+  size_t slot = SceneSlot(scene, id);
+  if (slot != SIZE_MAX)
+    scene->mesh[slot] = mesh;
+}
+
+void SceneSetMaterial(Scene *scene, EntityId id, MaterialHandle material) {
+  size_t slot = SceneSlot(scene, id);
+  if (slot != SIZE_MAX)
+    scene->material[slot] = material;
+}
+
+MaterialHandle SceneGetMaterial(const Scene *scene, EntityId id) {
+  size_t slot = SceneSlot(scene, id);
+  return slot != SIZE_MAX ? scene->material[slot] : 0;
+}
+
+void SceneSetVisibility(Scene *scene, EntityId id, uint32_t visibility) {
+  size_t slot = SceneSlot(scene, id);
+  if (slot != SIZE_MAX)
+    scene->visibility[slot] = visibility;
+}
+
+uint32_t SceneGetVisibility(const Scene *scene, EntityId id) {
+  size_t slot = SceneSlot(scene, id);
+  return slot != SIZE_MAX ? scene->visibility[slot] : 0;
+}
+
+void SceneUpdateTransformsRange(void *data, size_t begin, size_t end) {
+  Scene *scene = data;
+  TransformSoA *t = &scene->transform;
+  TransformSoA range = {t->px + begin, t->py + begin, t->pz + begin, t->qx + begin, t->qy + begin,
+                        t->qz + begin, t->qw + begin, t->sx + begin, t->sy + begin, t->sz + begin};
+  Mat4ComposeSoA(&range, scene->world + begin, end - begin);
+}
+
+void SceneUpdateTransforms(Scene *scene) { SceneUpdateTransformsRange(scene, 0, scene->count); }
+
+size_t SceneCollectVisible(const Scene *scene, uint32_t mask, uint32_t *slots) {
+  size_t visible = 0;
+  for (size_t i = 0; i < scene->count; i++) {
+    // Branchless append keeps the sweep free of mispredictions on mixed visibility
+    slots[visible] = (uint32_t)i;
+    visible += (scene->visibility[i] & mask) != 0;
+  }
+  return visible;
+}
@@ -1,4 +1,5 @@
 #include "shaders.h"
+#include "arena.h"
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -10,7 +11,7 @@ ShaderLoadResult ShaderLoadFromDisk(const char *vertex_path, const char *fragmen
   fseek(file, 0, SEEK_END);
   long vertex_length = ftell(file);
   rewind(file);
-  char *vertex_source = malloc(vertex_length + 1);
+  char *vertex_source = ArenaScratchAlloc(vertex_length + 1);
   if (!vertex_source) {
     fclose(file);
     return FAILED_VERTEX_NOT_FOUND;
@@ -22,15 +23,15 @@ ShaderLoadResult ShaderLoadFromDisk(const char *vertex_path, const char *fragmen
   // Read fragment shader file
   file = fopen(fragment_path, "rb");
   if (!file) {
-    free(vertex_source);
+    ArenaScratchFree(vertex_source);
     return FAILED_FRAGMENT_NOT_FOUND;
   }
   fseek(file, 0, SEEK_END);
   long fragment_length = ftell(file);
   rewind(file);
-  char *fragment_source = malloc(fragment_length + 1);
+  char *fragment_source = ArenaScratchAlloc(fragment_length + 1);
   if (!fragment_source) {
-    free(vertex_source);
+    ArenaScratchFree(vertex_source);
     fclose(file);
     return FAILED_FRAGMENT_NOT_FOUND;
   }
@@ -38,39 +39,43 @@ ShaderLoadResult ShaderLoadFromDisk(const char *vertex_path, const char *fragmen
   fragment_source[fragment_length] = '\0';
   fclose(file);
 
+  ShaderLoadResult result =
+      ShaderLoadFromMemory(vertex_source, vertex_length, fragment_source, fragment_length, shader_output);
+  // A bound arena only rolls back the fragment source, its latest allocation; the vertex source
+  // stays until the arena is reset
+  ArenaScratchFree(fragment_source);
+  ArenaScratchFree(vertex_source);
+  return result;
+}
+
+ShaderLoadResult ShaderLoadFromMemory(const char *vertex_source, GLint vertex_length, const char *fragment_source,
+                                      GLint fragment_length, GLuint *shader_output) {
   // Compile vertex shader
   GLuint vertex_shader = glCreateShader(GL_VERTEX_SHADER);
   *shader_output = vertex_shader;
-  glShaderSource(vertex_shader, 1, (const char **)&vertex_source, NULL);
+  glShaderSource(vertex_shader, 1, &vertex_source, &vertex_length);
   glCompileShader(vertex_shader);
 
   GLint success = 0;
   glGetShaderiv(vertex_shader, GL_COMPILE_STATUS, &success);
   if (!success) {
     glDeleteShader(vertex_shader);
-    free(vertex_source);
-    free(fragment_source);
     return FAILED_COMPILE_VERTEX;
   }
 
   // Compile fragment shader
   GLuint fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
   *shader_output = fragment_shader;
-  glShaderSource(fragment_shader, 1, (const char **)&fragment_source, NULL);
+  glShaderSource(fragment_shader, 1, &fragment_source, &fragment_length);
   glCompileShader(fragment_shader);
 
   glGetShaderiv(fragment_shader, GL_COMPILE_STATUS, &success);
   if (!success) {
     glDeleteShader(vertex_shader);
     glDeleteShader(fragment_shader);
-    free(vertex_source);
-    free(fragment_source);
     return FAILED_COMPILE_FRAGMENT;
   }
 
-  free(vertex_source);
-  free(fragment_source);
-
   // Link shaders into a program
   GLuint program = glCreateProgram();
   glAttachShader(program, vertex_shader);
@@ -92,6 +97,54 @@ ShaderLoadResult ShaderLoadFromDisk(const char *vertex_path, const char *fragmen
   return SUCCESS;
 }
 
+static const char *packSource(const PackEntry *entry, char **owned) {
+  *owned = NULL;
+  if (entry->codec == PACK_CODEC_NONE)
+    return entry->data;
+  *owned = ArenaScratchAlloc(entry->size);
+  if (!*owned || PackDecompress(entry, *owned, entry->size) != PACK_SUCCESS) {
+    ArenaScratchFree(*owned);
+    *owned = NULL;
+    return NULL;
+  }
+  return *owned;
+}
+
+ShaderLoadResult ShaderLoadFromPack(const Pack *pack, const char *vertex_path, const char *fragment_path,
+                                    GLuint *shader_output) {
+  PackEntry vertex_entry, fragment_entry;
+  if (PackFind(pack, vertex_path, &vertex_entry) != PACK_SUCCESS)
+    return FAILED_VERTEX_NOT_FOUND;
+  if (PackFind(pack, fragment_path, &fragment_entry) != PACK_SUCCESS)
+    return FAILED_FRAGMENT_NOT_FOUND;
+
+  // Uncompressed sources are handed to the driver straight from the mapping
+  char *vertex_owned, *fragment_owned;
+  const char *vertex_source = packSource(&vertex_entry, &vertex_owned);
+  if (!vertex_source)
+    return FAILED_VERTEX_NOT_FOUND;
+  const char *fragment_source = packSource(&fragment_entry, &fragment_owned);
+  if (!fragment_source) {
+    ArenaScratchFree(vertex_owned);
+    return FAILED_FRAGMENT_NOT_FOUND;
+  }
+
+  ShaderLoadResult result = ShaderLoadFromMemory(vertex_source, (GLint)vertex_entry.size, fragment_source,
+                                                 (GLint)fragment_entry.size, shader_output);
+  ArenaScratchFree(fragment_owned);
+  ArenaScratchFree(vertex_owned);
+  return result;
+}
+
+// The shaders stay attached after ShaderLoadFromMemory deletes them, so the program can link again
+ShaderLoadResult ShaderCaptureVaryings(GLuint program, const char *const *varyings, GLsizei count) {
+  glTransformFeedbackVaryings(program, count, varyings, GL_INTERLEAVED_ATTRIBS);
+  glLinkProgram(program);
+  GLint success = 0;
+  glGetProgramiv(program, GL_LINK_STATUS, &success);
+  return success ? SUCCESS : FAILED_LINKAGE;
+}
+
 void PrintShaderCompilationError(GLuint shader_handle) {
   GLint length = 0;
   glGetShaderiv(shader_handle, GL_INFO_LOG_LENGTH, &length);
@@ -0,0 +1,140 @@
+#include "texture_atlas.h"
+#include <stdio.h>
+#include <string.h>
+
+static GLint alignUp(GLint value, GLint alignment) { return (value + alignment - 1) / alignment * alignment; }
+
+// Storage starts out undefined, and filtering and mips reach past the padding into it
+static void clearLayers(const TextureAtlas *atlas) {
+  GLfloat clear_color[4];
+  GLint previous;
+  glGetFloatv(GL_COLOR_CLEAR_VALUE, clear_color);
+  glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous);
+  GLuint framebuffer;
+  glGenFramebuffers(1, &framebuffer);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+  glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+  for (GLint level = 0; level <= atlas->max_level; level++) {
+    for (GLint layer = 0; layer < atlas->layers; layer++) {
+      glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, atlas->texture, level, layer);
+      glClear(GL_COLOR_BUFFER_BIT);
+    }
+  }
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, (GLuint)previous);
+  glDeleteFramebuffers(1, &framebuffer);
+  glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
+}
+
+bool TextureAtlasInit(TextureAtlas *atlas, GLsizei width, GLsizei height, GLsizei layers, GLint padding) {
+  memset(atlas, 0, sizeof(*atlas));
+  if (layers < 1 || layers > ATLAS_MAX_LAYERS || padding < 1 || (padding & (padding - 1)) != 0)
+    return false;
+  atlas->width = width;
+  atlas->height = height;
+  atlas->layers = layers;
+  atlas->padding = padding;
+  while ((1 << (atlas->max_level + 1)) <= padding)
+    atlas->max_level++;
+
+  glGenTextures(1, &atlas->texture);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, atlas->texture);
+  for (GLint level = 0; level <= atlas->max_level; level++) {
+    GLsizei w = width >> level, h = height >> level;
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, w > 0 ? w : 1, h > 0 ? h : 1, layers, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, NULL);
+  }
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, atlas->max_level);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+  clearLayers(atlas);
+  // The loader context writes into this texture. Another context only sees it once the commands
+  // creating and clearing it have completed, which a flush does not wait for.
+  glFinish();
+  return glGetError() == GL_NO_ERROR;
+}
+
+void TextureAtlasDestroy(TextureAtlas *atlas) {
+  if (atlas->texture)
+    glDeleteTextures(1, &atlas->texture);
+  memset(atlas, 0, sizeof(*atlas));
+}
+
+bool TextureAtlasPack(TextureAtlas *atlas, GLsizei width, GLsizei height, AtlasRegion *region) {
+  GLint pad = atlas->padding;
+  GLsizei slot_width = alignUp(width + 2 * pad, pad), slot_height = alignUp(height + 2 * pad, pad);
+  if (slot_width > atlas->width || slot_height > atlas->height)
+    return false;
+
+  for (GLint layer = 0; layer < atlas->layers; layer++) {
+    AtlasPage *page = &atlas->pages[layer];
+
+    // Best fit: the lowest existing shelf that is tall enough and has room
+    AtlasShelf *best = NULL;
+    for (size_t s = 0; s < page->shelf_count; s++) {
+      AtlasShelf *shelf = &page->shelves[s];
+      if (shelf->height >= slot_height && shelf->x + slot_width <= atlas->width &&
+          (!best || shelf->height < best->height))
+        best = shelf;
+    }
+    if (!best && page->shelf_count < ATLAS_MAX_SHELVES && page->next_y + slot_height <= atlas->height) {
+      best = &page->shelves[page->shelf_count++];
+      *best = (AtlasShelf){page->next_y, slot_height, 0};
+      page->next_y += slot_height;
+    }
+    if (!best)
+      continue;
+
+    region->layer = layer;
+    region->x = best->x + pad;
+    region->y = best->y + pad;
+    region->width = width;
+    region->height = height;
+    region->uv[0] = (float)region->x / (float)atlas->width;
+    region->uv[1] = (float)region->y / (float)atlas->height;
+    region->uv[2] = (float)(region->x + width) / (float)atlas->width;
+    region->uv[3] = (float)(region->y + height) / (float)atlas->height;
+    best->x += slot_width;
+    atlas->regions++;
+    atlas->used_area += (size_t)width * (size_t)height;
+    return true;
+  }
+  return false;
+}
+
+bool TextureAtlasAdd(TextureAtlas *atlas, Uploader *uploader, UploadRequest *request, GLsizei width, GLsizei height,
+                     GLenum format, AtlasRegion *region) {
+  if (!TextureAtlasPack(atlas, width, height, region))
+    return false;
+  request->kind = UPLOAD_TEXTURE_REGION;
+  request->object = atlas->texture;
+  request->region.target = GL_TEXTURE_2D_ARRAY;
+  request->region.x = region->x;
+  request->region.y = region->y;
+  request->region.layer = region->layer;
+  request->region.width = width;
+  request->region.height = height;
+  request->region.format = format;
+  request->region.type = GL_UNSIGNED_BYTE;
+  request->region.padding = atlas->padding;
+  return UploaderSubmit(uploader, request);
+}
+
+bool TextureAtlasGenerateMipmaps(TextureAtlas *atlas, Uploader *uploader, UploadRequest *request) {
+  memset(request, 0, sizeof(*request));
+  request->kind = UPLOAD_MIPMAPS;
+  request->object = atlas->texture;
+  request->mipmaps.target = GL_TEXTURE_2D_ARRAY;
+  return UploaderSubmit(uploader, request);
+}
+
+void TextureAtlasPrintStats(const TextureAtlas *atlas) {
+  size_t used_layers = 0;
+  for (GLsizei layer = 0; layer < atlas->layers; layer++)
+    used_layers += atlas->pages[layer].shelf_count > 0;
+  double capacity = (double)atlas->width * (double)atlas->height * (double)(used_layers ? used_layers : 1);
+  printf("Texture atlas: %zu images on %zu of %d %dx%d layers, %.1f%% of used layers filled\n", atlas->regions,
+         used_layers, atlas->layers, atlas->width, atlas->height, 100.0 * (double)atlas->used_area / capacity);
+}
@@ -0,0 +1,101 @@
+#include "uniform_ring.h"
+#include "render_commands.h"
+#include <stdio.h>
+#include <string.h>
+
+bool UniformRingInit(UniformRing *ring, GLuint binding, GLsizeiptr block_size) {
+  memset(ring, 0, sizeof(*ring));
+  ring->binding = binding;
+  ring->block_size = block_size;
+  return block_size > 0 && block_size <= UNIFORM_RING_MAX_BLOCK;
+}
+
+void UniformRingDestroy(UniformRing *ring) {
+  for (size_t i = 0; i < UNIFORM_RING_FRAMES; i++) {
+    if (ring->fences[i])
+      glDeleteSync(ring->fences[i]);
+    ring->fences[i] = 0;
+  }
+  glDeleteBuffers(1, &ring->buffer);
+  ring->buffer = 0;
+}
+
+bool UniformRingBindProgram(const UniformRing *ring, GLuint program, const char *name) {
+  GLuint index = glGetUniformBlockIndex(program, name);
+  if (index == GL_INVALID_INDEX)
+    return false;
+  glUniformBlockBinding(program, index, ring->binding);
+  return true;
+}
+
+static bool createBuffer(UniformRing *ring) {
+  GLint alignment = 256;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+  if (alignment < 1)
+    alignment = 256;
+  ring->stride = (ring->block_size + alignment - 1) / alignment * alignment;
+  glGenBuffers(1, &ring->buffer);
+  glBindBuffer(GL_UNIFORM_BUFFER, ring->buffer);
+  glBufferData(GL_UNIFORM_BUFFER, ring->stride * UNIFORM_RING_FRAMES, NULL, GL_STREAM_DRAW);
+  return ring->buffer != 0;
+}
+
+void UniformRingUpdate(UniformRing *ring, const void *block) {
+  if (!ring->buffer && !createBuffer(ring))
+    return;
+  // Every draw that read the previous section has been issued by now
+  if (ring->updates > 0) {
+    size_t previous = (ring->next + UNIFORM_RING_FRAMES - 1) % UNIFORM_RING_FRAMES;
+    ring->fences[previous] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  }
+  size_t section = ring->next;
+  ring->next = (ring->next + 1) % UNIFORM_RING_FRAMES;
+  GLsync fence = ring->fences[section];
+  if (fence) {
+    if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+      ring->stalls++;
+      glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+    }
+    glDeleteSync(fence);
+    ring->fences[section] = 0;
+  }
+
+  GLintptr offset = (GLintptr)section * ring->stride;
+  glBindBuffer(GL_UNIFORM_BUFFER, ring->buffer);
+  void *mapped = glMapBufferRange(GL_UNIFORM_BUFFER, offset, ring->block_size,
+                                  GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+  if (mapped) {
+    memcpy(mapped, block, (size_t)ring->block_size);
+    glUnmapBuffer(GL_UNIFORM_BUFFER);
+  } else {
+    glBufferSubData(GL_UNIFORM_BUFFER, offset, ring->block_size, block);
+  }
+  glBindBufferRange(GL_UNIFORM_BUFFER, ring->binding, ring->buffer, offset, ring->block_size);
+  ring->updates++;
+}
+
+// A frame's block, copied into the command list when it is recorded
+typedef struct UpdateCommand {
+  UniformRing *ring;
+  unsigned char block[UNIFORM_RING_MAX_BLOCK];
+} UpdateCommand;
+
+_Static_assert(sizeof(UpdateCommand) <= RENDER_CMD_PAYLOAD_SIZE, "a block must fit a callback payload");
+
+static void replayUpdate(const void *payload) {
+  const UpdateCommand *command = payload;
+  UniformRingUpdate(command->ring, command->block);
+}
+
+void UniformRingRecordUpdate(UniformRing *ring, RenderCommandList *list, const void *block) {
+  UpdateCommand *command = RenderCmdCallback(list, replayUpdate, sizeof(*command));
+  if (command) {
+    command->ring = ring;
+    memcpy(command->block, block, (size_t)ring->block_size);
+  }
+}
+
+void UniformRingPrintStats(const UniformRing *ring) {
+  printf("Uniform ring: %zu updates of %ld bytes in %d sections of %ld, %zu stalls\n", ring->updates,
+         (long)ring->block_size, UNIFORM_RING_FRAMES, (long)ring->stride, ring->stalls);
+}
@@ -0,0 +1,195 @@
+#include "uploader.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static size_t formatChannels(GLenum format) {
+  switch (format) {
+  case GL_RED:
+    return 1;
+  case GL_RG:
+    return 2;
+  case GL_RGB:
+    return 3;
+  default:
+    return 4;
+  }
+}
+
+// Copies the image into the middle of one `padding` texels larger on every side, repeating its
+// edge texels outwards, so filtering past the edge and the mips built from it see the image
+static unsigned char *extrude(const unsigned char *pixels, GLsizei width, GLsizei height, size_t channels,
+                              GLint padding) {
+  size_t pad = (size_t)padding, row = (size_t)width * channels;
+  size_t padded_width = (size_t)width + 2 * pad, padded_height = (size_t)height + 2 * pad;
+  unsigned char *padded = malloc(padded_width * padded_height * channels);
+  if (!padded)
+    return NULL;
+  for (size_t y = 0; y < padded_height; y++) {
+    size_t source_y = y < pad ? 0 : y - pad < (size_t)height ? y - pad : (size_t)height - 1;
+    const unsigned char *source = pixels + source_y * row;
+    unsigned char *target = padded + y * padded_width * channels;
+    for (size_t x = 0; x < pad; x++) {
+      memcpy(target + x * channels, source, channels);
+      memcpy(target + (pad + (size_t)width + x) * channels, source + row - channels, channels);
+    }
+    memcpy(target + pad * channels, source, row);
+  }
+  return padded;
+}
+
+static void uploadRegion(UploadRequest *request) {
+  GLint x = request->region.x, y = request->region.y, pad = request->region.padding;
+  GLsizei width = request->region.width, height = request->region.height;
+  const void *pixels = request->data;
+  unsigned char *padded = NULL;
+  if (pad > 0 && request->region.type == GL_UNSIGNED_BYTE)
+    padded = extrude(pixels, width, height, formatChannels(request->region.format), pad);
+  if (padded) {
+    pixels = padded;
+    x -= pad;
+    y -= pad;
+    width += 2 * pad;
+    height += 2 * pad;
+  }
+  glBindTexture(request->region.target, request->object);
+  // Rows of RGB images are not necessarily 4-byte aligned
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage3D(request->region.target, 0, x, y, request->region.layer, width, height, 1, request->region.format,
+                  request->region.type, pixels);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glBindTexture(request->region.target, 0);
+  free(padded);
+}
+
+static void upload(Uploader *uploader, UploadRequest *request) {
+  double start = glfwGetTime();
+  switch (request->kind) {
+  case UPLOAD_TEXTURE_2D:
+    glGenTextures(1, &request->object);
+    glBindTexture(GL_TEXTURE_2D, request->object);
+    glTexImage2D(GL_TEXTURE_2D, 0, request->texture.internal_format, request->texture.width, request->texture.height,
+                 0, request->texture.format, request->texture.type, request->data);
+    if (request->texture.mipmaps)
+      glGenerateMipmap(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    break;
+  case UPLOAD_BUFFER:
+    glGenBuffers(1, &request->object);
+    glBindBuffer(request->buffer.target, request->object);
+    glBufferData(request->buffer.target, request->buffer.size, request->data, request->buffer.usage);
+    glBindBuffer(request->buffer.target, 0);
+    break;
+  case UPLOAD_TEXTURE_REGION:
+    uploadRegion(request);
+    break;
+  case UPLOAD_MIPMAPS:
+    glBindTexture(request->mipmaps.target, request->object);
+    glGenerateMipmap(request->mipmaps.target);
+    glBindTexture(request->mipmaps.target, 0);
+    break;
+  }
+
+  // The fence has to reach the GPU before another context can wait on it
+  request->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  glFlush();
+  if (request->release)
+    request->release(request->user);
+
+  uploader->uploads++;
+  uploader->upload_time += glfwGetTime() - start;
+  atomic_store_explicit(&request->state, glGetError() == GL_NO_ERROR ? UPLOAD_READY : UPLOAD_FAILED,
+                        memory_order_release);
+}
+
+static void *uploaderMain(void *arg) {
+  Uploader *uploader = arg;
+  glfwMakeContextCurrent(uploader->context);
+
+  pthread_mutex_lock(&uploader->mutex);
+  for (;;) {
+    while (uploader->head == uploader->tail && !uploader->quit)
+      pthread_cond_wait(&uploader->cond, &uploader->mutex);
+    if (uploader->head == uploader->tail)
+      break;
+    UploadRequest *request = uploader->queue[uploader->head % UPLOADER_QUEUE_SIZE];
+    uploader->head++;
+    pthread_cond_broadcast(&uploader->cond);
+    pthread_mutex_unlock(&uploader->mutex);
+
+    upload(uploader, request);
+
+    pthread_mutex_lock(&uploader->mutex);
+  }
+  pthread_mutex_unlock(&uploader->mutex);
+
+  glfwMakeContextCurrent(NULL);
+  return NULL;
+}
+
+bool UploaderStart(Uploader *uploader, GLFWwindow *share, bool threaded) {
+  memset(uploader, 0, sizeof(*uploader));
+  if (!threaded)
+    return true;
+
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  uploader->context = glfwCreateWindow(1, 1, "loader", NULL, share);
+  glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+  if (!uploader->context) {
+    printf("Failed to create shared loader context, uploading inline\n");
+    return true;
+  }
+
+  pthread_mutex_init(&uploader->mutex, NULL);
+  pthread_cond_init(&uploader->cond, NULL);
+  if (pthread_create(&uploader->thread, NULL, uploaderMain, uploader) != 0) {
+    printf("Failed to start loader thread, uploading inline\n");
+    pthread_cond_destroy(&uploader->cond);
+    pthread_mutex_destroy(&uploader->mutex);
+    glfwDestroyWindow(uploader->context);
+    uploader->context = NULL;
+    return true;
+  }
+  uploader->threaded = true;
+  return true;
+}
+
+void UploaderStop(Uploader *uploader) {
+  if (!uploader->context)
+    return;
+  pthread_mutex_lock(&uploader->mutex);
+  uploader->quit = true;
+  pthread_cond_broadcast(&uploader->cond);
+  pthread_mutex_unlock(&uploader->mutex);
+  pthread_join(uploader->thread, NULL);
+  pthread_cond_destroy(&uploader->cond);
+  pthread_mutex_destroy(&uploader->mutex);
+  glfwDestroyWindow(uploader->context);
+  uploader->context = NULL;
+}
+
+bool UploaderSubmit(Uploader *uploader, UploadRequest *request) {
+  atomic_store_explicit(&request->state, UPLOAD_PENDING, memory_order_relaxed);
+  if (!uploader->threaded) {
+    upload(uploader, request);
+    return true;
+  }
+
+  pthread_mutex_lock(&uploader->mutex);
+  while (uploader->tail - uploader->head == UPLOADER_QUEUE_SIZE)
+    pthread_cond_wait(&uploader->cond, &uploader->mutex);
+  uploader->queue[uploader->tail % UPLOADER_QUEUE_SIZE] = request;
+  uploader->tail++;
+  pthread_cond_broadcast(&uploader->cond);
+  pthread_mutex_unlock(&uploader->mutex);
+  return true;
+}
+
+UploadState UploadPoll(const UploadRequest *request) {
+  return (UploadState)atomic_load_explicit(&request->state, memory_order_acquire);
+}
+
+void UploaderPrintStats(const Uploader *uploader) {
+  printf("Uploader: %s, %zu uploads, %.2f ms on the %s thread\n", uploader->threaded ? "shared context" : "inline",
+         uploader->uploads, 1000.0 * uploader->upload_time, uploader->threaded ? "loader" : "submitting");
+}
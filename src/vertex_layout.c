@@ -0,0 +1,179 @@
+#include "vertex_layout.h"
+#include <math.h>
+#include <string.h>
+
+typedef struct FormatInfo {
+  GLint components;
+  GLenum type;
+  GLboolean normalized;
+  GLsizei size;
+} FormatInfo;
+
+static const FormatInfo formats[VERTEX_FORMAT_COUNT] = {
+    [VERTEX_FORMAT_FLOAT1] = {1, GL_FLOAT, GL_FALSE, 4},
+    [VERTEX_FORMAT_FLOAT2] = {2, GL_FLOAT, GL_FALSE, 8},
+    [VERTEX_FORMAT_FLOAT3] = {3, GL_FLOAT, GL_FALSE, 12},
+    [VERTEX_FORMAT_FLOAT4] = {4, GL_FLOAT, GL_FALSE, 16},
+    [VERTEX_FORMAT_HALF2] = {2, GL_HALF_FLOAT, GL_FALSE, 4},
+    [VERTEX_FORMAT_HALF4] = {4, GL_HALF_FLOAT, GL_FALSE, 8},
+    [VERTEX_FORMAT_UNORM8X4] = {4, GL_UNSIGNED_BYTE, GL_TRUE, 4},
+    [VERTEX_FORMAT_SNORM8X4] = {4, GL_BYTE, GL_TRUE, 4},
+    [VERTEX_FORMAT_UNORM16X2] = {2, GL_UNSIGNED_SHORT, GL_TRUE, 4},
+    [VERTEX_FORMAT_SNORM16X2] = {2, GL_SHORT, GL_TRUE, 4},
+    [VERTEX_FORMAT_UNORM16X4] = {4, GL_UNSIGNED_SHORT, GL_TRUE, 8},
+    [VERTEX_FORMAT_SNORM16X4] = {4, GL_SHORT, GL_TRUE, 8},
+    [VERTEX_FORMAT_UNORM10_10_10_2] = {4, GL_UNSIGNED_INT_2_10_10_10_REV, GL_TRUE, 4},
+    [VERTEX_FORMAT_SNORM10_10_10_2] = {4, GL_INT_2_10_10_10_REV, GL_TRUE, 4},
+};
+
+GLsizei VertexFormatSize(VertexFormat format) { return formats[format].size; }
+
+int VertexFormatComponents(VertexFormat format) { return formats[format].components; }
+
+void VertexLayoutInit(VertexLayout *layout) { memset(layout, 0, sizeof(*layout)); }
+
+bool VertexLayoutAdd(VertexLayout *layout, GLuint location, VertexFormat format) {
+  if (layout->count == VERTEX_MAX_ATTRIBUTES || format >= VERTEX_FORMAT_COUNT)
+    return false;
+  layout->attributes[layout->count++] = (VertexAttribute){location, format, layout->stride};
+  // every format is a multiple of 4 bytes, so attributes stay aligned
+  layout->stride += formats[format].size;
+  return true;
+}
+
+void VertexLayoutApply(const VertexLayout *layout) {
+  for (size_t i = 0; i < layout->count; i++) {
+    const VertexAttribute *attribute = &layout->attributes[i];
+    const FormatInfo *info = &formats[attribute->format];
+    glVertexAttribPointer(attribute->location, info->components, info->type, info->normalized, layout->stride,
+                          (void *)(size_t)attribute->offset);
+    glEnableVertexAttribArray(attribute->location);
+  }
+}
+
+// Round to nearest even, with overflow to infinity and gradual underflow
+uint16_t VertexFloatToHalf(float value) {
+  union {
+    float f;
+    uint32_t u;
+  } bits = {.f = value}, denorm_magic = {.u = ((127u - 15u) + (23u - 10u) + 1u) << 23};
+  uint32_t sign = bits.u & 0x80000000u;
+  bits.u ^= sign;
+
+  uint16_t half;
+  if (bits.u >= (127u + 16u) << 23) {
+    half = bits.u > 0x7f800000u ? 0x7e00 : 0x7c00;
+  } else if (bits.u < 113u << 23) {
+    bits.f += denorm_magic.f;
+    half = (uint16_t)(bits.u - denorm_magic.u);
+  } else {
+    uint32_t mantissa_odd = (bits.u >> 13) & 1;
+    bits.u += ((uint32_t)(15 - 127) << 23) + 0xfff + mantissa_odd;
+    half = (uint16_t)(bits.u >> 13);
+  }
+  return half | (uint16_t)(sign >> 16);
+}
+
+float VertexHalfToFloat(uint16_t half) {
+  union {
+    float f;
+    uint32_t u;
+  } bits = {.u = (uint32_t)(half & 0x7fff) << 13}, magic = {.u = 113u << 23};
+  uint32_t exponent = bits.u & (0x7c00u << 13);
+  bits.u += (127u - 15u) << 23;
+  if (exponent == 0x7c00u << 13) {
+    bits.u += (128u - 16u) << 23; // inf / nan
+  } else if (exponent == 0) {
+    bits.u += 1u << 23; // denormal: renormalize
+    bits.f -= magic.f;
+  }
+  bits.u |= (uint32_t)(half & 0x8000) << 16;
+  return bits.f;
+}
+
+static float clampUnit(float value, float lo) { return value < lo ? lo : value > 1.0f ? 1.0f : value; }
+
+// GL 4.2+ conversion rules: unorm c / (2^b - 1), snorm max(c / (2^(b-1) - 1), -1)
+static uint32_t quantizeUnorm(float value, uint32_t max) {
+  return (uint32_t)lrintf(clampUnit(value, 0.0f) * (float)max);
+}
+
+static int32_t quantizeSnorm(float value, int32_t max) {
+  return (int32_t)lrintf(clampUnit(value, -1.0f) * (float)max);
+}
+
+// Two's complement values are masked to their field width
+static uint32_t pack1010102(uint32_t x, uint32_t y, uint32_t z, uint32_t w) {
+  return (x & 0x3ff) | (y & 0x3ff) << 10 | (z & 0x3ff) << 20 | (w & 0x3) << 30;
+}
+
+static void packAttribute(VertexFormat format, const float *v, unsigned char *out) {
+  switch (format) {
+  case VERTEX_FORMAT_FLOAT1:
+  case VERTEX_FORMAT_FLOAT2:
+  case VERTEX_FORMAT_FLOAT3:
+  case VERTEX_FORMAT_FLOAT4:
+    memcpy(out, v, formats[format].size);
+    break;
+  case VERTEX_FORMAT_HALF2:
+  case VERTEX_FORMAT_HALF4: {
+    uint16_t h[4];
+    for (int c = 0; c < formats[format].components; c++)
+      h[c] = VertexFloatToHalf(v[c]);
+    memcpy(out, h, formats[format].size);
+    break;
+  }
+  case VERTEX_FORMAT_UNORM8X4:
+    for (int c = 0; c < 4; c++)
+      out[c] = (unsigned char)quantizeUnorm(v[c], 255);
+    break;
+  case VERTEX_FORMAT_SNORM8X4:
+    for (int c = 0; c < 4; c++)
+      out[c] = (unsigned char)(int8_t)quantizeSnorm(v[c], 127);
+    break;
+  case VERTEX_FORMAT_UNORM16X2:
+  case VERTEX_FORMAT_UNORM16X4: {
+    uint16_t s[4];
+    for (int c = 0; c < formats[format].components; c++)
+      s[c] = (uint16_t)quantizeUnorm(v[c], 65535);
+    memcpy(out, s, formats[format].size);
+    break;
+  }
+  case VERTEX_FORMAT_SNORM16X2:
+  case VERTEX_FORMAT_SNORM16X4: {
+    int16_t s[4];
+    for (int c = 0; c < formats[format].components; c++)
+      s[c] = (int16_t)quantizeSnorm(v[c], 32767);
+    memcpy(out, s, formats[format].size);
+    break;
+  }
+  case VERTEX_FORMAT_UNORM10_10_10_2: {
+    uint32_t packed = pack1010102(quantizeUnorm(v[0], 1023), quantizeUnorm(v[1], 1023), quantizeUnorm(v[2], 1023),
+                                  quantizeUnorm(v[3], 3));
+    memcpy(out, &packed, 4);
+    break;
+  }
+  case VERTEX_FORMAT_SNORM10_10_10_2: {
+    uint32_t packed = pack1010102((uint32_t)quantizeSnorm(v[0], 511), (uint32_t)quantizeSnorm(v[1], 511),
+                                  (uint32_t)quantizeSnorm(v[2], 511), (uint32_t)quantizeSnorm(v[3], 1));
+    memcpy(out, &packed, 4);
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+void VertexLayoutPack(const VertexLayout *layout, const VertexSource *sources, size_t vertex_count, void *out) {
+  unsigned char *vertex = out;
+  for (size_t i = 0; i < vertex_count; i++, vertex += layout->stride) {
+    for (size_t a = 0; a < layout->count; a++) {
+      const VertexAttribute *attribute = &layout->attributes[a];
+      const VertexSource *source = &sources[a];
+      float v[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+      for (int c = 0; c < source->components && c < 4; c++)
+        v[c] = source->data[i * source->stride + c];
+      packAttribute(attribute->format, v, vertex + attribute->offset);
+    }
+  }
+}
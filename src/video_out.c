@@ -0,0 +1,107 @@
+#include "video_out.h"
+#include "yuv.h"
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool VideoOutputOpen(VideoOutput *video, const char *target, unsigned fps) {
+  memset(video, 0, sizeof(*video));
+  video->fps = fps ? fps : 60;
+  video->pipe = target[0] == '|';
+  if (video->pipe) {
+    signal(SIGPIPE, SIG_IGN);
+    video->file = popen(target + 1, "w");
+  } else {
+    video->file = fopen(target, "wb");
+  }
+  if (!video->file)
+    return false;
+  if (pthread_mutex_init(&video->mutex, NULL) != 0) {
+    video->pipe ? pclose(video->file) : fclose(video->file);
+    video->file = NULL;
+    return false;
+  }
+  return true;
+}
+
+void VideoOutputClose(VideoOutput *video) {
+  if (!video->file)
+    return;
+  for (size_t i = 0; i < VIDEO_REORDER_SIZE; i++)
+    free(video->pending[i].planes);
+  // pclose waits for the command, e.g. for ffmpeg to finish the file
+  int status = video->pipe ? pclose(video->file) : fclose(video->file);
+  if (status != 0)
+    video->failed = true;
+  video->file = NULL;
+  pthread_mutex_destroy(&video->mutex);
+}
+
+static void writeFrame(VideoOutput *video, const unsigned char *planes) {
+  if (video->failed)
+    return;
+  // C420jpeg: full-range BT.601 with centered chroma, which is what YuvFromRgba produces
+  if (video->written == 0 && fprintf(video->file, "YUV4MPEG2 W%d H%d F%u:1 Ip A1:1 C420jpeg\n", video->width,
+                                     video->height, video->fps) < 0) {
+    video->failed = true;
+    return;
+  }
+  size_t size = YuvImageSize(video->width, video->height);
+  if (fputs("FRAME\n", video->file) < 0 || fwrite(planes, 1, size, video->file) != size) {
+    video->failed = true;
+    return;
+  }
+  video->written++;
+  video->bytes += size + 6;
+}
+
+void VideoOutputSubmit(VideoOutput *video, size_t sequence, const unsigned char *rgba, int width, int height) {
+  pthread_mutex_lock(&video->mutex);
+  if (video->width == 0) {
+    video->width = width;
+    video->height = height;
+  }
+  bool fits = width == video->width && height == video->height;
+  pthread_mutex_unlock(&video->mutex);
+
+  // The conversion runs unlocked, so frames on different workers convert in parallel
+  unsigned char *planes = fits ? malloc(YuvImageSize(width, height)) : NULL;
+  if (planes) {
+    YuvImage image;
+    YuvImageInit(&image, planes, width, height);
+    YuvFromRgba(rgba, &image);
+  }
+
+  // Whoever completes the frame at the head writes every frame that is now in order. Writing
+  // under the lock keeps the stream ordered; a slow pipe holds up submitters, which bounds the
+  // frames in flight.
+  pthread_mutex_lock(&video->mutex);
+  if (!planes)
+    video->dropped++;
+  VideoFrame *slot = &video->pending[sequence % VIDEO_REORDER_SIZE];
+  slot->planes = planes;
+  slot->ready = true;
+  for (slot = &video->pending[video->next % VIDEO_REORDER_SIZE]; slot->ready;
+       slot = &video->pending[video->next % VIDEO_REORDER_SIZE]) {
+    if (slot->planes)
+      writeFrame(video, slot->planes);
+    free(slot->planes);
+    slot->planes = NULL;
+    slot->ready = false;
+    video->next++;
+  }
+  pthread_mutex_unlock(&video->mutex);
+}
+
+bool VideoOutputAccepts(VideoOutput *video, size_t sequence) {
+  pthread_mutex_lock(&video->mutex);
+  bool accepts = sequence - video->next < VIDEO_REORDER_SIZE;
+  pthread_mutex_unlock(&video->mutex);
+  return accepts;
+}
+
+void VideoOutputPrintStats(const VideoOutput *video) {
+  printf("Video: %zu frames of %dx%d at %u fps (%.1f MiB of Y4M), %zu dropped%s\n", video->written, video->width,
+         video->height, video->fps, (double)video->bytes / (1024.0 * 1024.0), video->dropped,
+         video->failed ? ", output failed" : "");
+}
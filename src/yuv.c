@@ -0,0 +1,151 @@
+#include "yuv.h"
+#include "vecmath.h"
+#include <stdint.h>
+#include <string.h>
+
+// 8.8 fixed point; each row of weights sums to 256, or 0 for chroma
+#define LUMA_R 77
+#define LUMA_G 150
+#define LUMA_B 29
+#define CB_R -43
+#define CB_G -85
+#define CB_B 128
+#define CR_R 128
+#define CR_G -107
+#define CR_B -21
+#define CHROMA_BIAS (128 * 1024 + 512) // offset plus rounding for a sum of four pixels, >> 10
+
+void YuvImageInit(YuvImage *image, unsigned char *buffer, int width, int height) {
+  image->width = width;
+  image->height = height;
+  image->y = buffer;
+  image->u = buffer + (size_t)width * (size_t)height;
+  image->v = image->u + (size_t)YuvChromaWidth(width) * (size_t)YuvChromaHeight(height);
+}
+
+static unsigned char clampByte(int value) { return (unsigned char)(value < 0 ? 0 : value > 255 ? 255 : value); }
+
+static unsigned char luma(const unsigned char *p) {
+  return (unsigned char)((LUMA_R * p[0] + LUMA_G * p[1] + LUMA_B * p[2] + 128) >> 8);
+}
+
+// Columns [begin, end) of the row pair starting at `y`; blocks past the right or bottom edge
+// repeat the last column or row
+static void convertScalar(const unsigned char *rgba, YuvImage *image, int y, int begin, int end) {
+  int width = image->width;
+  const unsigned char *row0 = rgba + (size_t)y * width * 4;
+  const unsigned char *row1 = y + 1 < image->height ? row0 + (size_t)width * 4 : row0;
+  for (int x = begin; x < end; x++) {
+    image->y[(size_t)y * width + x] = luma(row0 + x * 4);
+    if (y + 1 < image->height)
+      image->y[(size_t)(y + 1) * width + x] = luma(row1 + x * 4);
+  }
+  size_t chroma_row = (size_t)(y / 2) * YuvChromaWidth(width);
+  for (int x = begin; x < end; x += 2) {
+    int x1 = x + 1 < width ? x + 1 : x;
+    const unsigned char *p[4] = {row0 + x * 4, row0 + x1 * 4, row1 + x * 4, row1 + x1 * 4};
+    int r = 0, g = 0, b = 0;
+    for (int i = 0; i < 4; i++) {
+      r += p[i][0];
+      g += p[i][1];
+      b += p[i][2];
+    }
+    image->u[chroma_row + x / 2] = clampByte((CHROMA_BIAS + CB_R * r + CB_G * g + CB_B * b) >> 10);
+    image->v[chroma_row + x / 2] = clampByte((CHROMA_BIAS + CR_R * r + CR_G * g + CR_B * b) >> 10);
+  }
+}
+
+#if defined(VECMATH_SSE)
+static __m128i pairWeights(int first, int second) {
+  return _mm_set1_epi32((int)((uint32_t)(uint16_t)first | (uint32_t)(uint16_t)second << 16));
+}
+
+// One channel of 8 pixels as 16-bit lanes
+static __m128i channel(__m128i low, __m128i high, int shift) {
+  const __m128i mask = _mm_set1_epi32(0xff);
+  return _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(low, shift), mask),
+                         _mm_and_si128(_mm_srli_epi32(high, shift), mask));
+}
+
+// Products stay below 2^16, so the wrapping 16-bit multiply is exact as unsigned
+static __m128i luma8(__m128i r, __m128i g, __m128i b) {
+  __m128i sum = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(LUMA_R)), _mm_mullo_epi16(g, _mm_set1_epi16(LUMA_G)));
+  sum = _mm_add_epi16(_mm_add_epi16(sum, _mm_mullo_epi16(b, _mm_set1_epi16(LUMA_B))), _mm_set1_epi16(128));
+  return _mm_srli_epi16(sum, 8);
+}
+
+static void convert8(const unsigned char *row0, const unsigned char *row1, unsigned char *y0, unsigned char *y1,
+                     unsigned char *u, unsigned char *v) {
+  __m128i a0 = _mm_loadu_si128((const __m128i *)row0), a1 = _mm_loadu_si128((const __m128i *)(row0 + 16));
+  __m128i b0 = _mm_loadu_si128((const __m128i *)row1), b1 = _mm_loadu_si128((const __m128i *)(row1 + 16));
+  __m128i r0 = channel(a0, a1, 0), g0 = channel(a0, a1, 8), bl0 = channel(a0, a1, 16);
+  __m128i r1 = channel(b0, b1, 0), g1 = channel(b0, b1, 8), bl1 = channel(b0, b1, 16);
+  __m128i l0 = luma8(r0, g0, bl0), l1 = luma8(r1, g1, bl1);
+  _mm_storel_epi64((__m128i *)y0, _mm_packus_epi16(l0, l0));
+  _mm_storel_epi64((__m128i *)y1, _mm_packus_epi16(l1, l1));
+
+  // Sums of each 2x2 block, four blocks
+  const __m128i ones = _mm_set1_epi16(1), zero = _mm_setzero_si128();
+  __m128i rs = _mm_add_epi32(_mm_madd_epi16(r0, ones), _mm_madd_epi16(r1, ones));
+  __m128i gs = _mm_add_epi32(_mm_madd_epi16(g0, ones), _mm_madd_epi16(g1, ones));
+  __m128i bs = _mm_add_epi32(_mm_madd_epi16(bl0, ones), _mm_madd_epi16(bl1, ones));
+  __m128i rg = _mm_unpacklo_epi16(_mm_packs_epi32(rs, rs), _mm_packs_epi32(gs, gs));
+  __m128i bz = _mm_unpacklo_epi16(_mm_packs_epi32(bs, bs), zero);
+  const __m128i bias = _mm_set1_epi32(CHROMA_BIAS);
+  __m128i cb = _mm_add_epi32(_mm_madd_epi16(rg, pairWeights(CB_R, CB_G)), _mm_madd_epi16(bz, pairWeights(CB_B, 0)));
+  __m128i cr = _mm_add_epi32(_mm_madd_epi16(rg, pairWeights(CR_R, CR_G)), _mm_madd_epi16(bz, pairWeights(CR_B, 0)));
+  cb = _mm_srai_epi32(_mm_add_epi32(cb, bias), 10);
+  cr = _mm_srai_epi32(_mm_add_epi32(cr, bias), 10);
+  int packed_u = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(cb, cb), zero));
+  int packed_v = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(cr, cr), zero));
+  memcpy(u, &packed_u, 4);
+  memcpy(v, &packed_v, 4);
+}
+#elif defined(VECMATH_NEON)
+static uint8x8_t luma8(uint8x8x4_t p) {
+  uint16x8_t sum = vmull_u8(p.val[0], vdup_n_u8(LUMA_R));
+  sum = vmlal_u8(sum, p.val[1], vdup_n_u8(LUMA_G));
+  sum = vmlal_u8(sum, p.val[2], vdup_n_u8(LUMA_B));
+  return vrshrn_n_u16(sum, 8);
+}
+
+static void storeChroma(int32x4_t value, unsigned char *out) {
+  uint16x4_t narrow = vqmovun_s32(vshrq_n_s32(value, 10));
+  uint8_t bytes[8];
+  vst1_u8(bytes, vqmovn_u16(vcombine_u16(narrow, narrow)));
+  memcpy(out, bytes, 4);
+}
+
+static void convert8(const unsigned char *row0, const unsigned char *row1, unsigned char *y0, unsigned char *y1,
+                     unsigned char *u, unsigned char *v) {
+  uint8x8x4_t p0 = vld4_u8(row0), p1 = vld4_u8(row1);
+  vst1_u8(y0, luma8(p0));
+  vst1_u8(y1, luma8(p1));
+
+  // Sums of each 2x2 block, four blocks
+  int32x4_t rs = vreinterpretq_s32_u32(vpaddlq_u16(vaddl_u8(p0.val[0], p1.val[0])));
+  int32x4_t gs = vreinterpretq_s32_u32(vpaddlq_u16(vaddl_u8(p0.val[1], p1.val[1])));
+  int32x4_t bs = vreinterpretq_s32_u32(vpaddlq_u16(vaddl_u8(p0.val[2], p1.val[2])));
+  const int32x4_t bias = vdupq_n_s32(CHROMA_BIAS);
+  storeChroma(vmlaq_n_s32(vmlaq_n_s32(vmlaq_n_s32(bias, rs, CB_R), gs, CB_G), bs, CB_B), u);
+  storeChroma(vmlaq_n_s32(vmlaq_n_s32(vmlaq_n_s32(bias, rs, CR_R), gs, CR_G), bs, CR_B), v);
+}
+#endif
+
+void YuvFromRgba(const unsigned char *rgba, YuvImage *image) {
+  int width = image->width, height = image->height;
+  for (int y = 0; y < height; y += 2) {
+    int x = 0;
+#if defined(VECMATH_SSE) || defined(VECMATH_NEON)
+    if (y + 1 < height) {
+      const unsigned char *row0 = rgba + (size_t)y * width * 4, *row1 = row0 + (size_t)width * 4;
+      unsigned char *y0 = image->y + (size_t)y * width, *y1 = y0 + width;
+      size_t chroma_row = (size_t)(y / 2) * YuvChromaWidth(width);
+      for (; x + 8 <= width; x += 8)
+        convert8(row0 + x * 4, row1 + x * 4, y0 + x, y1 + x, image->u + chroma_row + x / 2,
+                 image->v + chroma_row + x / 2);
+    }
+#endif
+    convertScalar(rgba, image, y, x, width);
+  }
+}
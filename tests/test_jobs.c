@@ -0,0 +1,92 @@
+// Every chunk of a JobsParallelFor runs exactly once, also when there are more chunks than
+// fit in a worker's queue and thieves are taking them concurrently. Jobs submitted with
+// JobsRunAfter run once, only after their dependency, also when more of them are released at
+// once than fit in a queue.
+#include "jobs.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CHUNKS (JOBS_QUEUE_SIZE + JOBS_QUEUE_SIZE / 2)
+#define CHAIN 64
+
+static atomic_int runs[CHUNKS];
+static atomic_int before; // jobs of the dependency that have run
+static atomic_int chain_next;
+static int chain_index[CHAIN];
+
+static void countRange(void *data, size_t begin, size_t end) {
+  (void)data;
+  for (size_t i = begin; i < end; i++)
+    atomic_fetch_add(&runs[i], 1);
+}
+
+static void countOne(void *data) { atomic_fetch_add((atomic_int *)data, 1); }
+
+// Counts twice if the dependency has not finished yet
+static void countAfter(void *data) { atomic_fetch_add((atomic_int *)data, atomic_load(&before) == CHUNKS ? 1 : 2); }
+
+static void chainLink(void *data) {
+  int index = *(const int *)data;
+  if (atomic_fetch_add(&chain_next, 1) == index)
+    atomic_fetch_add(&runs[index], 1);
+}
+
+static int check(const char *name, int workers) {
+  int failures = 0;
+  for (size_t i = 0; i < CHUNKS; i++) {
+    int n = atomic_load(&runs[i]);
+    if (n != 1 && failures++ < 8)
+      printf("%s, %d workers: chunk %zu ran %d times\n", name, workers, i, n);
+    atomic_store(&runs[i], 0);
+  }
+  return failures;
+}
+
+int main(void) {
+  int failures = 0;
+  static const int worker_counts[] = {1, 2, 4};
+  for (size_t w = 0; w < sizeof(worker_counts) / sizeof(worker_counts[0]); w++) {
+    JobSystem jobs;
+    if (!JobSystemInit(&jobs, worker_counts[w]))
+      return 1;
+    for (int repeat = 0; repeat < 20; repeat++) {
+      JobCounter done = {0};
+      JobsParallelFor(&jobs, CHUNKS, 1, countRange, NULL, &done);
+      JobsWait(&jobs, &done);
+      failures += check("ParallelFor", worker_counts[w]);
+
+      for (size_t i = 0; i < CHUNKS; i++)
+        JobsRun(&jobs, countOne, &runs[i], &done);
+      JobsWait(&jobs, &done);
+      failures += check("Run", worker_counts[w]);
+
+      // The dependents are queued behind the jobs they wait for
+      JobCounter first = {0};
+      atomic_store(&before, 0);
+      for (size_t i = 0; i < CHUNKS; i++)
+        JobsRun(&jobs, countOne, &before, &first);
+      for (size_t i = 0; i < CHUNKS; i++)
+        JobsRunAfter(&jobs, &first, countAfter, &runs[i], &done);
+      JobsWait(&jobs, &done);
+      failures += check("RunAfter", worker_counts[w]);
+
+      // Each link waits for the one before it
+      JobCounter links[CHAIN] = {{0}};
+      atomic_store(&chain_next, 0);
+      for (int i = 0; i < CHAIN; i++) {
+        chain_index[i] = i;
+        JobsRunAfter(&jobs, i > 0 ? &links[i - 1] : NULL, chainLink, &chain_index[i], &links[i]);
+      }
+      JobsWait(&jobs, &links[CHAIN - 1]);
+      for (int i = 0; i < CHAIN; i++) {
+        int n = atomic_load(&runs[i]);
+        if (n != 1 && failures++ < 8)
+          printf("RunAfter chain, %d workers: link %d ran out of order or %d times\n", worker_counts[w], i, n);
+        atomic_store(&runs[i], 0);
+      }
+    }
+    JobSystemShutdown(&jobs);
+  }
+  printf("jobs: %s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,119 @@
+// Malformed .glb files are rejected without reading outside the file. Each case takes a valid
+// one-triangle file and replaces one field of its JSON.
+#include "mesh.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GLB_MAGIC 0x46546c67u
+#define GLB_CHUNK_JSON 0x4e4f534au
+#define GLB_CHUNK_BIN 0x004e4942u
+
+typedef struct GlbFields {
+  const char *position_count, *index_count, *index_type, *index_view, *position_offset;
+  const char *view_offset, *view_length, *view_stride;
+} GlbFields;
+
+static const GlbFields valid = {"3", "3", "5123", "1", "0", "0", "36", "12"};
+
+// Positions (0,0,0), (1,0,0), (0,1,0), then indices 0, 1, 2 as unsigned shorts
+static size_t buildGlb(const GlbFields *f, unsigned char *out, size_t size) {
+  char json[1024];
+  int json_length = snprintf(json, sizeof(json),
+                             "{\"asset\":{\"version\":\"2.0\"},"
+                             "\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0},\"indices\":1}]}],"
+                             "\"accessors\":[{\"bufferView\":0,\"componentType\":5126,\"count\":%s,\"type\":\"VEC3\","
+                             "\"byteOffset\":%s},"
+                             "{\"bufferView\":%s,\"componentType\":%s,\"count\":%s,\"type\":\"SCALAR\"}],"
+                             "\"bufferViews\":[{\"buffer\":0,\"byteOffset\":%s,\"byteLength\":%s,\"byteStride\":%s},"
+                             "{\"buffer\":0,\"byteOffset\":36,\"byteLength\":6}],"
+                             "\"buffers\":[{\"byteLength\":44}]}",
+                             f->position_count, f->position_offset, f->index_view, f->index_type, f->index_count,
+                             f->view_offset, f->view_length, f->view_stride);
+  while (json_length % 4)
+    json[json_length++] = ' ';
+  float positions[9] = {0, 0, 0, 1, 0, 0, 0, 1, 0};
+  unsigned short indices[4] = {0, 1, 2, 0};
+  uint32_t bin_length = sizeof(positions) + sizeof(indices);
+  uint32_t total = 28 + (uint32_t)json_length + bin_length;
+  if (total > size)
+    return 0;
+  uint32_t header[5] = {GLB_MAGIC, 2, total, (uint32_t)json_length, GLB_CHUNK_JSON};
+  uint32_t bin_header[2] = {bin_length, GLB_CHUNK_BIN};
+  memcpy(out, header, sizeof(header));
+  memcpy(out + 20, json, (size_t)json_length);
+  memcpy(out + 20 + json_length, bin_header, sizeof(bin_header));
+  memcpy(out + 28 + json_length, positions, sizeof(positions));
+  memcpy(out + 28 + json_length + sizeof(positions), indices, sizeof(indices));
+  return total;
+}
+
+// Imports from an exact-size heap copy, so a sanitizer or guard page catches reads past the end
+static MeshResult import(const GlbFields *fields) {
+  unsigned char buffer[2048];
+  size_t size = buildGlb(fields, buffer, sizeof(buffer));
+  unsigned char *data = malloc(size);
+  if (!data)
+    return MESH_FAILED_MEMORY;
+  memcpy(data, buffer, size);
+  Mesh mesh;
+  MeshResult result = MeshImport("test.glb", data, size, &mesh, NULL);
+  if (result == MESH_SUCCESS)
+    MeshFree(&mesh);
+  free(data);
+  return result;
+}
+
+int main(void) {
+  int failures = 0;
+  if (import(&valid) != MESH_SUCCESS) {
+    printf("valid file: not imported\n");
+    failures++;
+  }
+
+  typedef struct Case {
+    const char *name;
+    GlbFields fields;
+  } Case;
+  Case cases[] = {
+      {"negative count", valid},
+      {"zero count", valid},
+      {"count past the view", valid},
+      {"count wrapping the end check", valid},
+      {"count overflowing a long", valid},
+      {"negative accessor offset", valid},
+      {"accessor offset past the view", valid},
+      {"negative view offset", valid},
+      {"view past the chunk", valid},
+      {"view length wrapping the chunk check", valid},
+      {"stride under the element", valid},
+      {"negative stride", valid},
+      {"huge buffer view index", valid},
+      {"float indices", valid},
+      {"index count past its view", valid},
+  };
+  cases[0].fields.position_count = "-1";
+  cases[1].fields.position_count = "0";
+  cases[2].fields.position_count = "4";
+  cases[3].fields.position_count = "1537228672809129302"; // (count - 1) * 12 wraps to 36
+  cases[4].fields.position_count = "99999999999999999999999";
+  cases[5].fields.position_offset = "-12";
+  cases[6].fields.position_offset = "48";
+  cases[7].fields.view_offset = "-4";
+  cases[8].fields.view_length = "48";
+  cases[9].fields.view_length = "18446744073709551615";
+  cases[10].fields.view_stride = "4";
+  cases[11].fields.view_stride = "-12";
+  cases[12].fields.index_view = "4294967297";
+  cases[13].fields.index_type = "5126";
+  cases[14].fields.index_count = "4";
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    MeshResult result = import(&cases[i].fields);
+    if (result != MESH_FAILED_FORMAT) {
+      printf("%s: result %d, expected a format error\n", cases[i].name, (int)result);
+      failures++;
+    }
+  }
+  printf("mesh import: %s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,268 @@
+// Renders the reference scenes offscreen and compares them against golden images, so
+// performance work can show it did not change what ends up on screen. Also times every scene.
+// Each scene is the application's own (demo.c) in a given state: its frames are recorded like
+// the application records them and the command list is replayed inline, into an offscreen
+// target standing in for the window.
+//
+// usage: golden [--update] [--golden <dir>] [--output <dir>] [--threshold <t>] [--tolerance <fraction>]
+//               [--frames <n>] [--size <pixels>]
+//
+// Run from the repository root; assets are read as loose files. Without a display, run it on
+// a software rasterizer, e.g. LIBGL_ALWAYS_SOFTWARE=1 (the `check_golden` target does this).
+// Each scene passes when at most --tolerance of its pixels differ from tools/golden/<scene>.png
+// by more than --threshold (see ImageDiffPixel); failures write <scene>.actual.png and
+// <scene>.diff.png to --output. --update rewrites the golden images instead.
+#include "clock.h"
+#include "demo.h"
+#include "image.h"
+#include "image_diff.h"
+#include "image_write.h"
+#include "jobs.h"
+#include "render_commands.h"
+#include "uploader.h"
+#include <GL/gl.h>
+#include <GLFW/glfw3.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define FRAME_INTERVAL (1.0 / 60.0) // wall time between the frames that bring a scene up to its time
+#define GOLDEN_POST_CHAIN "none"    // the goldens are the scene as drawn before any post-processing
+
+typedef enum SceneKind { SCENE_FIXED, SCENE_BREATHING, SCENE_TEXTURED } SceneKind;
+
+typedef struct SceneDesc {
+  const char *name;
+  SceneKind kind;
+  float value; // breathing: animation time in seconds; textured: texture_mix
+} SceneDesc;
+
+static const SceneDesc scenes[] = {
+    {"triangle_fixed", SCENE_FIXED, 0.0f},       {"triangle_breathing", SCENE_BREATHING, 1.0f},
+    {"rectangle_mix_000", SCENE_TEXTURED, 0.0f}, {"rectangle_mix_020", SCENE_TEXTURED, 0.2f},
+    {"rectangle_mix_050", SCENE_TEXTURED, 0.5f}, {"rectangle_mix_100", SCENE_TEXTURED, 1.0f},
+};
+
+static int compareDoubles(const void *a, const void *b) {
+  double da = *(const double *)a, db = *(const double *)b;
+  return (da > db) - (da < db);
+}
+
+// The offscreen target the demo's backbuffer is drawn into
+static bool createTarget(GLsizei size, GLuint *framebuffer, GLuint *color) {
+  glGenTextures(1, color);
+  glBindTexture(GL_TEXTURE_2D, *color);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glGenFramebuffers(1, framebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, *framebuffer);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, *color, 0);
+  bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  return complete;
+}
+
+// Puts the demo in the scene's state, with the animation clock run from zero up to the
+// scene's time a frame at a time, as the application would
+static void setScene(Demo *demo, const SceneDesc *scene) {
+  bool triangle = scene->kind != SCENE_TEXTURED;
+  SceneSetVisibility(&demo->entities, demo->triangle, triangle ? VISIBILITY_VISIBLE : 0);
+  SceneSetVisibility(&demo->entities, demo->rectangle, triangle ? 0 : VISIBILITY_VISIBLE);
+  SceneSetMaterial(&demo->entities, demo->triangle,
+                   scene->kind == SCENE_BREATHING ? DEMO_MATERIAL_BREATHING : DEMO_MATERIAL_VERTEX_COLOR);
+  if (scene->kind == SCENE_TEXTURED)
+    demo->texture_mix = scene->value;
+  double time = scene->kind == SCENE_BREATHING ? scene->value : 0.0;
+  AnimationClockInit(&demo->clock, ANIMATION_DEFAULT_STEP);
+  for (double now = 0.0; now < time; now += FRAME_INTERVAL)
+    DemoUpdate(demo, now);
+  DemoUpdate(demo, time);
+}
+
+// One frame at the scene's time, recorded and replayed; the clock does not move
+static void drawFrame(Demo *demo, const SceneDesc *scene, RenderCommandList *list, GLsizei size) {
+  DemoUpdate(demo, scene->kind == SCENE_BREATHING ? scene->value : 0.0);
+  DemoCull(demo);
+  RenderCommandListReset(list);
+  DemoRecordFrame(demo, list, size, size);
+  RenderCommandListExecute(list);
+}
+
+// Rows top to bottom, like the files
+static void readFrame(GLuint framebuffer, GLsizei size, unsigned char *pixels) {
+  size_t row = (size_t)size * 4;
+  unsigned char *flipped = malloc(row * (size_t)size);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glReadPixels(0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, flipped);
+  for (GLsizei y = 0; y < size; y++)
+    memcpy(pixels + (size_t)y * row, flipped + (size_t)(size - 1 - y) * row, row);
+  free(flipped);
+}
+
+// Differing pixels in red over a faded copy of the golden image
+static void writeDiffImage(const char *path, const unsigned char *golden, const unsigned char *actual, int size,
+                           float threshold) {
+  size_t pixels = (size_t)size * (size_t)size;
+  unsigned char *out = malloc(pixels * 4);
+  for (size_t p = 0; p < pixels; p++) {
+    const unsigned char *g = golden + p * 4;
+    unsigned char *o = out + p * 4;
+    if (ImageDiffPixel(g, actual + p * 4) > threshold) {
+      o[0] = 255, o[1] = 0, o[2] = 0;
+    } else {
+      unsigned luma = (g[0] * 77u + g[1] * 150u + g[2] * 29u) >> 8;
+      o[0] = o[1] = o[2] = (unsigned char)(192 + luma / 4);
+    }
+    o[3] = 255;
+  }
+  ImageWritePng(path, out, size, size);
+  free(out);
+}
+
+int main(int argc, char **argv) {
+  const char *golden_dir = "tools/golden", *output_dir = "golden_out";
+  float threshold = IMAGE_DIFF_DEFAULT_THRESHOLD;
+  double tolerance = 0.001;
+  int frames = 100, size = 256;
+  bool update = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--update") == 0) {
+      update = true;
+    } else if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc) {
+      golden_dir = argv[++i];
+    } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+      output_dir = argv[++i];
+    } else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+      threshold = (float)atof(argv[++i]);
+    } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+      tolerance = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+      frames = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      size = atoi(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: golden [--update] [--golden <dir>] [--output <dir>] [--threshold <t>] "
+                      "[--tolerance <fraction>] [--frames <n>] [--size <pixels>]\n");
+      return 2;
+    }
+  }
+  if (frames < 1)
+    frames = 1;
+
+#ifdef GLFW_PLATFORM_NULL
+  glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#endif
+  if (!glfwInit())
+    return 1;
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef GLFW_EGL_CONTEXT_API
+  glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+#endif
+  GLFWwindow *window = glfwCreateWindow(size, size, "golden", NULL, NULL);
+  if (!window) {
+    fprintf(stderr, "golden: could not create a GL 3.3 context\n");
+    glfwTerminate();
+    return 1;
+  }
+  glfwMakeContextCurrent(window);
+  printf("%s on %s\n", (const char *)glGetString(GL_VERSION), (const char *)glGetString(GL_RENDERER));
+
+  // Uploads run inline: the harness has a single context
+  static Demo demo;
+  JobSystem jobs;
+  Uploader uploader;
+  RenderCommandList list;
+  GLuint framebuffer, color;
+  if (!JobSystemInit(&jobs, 0) || !UploaderStart(&uploader, NULL, false) || !RenderCommandListInit(&list, 256) ||
+      !createTarget(size, &framebuffer, &color)) {
+    fprintf(stderr, "golden: could not set up the renderer\n");
+    glfwTerminate();
+    return 1;
+  }
+  if (!DemoLoad(&demo, NULL, &uploader, &jobs, false) || !DemoBuildPostChain(&demo, GOLDEN_POST_CHAIN)) {
+    fprintf(stderr, "golden: could not load the scene's assets (run from the repository root)\n");
+    glfwTerminate();
+    return 1;
+  }
+  demo.targets.backbuffer = framebuffer;
+
+  size_t pixels = (size_t)size * (size_t)size;
+  unsigned char *actual = malloc(pixels * 4);
+  double *times = malloc((size_t)frames * sizeof(double));
+  int failures = 0;
+  if (update)
+    mkdir(golden_dir, 0755);
+  for (size_t s = 0; s < sizeof(scenes) / sizeof(scenes[0]); s++) {
+    const SceneDesc *scene = &scenes[s];
+    // glFinish makes each sample the whole frame, recording and GPU included. The first frame,
+    // which compiles the draw for this state on some drivers, is left out.
+    setScene(&demo, scene);
+    drawFrame(&demo, scene, &list, size);
+    glFinish();
+    double total = 0.0;
+    for (int f = 0; f < frames; f++) {
+      double start = ClockNow();
+      drawFrame(&demo, scene, &list, size);
+      glFinish();
+      times[f] = ClockNow() - start;
+      total += times[f];
+    }
+    qsort(times, (size_t)frames, sizeof(double), compareDoubles);
+    readFrame(framebuffer, size, actual);
+
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%s.png", golden_dir, scene->name);
+    printf("%-20s %7.3f ms mean, %7.3f median, %7.3f p95, %7.3f max  ", scene->name, 1000.0 * total / frames,
+           1000.0 * times[frames / 2], 1000.0 * times[frames * 95 / 100], 1000.0 * times[frames - 1]);
+    if (update) {
+      bool written = ImageWritePng(path, actual, size, size);
+      printf("%s %s\n", written ? "wrote" : "could not write", path);
+      failures += !written;
+      continue;
+    }
+
+    int width, height, channels;
+    unsigned char *golden = stbi_load(path, &width, &height, &channels, 4);
+    if (!golden || width != size || height != size) {
+      printf("FAIL: no %dx%d golden image at %s\n", size, size, path);
+      stbi_image_free(golden);
+      failures++;
+      continue;
+    }
+    ImageDiffStats stats;
+    ImageDiff(golden, actual, pixels, threshold, &stats);
+    bool pass = (double)stats.differing <= tolerance * (double)pixels;
+    printf("%s: %zu pixels differ (%.3f%%), max channel %u, mean error %.5f, max %.3f\n", pass ? "ok" : "FAIL",
+           stats.differing, 100.0 * (double)stats.differing / (double)pixels, stats.max_channel, stats.mean_error,
+           stats.max_error);
+    if (!pass) {
+      failures++;
+      if (mkdir(output_dir, 0755) != 0 && errno != EEXIST)
+        fprintf(stderr, "golden: could not create %s\n", output_dir);
+      snprintf(path, sizeof(path), "%s/%s.actual.png", output_dir, scene->name);
+      ImageWritePng(path, actual, size, size);
+      snprintf(path, sizeof(path), "%s/%s.diff.png", output_dir, scene->name);
+      writeDiffImage(path, golden, actual, size, threshold);
+    }
+    stbi_image_free(golden);
+  }
+  if (!update)
+    printf("%d of %zu scenes failed\n", failures, sizeof(scenes) / sizeof(scenes[0]));
+
+  free(times);
+  free(actual);
+  DemoDestroy(&demo);
+  glDeleteFramebuffers(1, &framebuffer);
+  glDeleteTextures(1, &color);
+  RenderCommandListDestroy(&list);
+  UploaderStop(&uploader);
+  JobSystemShutdown(&jobs);
+  glfwTerminate();
+  return failures ? 1 : 0;
+}
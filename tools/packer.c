@@ -0,0 +1,207 @@
+// Builds a single-file asset archive readable by PackOpen.
+//
+// usage: packer -o <output.pack> [-C <root>] [--codec none|lz4|zstd] <path>...
+//
+// Paths are stored relative to <root>, exactly as given, which is also the string used
+// at runtime for lookups. --codec applies to every path that follows it; compressed data
+// is only kept when it is actually smaller than the source.
+#include "pack.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_LZ4
+#include <lz4.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+typedef struct Input {
+  const char *path;
+  PackCodec codec;
+  unsigned char *data; // payload as stored
+  uint64_t size;
+  uint64_t stored_size;
+  uint64_t hash;
+  uint64_t offset;
+  uint32_t name_offset;
+} Input;
+
+static int compareInputs(const void *a, const void *b) {
+  const Input *ia = a, *ib = b;
+  if (ia->hash != ib->hash)
+    return ia->hash < ib->hash ? -1 : 1;
+  return strcmp(ia->path, ib->path);
+}
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment) { return (value + alignment - 1) / alignment * alignment; }
+
+static unsigned char *readFile(const char *root, const char *path, uint64_t *size) {
+  char full[4096];
+  snprintf(full, sizeof(full), "%s/%s", root, path);
+  FILE *file = fopen(full, "rb");
+  if (!file)
+    return NULL;
+  fseek(file, 0, SEEK_END);
+  long length = ftell(file);
+  rewind(file);
+  unsigned char *data = malloc(length > 0 ? length : 1);
+  if (data && fread(data, 1, length, file) != (size_t)length) {
+    free(data);
+    data = NULL;
+  }
+  fclose(file);
+  *size = (uint64_t)length;
+  return data;
+}
+
+static void compress(Input *input) {
+  input->stored_size = input->size;
+  unsigned char *packed = NULL;
+  uint64_t packed_size = 0;
+
+  switch (input->codec) {
+#ifdef HAVE_LZ4
+  case PACK_CODEC_LZ4: {
+    int bound = LZ4_compressBound((int)input->size);
+    packed = malloc(bound);
+    if (packed)
+      packed_size = (uint64_t)LZ4_compress_default((const char *)input->data, (char *)packed, (int)input->size, bound);
+    break;
+  }
+#endif
+#ifdef HAVE_ZSTD
+  case PACK_CODEC_ZSTD: {
+    size_t bound = ZSTD_compressBound(input->size);
+    packed = malloc(bound);
+    if (packed) {
+      size_t n = ZSTD_compress(packed, bound, input->data, input->size, 19);
+      packed_size = ZSTD_isError(n) ? 0 : n;
+    }
+    break;
+  }
+#endif
+  default:
+    break;
+  }
+
+  if (packed && packed_size > 0 && packed_size < input->size) {
+    free(input->data);
+    input->data = packed;
+    input->stored_size = packed_size;
+  } else {
+    free(packed);
+    input->codec = PACK_CODEC_NONE;
+  }
+}
+
+static int parseCodec(const char *name, PackCodec *codec) {
+  if (strcmp(name, "none") == 0)
+    *codec = PACK_CODEC_NONE;
+  else if (strcmp(name, "lz4") == 0)
+    *codec = PACK_CODEC_LZ4;
+  else if (strcmp(name, "zstd") == 0)
+    *codec = PACK_CODEC_ZSTD;
+  else
+    return 0;
+  return 1;
+}
+
+int main(int argc, char **argv) {
+  const char *output = NULL;
+  const char *root = ".";
+  PackCodec codec = PACK_CODEC_NONE;
+  Input *inputs = calloc(argc, sizeof(Input));
+  uint32_t count = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+      output = argv[++i];
+    } else if (strcmp(argv[i], "-C") == 0 && i + 1 < argc) {
+      root = argv[++i];
+    } else if (strcmp(argv[i], "--codec") == 0 && i + 1 < argc) {
+      if (!parseCodec(argv[++i], &codec)) {
+        fprintf(stderr, "packer: unknown codec '%s'\n", argv[i]);
+        return 1;
+      }
+      if (!PackCodecAvailable(codec)) {
+        fprintf(stderr, "packer: codec '%s' not compiled in, storing uncompressed\n", argv[i]);
+        codec = PACK_CODEC_NONE;
+      }
+    } else {
+      inputs[count].path = argv[i];
+      inputs[count].codec = codec;
+      count++;
+    }
+  }
+  if (!output || count == 0) {
+    fprintf(stderr, "usage: packer -o <output.pack> [-C <root>] [--codec none|lz4|zstd] <path>...\n");
+    return 1;
+  }
+
+  uint64_t names_size = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    Input *input = &inputs[i];
+    input->data = readFile(root, input->path, &input->size);
+    if (!input->data) {
+      fprintf(stderr, "packer: cannot read '%s/%s'\n", root, input->path);
+      return 1;
+    }
+    input->hash = PackHashPath(input->path);
+    compress(input);
+    names_size += strlen(input->path) + 1;
+  }
+  qsort(inputs, count, sizeof(Input), compareInputs);
+
+  PackHeader header = {0};
+  header.magic = PACK_MAGIC;
+  header.version = PACK_VERSION;
+  header.entry_count = count;
+  header.toc_offset = alignUp(sizeof(PackHeader), sizeof(uint64_t));
+  header.names_offset = header.toc_offset + (uint64_t)count * sizeof(PackTocEntry);
+  header.names_size = names_size;
+
+  uint64_t cursor = header.names_offset + names_size;
+  uint32_t name_cursor = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    Input *input = &inputs[i];
+    uint64_t alignment = input->codec == PACK_CODEC_NONE ? PACK_PAYLOAD_ALIGNMENT : PACK_COMPRESSED_ALIGNMENT;
+    input->offset = alignUp(cursor, alignment);
+    input->name_offset = name_cursor;
+    cursor = input->offset + input->stored_size;
+    name_cursor += (uint32_t)strlen(input->path) + 1;
+  }
+  header.file_size = cursor;
+
+  FILE *file = fopen(output, "wb");
+  if (!file) {
+    fprintf(stderr, "packer: cannot open '%s' for writing\n", output);
+    return 1;
+  }
+
+  fwrite(&header, sizeof(header), 1, file);
+  for (uint64_t pad = sizeof(header); pad < header.toc_offset; pad++)
+    fputc(0, file);
+  for (uint32_t i = 0; i < count; i++) {
+    PackTocEntry toc = {inputs[i].hash,        inputs[i].offset,          inputs[i].size,
+                        inputs[i].stored_size, (uint32_t)inputs[i].codec, inputs[i].name_offset};
+    fwrite(&toc, sizeof(toc), 1, file);
+  }
+  for (uint32_t i = 0; i < count; i++)
+    fwrite(inputs[i].path, 1, strlen(inputs[i].path) + 1, file);
+  for (uint32_t i = 0; i < count; i++) {
+    for (long pad = ftell(file); (uint64_t)pad < inputs[i].offset; pad++)
+      fputc(0, file);
+    fwrite(inputs[i].data, 1, inputs[i].stored_size, file);
+    free(inputs[i].data);
+  }
+
+  if (fclose(file) != 0) {
+    fprintf(stderr, "packer: failed writing '%s'\n", output);
+    return 1;
+  }
+  printf("packer: wrote %u entries (%llu bytes) to %s\n", count, (unsigned long long)header.file_size, output);
+  free(inputs);
+  return 0;
+}